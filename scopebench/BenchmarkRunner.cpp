@@ -0,0 +1,1046 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of BenchmarkRunner
+ */
+#include "BenchmarkRunner.h"
+#include "ResourceUsage.h"
+#include "../scopeprotocols/scopeprotocols.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+///@brief Sample period of the synthetic sources (50 Gsps, same as DemoOscilloscope)
+static const int64_t g_samplePeriod = 20000;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkConfig& config)
+	: m_config(config)
+	, m_rng(0x5ca1ab1e)
+{
+	m_source = make_unique<TestWaveformSource>(m_rng);
+
+	//Dummy instrument so the sources look like any other scope channel to the filters
+	m_scope = make_unique<MockOscilloscope>("bench", "Synthetic", "00000000", "null", "mock", "");
+	static const char* names[SOURCE_COUNT] = { "SINE", "PRBS31", "8B10B", "STEP", "UART" };
+	for(size_t i=0; i<SOURCE_COUNT; i++)
+	{
+		m_scope->AddChannel(new OscilloscopeChannel(
+			m_scope.get(),
+			names[i],
+			"#ffffff",
+			Unit(Unit::UNIT_FS),
+			Unit(Unit::UNIT_VOLTS),
+			Stream::STREAM_TYPE_ANALOG,
+			i));
+		m_sourceReady[i] = false;
+	}
+
+	m_executor = make_unique<FilterGraphExecutor>(m_config.m_threads);
+
+	//Every iteration has to actually do the work, so don't let the executor skip unchanged nodes
+	m_executor->SetIncrementalEvaluation(false);
+	m_executor->SetTracingEnabled(!m_config.m_tracePath.empty());
+
+	//Command buffer for generating serial data and for GPU FFTs
+	m_queue = g_vkQueueManager->GetComputeQueue("BenchmarkRunner.queue");
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		m_queue->m_family);
+	m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(**m_pool, vk::CommandBufferLevel::ePrimary, 1);
+	m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
+		std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+}
+
+BenchmarkRunner::~BenchmarkRunner()
+{
+	m_executor = nullptr;
+	m_cmdBuf = nullptr;
+	m_pool = nullptr;
+	m_queue = nullptr;
+
+	//Scope deletes its channels, which delete their waveforms
+	m_scope = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test cases
+
+/**
+	@brief Returns the list of filter graphs to benchmark
+
+	Cases cover the filters users typically stack on a deep capture: math, spectral analysis, clock recovery and eye
+	patterns, serial decode, and a dashboard of measurements sharing one input.
+ */
+vector<BenchmarkCase> BenchmarkRunner::GetFilterCases()
+{
+	//Shorthand for the inputs
+	auto src = [](BenchmarkSource s) { return BenchmarkInput{-1, s, 0}; };
+	auto stage = [](int i) { return BenchmarkInput{i, SOURCE_SINE, 0}; };
+
+	vector<BenchmarkCase> cases;
+
+	cases.push_back({"Threshold", SOURCE_PRBS31,
+		{
+			{"Threshold", {src(SOURCE_PRBS31)}, {{"Threshold", "0"}}}
+		}});
+
+	cases.push_back({"Moving average", SOURCE_SINE,
+		{
+			{"Moving average", {src(SOURCE_SINE)}, {{"Depth", "1000"}}}
+		}});
+
+	cases.push_back({"FIR low pass", SOURCE_SINE,
+		{
+			{"FIR Filter", {src(SOURCE_SINE)}, {{"Filter Type", "Low pass"}, {"Frequency High", "2000000000"}}}
+		}});
+
+	cases.push_back({"Upsample", SOURCE_SINE,
+		{
+			{"Upsample", {src(SOURCE_SINE)}, {{"Upsample factor", "4"}}}
+		}});
+
+	cases.push_back({"FFT", SOURCE_SINE,
+		{
+			{"FFT", {src(SOURCE_SINE)}, {}}
+		}});
+
+	cases.push_back({"Spectrogram", SOURCE_SINE,
+		{
+			{"Spectrogram", {src(SOURCE_SINE)}, {{"FFT length", "1024"}}}
+		}});
+
+	cases.push_back({"Autocorrelation", SOURCE_SINE,
+		{
+			{"Autocorrelation", {src(SOURCE_SINE)}, {{"Max offset", "10000"}}}
+		}});
+
+	cases.push_back({"Clock recovery", SOURCE_PRBS31,
+		{
+			{"Clock Recovery (PLL)", {src(SOURCE_PRBS31)}, {{"Symbol rate", "10312500000"}}}
+		}});
+
+	cases.push_back({"Eye pattern", SOURCE_PRBS31,
+		{
+			{"Clock Recovery (PLL)", {src(SOURCE_PRBS31)}, {{"Symbol rate", "10312500000"}}},
+			{"Eye pattern", {src(SOURCE_PRBS31), stage(0)}, {}}
+		}});
+
+	cases.push_back({"Jitter histogram", SOURCE_PRBS31,
+		{
+			{"Clock Recovery (PLL)", {src(SOURCE_PRBS31)}, {{"Symbol rate", "10312500000"}}},
+			{"Clock Jitter (TIE)", {src(SOURCE_PRBS31), stage(0)}, {}},
+			{"Histogram", {stage(1)}, {}}
+		}});
+
+	cases.push_back({"8b/10b decode", SOURCE_8B10B,
+		{
+			{"Threshold", {src(SOURCE_8B10B)}, {{"Threshold", "0"}}},
+			{"Clock Recovery (PLL)", {stage(0)}, {{"Symbol rate", "1250000000"}}},
+			{"8b/10b (IBM)", {stage(0), stage(1)}, {}}
+		}});
+
+	cases.push_back({"Measurement dashboard", SOURCE_PRBS31,
+		{
+			{"Rise", {src(SOURCE_PRBS31)}, {}},
+			{"Fall", {src(SOURCE_PRBS31)}, {}},
+			{"Overshoot", {src(SOURCE_PRBS31)}, {}},
+			{"Undershoot", {src(SOURCE_PRBS31)}, {}},
+			{"Peak-To-Peak", {src(SOURCE_PRBS31)}, {}},
+			{"Frequency", {src(SOURCE_PRBS31)}, {}}
+		}});
+
+	cases.push_back({"Step measurements", SOURCE_STEP,
+		{
+			{"Rise", {src(SOURCE_STEP)}, {}},
+			{"Overshoot", {src(SOURCE_STEP)}, {}}
+		}});
+
+	return cases;
+}
+
+/**
+	@brief Returns the list of filter graphs to run both in one pass and segmented, comparing the results
+
+	Each case uses only streaming-capable filters, so the whole graph is evaluated one segment at a time.
+ */
+vector<BenchmarkCase> BenchmarkRunner::GetSegmentedCases()
+{
+	auto src = [](BenchmarkSource s) { return BenchmarkInput{-1, s, 0}; };
+	auto stage = [](int i) { return BenchmarkInput{i, SOURCE_SINE, 0}; };
+
+	vector<BenchmarkCase> cases;
+
+	cases.push_back({"Segmented FIR low pass", SOURCE_SINE,
+		{
+			{"FIR Filter", {src(SOURCE_SINE)}, {{"Filter Type", "Low pass"}, {"Frequency High", "2000000000"}}}
+		}});
+
+	cases.push_back({"Segmented UART", SOURCE_UART,
+		{
+			{"Threshold", {src(SOURCE_UART)}, {{"Threshold", "0"}}},
+			{"UART", {stage(0)}, {{"Baud rate", "2500000000"}}}
+		}});
+
+	//The PLL relocks at the start of each segment, so edges are only expected to land within an eighth of a UI
+	//of the monolithic ones
+	cases.push_back({"Segmented clock recovery", SOURCE_PRBS31,
+		{
+			{"Clock Recovery (PLL)", {src(SOURCE_PRBS31)}, {{"Symbol rate", "10312500000"}}}
+		},
+		12121});
+
+	return cases;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Running
+
+/**
+	@brief Runs every enabled case
+ */
+void BenchmarkRunner::Run()
+{
+	if(m_config.m_runFilters)
+	{
+		for(auto& bc : GetFilterCases())
+		{
+			if(ShouldRun(bc.m_name))
+				RunFilterCase(bc);
+		}
+
+		for(auto& bc : GetSegmentedCases())
+		{
+			if(ShouldRun(bc.m_name))
+				RunSegmentedCase(bc);
+		}
+
+		if(ShouldRun("Segmented BIN import memory"))
+			RunSegmentedMemoryCheck();
+	}
+
+	if(m_config.m_runMicro)
+		RunMicroBenchmarks();
+}
+
+/**
+	@brief Checks a case name against the user's filter string
+ */
+bool BenchmarkRunner::ShouldRun(const string& name)
+{
+	if(m_config.m_filter.empty())
+		return true;
+	return (name.find(m_config.m_filter) != string::npos);
+}
+
+/**
+	@brief Times a piece of work
+
+	Runs the body once untimed to warm caches, allocate filter outputs and build FFT plans, then runs it
+	m_config.m_iterations more times and records the median and fastest wall clock time.
+
+	Peak RSS covers the warmup as well, since that is where output buffers are first allocated. Allocation counts
+	cover only the timed iterations, so they show the steady state cost of re-running a graph.
+
+	@param name		Name of the case
+	@param group	Group the case belongs to
+	@param samples	Number of samples processed by each run of the body
+	@param body		The work to time
+	@param setup	Optional untimed work to run before each iteration (including the warmup)
+ */
+BenchmarkResult BenchmarkRunner::Measure(
+	const string& name,
+	const string& group,
+	size_t samples,
+	function<void()> body,
+	function<void()> setup)
+{
+	BenchmarkResult result;
+	result.m_name = name;
+	result.m_group = group;
+	result.m_samples = samples;
+	result.m_iterations = max(m_config.m_iterations, (size_t)1);
+
+	LogNotice("%-40s ", name.c_str());
+	fflush(stdout);
+
+	ResetPeakRSS();
+
+	//Warmup
+	if(setup)
+		setup();
+	body();
+
+	vector<double> times;
+	uint64_t allocCount = 0;
+	uint64_t allocBytes = 0;
+	for(size_t i=0; i<result.m_iterations; i++)
+	{
+		if(setup)
+			setup();
+
+		auto before = GetAllocationCounters();
+		double start = GetTime();
+		body();
+		double dt = GetTime() - start;
+		auto after = GetAllocationCounters();
+
+		times.push_back(dt);
+		allocCount += after.m_count - before.m_count;
+		allocBytes += after.m_bytes - before.m_bytes;
+	}
+
+	sort(times.begin(), times.end());
+	size_t mid = times.size() / 2;
+	if(times.size() & 1)
+		result.m_medianTime = times[mid];
+	else
+		result.m_medianTime = (times[mid-1] + times[mid]) / 2;
+	result.m_minTime = times[0];
+
+	result.m_peakRSS = GetPeakRSS();
+	result.m_allocations = allocCount * 1.0 / result.m_iterations;
+	result.m_allocatedBytes = allocBytes * 1.0 / result.m_iterations;
+	result.m_ok = true;
+
+	LogNotice("%10.3f ms  %8.3f ns/sample\n", result.m_medianTime * 1e3, result.GetNsPerSample());
+	return result;
+}
+
+/**
+	@brief Generates a +/- 0.5V 8N1 UART signal carrying random bytes, at 20 samples per bit
+
+	Frames are separated by 12 idle bits, so a decoder starting at an arbitrary point is back in sync within two
+	frames (the overlap UARTDecoder asks for when segmented).
+ */
+static WaveformBase* GenerateUARTWaveform(minstd_rand& rng, size_t depth)
+{
+	const size_t samplesPerBit = 20;
+	const size_t idleBits = 12;
+
+	auto ret = new UniformAnalogWaveform("UART");
+	ret->m_timescale = g_samplePeriod;
+	ret->Resize(depth);
+	ret->PrepareForCpuAccess();
+
+	float* samples = ret->m_samples.GetCpuPointer();
+	size_t i = 0;
+	while(i < depth)
+	{
+		//Start bit (low), data LSB first, stop bit (high), then idle
+		uint32_t frame = ((rng() & 0xff) << 1) | 0x200;
+
+		for(size_t bit=0; (bit < 10 + idleBits) && (i < depth); bit++)
+		{
+			float v = ((bit >= 10) || (frame & (1 << bit))) ? 0.5 : -0.5;
+			for(size_t j=0; (j < samplesPerBit) && (i < depth); j++, i++)
+				samples[i] = v;
+		}
+	}
+
+	ret->MarkModifiedFromCpu();
+	return ret;
+}
+
+/**
+	@brief Gets the waveform for a synthetic source, generating it on first use
+ */
+WaveformBase* BenchmarkRunner::GenerateSource(BenchmarkSource source)
+{
+	auto chan = m_scope->GetOscilloscopeChannel(source);
+	if(m_sourceReady[source])
+		return chan->GetData(0);
+
+	size_t depth = m_config.m_depth;
+	WaveformBase* wfm = nullptr;
+	switch(source)
+	{
+		case SOURCE_SINE:
+			wfm = m_source->GenerateNoisySinewave(0.9, 0.0, 1e6, g_samplePeriod, depth, nullptr, 0.01);
+			break;
+
+		case SOURCE_PRBS31:
+			wfm = m_source->GeneratePRBS31(
+				*m_cmdBuf, m_queue, 0.9, 96969.6, g_samplePeriod, depth, nullptr, true, 0.01);
+			break;
+
+		case SOURCE_8B10B:
+			wfm = m_source->Generate8b10b(
+				*m_cmdBuf, m_queue, 0.9, 800e3, g_samplePeriod, depth, nullptr, true, 0.01);
+			break;
+
+		case SOURCE_UART:
+			wfm = GenerateUARTWaveform(m_rng, depth);
+			break;
+
+		case SOURCE_STEP:
+		default:
+			wfm = m_source->GenerateStep(-0.5, 0.5, g_samplePeriod, depth);
+			break;
+	}
+
+	chan->SetData(wfm, 0);
+	m_sourceReady[source] = true;
+	return wfm;
+}
+
+/**
+	@brief Creates and connects the filters of a case
+
+	@param bc		The case
+	@param filters	Filled with the filters created, one per stage, each holding a reference
+	@param nodes	Filled with the same filters, for passing to the executor
+	@param error	Description of the problem if the graph could not be built
+
+	@return True on success. Filters created before an error are still returned, and must be released.
+ */
+bool BenchmarkRunner::BuildFilterCase(
+	const BenchmarkCase& bc,
+	vector<Filter*>& filters,
+	set<FlowGraphNode*>& nodes,
+	string& error)
+{
+	for(auto& stage : bc.m_stages)
+	{
+		auto f = Filter::CreateFilter(stage.m_protocol);
+		if(!f)
+		{
+			error = "Unknown filter \"" + stage.m_protocol + "\"";
+			return false;
+		}
+		f->AddRef();
+		filters.push_back(f);
+		nodes.emplace(f);
+
+		//Eye patterns are sized by the GUI, pick something typical
+		auto eye = dynamic_cast<EyePattern*>(f);
+		if(eye)
+		{
+			eye->SetWidth(1024);
+			eye->SetHeight(512);
+		}
+
+		for(auto& it : stage.m_parameters)
+		{
+			if(!f->HasParameter(it.first))
+			{
+				error = "Filter \"" + stage.m_protocol + "\" has no parameter \"" + it.first + "\"";
+				return false;
+			}
+			f->GetParameter(it.first).ParseString(it.second, false);
+		}
+
+		for(size_t i=0; i<stage.m_inputs.size(); i++)
+		{
+			auto& in = stage.m_inputs[i];
+			if(in.m_stage < 0)
+			{
+				GenerateSource(in.m_source);
+				f->SetInput(i, StreamDescriptor(m_scope->GetOscilloscopeChannel(in.m_source), 0));
+			}
+			else
+				f->SetInput(i, StreamDescriptor(filters[in.m_stage], in.m_stream));
+		}
+	}
+
+	return true;
+}
+
+/**
+	@brief Releases the filters of a case, downstream filters first
+ */
+void BenchmarkRunner::ReleaseFilterCase(vector<Filter*>& filters)
+{
+	for(auto it = filters.rbegin(); it != filters.rend(); it++)
+		(*it)->Release();
+	filters.clear();
+	Filter::ClearAnalysisCache();
+}
+
+/**
+	@brief Builds one filter graph, times it, and tears it down again
+ */
+void BenchmarkRunner::RunFilterCase(const BenchmarkCase& bc)
+{
+	BenchmarkResult err;
+	err.m_name = bc.m_name;
+	err.m_group = "filter";
+
+	vector<Filter*> filters;
+	set<FlowGraphNode*> nodes;
+	if(BuildFilterCase(bc, filters, nodes, err.m_error))
+	{
+		auto wfm = GenerateSource(bc.m_primarySource);
+		m_results.push_back(Measure(
+			bc.m_name,
+			"filter",
+			wfm->size(),
+			[&]{ m_executor->RunBlocking(nodes); }));
+	}
+	else
+	{
+		LogError("%s: %s\n", bc.m_name.c_str(), err.m_error.c_str());
+		m_results.push_back(err);
+	}
+
+	ReleaseFilterCase(filters);
+}
+
+/**
+	@brief Gets the value of one sample of an analog, digital or byte waveform
+
+	@return False if the waveform is of some other type
+ */
+static bool GetSampleValue(WaveformBase* wfm, size_t i, double& value)
+{
+	auto sa = dynamic_cast<SparseWaveform<float>*>(wfm);
+	auto ua = dynamic_cast<UniformWaveform<float>*>(wfm);
+	if(sa || ua)
+	{
+		value = GetValue(sa, ua, i);
+		return true;
+	}
+
+	auto sd = dynamic_cast<SparseWaveform<bool>*>(wfm);
+	auto ud = dynamic_cast<UniformWaveform<bool>*>(wfm);
+	if(sd || ud)
+	{
+		value = GetValue(sd, ud, i);
+		return true;
+	}
+
+	auto sb = dynamic_cast<SparseWaveform<char>*>(wfm);
+	if(sb)
+	{
+		value = sb->m_samples[i];
+		return true;
+	}
+
+	return false;
+}
+
+/**
+	@brief Compares one output of a segmented run against the same output of a monolithic run
+
+	Samples are paired up by timestamp. If the tolerance is zero every sample must match exactly (analog values to
+	within rounding error). Otherwise the filter only approximately survives being cut into segments (e.g. a PLL
+	relocking at each boundary), so only timestamps are compared and up to two samples may be gained or lost at each
+	segment boundary.
+
+	@param ref			Output of the monolithic run
+	@param seg			Output of the segmented run
+	@param tolerance	Largest timestamp difference allowed, in femtoseconds
+	@param boundaries	Number of segment boundaries
+	@param error		Description of the first difference found
+
+	@return True if the outputs match
+ */
+static bool CompareSegmentedOutput(
+	WaveformBase* ref,
+	WaveformBase* seg,
+	int64_t tolerance,
+	size_t boundaries,
+	string& error)
+{
+	if( (ref == nullptr) || (seg == nullptr) )
+	{
+		if(ref == seg)
+			return true;
+		error = "output is missing in one run";
+		return false;
+	}
+
+	//Only sample streams can be segmented
+	auto sref = dynamic_cast<SparseWaveformBase*>(ref);
+	auto uref = dynamic_cast<UniformWaveformBase*>(ref);
+	auto sseg = dynamic_cast<SparseWaveformBase*>(seg);
+	auto useg = dynamic_cast<UniformWaveformBase*>(seg);
+	if( (!sref && !uref) || (!sseg && !useg) )
+		return true;
+
+	ref->PrepareForCpuAccess();
+	seg->PrepareForCpuAccess();
+
+	size_t nref = ref->size();
+	size_t nseg = seg->size();
+	size_t unmatched = 0;
+	size_t i = 0;
+	size_t j = 0;
+	char tmp[256];
+	while( (i < nref) && (j < nseg) )
+	{
+		int64_t tref = GetOffsetScaled(sref, uref, i);
+		int64_t tseg = GetOffsetScaled(sseg, useg, j);
+		if(llabs(tseg - tref) <= tolerance)
+		{
+			double vref;
+			double vseg;
+			if( (tolerance == 0) && GetSampleValue(ref, i, vref) && GetSampleValue(seg, j, vseg) &&
+				(fabs(vseg - vref) > 1e-4) )
+			{
+				snprintf(tmp, sizeof(tmp), "sample %zu at %" PRId64 " fs is %g, expected %g", j, tseg, vseg, vref);
+				error = tmp;
+				return false;
+			}
+			i++;
+			j++;
+		}
+		else if(tref < tseg)
+		{
+			unmatched ++;
+			i++;
+		}
+		else
+		{
+			unmatched ++;
+			j++;
+		}
+	}
+	unmatched += (nref - i) + (nseg - j);
+
+	size_t allowed = tolerance ? 2*boundaries : 0;
+	if(unmatched > allowed)
+	{
+		snprintf(tmp, sizeof(tmp), "%zu of %zu samples don't match (%zu segmented samples, %zu allowed)",
+			unmatched, nref, nseg, allowed);
+		error = tmp;
+		return false;
+	}
+	return true;
+}
+
+/**
+	@brief Runs a filter graph in one pass, then times running it segmented and checks the results are the same
+
+	Every stream of every stage which isn't consumed by a later stage is compared. Streams passed between stages are
+	only valid within the segmented group, so they are expected to be null afterwards.
+ */
+void BenchmarkRunner::RunSegmentedCase(const BenchmarkCase& bc)
+{
+	BenchmarkResult err;
+	err.m_name = bc.m_name;
+	err.m_group = "segmented";
+
+	vector<Filter*> filters;
+	set<FlowGraphNode*> nodes;
+	if(!BuildFilterCase(bc, filters, nodes, err.m_error))
+	{
+		LogError("%s: %s\n", bc.m_name.c_str(), err.m_error.c_str());
+		m_results.push_back(err);
+		ReleaseFilterCase(filters);
+		return;
+	}
+
+	//Reference outputs and packet counts from a single pass over the whole record
+	m_executor->RunBlocking(nodes);
+	vector<vector<unique_ptr<WaveformBase>>> refs;
+	vector<size_t> refPackets;
+	for(auto f : filters)
+	{
+		refs.emplace_back();
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+			refs.back().emplace_back(f->Detach(i));
+
+		auto pd = dynamic_cast<PacketDecoder*>(f);
+		refPackets.push_back(pd ? pd->GetPacketCount() : 0);
+	}
+
+	//Eight segments, so there are plenty of boundaries to get wrong
+	auto wfm = GenerateSource(bc.m_primarySource);
+	size_t segmentSize = max(wfm->size() / 8, (size_t)1024);
+	size_t boundaries = (wfm->size() + segmentSize - 1) / segmentSize - 1;
+
+	auto result = Measure(
+		bc.m_name,
+		"segmented",
+		wfm->size(),
+		[&]{ m_executor->RunSegmentedBlocking(nodes, segmentSize); });
+
+	//Streams which feed later stages
+	set<pair<int, size_t>> intermediates;
+	for(auto& stage : bc.m_stages)
+	{
+		for(auto& in : stage.m_inputs)
+		{
+			if(in.m_stage >= 0)
+				intermediates.emplace(in.m_stage, in.m_stream);
+		}
+	}
+
+	//Check the outputs of the last run
+	for(size_t k=0; (k < filters.size()) && result.m_ok; k++)
+	{
+		auto f = filters[k];
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			if(intermediates.find(make_pair((int)k, i)) != intermediates.end())
+			{
+				if(f->GetData(i) != nullptr)
+				{
+					result.m_ok = false;
+					result.m_error = f->GetProtocolDisplayName() + " " + f->GetStreamName(i) +
+						": intermediate stream still holds data after segmented run";
+					break;
+				}
+				continue;
+			}
+
+			string error;
+			if(!CompareSegmentedOutput(refs[k][i].get(), f->GetData(i), bc.m_segmentTolerance, boundaries, error))
+			{
+				result.m_ok = false;
+				result.m_error = f->GetProtocolDisplayName() + " " + f->GetStreamName(i) + ": " + error;
+				break;
+			}
+		}
+
+		auto pd = dynamic_cast<PacketDecoder*>(f);
+		if(result.m_ok && pd && (bc.m_segmentTolerance == 0) && (pd->GetPacketCount() != refPackets[k]) )
+		{
+			result.m_ok = false;
+			result.m_error = f->GetProtocolDisplayName() + ": " + to_string(pd->GetPacketCount()) +
+				" packets, expected " + to_string(refPackets[k]);
+		}
+	}
+
+	if(!result.m_ok)
+		LogError("%s: %s\n", bc.m_name.c_str(), result.m_error.c_str());
+	m_results.push_back(result);
+
+	ReleaseFilterCase(filters);
+}
+
+/**
+	@brief Writes a single channel Keysight BIN file containing a sine wave
+
+	@param path		Path of the file to create
+	@param depth	Number of samples
+ */
+bool BenchmarkRunner::WriteBINFile(const string& path, size_t depth)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+		return false;
+
+	BINImportFilter::FileHeader fh;
+	memset(&fh, 0, sizeof(fh));
+	fh.magic[0] = 'A';
+	fh.magic[1] = 'G';
+	fh.version[0] = '1';
+	fh.version[1] = '0';
+	fh.length = sizeof(BINImportFilter::FileHeader) + sizeof(BINImportFilter::WaveHeader) +
+		sizeof(BINImportFilter::DataHeader) + depth*sizeof(float);
+	fh.count = 1;
+
+	BINImportFilter::WaveHeader wh;
+	memset(&wh, 0, sizeof(wh));
+	wh.size = sizeof(wh);
+	wh.type = 1;
+	wh.buffers = 1;
+	wh.samples = depth;
+	wh.interval = g_samplePeriod * SECONDS_PER_FS;
+	wh.duration = depth * wh.interval;
+	strncpy(wh.label, "CH1", sizeof(wh.label));
+
+	BINImportFilter::DataHeader dh;
+	memset(&dh, 0, sizeof(dh));
+	dh.size = sizeof(dh);
+	dh.type = 4;
+	dh.depth = sizeof(float);
+	dh.length = depth*sizeof(float);
+
+	bool ok =
+		(fwrite(&fh, sizeof(fh), 1, fp) == 1) &&
+		(fwrite(&wh, sizeof(wh), 1, fp) == 1) &&
+		(fwrite(&dh, sizeof(dh), 1, fp) == 1);
+
+	//1 GHz sine, written in chunks so the file can be much bigger than what we hold in memory
+	vector<float> chunk(65536);
+	for(size_t i=0; (i < depth) && ok; i += chunk.size())
+	{
+		size_t n = min(chunk.size(), depth - i);
+		for(size_t j=0; j<n; j++)
+			chunk[j] = sin(2 * M_PI * 1e9 * (i+j) * wh.interval);
+		ok = (fwrite(&chunk[0], sizeof(float), n, fp) == n);
+	}
+
+	if(fclose(fp) != 0)
+		ok = false;
+	return ok;
+}
+
+/**
+	@brief Checks that segmented execution of an imported record uses memory proportional to the segment size
+
+	Imports a BIN file of m_config.m_depth samples and one four times as long, low pass filters each a segment at a
+	time, and compares how far peak RSS rises above where it started. If any part of the record was held in memory
+	in full, the longer one would need about four times as much.
+ */
+void BenchmarkRunner::RunSegmentedMemoryCheck()
+{
+	static const char* name = "Segmented BIN import memory";
+	static const size_t segmentSize = 1024 * 1024;
+	static const size_t slack = 16 * 1024 * 1024;
+
+	BenchmarkResult err;
+	err.m_name = name;
+	err.m_group = "segmented";
+
+#ifdef _WIN32
+	LogNotice("%-40s skipped, needs a temporary file\n", name);
+#else
+	size_t depths[2] = { m_config.m_depth, 4*m_config.m_depth };
+	size_t growth[2] = { 0, 0 };
+	BenchmarkResult result;
+	for(size_t k=0; k<2; k++)
+	{
+		char path[] = "/tmp/scopebench-XXXXXX";
+		int fd = mkstemp(path);
+		if(fd < 0)
+		{
+			err.m_error = "Couldn't create temporary file";
+			break;
+		}
+		close(fd);
+		if(!WriteBINFile(path, depths[k]))
+		{
+			err.m_error = string("Couldn't write ") + path;
+			unlink(path);
+			break;
+		}
+
+		vector<Filter*> filters;
+		auto importer = dynamic_cast<ImportFilter*>(Filter::CreateFilter("BIN Import"));
+		auto fir = Filter::CreateFilter("FIR Filter");
+		importer->AddRef();
+		fir->AddRef();
+		filters.push_back(importer);
+		filters.push_back(fir);
+		importer->GetParameter(importer->GetFileNameParameter()).SetFileName(path);
+		fir->GetParameter("Filter Type").ParseString("Low pass", false);
+		fir->GetParameter("Frequency High").ParseString("2000000000", false);
+		fir->SetInput(0, StreamDescriptor(importer, 0));
+		set<FlowGraphNode*> nodes = { importer, fir };
+
+		ResetPeakRSS();
+		size_t base = GetPeakRSS();
+		result = Measure(
+			string(name) + " (" + to_string(depths[k]) + ")",
+			"segmented",
+			depths[k],
+			[&]{ m_executor->RunSegmentedBlocking(nodes, segmentSize); });
+		growth[k] = (result.m_peakRSS > base) ? (result.m_peakRSS - base) : 0;
+
+		if(result.m_ok && ( (fir->GetData(0) == nullptr) || (fir->GetData(0)->size() + 1 < depths[k]) ) )
+		{
+			result.m_ok = false;
+			result.m_error = "filtered output is shorter than the imported record";
+		}
+
+		ReleaseFilterCase(filters);
+		unlink(path);
+
+		if(!result.m_ok)
+			break;
+		m_results.push_back(result);
+	}
+
+	if(!err.m_error.empty())
+	{
+		LogError("%s: %s\n", name, err.m_error.c_str());
+		m_results.push_back(err);
+	}
+	else if(!result.m_ok)
+	{
+		LogError("%s: %s\n", name, result.m_error.c_str());
+		m_results.push_back(result);
+	}
+
+	//Allow some noise from allocator and page cache behavior, but nothing like the 4x of a fully resident record
+	else if(growth[1] > growth[0] + growth[0]/2 + slack)
+	{
+		auto& r = m_results.back();
+		r.m_ok = false;
+		r.m_error = "peak RSS grew by " + to_string(growth[1] / (1024*1024)) + " MB for " +
+			to_string(depths[1]) + " samples but only " + to_string(growth[0] / (1024*1024)) + " MB for " +
+			to_string(depths[0]);
+		LogError("%s: %s\n", name, r.m_error.c_str());
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Prints a table of all results to the log
+ */
+void BenchmarkRunner::PrintSummary()
+{
+	LogNotice("\n");
+	LogNotice("%-40s %12s %12s %14s %12s %12s\n",
+		"Case", "Median (ms)", "ns/sample", "Msamples/s", "Peak RSS", "Allocs/iter");
+	for(auto& r : m_results)
+	{
+		if(!r.m_ok)
+		{
+			LogNotice("%-40s FAILED: %s\n", r.m_name.c_str(), r.m_error.c_str());
+			continue;
+		}
+
+		LogNotice("%-40s %12.3f %12.3f %14.2f %9zu MB %12.1f\n",
+			r.m_name.c_str(),
+			r.m_medianTime * 1e3,
+			r.GetNsPerSample(),
+			r.GetSamplesPerSecond() * 1e-6,
+			r.m_peakRSS / (1024 * 1024),
+			r.m_allocations);
+	}
+}
+
+/**
+	@brief Checks if every case ran successfully
+ */
+bool BenchmarkRunner::AllPassed() const
+{
+	for(auto& r : m_results)
+	{
+		if(!r.m_ok)
+			return false;
+	}
+	return true;
+}
+
+/**
+	@brief Writes the execution trace of the most recent filter graph passes and prints per-filter timing
+
+	The file is read back afterwards, so a run which recorded no filter graph passes fails rather than leaving an
+	empty trace.
+
+	@return True on success, or if tracing is disabled
+ */
+bool BenchmarkRunner::WriteTrace()
+{
+	if(m_config.m_tracePath.empty())
+		return true;
+
+	LogNotice("\n");
+	LogNotice("%-40s %-24s %8s %12s %12s %12s\n",
+		"Filter", "Protocol", "Count", "p50 (ms)", "p99 (ms)", "xfer (ms)");
+	for(auto& s : m_executor->GetFilterTimingStats())
+	{
+		LogNotice("%-40s %-24s %8zu %12.3f %12.3f %12.3f\n",
+			s.m_name.c_str(),
+			s.m_protocol.c_str(),
+			s.m_count,
+			s.m_p50 * 1e-6,
+			s.m_p99 * 1e-6,
+			s.m_transferWait * 1e-6);
+	}
+
+	if(!m_executor->WriteChromeTrace(m_config.m_tracePath, 64))
+		return false;
+
+	//Make sure the file actually holds some events
+	ifstream in(m_config.m_tracePath);
+	stringstream trace;
+	trace << in.rdbuf();
+	if(!in || (trace.str().find("\"ph\":\"X\"") == string::npos) )
+	{
+		LogError("Trace file %s is missing or has no events\n", m_config.m_tracePath.c_str());
+		return false;
+	}
+	LogNotice("Wrote trace to %s (%zu bytes)\n", m_config.m_tracePath.c_str(), trace.str().size());
+	return true;
+}
+
+/**
+	@brief Writes all results to a JSON file
+
+	@return True on success
+ */
+bool BenchmarkRunner::WriteJSON(const string& path)
+{
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Couldn't open %s for writing\n", path.c_str());
+		return false;
+	}
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"version\": \"%s\",\n", JSONEscape(ScopehalGetVersion()).c_str());
+	fprintf(fp, "\t\"avx2\": %s,\n", g_hasAvx2 ? "true" : "false");
+	fprintf(fp, "\t\"avx512f\": %s,\n", g_hasAvx512F ? "true" : "false");
+	fprintf(fp, "\t\"cpuOnly\": %s,\n", m_config.m_cpuOnly ? "true" : "false");
+	fprintf(fp, "\t\"depth\": %zu,\n", m_config.m_depth);
+	fprintf(fp, "\t\"iterations\": %zu,\n", m_config.m_iterations);
+	fprintf(fp, "\t\"threads\": %zu,\n", m_config.m_threads);
+	fprintf(fp, "\t\"results\":\n\t[\n");
+	for(size_t i=0; i<m_results.size(); i++)
+	{
+		auto& r = m_results[i];
+		fprintf(fp, "\t\t{\n");
+		fprintf(fp, "\t\t\t\"name\": \"%s\",\n", JSONEscape(r.m_name).c_str());
+		fprintf(fp, "\t\t\t\"group\": \"%s\",\n", JSONEscape(r.m_group).c_str());
+		fprintf(fp, "\t\t\t\"ok\": %s,\n", r.m_ok ? "true" : "false");
+		if(!r.m_ok)
+			fprintf(fp, "\t\t\t\"error\": \"%s\",\n", JSONEscape(r.m_error).c_str());
+		fprintf(fp, "\t\t\t\"samples\": %zu,\n", r.m_samples);
+		fprintf(fp, "\t\t\t\"iterations\": %zu,\n", r.m_iterations);
+		fprintf(fp, "\t\t\t\"medianSeconds\": %.9g,\n", r.m_medianTime);
+		fprintf(fp, "\t\t\t\"minSeconds\": %.9g,\n", r.m_minTime);
+		fprintf(fp, "\t\t\t\"samplesPerSecond\": %.6g,\n", r.GetSamplesPerSecond());
+		fprintf(fp, "\t\t\t\"nsPerSample\": %.6g,\n", r.GetNsPerSample());
+		fprintf(fp, "\t\t\t\"peakRSSBytes\": %zu,\n", r.m_peakRSS);
+		fprintf(fp, "\t\t\t\"allocationsPerIteration\": %.1f,\n", r.m_allocations);
+		fprintf(fp, "\t\t\t\"allocatedBytesPerIteration\": %.1f\n", r.m_allocatedBytes);
+		fprintf(fp, "\t\t}%s\n", (i+1 < m_results.size()) ? "," : "");
+	}
+	fprintf(fp, "\t]\n");
+	fprintf(fp, "}\n");
+
+	fclose(fp);
+	return true;
+}
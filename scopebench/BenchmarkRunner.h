@@ -0,0 +1,282 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of BenchmarkRunner
+ */
+#ifndef BenchmarkRunner_h
+#define BenchmarkRunner_h
+
+#include "../scopehal/scopehal.h"
+#include "../scopehal/MockOscilloscope.h"
+#include "../scopehal/TestWaveformSource.h"
+
+#include <functional>
+#include <random>
+
+/**
+	@brief Settings for a benchmark run
+ */
+struct BenchmarkConfig
+{
+	///@brief Number of samples in each synthetic input waveform
+	size_t m_depth = 10*1000*1000;
+
+	///@brief Number of timed iterations of each case (after one untimed warmup)
+	size_t m_iterations = 5;
+
+	///@brief Number of filter graph worker threads
+	size_t m_threads = 8;
+
+	///@brief If not empty, only run cases whose name contains this string
+	std::string m_filter;
+
+	///@brief True to force filters onto their CPU implementations
+	bool m_cpuOnly = false;
+
+	///@brief True to run filter graph cases
+	bool m_runFilters = true;
+
+	///@brief True to run microbenchmarks of individual kernels
+	bool m_runMicro = true;
+
+	///@brief Largest FFT size to benchmark, in points
+	size_t m_maxFFTSize = 64*1024*1024;
+
+	///@brief If not empty, record filter graph execution traces and write them to this file
+	std::string m_tracePath;
+
+	///@brief If not empty, a captured LeCroy digital waveform block (reply to "Digital1:WF?") to benchmark decoding of
+	std::string m_lecroyDigitalPath;
+};
+
+/**
+	@brief Result of one benchmark case
+ */
+struct BenchmarkResult
+{
+	///@brief Name of the case
+	std::string m_name;
+
+	///@brief Group the case belongs to ("filter", "segmented" or "micro")
+	std::string m_group;
+
+	///@brief Number of input samples (or other work items) processed per iteration
+	size_t m_samples = 0;
+
+	///@brief Number of timed iterations
+	size_t m_iterations = 0;
+
+	///@brief Median wall clock time per iteration, in seconds
+	double m_medianTime = 0;
+
+	///@brief Fastest wall clock time of any iteration, in seconds
+	double m_minTime = 0;
+
+	///@brief Peak resident set size of the process while running the case, in bytes
+	size_t m_peakRSS = 0;
+
+	///@brief Average number of operator new calls per iteration
+	double m_allocations = 0;
+
+	///@brief Average number of bytes requested from operator new per iteration
+	double m_allocatedBytes = 0;
+
+	///@brief True if the case ran successfully
+	bool m_ok = false;
+
+	///@brief Error message if the case failed
+	std::string m_error;
+
+	///@brief Gets the throughput in samples per second, based on the median time
+	double GetSamplesPerSecond() const
+	{ return (m_medianTime > 0) ? m_samples / m_medianTime : 0; }
+
+	///@brief Gets the cost per sample in nanoseconds, based on the median time
+	double GetNsPerSample() const
+	{ return m_samples ? (m_medianTime * 1e9 / m_samples) : 0; }
+};
+
+/**
+	@brief Synthetic input waveforms available to filter cases
+ */
+enum BenchmarkSource
+{
+	SOURCE_SINE,
+	SOURCE_PRBS31,
+	SOURCE_8B10B,
+	SOURCE_STEP,
+	SOURCE_UART,
+
+	SOURCE_COUNT
+};
+
+/**
+	@brief Reference to an input of a filter in a benchmark graph
+
+	Either one of the synthetic sources, or a stream of an earlier stage in the same case.
+ */
+struct BenchmarkInput
+{
+	///@brief Index of the stage providing the input, or -1 for a synthetic source
+	int m_stage;
+
+	///@brief Synthetic source to use if m_stage is negative
+	BenchmarkSource m_source;
+
+	///@brief Stream index of the stage
+	size_t m_stream;
+};
+
+/**
+	@brief One filter in a benchmark graph
+ */
+struct BenchmarkStage
+{
+	///@brief Protocol name of the filter, as passed to Filter::CreateFilter()
+	std::string m_protocol;
+
+	///@brief Inputs of the filter, in order
+	std::vector<BenchmarkInput> m_inputs;
+
+	///@brief Parameter values, parsed with FilterParameter::ParseString()
+	std::map<std::string, std::string> m_parameters;
+};
+
+/**
+	@brief A filter graph to benchmark
+ */
+struct BenchmarkCase
+{
+	///@brief Name of the case, used in reports
+	std::string m_name;
+
+	///@brief Source whose length is used to compute throughput
+	BenchmarkSource m_primarySource;
+
+	///@brief Filters in the graph, each stage may only use sources or earlier stages as inputs
+	std::vector<BenchmarkStage> m_stages;
+
+	/**
+		@brief Largest timestamp difference allowed between segmented and monolithic outputs, in femtoseconds
+
+		Zero if segmented execution must reproduce the monolithic output exactly.
+	 */
+	int64_t m_segmentTolerance = 0;
+};
+
+/**
+	@brief Runs filter graph and kernel benchmarks and collects the results
+ */
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(const BenchmarkConfig& config);
+	~BenchmarkRunner();
+
+	BenchmarkRunner(const BenchmarkRunner&) =delete;
+	BenchmarkRunner& operator=(const BenchmarkRunner&) =delete;
+
+	void Run();
+
+	static std::vector<BenchmarkCase> GetFilterCases();
+	static std::vector<BenchmarkCase> GetSegmentedCases();
+
+	void PrintSummary();
+	bool WriteJSON(const std::string& path);
+	bool WriteTrace();
+	bool AllPassed() const;
+
+protected:
+	bool ShouldRun(const std::string& name);
+
+	BenchmarkResult Measure(
+		const std::string& name,
+		const std::string& group,
+		size_t samples,
+		std::function<void()> body,
+		std::function<void()> setup = nullptr);
+
+	bool BuildFilterCase(
+		const BenchmarkCase& bc,
+		std::vector<Filter*>& filters,
+		std::set<FlowGraphNode*>& nodes,
+		std::string& error);
+	void ReleaseFilterCase(std::vector<Filter*>& filters);
+	void RunFilterCase(const BenchmarkCase& bc);
+	void RunSegmentedCase(const BenchmarkCase& bc);
+	void RunSegmentedMemoryCheck();
+	bool WriteBINFile(const std::string& path, size_t depth);
+	WaveformBase* GenerateSource(BenchmarkSource source);
+
+	void RunMicroBenchmarks();
+	void RunSchedulerBenchmarks();
+	void RunPacketStoreBenchmark();
+	void RunFFTBenchmarks();
+	void RunEdgeBenchmarks();
+	void RunPackedDigitalBenchmarks();
+	void RunMovingAverageBenchmarks();
+	void RunSCPITransportBenchmarks();
+	void RunAcquisitionBenchmarks();
+	void RunLeCroyDigitalBenchmarks();
+
+	///@brief Run settings
+	BenchmarkConfig m_config;
+
+	///@brief Results of all cases run so far
+	std::vector<BenchmarkResult> m_results;
+
+	///@brief Random number generator for the synthetic sources (fixed seed so runs are comparable)
+	std::minstd_rand m_rng;
+
+	///@brief Generator for synthetic waveforms
+	std::unique_ptr<TestWaveformSource> m_source;
+
+	///@brief Dummy instrument owning one channel per synthetic source
+	std::unique_ptr<MockOscilloscope> m_scope;
+
+	///@brief True if the waveform for each source has been generated
+	bool m_sourceReady[SOURCE_COUNT];
+
+	///@brief Executor for filter graphs
+	std::unique_ptr<FilterGraphExecutor> m_executor;
+
+	///@brief Queue for GPU work done outside the filter graph
+	std::shared_ptr<QueueHandle> m_queue;
+
+	///@brief Command pool for m_cmdBuf
+	std::unique_ptr<vk::raii::CommandPool> m_pool;
+
+	///@brief Command buffer for GPU work done outside the filter graph
+	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
+};
+
+#endif
@@ -0,0 +1,1188 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Microbenchmarks of individual kernels, outside of any filter graph
+ */
+#include "BenchmarkRunner.h"
+#include "../scopehal/CPUFFTPlan.h"
+#include "../scopehal/LeCroyOscilloscope.h"
+#include "../scopehal/base64.h"
+#include "../scopeprotocols/scopeprotocols.h"
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Top level
+
+/**
+	@brief Runs all enabled microbenchmarks
+ */
+void BenchmarkRunner::RunMicroBenchmarks()
+{
+	RunSchedulerBenchmarks();
+	RunPacketStoreBenchmark();
+	RunFFTBenchmarks();
+	RunEdgeBenchmarks();
+	RunPackedDigitalBenchmarks();
+	RunMovingAverageBenchmarks();
+	RunSCPITransportBenchmarks();
+	RunAcquisitionBenchmarks();
+	RunLeCroyDigitalBenchmarks();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Filter graph scheduling
+
+/**
+	@brief Filter which does nothing when refreshed, so a graph of them measures only scheduling overhead
+ */
+class NopBenchmarkFilter : public Filter
+{
+public:
+	NopBenchmarkFilter()
+		: Filter("#808080", CAT_MISC)
+	{
+		CreateInput("in0");
+		CreateInput("in1");
+	}
+
+	virtual string GetProtocolDisplayName() override
+	{ return "Nop"; }
+
+	virtual void Refresh() override
+	{}
+
+	virtual void Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/) override
+	{}
+};
+
+/**
+	@brief The scheduler FilterGraphExecutor used before it switched to per-worker work-stealing queues
+
+	Kept here only as a baseline for the scheduler benchmark. All workers share one mutex protecting sets of
+	incomplete, runnable and running nodes; when the runnable set is empty, the worker holding the lock scans every
+	incomplete node for one whose inputs are all complete. Completion is signaled by waking every worker.
+ */
+class LegacyGraphScheduler
+{
+public:
+	LegacyGraphScheduler(size_t numThreads)
+		: m_allWorkersComplete(true)
+		, m_terminating(false)
+	{
+		for(size_t i=0; i<numThreads; i++)
+			m_threads.push_back(thread(&LegacyGraphScheduler::WorkerThread, this));
+	}
+
+	~LegacyGraphScheduler()
+	{
+		m_terminating = true;
+		m_workerCvar.notify_all();
+		for(auto& t : m_threads)
+			t.join();
+	}
+
+	void RunBlocking(const set<FlowGraphNode*>& nodes)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_incompleteNodes = nodes;
+			m_runnableNodes.clear();
+			m_allWorkersComplete = false;
+			Filter::ClearAnalysisCache();
+		}
+
+		m_workerCvar.notify_all();
+
+		while(true)
+		{
+			unique_lock<mutex> lock(m_completionCvarMutex);
+			m_completionCvar.wait(lock, [this]{return m_allWorkersComplete.load();});
+
+			lock_guard<mutex> lock2(m_mutex);
+			if(m_runnableNodes.empty())
+				break;
+		}
+	}
+
+protected:
+	FlowGraphNode* GetNextRunnableNode()
+	{
+		while(true)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				if(m_incompleteNodes.empty())
+					return nullptr;
+
+				if(m_runnableNodes.empty())
+					UpdateRunnable();
+
+				if(!m_runnableNodes.empty())
+				{
+					auto f = *m_runnableNodes.begin();
+					m_runnableNodes.erase(f);
+					m_runningNodes.emplace(f);
+					return f;
+				}
+			}
+
+			unique_lock<mutex> lock(m_workerCvarMutex);
+			m_workerCvar.wait(lock);
+		}
+	}
+
+	void UpdateRunnable()
+	{
+		for(auto f : m_incompleteNodes)
+		{
+			if(m_runningNodes.find(f) != m_runningNodes.end())
+				continue;
+
+			bool ok = true;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				if(m_incompleteNodes.find(f->GetInput(i).m_channel) != m_incompleteNodes.end())
+				{
+					ok = false;
+					break;
+				}
+			}
+			if(ok)
+				m_runnableNodes.emplace(f);
+		}
+	}
+
+	void WorkerThread()
+	{
+		while(true)
+		{
+			{
+				unique_lock<mutex> lock(m_workerCvarMutex);
+				m_workerCvar.wait_for(lock, chrono::milliseconds(50));
+			}
+			if(m_terminating)
+				break;
+			if(m_allWorkersComplete)
+				continue;
+
+			FlowGraphNode* f;
+			while( (f = GetNextRunnableNode()) != nullptr)
+			{
+				f->Refresh();
+
+				lock_guard<mutex> lock(m_mutex);
+				m_runningNodes.erase(f);
+				m_incompleteNodes.erase(f);
+				m_workerCvar.notify_all();
+			}
+
+			bool empty;
+			{
+				lock_guard<mutex> lock(m_mutex);
+				empty = m_incompleteNodes.empty();
+			}
+			if(empty)
+			{
+				{
+					lock_guard<mutex> lock(m_completionCvarMutex);
+					m_allWorkersComplete = true;
+				}
+				m_completionCvar.notify_all();
+			}
+		}
+	}
+
+	mutex m_mutex;
+	set<FlowGraphNode*> m_incompleteNodes;
+	set<FlowGraphNode*> m_runnableNodes;
+	set<FlowGraphNode*> m_runningNodes;
+
+	mutex m_workerCvarMutex;
+	condition_variable m_workerCvar;
+
+	mutex m_completionCvarMutex;
+	condition_variable m_completionCvar;
+
+	atomic<bool> m_allWorkersComplete;
+	atomic<bool> m_terminating;
+
+	vector<thread> m_threads;
+};
+
+/**
+	@brief Compares the dispatch overhead of FilterGraphExecutor and the scheduler it replaced
+
+	Graphs are random DAGs of 10, 100 and 1000 filters which do nothing, each fed by one or two earlier filters.
+	Every iteration runs the graph 100 times, and the per-"sample" figures are per node evaluated.
+ */
+void BenchmarkRunner::RunSchedulerBenchmarks()
+{
+	const size_t passes = 100;
+
+	for(size_t size : {10, 100, 1000})
+	{
+		string suffix = " (" + to_string(size) + " nodes)";
+		bool runNew = ShouldRun("Scheduler work-stealing" + suffix);
+		bool runLegacy = ShouldRun("Scheduler legacy" + suffix);
+		if(!runNew && !runLegacy)
+			continue;
+
+		vector<Filter*> filters;
+		set<FlowGraphNode*> nodes;
+		for(size_t i=0; i<size; i++)
+		{
+			auto f = new NopBenchmarkFilter;
+			f->AddRef();
+			if(i > 0)
+				f->SetInput(0, StreamDescriptor(filters[m_rng() % i], 0));
+			if( (i > 1) && (m_rng() & 1) )
+				f->SetInput(1, StreamDescriptor(filters[m_rng() % i], 0));
+			filters.push_back(f);
+			nodes.emplace(f);
+		}
+
+		if(runNew)
+		{
+			m_results.push_back(Measure(
+				"Scheduler work-stealing" + suffix,
+				"micro",
+				size * passes,
+				[&]
+				{
+					for(size_t i=0; i<passes; i++)
+						m_executor->RunBlocking(nodes);
+				}));
+		}
+
+		if(runLegacy)
+		{
+			LegacyGraphScheduler legacy(m_config.m_threads);
+			m_results.push_back(Measure(
+				"Scheduler legacy" + suffix,
+				"micro",
+				size * passes,
+				[&]
+				{
+					for(size_t i=0; i<passes; i++)
+						legacy.RunBlocking(nodes);
+				}));
+		}
+
+		ReleaseFilterCase(filters);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packet storage
+
+/**
+	@brief Ethernet decoder fed with a capture that has already been split into bytes, standing in for the PHY layer
+
+	Each frame goes through EthernetProtocolDecoder::BytesToFrames() exactly as a PHY decoder hands it over. The
+	frame segments are cleared after every frame, since a million frames of per-byte segments would dwarf the packets
+	being measured.
+ */
+class SyntheticEthernetDecoder : public EthernetProtocolDecoder
+{
+public:
+	SyntheticEthernetDecoder(const vector<uint8_t>& capture, size_t frameLen)
+		: EthernetProtocolDecoder("#808080")
+		, m_capture(capture)
+		, m_frameLen(frameLen)
+	{}
+
+	virtual string GetProtocolDisplayName() override
+	{ return "Synthetic Ethernet"; }
+
+	virtual void Refresh() override
+	{
+		ClearPackets();
+
+		EthernetWaveform segments;
+		segments.m_timescale = 1;
+		segments.PrepareForCpuAccess();
+
+		//1 Gbps, with a 12 byte inter-frame gap
+		const int64_t byteTime = 8000;
+
+		vector<uint8_t> bytes;
+		vector<uint64_t> starts;
+		vector<uint64_t> ends;
+		int64_t t = 0;
+		for(size_t base = 0; base + m_frameLen <= m_capture.size(); base += m_frameLen)
+		{
+			bytes.assign(m_capture.begin() + base, m_capture.begin() + base + m_frameLen);
+			starts.resize(m_frameLen);
+			ends.resize(m_frameLen);
+			for(size_t i=0; i<m_frameLen; i++)
+			{
+				starts[i] = t;
+				t += byteTime;
+				ends[i] = t;
+			}
+			t += 12 * byteTime;
+
+			BytesToFrames(bytes, starts, ends, &segments);
+			segments.clear();
+		}
+	}
+
+protected:
+	const vector<uint8_t>& m_capture;
+	size_t m_frameLen;
+};
+
+/**
+	@brief Decodes a million Ethernet frames into the PacketStore, and again with every row converted to a Packet
+	object by GetPackets()
+ */
+void BenchmarkRunner::RunPacketStoreBenchmark()
+{
+	if(!ShouldRun("Ethernet decode"))
+		return;
+
+	const size_t npackets = 1000 * 1000;
+	const size_t payloadLen = 46;
+	const size_t frameLen = 8 + 6 + 6 + 2 + payloadLen + 4;
+
+	//Minimum size IPv4 frames with a unique destination MAC and a valid FCS
+	vector<uint8_t> capture(npackets * frameLen);
+	for(size_t i=0; i<npackets; i++)
+	{
+		auto p = &capture[i * frameLen];
+		size_t n = 0;
+		for(int j=0; j<7; j++)
+			p[n++] = 0x55;
+		p[n++] = 0xd5;
+
+		const uint8_t dst[6] = {0x02, 0x00, 0x00, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i};
+		const uint8_t src[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+		for(int j=0; j<6; j++)
+			p[n++] = dst[j];
+		for(int j=0; j<6; j++)
+			p[n++] = src[j];
+		p[n++] = 0x08;
+		p[n++] = 0x00;
+		for(size_t j=0; j<payloadLen; j++)
+			p[n++] = (i + j) * 37;
+
+		uint32_t crc = CRC32(p, 8, n-1);
+		p[n++] = crc >> 24;
+		p[n++] = crc >> 16;
+		p[n++] = crc >> 8;
+		p[n++] = crc;
+	}
+
+	SyntheticEthernetDecoder decoder(capture, frameLen);
+
+	auto storeResult = Measure(
+		"Ethernet decode to PacketStore (1M frames)",
+		"micro",
+		npackets,
+		[&]{ decoder.Refresh(); });
+	size_t storeBytes = decoder.GetPacketStore().GetMemoryUsage();
+	if(decoder.GetPacketCount() != npackets)
+	{
+		LogError("Ethernet decode produced %zu packets, expected %zu\n", decoder.GetPacketCount(), npackets);
+		storeResult.m_ok = false;
+	}
+	m_results.push_back(storeResult);
+
+	auto objectResult = Measure(
+		"Ethernet decode + GetPackets() (1M frames)",
+		"micro",
+		npackets,
+		[&]
+		{
+			decoder.Refresh();
+			decoder.GetPackets();
+		});
+	auto& packets = decoder.GetPackets();
+	if( (packets.size() != npackets) ||
+		(packets.back()->m_headers["Dest MAC"] != "02:00:00:0f:42:3f") ||
+		(packets.back()->m_headers["Ethertype"] != "IPv4") )
+	{
+		LogError("GetPackets() returned %zu packets which don't match the decoded frames\n", packets.size());
+		objectResult.m_ok = false;
+	}
+	m_results.push_back(objectResult);
+
+	//Every byte of a Packet lives in its own allocations, so what the conversion requested from operator new is its
+	//footprint (less allocator overhead)
+	LogNotice("PacketStore: %.1f bytes/packet (%zu MB total)\n",
+		storeBytes * 1.0 / npackets,
+		storeBytes / (1024 * 1024));
+	LogNotice("Packet objects: %.1f bytes/packet\n",
+		(objectResult.m_allocatedBytes - storeResult.m_allocatedBytes) / npackets);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FFT
+
+/**
+	@brief Compares CPUFFTPlan and VulkanFFTPlan for real forward transforms of 1K to 64M points
+
+	GPU timings include command buffer submission and waiting for completion, but not moving data to or from the GPU,
+	since a filter chain keeps its data resident there.
+ */
+void BenchmarkRunner::RunFFTBenchmarks()
+{
+	for(size_t npoints = 1024; npoints <= m_config.m_maxFFTSize; npoints *= 4)
+	{
+		size_t nouts = npoints/2 + 1;
+		string size;
+		if(npoints >= 1024*1024)
+			size = to_string(npoints / (1024*1024)) + "M";
+		else
+			size = to_string(npoints / 1024) + "K";
+
+		AcceleratorBuffer<float> in;
+		AcceleratorBuffer<float> out;
+		in.resize(npoints);
+		out.resize(2 * nouts);
+		for(size_t i=0; i<npoints; i++)
+			in[i] = sin(i * 0.01f);
+		in.MarkModifiedFromCpu();
+
+		string cpuName = "CPU FFT " + size;
+		if(ShouldRun(cpuName))
+		{
+			CPUFFTPlan plan(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+			m_results.push_back(Measure(
+				cpuName,
+				"micro",
+				npoints,
+				[&]{ plan.Forward(in, out); }));
+		}
+
+		string gpuName = "Vulkan FFT " + size;
+		if(!m_config.m_cpuOnly && ShouldRun(gpuName))
+		{
+			in.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			out.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+			VulkanFFTPlan plan(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+			m_results.push_back(Measure(
+				gpuName,
+				"micro",
+				npoints,
+				[&]
+				{
+					m_cmdBuf->begin({});
+					plan.AppendForward(in, out, *m_cmdBuf);
+					m_cmdBuf->end();
+					m_queue->SubmitAndBlock(*m_cmdBuf);
+				},
+				[&]{ in.PrepareForGpuAccess(); }));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Edge finding
+
+/**
+	@brief Times the uncached edge finding kernels on the PRBS31 source
+
+	Each kernel is timed twice: once dispatched on the CPU features actually present, and once with the AVX flags
+	cleared so the generic kernel runs, to show the speedup from vectorization.
+ */
+void BenchmarkRunner::RunEdgeBenchmarks()
+{
+	auto wfm = dynamic_cast<UniformAnalogWaveform*>(GenerateSource(SOURCE_PRBS31));
+	if(!wfm)
+		return;
+	wfm->PrepareForCpuAccess();
+
+	bool hasAvx2 = g_hasAvx2;
+	bool hasAvx512F = g_hasAvx512F;
+
+	vector<int64_t> edges;
+	for(bool generic : {false, true})
+	{
+		string suffix = generic ? " generic (PRBS31)" : " (PRBS31)";
+
+		//Nothing else is running, so it's safe to pretend the CPU has no vector extensions for a while
+		if(generic)
+		{
+			g_hasAvx2 = false;
+			g_hasAvx512F = false;
+		}
+
+		if(ShouldRun("FindZeroCrossings" + suffix))
+		{
+			m_results.push_back(Measure(
+				"FindZeroCrossings" + suffix,
+				"micro",
+				wfm->size(),
+				[&]{ Filter::FindZeroCrossings(wfm, 0, edges); },
+				[&]{ edges.clear(); }));
+		}
+
+		if(ShouldRun("FindRisingEdges" + suffix))
+		{
+			m_results.push_back(Measure(
+				"FindRisingEdges" + suffix,
+				"micro",
+				wfm->size(),
+				[&]{ Filter::FindRisingEdges(wfm, 0, edges); },
+				[&]{ edges.clear(); }));
+		}
+
+		g_hasAvx2 = hasAvx2;
+		g_hasAvx512F = hasAvx512F;
+	}
+}
+
+/**
+	@brief Compares edge finding on byte-per-sample and packed digital waveforms, and checks they agree
+
+	The signal toggles at random with an average run length of 16 samples, which is typical of a busy logic analyzer
+	channel.
+ */
+void BenchmarkRunner::RunPackedDigitalBenchmarks()
+{
+	size_t depth = m_config.m_depth;
+	UniformDigitalWaveform uwfm;
+	uwfm.m_timescale = 1000;
+	uwfm.Resize(depth);
+	uwfm.PrepareForCpuAccess();
+	bool value = false;
+	for(size_t i=0; i<depth; i++)
+	{
+		if( (m_rng() & 15) == 0)
+			value = !value;
+		uwfm.m_samples[i] = value;
+	}
+	uwfm.MarkModifiedFromCpu();
+
+	PackedDigitalWaveform pwfm;
+	if(ShouldRun("Pack digital waveform"))
+	{
+		m_results.push_back(Measure(
+			"Pack digital waveform",
+			"micro",
+			depth,
+			[&]{ pwfm.Pack(uwfm); }));
+	}
+	pwfm.Pack(uwfm);
+	LogNotice("Digital waveform storage: %zu bytes unpacked, %zu bytes packed\n",
+		depth, pwfm.m_words.size() * sizeof(uint64_t));
+
+	vector<int64_t> uedges;
+	if(ShouldRun("Digital FindZeroCrossings unpacked"))
+	{
+		m_results.push_back(Measure(
+			"Digital FindZeroCrossings unpacked",
+			"micro",
+			depth,
+			[&]{ Filter::FindZeroCrossings(&uwfm, uedges); },
+			[&]{ uedges.clear(); }));
+	}
+
+	vector<int64_t> pedges;
+	if(ShouldRun("Digital FindZeroCrossings packed"))
+	{
+		auto result = Measure(
+			"Digital FindZeroCrossings packed",
+			"micro",
+			depth,
+			[&]{ Filter::FindZeroCrossings(&pwfm, pedges); },
+			[&]{ pedges.clear(); });
+
+		//Both searches must report exactly the same edges
+		uedges.clear();
+		pedges.clear();
+		Filter::FindZeroCrossings(&uwfm, uedges);
+		Filter::FindZeroCrossings(&pwfm, pedges);
+		if(uedges != pedges)
+		{
+			LogError("Packed edge search found %zu edges, unpacked found %zu\n", pedges.size(), uedges.size());
+			result.m_ok = false;
+		}
+		m_results.push_back(result);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Averaging
+
+/**
+	@brief Times the moving average kernel over a range of window sizes
+
+	Cost per sample should be flat with depth.
+ */
+void BenchmarkRunner::RunMovingAverageBenchmarks()
+{
+	auto wfm = dynamic_cast<UniformAnalogWaveform*>(GenerateSource(SOURCE_SINE));
+	if(!wfm)
+		return;
+	wfm->PrepareForCpuAccess();
+
+	const size_t depths[] = {2, 10, 100, 1000, 10000};
+	vector<float, AlignedAllocator<float, 64> > avg;
+	for(auto depth : depths)
+	{
+		if(wfm->size() <= depth)
+			continue;
+
+		string name = "MovingAverageSamples depth " + to_string(depth);
+		if(!ShouldRun(name))
+			continue;
+
+		size_t nout = wfm->size() - depth + 1;
+		avg.resize(nout);
+		m_results.push_back(Measure(
+			name,
+			"micro",
+			nout,
+			[&]{ Filter::MovingAverageSamples(wfm->m_samples.GetCpuPointer(), avg.data(), nout, depth); }));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waveform download
+
+#ifndef _WIN32
+
+/**
+	@brief Minimal SCPI server on the loopback interface, which answers every line it receives with the same canned
+	reply
+ */
+class MockSCPIServer
+{
+public:
+	MockSCPIServer(const string& reply)
+		: m_listenSocket(-1)
+		, m_port(0)
+		, m_reply(reply)
+	{
+		//Bind to an ephemeral port
+		m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if(m_listenSocket < 0)
+			return;
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		socklen_t addrlen = sizeof(addr);
+		if( (0 != ::bind(m_listenSocket, (sockaddr*)&addr, sizeof(addr))) ||
+			(0 != listen(m_listenSocket, 1)) ||
+			(0 != getsockname(m_listenSocket, (sockaddr*)&addr, &addrlen)) )
+		{
+			close(m_listenSocket);
+			m_listenSocket = -1;
+			return;
+		}
+		m_port = ntohs(addr.sin_port);
+
+		m_thread = thread(&MockSCPIServer::ServerThread, this);
+	}
+
+	~MockSCPIServer()
+	{
+		//Client disconnecting ends the server thread
+		if(m_thread.joinable())
+			m_thread.join();
+		if(m_listenSocket >= 0)
+			close(m_listenSocket);
+	}
+
+	///@brief Gets the port we're listening on, or zero if the server couldn't be started
+	unsigned short GetPort()
+	{ return m_port; }
+
+	/**
+		@brief Makes a reply consisting of an IEEE 488.2 definite-length block of canned sample data and a newline
+	 */
+	static string MakeBlockReply(size_t blocksize)
+	{
+		string header = "#9" + string(9 - to_string(blocksize).length(), '0') + to_string(blocksize);
+		string reply = header;
+		reply.resize(header.length() + blocksize);
+		for(size_t i=0; i<blocksize; i++)
+			reply[header.length() + i] = (char)(i & 0xff);
+		reply += "\n";
+		return reply;
+	}
+
+protected:
+	void ServerThread()
+	{
+		int client = accept(m_listenSocket, nullptr, nullptr);
+		if(client < 0)
+			return;
+
+		char c;
+		while(1 == recv(client, &c, 1, 0))
+		{
+			if(c != '\n')
+				continue;
+
+			size_t off = 0;
+			while(off < m_reply.length())
+			{
+				auto n = send(client, m_reply.data() + off, m_reply.length() - off, MSG_NOSIGNAL);
+				if(n <= 0)
+					break;
+				off += n;
+			}
+		}
+		close(client);
+	}
+
+	///@brief Socket we accept the connection on
+	int m_listenSocket;
+
+	///@brief Port we're listening on
+	unsigned short m_port;
+
+	///@brief Reply sent for each line received
+	string m_reply;
+
+	///@brief Thread serving the one client connection
+	thread m_thread;
+};
+
+#endif
+
+/**
+	@brief Measures SCPISocketTransport throughput in MB/s for text replies and binary blocks from a loopback server
+
+	Text is read both as many short lines (typical query replies, where per-call overhead dominates) and as one long
+	line (ASCII waveform formats). Blocks are read with ReadRawData(), parsing the header by hand as older drivers do,
+	and with ReadBlock(). The per-"sample" figures are per byte, so Msamples/s is MB/s.
+ */
+void BenchmarkRunner::RunSCPITransportBenchmarks()
+{
+#ifdef _WIN32
+	LogNotice("Skipping SCPI transport benchmarks (mock SCPI server not supported on Windows)\n");
+#else
+	const size_t textSize = 4*1024*1024;
+	size_t blockSize = m_config.m_depth;
+
+	//Reports a result in MB/s as well as the usual units
+	auto report = [&](BenchmarkResult result)
+	{
+		if(result.m_medianTime > 0)
+			LogNotice("%s: %.1f MB/s\n", result.m_name.c_str(), result.m_samples * 1e-6 / result.m_medianTime);
+		m_results.push_back(result);
+	};
+
+	string shortName = "SCPI ReadReply 64-byte lines";
+	if(ShouldRun(shortName))
+	{
+		const size_t lineLen = 64;
+		const size_t nlines = textSize / lineLen;
+		string line = string(lineLen - 1, '1') + "\n";
+		string reply;
+		for(size_t i=0; i<nlines; i++)
+			reply += line;
+
+		MockSCPIServer server(reply);
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			report(Measure(
+				shortName,
+				"micro",
+				reply.length(),
+				[&]
+				{
+					transport.SendCommand("DATA?");
+					for(size_t i=0; i<nlines; i++)
+						transport.ReadReply();
+				}));
+		}
+	}
+
+	string longName = "SCPI ReadReply 4 MB line";
+	if(ShouldRun(longName))
+	{
+		string reply;
+		reply.reserve(textSize + 16);
+		while(reply.length() < textSize)
+			reply += "-1.234567E-03,";
+		reply += "0\n";
+
+		MockSCPIServer server(reply);
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			report(Measure(
+				longName,
+				"micro",
+				reply.length(),
+				[&]
+				{
+					transport.SendCommand("DATA?");
+					transport.ReadReply();
+				}));
+		}
+	}
+
+	string rawName = "SCPI ReadRawData block";
+	if(ShouldRun(rawName))
+	{
+		MockSCPIServer server(MockSCPIServer::MakeBlockReply(blockSize));
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			vector<unsigned char> buf(blockSize);
+			report(Measure(
+				rawName,
+				"micro",
+				blockSize,
+				[&]
+				{
+					transport.SendCommand("WAV:DATA?");
+
+					//"#9" followed by nine digits of length
+					char header[12] = {0};
+					transport.ReadRawData(11, reinterpret_cast<unsigned char*>(header));
+					size_t len = min((size_t)stoull(header + 2), buf.size());
+					transport.ReadRawData(len, buf.data());
+
+					unsigned char nl;
+					transport.ReadRawData(1, &nl);
+				}));
+		}
+	}
+
+	string blockName = "SCPI ReadBlock block";
+	if(ShouldRun(blockName))
+	{
+		MockSCPIServer server(MockSCPIServer::MakeBlockReply(blockSize));
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			AcceleratorBuffer<uint8_t> raw;
+			raw.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_UNLIKELY);
+			report(Measure(
+				blockName,
+				"micro",
+				blockSize,
+				[&]
+				{
+					transport.SendCommand("WAV:DATA?");
+					transport.ReadBlock(raw);
+					unsigned char nl;
+					transport.ReadRawData(1, &nl);
+				}));
+		}
+	}
+#endif
+}
+
+/**
+	@brief Compares downloading and converting four 8-bit channels in sequence against overlapping the two with an
+	AcquisitionPipeline
+
+	The blocks come from a mock SCPI server on the loopback interface, so the "instrument" is much faster than any real
+	one and the comparison shows the best case for overlap when link and conversion speeds are similar.
+ */
+void BenchmarkRunner::RunAcquisitionBenchmarks()
+{
+#ifdef _WIN32
+	LogNotice("Skipping acquisition benchmarks (mock SCPI server not supported on Windows)\n");
+#else
+	const size_t nchans = 4;
+	size_t depth = m_config.m_depth;
+	float gain = 0.01f;
+	float offset = 0;
+
+	vector<UniformAnalogWaveform*> caps;
+	for(size_t i=0; i<nchans; i++)
+	{
+		auto cap = new UniformAnalogWaveform;
+		cap->Resize(depth);
+		caps.push_back(cap);
+	}
+
+	//Sequential download and conversion, as drivers did before AcquisitionPipeline
+	string seqName = "SCPI download sequential";
+	if(ShouldRun(seqName))
+	{
+		MockSCPIServer server(MockSCPIServer::MakeBlockReply(depth));
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			AcceleratorBuffer<uint8_t> raw;
+			raw.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_UNLIKELY);
+
+			auto result = Measure(
+				seqName,
+				"micro",
+				nchans * depth,
+				[&]
+				{
+					for(auto cap : caps)
+					{
+						transport.SendCommand("WAV:DATA?");
+						if(!transport.ReadBlock(raw))
+							continue;
+						unsigned char nl;
+						transport.ReadRawData(1, &nl);
+
+						cap->PrepareForCpuAccess();
+						Oscilloscope::Convert8BitSamples(
+							cap->m_samples.GetCpuPointer(),
+							reinterpret_cast<const int8_t*>(raw.GetCpuPointer()),
+							gain,
+							offset,
+							raw.size());
+						cap->MarkSamplesModifiedFromCpu();
+					}
+				});
+			if(result.m_medianTime > 0)
+				LogNotice("%s: %.1f waveforms/s\n", seqName.c_str(), nchans / result.m_medianTime);
+			m_results.push_back(result);
+		}
+	}
+
+	//Same thing through the pipeline
+	string pipeName = "SCPI download pipelined";
+	if(ShouldRun(pipeName))
+	{
+		MockSCPIServer server(MockSCPIServer::MakeBlockReply(depth));
+		if(server.GetPort())
+		{
+			SCPISocketTransport transport("127.0.0.1", server.GetPort());
+			AcquisitionPipeline pipeline;
+
+			auto result = Measure(
+				pipeName,
+				"micro",
+				nchans * depth,
+				[&]
+				{
+					for(auto cap : caps)
+					{
+						transport.SendCommand("WAV:DATA?");
+						size_t len;
+						auto buf = pipeline.ReadBlock(&transport, len);
+						if(!buf)
+							continue;
+						unsigned char nl;
+						transport.ReadRawData(1, &nl);
+
+						pipeline.Submit(buf, len, [cap, gain, offset](const uint8_t* data, size_t count)
+							{
+								cap->PrepareForCpuAccess();
+								Oscilloscope::Convert8BitSamples(
+									cap->m_samples.GetCpuPointer(),
+									reinterpret_cast<const int8_t*>(data),
+									gain,
+									offset,
+									count);
+								cap->MarkSamplesModifiedFromCpu();
+							});
+					}
+					pipeline.Flush();
+				});
+			if(result.m_medianTime > 0)
+				LogNotice("%s: %.1f waveforms/s\n", pipeName.c_str(), nchans / result.m_medianTime);
+			m_results.push_back(result);
+		}
+	}
+
+	for(auto cap : caps)
+		delete cap;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LeCroy digital download
+
+/**
+	@brief Base64 encodes a buffer, for building synthetic LeCroy digital blocks
+ */
+static string Base64Encode(const vector<uint8_t>& data)
+{
+	static const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	string ret;
+	ret.reserve((data.size() + 2) / 3 * 4);
+	for(size_t i=0; i<data.size(); i += 3)
+	{
+		uint32_t v = data[i] << 16;
+		if(i+1 < data.size())
+			v |= data[i+1] << 8;
+		if(i+2 < data.size())
+			v |= data[i+2];
+
+		ret += digits[(v >> 18) & 0x3f];
+		ret += digits[(v >> 12) & 0x3f];
+		ret += (i+1 < data.size()) ? digits[(v >> 6) & 0x3f] : '=';
+		ret += (i+2 < data.size()) ? digits[v & 0x3f] : '=';
+	}
+	return ret;
+}
+
+/**
+	@brief Times the stages of LeCroyOscilloscope::ProcessDigitalWaveform(): base64 decoding (libb64 vs the fast
+	decoder) and unpacking of lanes into sparse waveforms (sequential vs parallel)
+
+	Uses the captured block given by --lecroy-digital if any, otherwise a synthetic 16-lane block of --depth samples
+	per lane with a counter pattern on the lanes.
+ */
+void BenchmarkRunner::RunLeCroyDigitalBenchmarks()
+{
+	string xml;
+	if(!m_config.m_lecroyDigitalPath.empty())
+	{
+		ifstream in(m_config.m_lecroyDigitalPath, ios::binary);
+		if(!in)
+		{
+			LogError("Couldn't open %s\n", m_config.m_lecroyDigitalPath.c_str());
+			return;
+		}
+		stringstream ss;
+		ss << in.rdbuf();
+		xml = ss.str();
+	}
+	else
+	{
+		const size_t nlanes = 16;
+		size_t depth = m_config.m_depth;
+		vector<uint8_t> raw(nlanes * depth);
+		for(size_t i=0; i<nlanes; i++)
+		{
+			for(size_t j=0; j<depth; j++)
+				raw[i*depth + j] = (j >> (i+1)) & 1;
+		}
+
+		xml =
+			"SelectedLines=1111111111111111\n<NumSamples>" + to_string(depth) + "</NumSamples>"
+			"<BinaryData>" + Base64Encode(raw) + "</BinaryData>";
+	}
+
+	//Find the data
+	auto b64 = LeCroyOscilloscope::FindXmlTag(xml, "BinaryData");
+	size_t num_samples = atoi(string(LeCroyOscilloscope::FindXmlTag(xml, "NumSamples")).c_str());
+	size_t nlanes = 0;
+	size_t linepos = xml.find("SelectedLines=");
+	if(linepos != string::npos)
+	{
+		for(size_t i=0; (i < 16) && (linepos + 14 + i < xml.length()); i++)
+		{
+			if(xml[linepos + 14 + i] == '1')
+				nlanes ++;
+		}
+	}
+	if(b64.empty() || (num_samples == 0) || (nlanes == 0))
+	{
+		LogError("No digital waveform data found, skipping LeCroy digital benchmarks\n");
+		return;
+	}
+	size_t total = nlanes * num_samples;
+	LogNotice("LeCroy digital block: %zu lanes, %zu samples per lane, %zu bytes of base64\n",
+		nlanes, num_samples, b64.length());
+
+	vector<unsigned char> block(b64.length() + 1);
+	size_t blocklen = 0;
+	if(ShouldRun("LeCroy digital base64 libb64"))
+	{
+		m_results.push_back(Measure(
+			"LeCroy digital base64 libb64",
+			"micro",
+			total,
+			[&]
+			{
+				base64_decodestate bstate;
+				base64_init_decodestate(&bstate);
+				base64_decode_block(b64.data(), b64.length(), reinterpret_cast<char*>(block.data()), &bstate);
+			}));
+	}
+
+	if(ShouldRun("LeCroy digital base64 fast"))
+	{
+		m_results.push_back(Measure(
+			"LeCroy digital base64 fast",
+			"micro",
+			total,
+			[&]{ blocklen = base64_decode_fast(b64.data(), b64.length(), block.data()); }));
+	}
+
+	//Unpacking needs decoded data whether or not we timed the decoding
+	blocklen = base64_decode_fast(b64.data(), b64.length(), block.data());
+	if(blocklen < total)
+	{
+		LogError("Digital block decoded to %zu bytes, expected %zu\n", blocklen, total);
+		return;
+	}
+
+	vector<SparseDigitalWaveform*> caps;
+	for(size_t i=0; i<nlanes; i++)
+		caps.push_back(new SparseDigitalWaveform);
+
+	if(ShouldRun("LeCroy digital unpack sequential"))
+	{
+		m_results.push_back(Measure(
+			"LeCroy digital unpack sequential",
+			"micro",
+			total,
+			[&]
+			{
+				for(size_t i=0; i<nlanes; i++)
+					LeCroyOscilloscope::UnpackDigitalLane(caps[i], block.data() + i*num_samples, num_samples);
+			}));
+	}
+
+	if(ShouldRun("LeCroy digital unpack parallel"))
+	{
+		m_results.push_back(Measure(
+			"LeCroy digital unpack parallel",
+			"micro",
+			total,
+			[&]
+			{
+				#pragma omp parallel for
+				for(size_t i=0; i<nlanes; i++)
+					LeCroyOscilloscope::UnpackDigitalLane(caps[i], block.data() + i*num_samples, num_samples);
+			}));
+	}
+
+	for(auto cap : caps)
+		delete cap;
+}
@@ -0,0 +1,174 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Process resource usage helpers for scopehal-bench
+
+	The global operator new / delete are replaced here so that every C++ heap allocation in the process (including
+	those made inside libscopehal and libscopeprotocols) is counted. Allocations made directly with malloc, aligned
+	allocators, or the Vulkan driver are not included.
+ */
+#include "ResourceUsage.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+///@brief Number of calls to operator new
+static atomic<uint64_t> g_allocationCount(0);
+
+///@brief Number of bytes requested from operator new
+static atomic<uint64_t> g_allocationBytes(0);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+
+void* operator new(size_t size)
+{
+	g_allocationCount.fetch_add(1, memory_order_relaxed);
+	g_allocationBytes.fetch_add(size, memory_order_relaxed);
+
+	void* p = malloc(size ? size : 1);
+	if(!p)
+		throw bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t /*size*/) noexcept
+{
+	free(p);
+}
+
+/**
+	@brief Gets the current values of the allocation counters
+ */
+AllocationCounters GetAllocationCounters()
+{
+	AllocationCounters ret;
+	ret.m_count = g_allocationCount.load(memory_order_relaxed);
+	ret.m_bytes = g_allocationBytes.load(memory_order_relaxed);
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Memory usage
+
+/**
+	@brief Resets the peak resident set size, if the OS supports it
+
+	On Linux, writing 5 to /proc/self/clear_refs resets the high water mark reported as VmHWM. Elsewhere this is a
+	no-op and GetPeakRSS() reports the peak since process startup.
+ */
+void ResetPeakRSS()
+{
+#ifdef __linux__
+	FILE* fp = fopen("/proc/self/clear_refs", "w");
+	if(fp)
+	{
+		fputs("5", fp);
+		fclose(fp);
+	}
+#endif
+}
+
+/**
+	@brief Gets the peak resident set size of the process, in bytes
+ */
+size_t GetPeakRSS()
+{
+#ifdef __linux__
+	//VmHWM respects ResetPeakRSS(), ru_maxrss does not
+	FILE* fp = fopen("/proc/self/status", "r");
+	if(fp)
+	{
+		char line[256];
+		size_t kb = 0;
+		while(fgets(line, sizeof(line), fp))
+		{
+			if(!strncmp(line, "VmHWM:", 6))
+			{
+				kb = strtoull(line + 6, nullptr, 10);
+				break;
+			}
+		}
+		fclose(fp);
+		if(kb)
+			return kb * 1024;
+	}
+#endif
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	return usage.ru_maxrss * 1024;
+#endif
+#endif
+}
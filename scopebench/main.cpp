@@ -0,0 +1,182 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* scopehal-bench                                                                                                       *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Program entry point for scopehal-bench
+
+	Builds filter graphs on synthetic waveforms, runs them through FilterGraphExecutor, and reports throughput,
+	peak memory and heap allocations for each. Used to catch performance regressions in libscopehal and the filters.
+ */
+#include "BenchmarkRunner.h"
+#include "../scopeprotocols/scopeprotocols.h"
+
+using namespace std;
+
+void PrintUsage();
+
+int main(int argc, char* argv[])
+{
+	Severity console_verbosity = Severity::NOTICE;
+
+	BenchmarkConfig config;
+	string jsonPath;
+	bool listOnly = false;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
+			continue;
+
+		if( (s == "--help") || (s == "-h") )
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if(s == "--cpu-only")
+			config.m_cpuOnly = true;
+		else if(s == "--list")
+			listOnly = true;
+		else if(s == "--no-micro")
+			config.m_runMicro = false;
+		else if(s == "--no-filters")
+			config.m_runFilters = false;
+		else if(i+1 < argc)
+		{
+			string arg(argv[++i]);
+			if(s == "--json")
+				jsonPath = arg;
+			else if(s == "--depth")
+				config.m_depth = stoull(arg);
+			else if(s == "--iterations")
+				config.m_iterations = stoull(arg);
+			else if(s == "--threads")
+				config.m_threads = stoull(arg);
+			else if(s == "--filter")
+				config.m_filter = arg;
+			else if(s == "--max-fft")
+				config.m_maxFFTSize = stoull(arg);
+			else if(s == "--chrome-trace")
+				config.m_tracePath = arg;
+			else if(s == "--lecroy-digital")
+				config.m_lecroyDigitalPath = arg;
+			else
+			{
+				fprintf(stderr, "Unrecognized command-line argument \"%s\"\n\n", s.c_str());
+				PrintUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unrecognized command-line argument \"%s\"\n\n", s.c_str());
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(console_verbosity));
+
+	if(listOnly)
+	{
+		for(auto& bc : BenchmarkRunner::GetFilterCases())
+			LogNotice("%s\n", bc.m_name.c_str());
+		for(auto& bc : BenchmarkRunner::GetSegmentedCases())
+			LogNotice("%s\n", bc.m_name.c_str());
+		return 0;
+	}
+
+	//Set up the library. We never open a window, so skip GLFW
+	if(!VulkanInit(true))
+	{
+		LogError("Failed to initialize Vulkan\n");
+		return 1;
+	}
+	TransportStaticInit();
+	DriverStaticInit();
+	InitializePlugins();
+	ScopeProtocolStaticInit();
+
+	//Route filters through their CPU implementations, for comparison or for machines with only a software renderer
+	if(config.m_cpuOnly)
+		g_gpuFilterEnabled = false;
+
+	LogNotice("scopehal-bench, libscopehal %s\n", ScopehalGetVersion());
+	LogNotice("Depth %zu samples, %zu iterations, %zu threads%s\n",
+		config.m_depth,
+		config.m_iterations,
+		config.m_threads,
+		config.m_cpuOnly ? ", CPU only" : "");
+
+	int ret = 0;
+	{
+		BenchmarkRunner runner(config);
+		runner.Run();
+		runner.PrintSummary();
+
+		//Segmented cases double as a check that segmented execution matches a single pass
+		if(!runner.AllPassed())
+			ret = 1;
+
+		if(!jsonPath.empty() && !runner.WriteJSON(jsonPath))
+			ret = 1;
+		if(!runner.WriteTrace())
+			ret = 1;
+	}
+
+	ScopehalStaticCleanup();
+	return ret;
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: scopehal-bench [options]\n"
+		"\n"
+		"    --json <file>       Write results to a JSON file\n"
+		"    --depth <n>         Samples per synthetic input waveform (default 10000000)\n"
+		"    --iterations <n>    Timed iterations per case (default 5)\n"
+		"    --threads <n>       Filter graph worker threads (default 8)\n"
+		"    --filter <text>     Only run cases whose name contains <text>\n"
+		"    --max-fft <n>       Largest FFT size to benchmark (default 67108864)\n"
+		"    --chrome-trace <file>\n"
+		"                        Write a Chrome trace of the last 64 filter graph passes\n"
+		"    --lecroy-digital <file>\n"
+		"                        Benchmark decoding of a captured LeCroy digital waveform block\n"
+		"                        instead of a synthetic 16-lane one\n"
+		"    --cpu-only          Run filters on their CPU implementations and skip GPU microbenchmarks\n"
+		"    --no-filters        Skip filter graph cases\n"
+		"    --no-micro          Skip kernel microbenchmarks\n"
+		"    --list              List filter graph cases and exit\n"
+		"\n"
+		"Standard logging options (--debug, --trace, --quiet etc) are also accepted.\n");
+}
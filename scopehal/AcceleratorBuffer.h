@@ -37,6 +37,7 @@
 
 #include "AlignedAllocator.h"
 #include "QueueManager.h"
+#include "AcceleratorTransfer.h"
 
 #ifdef _WIN32
 #undef MemoryBarrier
@@ -94,6 +95,25 @@ typedef bool (*MemoryPressureHandler)(MemoryPressureLevel level, MemoryPressureT
 
 bool OnMemoryPressure(MemoryPressureLevel level, MemoryPressureType type, size_t requestedSize);
 
+/**
+	@brief Running totals of data copied between CPU and GPU memory by AcceleratorBuffer on one thread
+
+	Used by FilterGraphExecutor to attribute transfers to the filter that caused them.
+ */
+struct AcceleratorTransferCounters
+{
+	///@brief Bytes copied from GPU to CPU memory
+	uint64_t m_bytesToCpu;
+
+	///@brief Bytes copied from CPU to GPU memory
+	uint64_t m_bytesToGpu;
+
+	///@brief Time spent blocked waiting for copies to complete, in nanoseconds
+	uint64_t m_nsBlocked;
+};
+
+AcceleratorTransferCounters& GetAcceleratorTransferCounters();
+
 template<class T>
 class AcceleratorBufferIterator
 {
@@ -278,6 +298,17 @@ protected:
 	///@brief True if m_gpuPhysMem contains stale data (m_cpuPtr has been modified and they point to different memory)
 	bool m_gpuPhysMemIsStale;
 
+	/**
+		@brief Copy started by PrepareForCpuAccessAsync() or PrepareForGpuAccessAsync() which may still be in flight
+
+		The staleness flags are updated as soon as the copy is submitted, so anything which touches either side of the
+		buffer must call WaitForPendingTransfer() first.
+
+		Several filters sharing one input may prepare it for access at the same time, so this pointer is only ever
+		read or written through std::atomic_load / std::atomic_store / std::atomic_compare_exchange_strong.
+	 */
+	mutable std::shared_ptr<AcceleratorTransfer> m_pendingTransfer;
+
 	///@brief File handle used for MEM_TYPE_CPU_PAGED
 #ifndef _WIN32
 	int m_tempFileHandle;
@@ -327,6 +358,7 @@ public:
 		, m_buffersAreSame(false)
 		, m_cpuPhysMemIsStale(false)
 		, m_gpuPhysMemIsStale(false)
+		, m_pendingTransfer(nullptr)
 		#ifndef _WIN32
 		, m_tempFileHandle(0)
 		#endif
@@ -496,12 +528,32 @@ public:
 			Reallocate(m_size);
 	}
 
+	/**
+		@brief Drops the resident pages of a MEM_TYPE_CPU_PAGED buffer
+
+		The content stays in the backing file and is faulted back in on next access, so a large paged buffer which is
+		written a piece at a time doesn't keep growing the resident set of the process. No effect on other memory
+		types.
+	 */
+	void PageOut()
+	{
+		#ifdef __linux__
+			//On a shared file mapping this only unmaps the pages, dirty ones are still written back to the file
+			if( (m_cpuMemoryType == MEM_TYPE_CPU_PAGED) && (m_cpuPtr != nullptr) )
+				madvise(m_cpuPtr, m_capacity * sizeof(T), MADV_DONTNEED);
+		#endif
+	}
+
 	/**
 		@brief Copies our content from another AcceleratorBuffer
 	 */
 	 __attribute__((noinline))
 	void CopyFrom(const AcceleratorBuffer<T>& rhs)
 	{
+		//Make sure neither buffer has a copy in flight
+		WaitForPendingTransfer();
+		rhs.WaitForPendingTransfer();
+
 		//Copy placement hints from the other instance, then resize to match
 		SetCpuAccessHint(rhs.m_cpuAccessHint);
 		SetGpuAccessHint(rhs.m_gpuAccessHint, true);
@@ -535,7 +587,7 @@ public:
 			g_vkTransferCommandBuffer->end();
 
 			//Submit the request and block until it completes
-			g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+			AcceleratorTransfer::SubmitAndBlock(*g_vkTransferCommandBuffer);
 		}
 		m_gpuPhysMemIsStale = rhs.m_gpuPhysMemIsStale;
 	}
@@ -551,6 +603,9 @@ protected:
 		if(size == 0)
 			return;
 
+		//Don't move memory out from under an in-flight copy
+		WaitForPendingTransfer();
+
 		/*
 			If we are a bool[] or similar one-byte type, we are likely going to be accessed from the GPU via a uint32
 			descriptor for at least some shaders (such as rendering).
@@ -576,10 +631,13 @@ protected:
 
 		else
 		{
-			//Resize CPU memory
-			//TODO: optimization, when expanding a MEM_TYPE_CPU_PAGED we can just enlarge the file
-			//and not have to make a new temp file and copy the content
-			if(m_cpuPtr != nullptr)
+			//Resize CPU memory.
+			//A MEM_TYPE_CPU_PAGED buffer which is staying paged just has its file enlarged and mapped again, so
+			//growing it a piece at a time doesn't copy (and page in) the whole content each time
+			if(CanGrowPagedBuffer(size))
+				GrowPagedBuffer(size);
+
+			else if(m_cpuPtr != nullptr)
 			{
 				//Save the old pointer
 				auto pOld = m_cpuPtr;
@@ -663,7 +721,7 @@ protected:
 					g_vkTransferCommandBuffer->end();
 
 					//Submit the request and block until it completes
-					g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+					AcceleratorTransfer::SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 					//make sure buffer is freed before underlying physical memory (pOld) goes out of scope
 					bOld = nullptr;
@@ -798,6 +856,39 @@ public:
 		MarkModifiedFromCpu();
 	}
 
+	/**
+		@brief Removes the first count items in the container with a single move of the remaining data
+
+		@param count	Number of items to remove (clamped to the size of the container)
+	 */
+	void pop_front(size_t count)
+	{
+		if(count >= m_size)
+		{
+			clear();
+			return;
+		}
+		if(count == 0)
+			return;
+
+		//Don't touch GPU side buffer
+
+		PrepareForCpuAccess();
+
+		size_t remaining = m_size - count;
+		if(!std::is_trivially_copyable<T>::value)
+		{
+			for(size_t i=0; i<remaining; i++)
+				m_cpuPtr[i] = std::move(m_cpuPtr[i+count]);
+		}
+		else
+			memmove(m_cpuPtr, m_cpuPtr+count, sizeof(T) * remaining);
+
+		resize(remaining);
+
+		MarkModifiedFromCpu();
+	}
+
 	AcceleratorBufferIterator<T> begin()
 	{ return AcceleratorBufferIterator<T>(*this, 0); }
 
@@ -876,6 +967,8 @@ public:
 	 */
 	void PrepareForCpuAccess()
 	{
+		WaitForPendingTransfer();
+
 		//Early out if no content
 		if(m_size == 0)
 			return;
@@ -898,6 +991,8 @@ public:
 	 */
 	void PrepareForGpuAccess(bool outputOnly = false)
 	{
+		WaitForPendingTransfer();
+
 		//Early out if no content or if unified memory
 		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
 			return;
@@ -925,6 +1020,8 @@ public:
 	 */
 	void PrepareForGpuAccessNonblocking(bool outputOnly, vk::raii::CommandBuffer& cmdBuf)
 	{
+		WaitForPendingTransfer();
+
 		//Early out if no content or if unified memory
 		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
 			return;
@@ -942,6 +1039,71 @@ public:
 			CopyToGpuNonblocking(cmdBuf);
 	}
 
+	/**
+		@brief Starts bringing the CPU-side buffer up to date, without waiting for the copy to complete
+
+		The CPU-side buffer must not be touched until the copy completes. PrepareForCpuAccess(), and anything which
+		reallocates or frees the buffer, waits for it automatically.
+
+		@return The in-flight copy, or nullptr if the CPU-side buffer was already up to date
+	 */
+	std::shared_ptr<AcceleratorTransfer> PrepareForCpuAccessAsync()
+	{
+		//Early out if no content
+		if(m_size == 0)
+			return std::atomic_load(&m_pendingTransfer);
+
+		//If there's no buffer at all on the CPU, allocate one
+		if(!HasCpuBuffer() && (m_gpuMemoryType != MEM_TYPE_GPU_DMA_CAPABLE))
+			AllocateCpuBuffer(m_capacity);
+
+		if(m_cpuPhysMemIsStale)
+			CopyToCpuAsync();
+		return std::atomic_load(&m_pendingTransfer);
+	}
+
+	/**
+		@brief Starts bringing the GPU-side buffer up to date, without waiting for the copy to complete
+
+		The GPU-side buffer must not be used until the copy completes. PrepareForGpuAccess(), and anything which
+		reallocates or frees the buffer, waits for it automatically.
+
+		@return The in-flight copy, or nullptr if the GPU-side buffer was already up to date
+	 */
+	std::shared_ptr<AcceleratorTransfer> PrepareForGpuAccessAsync()
+	{
+		//Early out if no content or if unified memory
+		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
+			return std::atomic_load(&m_pendingTransfer);
+
+		//If our current hint has no GPU access at all, update to say "unlikely" and reallocate
+		if(m_gpuAccessHint == HINT_NEVER)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//If we don't have a buffer, allocate one unless our CPU buffer is pinned and GPU-readable
+		if(!HasGpuBuffer() && (m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE) )
+			AllocateGpuBuffer(m_capacity);
+
+		if(m_gpuPhysMemIsStale)
+			CopyToGpuAsync();
+		return std::atomic_load(&m_pendingTransfer);
+	}
+
+	/**
+		@brief Blocks until any copy started by PrepareForCpuAccessAsync() or PrepareForGpuAccessAsync() completes
+	 */
+	void WaitForPendingTransfer() const
+	{
+		//Hold our own reference while waiting, so another thread clearing the pointer can't free the transfer
+		//out from under us. Only clear it if nobody has started a new copy in the meantime.
+		auto transfer = std::atomic_load(&m_pendingTransfer);
+		if(transfer)
+		{
+			transfer->Wait();
+			std::atomic_compare_exchange_strong(&m_pendingTransfer, &transfer, std::shared_ptr<AcceleratorTransfer>());
+		}
+	}
+
 protected:
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -963,9 +1125,10 @@ protected:
 		g_vkTransferCommandBuffer->end();
 
 		//Submit the request and block until it completes
-		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+		AcceleratorTransfer::SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 		m_cpuPhysMemIsStale = false;
+		GetAcceleratorTransferCounters().m_bytesToCpu += m_size * sizeof(T);
 	}
 
 	/**
@@ -984,9 +1147,10 @@ protected:
 		g_vkTransferCommandBuffer->end();
 
 		//Submit the request and block until it completes
-		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
+		AcceleratorTransfer::SubmitAndBlock(*g_vkTransferCommandBuffer);
 
 		m_gpuPhysMemIsStale = false;
+		GetAcceleratorTransferCounters().m_bytesToGpu += m_size * sizeof(T);
 	}
 
 
@@ -1015,7 +1179,51 @@ protected:
 			{});
 
 		m_gpuPhysMemIsStale = false;
+		GetAcceleratorTransferCounters().m_bytesToGpu += m_size * sizeof(T);
+	}
+
+	/**
+		@brief Starts copying the buffer contents from GPU to CPU and returns without waiting for the copy to complete.
+	 */
+	void CopyToCpuAsync()
+	{
+		assert(std::is_trivially_copyable<T>::value);
+
+		//Only one copy in flight at a time
+		WaitForPendingTransfer();
+
+		//Make the transfer request on its own command buffer, so we don't need to hold g_vkTransferMutex
+		auto transfer = std::make_shared<AcceleratorTransfer>();
+		vk::BufferCopy region(0, 0, m_size * sizeof(T));
+		transfer->GetCommandBuffer().copyBuffer(**m_gpuBuffer, **m_cpuBuffer, {region});
+		transfer->Submit();
+		std::atomic_store(&m_pendingTransfer, transfer);
+
+		m_cpuPhysMemIsStale = false;
+		GetAcceleratorTransferCounters().m_bytesToCpu += m_size * sizeof(T);
 	}
+
+	/**
+		@brief Starts copying the buffer contents from CPU to GPU and returns without waiting for the copy to complete.
+	 */
+	void CopyToGpuAsync()
+	{
+		assert(std::is_trivially_copyable<T>::value);
+
+		//Only one copy in flight at a time
+		WaitForPendingTransfer();
+
+		//Make the transfer request on its own command buffer, so we don't need to hold g_vkTransferMutex
+		auto transfer = std::make_shared<AcceleratorTransfer>();
+		vk::BufferCopy region(0, 0, m_size * sizeof(T));
+		transfer->GetCommandBuffer().copyBuffer(**m_cpuBuffer, **m_gpuBuffer, {region});
+		transfer->Submit();
+		std::atomic_store(&m_pendingTransfer, transfer);
+
+		m_gpuPhysMemIsStale = false;
+		GetAcceleratorTransferCounters().m_bytesToGpu += m_size * sizeof(T);
+	}
+
 public:
 	/**
 		@brief Adds a memory barrier for transferring data from host to device
@@ -1048,6 +1256,8 @@ protected:
 		if(m_cpuPtr == nullptr)
 			return;
 
+		WaitForPendingTransfer();
+
 		//We have a buffer on the GPU.
 		//If it's stale, need to push our updated content there before freeing the CPU-side copy
 		if( (m_gpuMemoryType != MEM_TYPE_NULL) && m_gpuPhysMemIsStale && !empty())
@@ -1086,6 +1296,8 @@ public:
 		if(m_gpuPhysMem == nullptr)
 			return;
 
+		WaitForPendingTransfer();
+
 		//If we do NOT have a CPU-side buffer, we're deleting all of our data! Warn for now
 		if( (m_cpuMemoryType == MEM_TYPE_NULL) && m_gpuPhysMemIsStale && !empty() && !dataLossOK)
 		{
@@ -1219,6 +1431,59 @@ protected:
 		}
 	}
 
+	/**
+		@brief Checks if Reallocate() can grow the CPU-side buffer in place by enlarging its backing file
+	 */
+	bool CanGrowPagedBuffer(size_t size)
+	{
+		#ifdef _WIN32
+			(void)size;
+			return false;
+		#else
+			return
+				(m_cpuPtr != nullptr) &&
+				(m_cpuMemoryType == MEM_TYPE_CPU_PAGED) &&
+				(m_cpuAccessHint == HINT_UNLIKELY) &&
+				(m_gpuAccessHint == HINT_NEVER) &&
+				(size > m_capacity) &&
+				std::is_trivially_copyable<T>::value;
+		#endif
+	}
+
+	/**
+		@brief Grows a MEM_TYPE_CPU_PAGED buffer by enlarging its temporary file and mapping it again
+
+		Existing content stays in the file, so nothing is copied.
+	 */
+	void GrowPagedBuffer(size_t size)
+	{
+		#ifndef _WIN32
+			size_t bytesize = size * sizeof(T);
+			if(0 != ftruncate(m_tempFileHandle, bytesize))
+			{
+				LogError("Failed to resize temporary file\n");
+				abort();
+			}
+
+			munmap(m_cpuPtr, m_capacity * sizeof(T));
+			m_cpuPtr = reinterpret_cast<T*>(mmap(
+				nullptr,
+				bytesize,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED,
+				m_tempFileHandle,
+				0));
+			if(m_cpuPtr == MAP_FAILED)
+			{
+				LogError("Failed to map temporary file\n");
+				perror("mmap failed: ");
+				abort();
+			}
+		#else
+			(void)size;
+		#endif
+	}
+
 	/**
 		@brief Frees a CPU-side buffer
 
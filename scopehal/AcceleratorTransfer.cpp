@@ -0,0 +1,176 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of AcceleratorTransfer
+ */
+
+#include "scopehal.h"
+
+using namespace std;
+
+///@brief Maximum number of idle transfer contexts kept for reuse
+static const size_t g_maxFreeTransferContexts = 16;
+
+mutex AcceleratorTransfer::m_contextMutex;
+vector<unique_ptr<AcceleratorTransfer::Context> > AcceleratorTransfer::m_freeContexts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a transfer and begins recording its command buffer
+ */
+AcceleratorTransfer::AcceleratorTransfer()
+	: m_submitted(false)
+	, m_complete(false)
+{
+	{
+		lock_guard<mutex> lock(m_contextMutex);
+		if(!m_freeContexts.empty())
+		{
+			m_context = std::move(m_freeContexts.back());
+			m_freeContexts.pop_back();
+		}
+	}
+
+	//Nothing to reuse, make a new context
+	if(!m_context)
+	{
+		m_context = make_unique<Context>();
+
+		vk::CommandPoolCreateInfo poolInfo(
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+			g_vkTransferQueue->m_family );
+		m_context->m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+
+		vk::CommandBufferAllocateInfo bufinfo(**m_context->m_pool, vk::CommandBufferLevel::ePrimary, 1);
+		m_context->m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
+			std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+		m_context->m_fence = make_unique<vk::raii::Fence>(*g_vkComputeDevice, vk::FenceCreateInfo());
+	}
+
+	m_context->m_cmdBuf->begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+}
+
+/**
+	@brief Waits for the transfer to complete, then returns its command buffer and fence for reuse
+ */
+AcceleratorTransfer::~AcceleratorTransfer()
+{
+	//Never submitted, finish recording so the command buffer can be reset
+	if(!m_submitted)
+		m_context->m_cmdBuf->end();
+	else
+	{
+		Wait();
+		g_vkComputeDevice->resetFences({**m_context->m_fence});
+	}
+
+	lock_guard<mutex> lock(m_contextMutex);
+	if(m_freeContexts.size() < g_maxFreeTransferContexts)
+		m_freeContexts.push_back(std::move(m_context));
+}
+
+/**
+	@brief Frees all cached transfer contexts
+
+	Must be called before the Vulkan device is destroyed.
+ */
+void AcceleratorTransfer::ClearCache()
+{
+	lock_guard<mutex> lock(m_contextMutex);
+	m_freeContexts.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Submission and completion
+
+/**
+	@brief Finishes recording the command buffer and submits it to the transfer queue, without waiting for it
+ */
+void AcceleratorTransfer::Submit()
+{
+	m_context->m_cmdBuf->end();
+	g_vkTransferQueue->Submit(*m_context->m_cmdBuf, *m_context->m_fence);
+	m_submitted = true;
+}
+
+/**
+	@brief Checks if the transfer has completed, without blocking
+ */
+bool AcceleratorTransfer::IsComplete()
+{
+	if(m_complete)
+		return true;
+
+	lock_guard<mutex> lock(m_mutex);
+	if(vk::Result::eSuccess == g_vkComputeDevice->waitForFences({**m_context->m_fence}, VK_TRUE, 0))
+		m_complete = true;
+	return m_complete;
+}
+
+/**
+	@brief Blocks until the transfer has completed
+
+	Time spent blocked is added to the calling thread's AcceleratorTransferCounters.
+ */
+void AcceleratorTransfer::Wait()
+{
+	if(m_complete || !m_submitted)
+		return;
+
+	lock_guard<mutex> lock(m_mutex);
+	if(m_complete)
+		return;
+
+	auto start = chrono::steady_clock::now();
+	while(vk::Result::eTimeout == g_vkComputeDevice->waitForFences({**m_context->m_fence}, VK_TRUE, 1000 * 1000))
+	{}
+	m_complete = true;
+
+	GetAcceleratorTransferCounters().m_nsBlocked +=
+		chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+	@brief Submits a command buffer to g_vkTransferQueue and blocks until it completes
+
+	Time spent blocked is added to the calling thread's AcceleratorTransferCounters.
+ */
+void AcceleratorTransfer::SubmitAndBlock(vk::raii::CommandBuffer& cmdBuf)
+{
+	auto start = chrono::steady_clock::now();
+	g_vkTransferQueue->SubmitAndBlock(cmdBuf);
+	GetAcceleratorTransferCounters().m_nsBlocked +=
+		chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,109 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AcceleratorTransfer
+ */
+
+#ifndef AcceleratorTransfer_h
+#define AcceleratorTransfer_h
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+/**
+	@brief A copy between CPU and GPU memory which may still be in flight
+
+	Each transfer records into its own command buffer and signals its own fence, so any number of them can be
+	outstanding at once without holding g_vkTransferMutex. Command pools and fences are recycled between transfers.
+
+	Transfers are normally started by AcceleratorBuffer::PrepareForCpuAccessAsync() or
+	AcceleratorBuffer::PrepareForGpuAccessAsync() rather than created directly.
+ */
+class AcceleratorTransfer
+{
+public:
+	AcceleratorTransfer();
+	~AcceleratorTransfer();
+
+	//non-copyable
+	AcceleratorTransfer(const AcceleratorTransfer&) = delete;
+	AcceleratorTransfer& operator=(const AcceleratorTransfer&) = delete;
+
+	///@brief Gets the command buffer to record the copy into (only valid until Submit() is called)
+	vk::raii::CommandBuffer& GetCommandBuffer()
+	{ return *m_context->m_cmdBuf; }
+
+	void Submit();
+	bool IsComplete();
+	void Wait();
+
+	static void SubmitAndBlock(vk::raii::CommandBuffer& cmdBuf);
+	static void ClearCache();
+
+protected:
+
+	///@brief Vulkan objects needed for one transfer
+	struct Context
+	{
+		///@brief Pool the command buffer was allocated from (command pools can't be shared between threads)
+		std::unique_ptr<vk::raii::CommandPool> m_pool;
+
+		///@brief Command buffer the copy is recorded into
+		std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
+
+		///@brief Fence signaled when the copy completes
+		std::unique_ptr<vk::raii::Fence> m_fence;
+	};
+
+	///@brief Our command buffer and fence
+	std::unique_ptr<Context> m_context;
+
+	///@brief Mutex for waiting on the fence from several threads
+	std::mutex m_mutex;
+
+	///@brief True once the command buffer has been submitted
+	bool m_submitted;
+
+	///@brief True once the fence has been seen signaled
+	std::atomic<bool> m_complete;
+
+	///@brief Mutex for m_freeContexts
+	static std::mutex m_contextMutex;
+
+	///@brief Contexts of completed transfers, available for reuse
+	static std::vector<std::unique_ptr<Context> > m_freeContexts;
+};
+
+#endif
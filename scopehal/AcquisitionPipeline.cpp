@@ -0,0 +1,267 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of AcquisitionPipeline
+	@ingroup core
+ */
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a pipeline
+
+	@param numBuffers	Number of staging buffers (at least two are needed for any overlap)
+ */
+AcquisitionPipeline::AcquisitionPipeline(size_t numBuffers)
+	: m_pendingJobs(0)
+	, m_blocksConverted(0)
+	, m_terminating(false)
+{
+	for(size_t i=0; i<max(numBuffers, (size_t)1); i++)
+	{
+		auto buf = make_unique<StagingBuffer>("AcquisitionPipeline.staging[" + to_string(i) + "]");
+
+		//Pinned memory, since some transports can DMA straight into it
+		buf->m_data.SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		buf->m_data.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_UNLIKELY);
+		m_buffers.push_back(std::move(buf));
+	}
+}
+
+AcquisitionPipeline::~AcquisitionPipeline()
+{
+	Flush();
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_terminating = true;
+	}
+	m_jobCvar.notify_all();
+	if(m_thread)
+		m_thread->join();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Feeding the pipeline
+
+/**
+	@brief Gets a staging buffer to download a block into, waiting for one to be freed if necessary
+
+	@param len	Size of the block, in bytes
+
+	@return Pointer to at least len bytes of CPU-accessible memory, owned by the pipeline until passed to Submit()
+ */
+uint8_t* AcquisitionPipeline::GetStagingBuffer(size_t len)
+{
+	StagingBuffer* buf = nullptr;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		while(true)
+		{
+			for(auto& b : m_buffers)
+			{
+				if(!b->m_busy)
+				{
+					buf = b.get();
+					break;
+				}
+			}
+			if(buf)
+				break;
+
+			m_doneCvar.wait(lock);
+		}
+
+		buf->m_busy = true;
+	}
+
+	//Resize outside the lock so we don't stall the worker on an allocation
+	buf->m_data.resize(max(len, (size_t)1));
+	buf->m_data.PrepareForCpuAccess();
+	return buf->m_data.GetCpuPointer();
+}
+
+/**
+	@brief Reads a definite-length block from an instrument into a staging buffer
+
+	@param transport	Transport to read from (the caller should hold its mutex)
+	@param len			Set to the length of the block, in bytes
+	@param progress		Optional progress callback
+
+	@return The staging buffer, to be passed to Submit() or Release(), or nullptr on failure
+ */
+uint8_t* AcquisitionPipeline::ReadBlock(SCPITransport* transport, size_t& len, function<void(float)> progress)
+{
+	len = 0;
+	if(!transport->ReadBlockHeader(len))
+	{
+		transport->EndBlock();
+		return nullptr;
+	}
+
+	auto buf = GetStagingBuffer(len);
+	size_t nread = transport->ReadBlockData(len, buf, progress);
+	transport->EndBlock();
+
+	if(nread != len)
+	{
+		LogError("AcquisitionPipeline::ReadBlock: failed to read %zu bytes of block data\n", len);
+		Release(buf);
+		return nullptr;
+	}
+	return buf;
+}
+
+/**
+	@brief Returns a staging buffer to the pool without converting its content
+
+	@param buf	Staging buffer from GetStagingBuffer()
+ */
+void AcquisitionPipeline::Release(uint8_t* buf)
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(auto& b : m_buffers)
+	{
+		if(b->m_busy && (b->m_data.GetCpuPointer() == buf))
+			b->m_busy = false;
+	}
+	m_doneCvar.notify_all();
+}
+
+/**
+	@brief Queues a downloaded block for conversion, and returns immediately
+
+	@param buf	Staging buffer from GetStagingBuffer() containing the block
+	@param len	Number of valid bytes in the buffer
+	@param func	Function to convert the block. It is called from the worker thread, in submission order.
+ */
+void AcquisitionPipeline::Submit(uint8_t* buf, size_t len, ConvertFunction func)
+{
+	Enqueue(buf, len, func);
+}
+
+/**
+	@brief Queues work which doesn't use a staging buffer, and returns immediately
+
+	Any data the function uses must stay valid until Flush() returns.
+
+	@param func	Function to run. It is called from the worker thread, in submission order.
+ */
+void AcquisitionPipeline::Submit(function<void()> func)
+{
+	Enqueue(nullptr, 0, [func](const uint8_t* /*data*/, size_t /*len*/) { func(); });
+}
+
+/**
+	@brief Adds a job to the queue, starting the worker thread if needed
+
+	@param buf	Staging buffer the job uses, or null if none
+	@param len	Number of valid bytes in the buffer
+	@param func	Conversion function
+ */
+void AcquisitionPipeline::Enqueue(uint8_t* buf, size_t len, ConvertFunction func)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	StagingBuffer* staging = nullptr;
+	if(buf)
+	{
+		for(auto& b : m_buffers)
+		{
+			if(b->m_busy && (b->m_data.GetCpuPointer() == buf))
+				staging = b.get();
+		}
+		if(!staging)
+		{
+			LogError("AcquisitionPipeline::Submit: buffer was not obtained from GetStagingBuffer()\n");
+			return;
+		}
+	}
+
+	if(!m_thread)
+		m_thread = make_unique<thread>(&AcquisitionPipeline::WorkerThread, this);
+
+	m_jobs.push_back({staging, len, func});
+	m_pendingJobs ++;
+	m_jobCvar.notify_one();
+}
+
+/**
+	@brief Blocks until every submitted block has been converted
+ */
+void AcquisitionPipeline::Flush()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_doneCvar.wait(lock, [this]{ return m_pendingJobs == 0; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Conversion
+
+void AcquisitionPipeline::WorkerThread(AcquisitionPipeline* pThis)
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "AcqPipeline");
+	#endif
+
+	pThis->DoWorkerThread();
+}
+
+void AcquisitionPipeline::DoWorkerThread()
+{
+	unique_lock<mutex> lock(m_mutex);
+	while(true)
+	{
+		m_jobCvar.wait(lock, [this]{ return m_terminating || !m_jobs.empty(); });
+		if(m_jobs.empty())
+			return;
+
+		auto job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+
+		//Convert without holding the lock so the next download can grab a free buffer
+		lock.unlock();
+		job.m_func(job.m_buffer ? job.m_buffer->m_data.GetCpuPointer() : nullptr, job.m_len);
+		m_blocksConverted ++;
+		lock.lock();
+
+		if(job.m_buffer)
+			job.m_buffer->m_busy = false;
+		m_pendingJobs --;
+		m_doneCvar.notify_all();
+	}
+}
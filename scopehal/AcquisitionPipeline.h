@@ -0,0 +1,153 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AcquisitionPipeline
+	@ingroup core
+ */
+
+#ifndef AcquisitionPipeline_h
+#define AcquisitionPipeline_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+class SCPITransport;
+
+/**
+	@brief Overlaps downloading of raw waveform data with conversion of previously downloaded data
+	@ingroup core
+
+	Drivers read each block from the instrument into a staging buffer obtained from ReadBlock() or GetStagingBuffer(),
+	then hand it to Submit() along with a function that converts it into a waveform. Conversion runs on a worker
+	thread, so the next block can be read from the socket while the previous one is being converted. Flush() waits
+	until everything submitted has been converted, and must be called before the resulting waveforms are published.
+
+	Staging buffers are pinned and reused from one acquisition to the next. With the default of two buffers, at most
+	one block is being converted while the next is downloaded. GetStagingBuffer() blocks if every buffer is still
+	waiting to be converted. Drivers which already read into buffers of their own can queue conversion of them with
+	Submit(std::function<void()>) instead.
+
+	A pipeline must only be fed from one thread at a time (normally the instrument's acquisition thread, with the
+	transport mutex held).
+ */
+class AcquisitionPipeline
+{
+public:
+	AcquisitionPipeline(size_t numBuffers = 2);
+	~AcquisitionPipeline();
+
+	AcquisitionPipeline(const AcquisitionPipeline&) =delete;
+	AcquisitionPipeline& operator=(const AcquisitionPipeline&) =delete;
+
+	/**
+		@brief Converts a downloaded block
+
+		@param data	Raw block content
+		@param len	Length of the block, in bytes
+	 */
+	typedef std::function<void(const uint8_t* data, size_t len)> ConvertFunction;
+
+	uint8_t* GetStagingBuffer(size_t len);
+	uint8_t* ReadBlock(SCPITransport* transport, size_t& len, std::function<void(float)> progress = nullptr);
+	void Release(uint8_t* buf);
+	void Submit(uint8_t* buf, size_t len, ConvertFunction func);
+	void Submit(std::function<void()> func);
+	void Flush();
+
+	///@brief Gets the number of blocks converted so far
+	uint64_t GetBlockCount()
+	{ return m_blocksConverted.load(); }
+
+protected:
+	static void WorkerThread(AcquisitionPipeline* pThis);
+	void DoWorkerThread();
+	void Enqueue(uint8_t* buf, size_t len, ConvertFunction func);
+
+	///@brief One staging buffer
+	struct StagingBuffer
+	{
+		StagingBuffer(const std::string& name)
+			: m_data(name)
+			, m_busy(false)
+		{}
+
+		///@brief Storage for the raw block
+		AcceleratorBuffer<uint8_t> m_data;
+
+		///@brief True from GetStagingBuffer() until the block has been converted
+		bool m_busy;
+	};
+
+	///@brief A block waiting to be converted
+	struct Job
+	{
+		///@brief Buffer holding the block (null for jobs without a staging buffer)
+		StagingBuffer* m_buffer;
+
+		///@brief Length of the block, in bytes
+		size_t m_len;
+
+		///@brief Conversion to run on the block
+		ConvertFunction m_func;
+	};
+
+	///@brief Pool of staging buffers
+	std::vector<std::unique_ptr<StagingBuffer> > m_buffers;
+
+	///@brief Blocks waiting to be converted, oldest first
+	std::deque<Job> m_jobs;
+
+	///@brief Number of submitted blocks not yet fully converted
+	size_t m_pendingJobs;
+
+	///@brief Number of blocks converted so far
+	std::atomic<uint64_t> m_blocksConverted;
+
+	///@brief Mutex for the buffer pool and job queue
+	std::mutex m_mutex;
+
+	///@brief Signaled when a job is submitted or the pipeline is shutting down
+	std::condition_variable m_jobCvar;
+
+	///@brief Signaled when a job completes
+	std::condition_variable m_doneCvar;
+
+	///@brief Conversion thread (started on first use)
+	std::unique_ptr<std::thread> m_thread;
+
+	///@brief Shutdown flag
+	bool m_terminating;
+};
+
+#endif
@@ -603,21 +603,19 @@ vector<uint8_t> AgilentOscilloscope::GetWaveformData(string channel)
 	m_transport->SendCommand(":WAV:SOUR " + channel);
 	m_transport->SendCommand(":WAV:DATA?");
 
-	// Read the length header size
-	char tmp[16] = {0};
-	m_transport->ReadRawData(2, (unsigned char*)tmp);
-	auto header_len = atoi(tmp+1);
-
-	// Read data length
-	m_transport->ReadRawData(header_len, (unsigned char*)tmp);
-	auto data_len = atoi(tmp);
+	// Read the length header
+	size_t data_len = 0;
+	if(!m_transport->ReadBlockHeader(data_len))
+		return {};
 
 	// Read the actual data
 	auto buf = vector<uint8_t>(data_len);
-	m_transport->ReadRawData(data_len, &buf[0]);
+	m_transport->ReadBlockData(data_len, buf.data());
+	m_transport->EndBlock();
 
 	// Discard trailing newline
-	m_transport->ReadRawData(1, (unsigned char*)tmp);
+	char tmp;
+	m_transport->ReadRawData(1, (unsigned char*)&tmp);
 
 	return buf;
 }
@@ -747,17 +745,36 @@ bool AgilentOscilloscope::AcquireData()
 		cap->m_startTimestamp = floor(t);
 		cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
 
-		// Format the capture
-		auto buf = GetWaveformData(chname);
-		if(preamble.length != buf.size())
-			LogError("Waveform preamble length (%zu) does not match data length (%zu)", preamble.length, buf.size());
-		cap->Resize(buf.size());
+		//Download the raw samples
+		m_transport->SendCommand(":WAV:SOUR " + chname);
+		m_transport->SendCommand(":WAV:DATA?");
+		size_t len;
+		auto buf = m_acquisitionPipeline.ReadBlock(m_transport, len);
+		if(!buf)
+		{
+			LogError("Failed to download waveform data for channel %s\n", chname.c_str());
+			delete cap;
+			continue;
+		}
+
+		// Discard trailing newline
+		char tmp;
+		m_transport->ReadRawData(1, (unsigned char*)&tmp);
+		if(preamble.length != len)
+			LogError("Waveform preamble length (%zu) does not match data length (%zu)", preamble.length, len);
+
+		//Format the capture in the background while we download the next channel
 		float gain = preamble.yincrement;
 		float offset = (gain * preamble.yreference) - preamble.yorigin;
-		ConvertUnsigned8BitSamples(cap->m_samples.GetCpuPointer(), buf.data(), gain, offset, buf.size());
+		m_acquisitionPipeline.Submit(buf, len, [cap, gain, offset](const uint8_t* data, size_t n)
+		{
+			cap->Resize(n);
+			cap->PrepareForCpuAccess();
+			ConvertUnsigned8BitSamples(cap->m_samples.GetCpuPointer(), data, gain, offset, n);
+			cap->MarkSamplesModifiedFromCpu();
+		});
 
 		//Done, update the data
-		cap->MarkSamplesModifiedFromCpu();
 		pending_waveforms[i].push_back(cap);
 	}
 
@@ -792,6 +809,9 @@ bool AgilentOscilloscope::AcquireData()
 		}
 	}
 
+	//Wait for conversion of the last analog channels to finish
+	m_acquisitionPipeline.Flush();
+
 	//Now that we have all of the pending waveforms, save them in sets across all channels
 	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//TODO: segmented capture mode
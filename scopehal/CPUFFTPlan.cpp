@@ -0,0 +1,750 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of CPUFFTPlan
+
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "CPUFFTPlan.h"
+#include <omp.h>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**
+	@brief Number of complex points processed as one cache-resident block during the early FFT stages
+
+	32K complex points is 256 kB, which fits comfortably in L2 on anything we're likely to run on.
+ */
+static const size_t g_fftCacheBlockSize = 32768;
+
+/**
+	@brief Minimum number of complex points before a single transform is split across threads
+ */
+static const size_t g_fftParallelThreshold = 65536;
+
+/**
+	@brief Largest total transform size for which the CPU backend is preferred over a hardware GPU
+
+	Below this size a GPU FFT is dominated by submission latency and host/device copies rather than arithmetic.
+ */
+static const size_t g_fftCpuPreferredPoints = 131072;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a new FFT plan
+
+	@param npoints			Number of points in the FFT (must be a power of two, see IsSizeSupported())
+	@param nouts			Number of output samples
+	@param dir				Direction (forward or reverse). Both directions are always available; this is only
+							accepted for interface compatibility with VulkanFFTPlan
+	@param numBatches		Number of batched FFTs to perform (for spectrograms etc)
+	@param timeDomainType	Data type of the time-domain signal (real or complex)
+ */
+CPUFFTPlan::CPUFFTPlan(
+	size_t npoints,
+	size_t nouts,
+	VulkanFFTPlan::VulkanFFTPlanDirection /*dir*/,
+	size_t numBatches,
+	VulkanFFTPlan::VulkanFFTDataType timeDomainType)
+	: m_size(npoints)
+	, m_nouts(nouts)
+	, m_numBatches(numBatches)
+	, m_type(timeDomainType)
+{
+	if(!IsSizeSupported(npoints))
+	{
+		LogError("CPUFFTPlan: %zu points is not a supported FFT size\n", npoints);
+		m_size = 0;
+		m_complexSize = 0;
+		return;
+	}
+
+	//Real transforms are done as a complex FFT of half the size
+	if(m_type == VulkanFFTPlan::TYPE_REAL)
+		m_complexSize = npoints / 2;
+	else
+		m_complexSize = npoints;
+
+	//Bit reversal table
+	size_t bits = __builtin_ctzll(m_complexSize);
+	m_bitrev.resize(m_complexSize);
+	for(size_t i=0; i<m_complexSize; i++)
+	{
+		uint32_t r = 0;
+		for(size_t b=0; b<bits; b++)
+		{
+			if(i & (1ULL << b))
+				r |= 1U << (bits - 1 - b);
+		}
+		m_bitrev[i] = r;
+	}
+
+	//Per-stage twiddle factors, computed in double precision to avoid accumulating error on large transforms
+	m_forwardTwiddles.resize(2 * max(m_complexSize, (size_t)1));
+	m_reverseTwiddles.resize(2 * max(m_complexSize, (size_t)1));
+	for(size_t half=1; half<m_complexSize; half *= 2)
+	{
+		for(size_t j=0; j<half; j++)
+		{
+			double theta = M_PI * j / half;
+			float c = cos(theta);
+			float s = sin(theta);
+
+			m_forwardTwiddles[(half + j)*2] = c;
+			m_forwardTwiddles[(half + j)*2 + 1] = -s;
+			m_reverseTwiddles[(half + j)*2] = c;
+			m_reverseTwiddles[(half + j)*2 + 1] = s;
+		}
+	}
+
+	//Split/merge twiddles for real transforms
+	if(m_type == VulkanFFTPlan::TYPE_REAL)
+	{
+		if(m_complexSize >= g_fftParallelThreshold)
+			m_scratch.resize(2 * m_complexSize);
+
+		size_t nreal = m_complexSize/2 + 1;
+		m_realTwiddles.resize(2 * nreal);
+		for(size_t k=0; k<nreal; k++)
+		{
+			double theta = M_PI * k / m_complexSize;
+			m_realTwiddles[k*2] = cos(theta);
+			m_realTwiddles[k*2 + 1] = -sin(theta);
+		}
+	}
+}
+
+CPUFFTPlan::~CPUFFTPlan()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Backend selection
+
+/**
+	@brief Checks if a transform size can be handled by CPUFFTPlan
+ */
+bool CPUFFTPlan::IsSizeSupported(size_t npoints)
+{
+	if(npoints < 2)
+		return false;
+	if(npoints > 0x80000000ULL)
+		return false;
+	return (npoints & (npoints - 1)) == 0;
+}
+
+/**
+	@brief Decides whether the CPU backend is expected to beat VulkanFFTPlan for a given transform
+
+	The CPU is preferred if there is no usable GPU, if the Vulkan device is itself a software renderer, or if the
+	transform is small and the input is already in host memory (so the GPU path would be dominated by copies and
+	submission latency).
+
+	@param npoints		Number of points in each FFT
+	@param numBatches	Number of FFTs done at once
+	@param inputOnGpu	True if the input data currently only has a valid copy in GPU memory
+ */
+bool CPUFFTPlan::IsPreferred(size_t npoints, size_t numBatches, bool inputOnGpu)
+{
+	if(!IsSizeSupported(npoints))
+		return false;
+
+	if(!g_gpuFilterEnabled || g_vulkanDeviceIsSoftware)
+		return true;
+
+	return !inputOnGpu && (npoints * numBatches <= g_fftCpuPreferredPoints);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Public API
+
+/**
+	@brief Performs a forward FFT
+
+	Input data is npoints (real) or 2*npoints (complex) floats per batch. Output is 2*nouts floats per batch of
+	interleaved complex values. The input and output buffers must not overlap.
+ */
+void CPUFFTPlan::Forward(const float* dataIn, float* dataOut)
+{
+	if(m_complexSize == 0)
+		return;
+
+	size_t instride = (m_type == VulkanFFTPlan::TYPE_REAL) ? m_size : 2*m_size;
+	size_t outstride = 2*m_nouts;
+
+	//Small transforms run one per thread, large ones are split internally
+	bool inner = (m_complexSize >= g_fftParallelThreshold);
+	#pragma omp parallel for if(!inner && (m_numBatches > 1))
+	for(size_t i=0; i<m_numBatches; i++)
+	{
+		float* out = dataOut + i*outstride;
+
+		//Real data is treated as a complex array of half the length, so the gather is the same for both types
+		GatherBitReversed(out, dataIn + i*instride, inner);
+		RunComplex(out, false, inner);
+
+		if(m_type == VulkanFFTPlan::TYPE_REAL)
+			PostprocessReal(out, inner);
+	}
+}
+
+/**
+	@brief Performs an unnormalized inverse FFT
+
+	Input data is 2*nouts floats of interleaved complex values per batch. Output is npoints (real) or 2*npoints
+	(complex) floats per batch. As with VulkanFFTPlan, the output is scaled by npoints. The input and output buffers
+	must not overlap.
+ */
+void CPUFFTPlan::Reverse(const float* dataIn, float* dataOut)
+{
+	if(m_complexSize == 0)
+		return;
+
+	size_t instride = 2*m_nouts;
+	size_t outstride = (m_type == VulkanFFTPlan::TYPE_REAL) ? m_size : 2*m_size;
+
+	bool inner = (m_complexSize >= g_fftParallelThreshold);
+	#pragma omp parallel for if(!inner && (m_numBatches > 1))
+	for(size_t i=0; i<m_numBatches; i++)
+	{
+		float* out = dataOut + i*outstride;
+
+		//Large real transforms are unpacked to scratch memory then gathered in cache-friendly order,
+		//small ones are unpacked in place and permuted while still in cache
+		if(m_type == VulkanFFTPlan::TYPE_REAL)
+		{
+			if(inner)
+			{
+				PreprocessReal(m_scratch.data(), dataIn + i*instride, inner);
+				GatherBitReversed(out, m_scratch.data(), inner);
+			}
+			else
+			{
+				PreprocessReal(out, dataIn + i*instride, inner);
+				SwapBitReversed(out);
+			}
+		}
+		else
+			GatherBitReversed(out, dataIn + i*instride, inner);
+
+		RunComplex(out, true, inner);
+	}
+}
+
+/**
+	@brief Performs a forward FFT on data in AcceleratorBuffers, leaving the result in CPU memory
+ */
+void CPUFFTPlan::Forward(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut)
+{
+	dataIn.PrepareForCpuAccess();
+	dataOut.PrepareForCpuAccess();
+	Forward(dataIn.GetCpuPointer(), dataOut.GetCpuPointer());
+	dataOut.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Performs an unnormalized inverse FFT on data in AcceleratorBuffers, leaving the result in CPU memory
+ */
+void CPUFFTPlan::Reverse(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut)
+{
+	dataIn.PrepareForCpuAccess();
+	dataOut.PrepareForCpuAccess();
+	Reverse(dataIn.GetCpuPointer(), dataOut.GetCpuPointer());
+	dataOut.MarkModifiedFromCpu();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Complex FFT core
+
+/**
+	@brief Copies complex input data into bit-reversed order
+
+	A naive gather touches a different cache line for every element once the transform is larger than cache. For
+	large transforms, the index is instead split into high, middle, and low fields of q, bits-2q, and q bits. For a
+	fixed middle field, the 2^q x 2^q elements formed by the high and low fields are read as 2^q contiguous runs and
+	written as 2^q contiguous runs, so every cache line is fully used.
+ */
+void CPUFFTPlan::GatherBitReversed(float* dst, const float* src, bool parallel)
+{
+	const uint32_t* bitrev = m_bitrev.data();
+	const uint64_t* in = reinterpret_cast<const uint64_t*>(src);
+	uint64_t* out = reinterpret_cast<uint64_t*>(dst);
+
+	//Small transforms fit in cache, do it the simple way
+	const size_t q = 4;
+	size_t bits = __builtin_ctzll(m_complexSize);
+	if(bits < 4*q)
+	{
+		for(size_t i=0; i<m_complexSize; i++)
+			out[i] = in[bitrev[i]];
+		return;
+	}
+
+	size_t hishift = bits - q;
+	size_t nmid = 1ULL << (bits - 2*q);
+	const size_t nrun = 1ULL << q;
+
+	#pragma omp parallel for if(parallel)
+	for(size_t mid=0; mid<nmid; mid++)
+	{
+		size_t rmid = bitrev[mid << q];
+		for(size_t hi=0; hi<nrun; hi++)
+		{
+			const uint64_t* row = in + (hi << hishift) + (mid << q);
+			size_t rhi = bitrev[hi << hishift];
+			for(size_t lo=0; lo<nrun; lo++)
+				out[bitrev[lo] | rmid | rhi] = row[lo];
+		}
+	}
+}
+
+/**
+	@brief Permutes complex data into bit-reversed order in place
+ */
+void CPUFFTPlan::SwapBitReversed(float* data)
+{
+	const uint32_t* bitrev = m_bitrev.data();
+	uint64_t* d = reinterpret_cast<uint64_t*>(data);
+
+	for(size_t i=0; i<m_complexSize; i++)
+	{
+		size_t j = bitrev[i];
+		if(i < j)
+			swap(d[i], d[j]);
+	}
+}
+
+/**
+	@brief Runs all butterfly stages of the complex FFT on bit-reversed data, in place
+
+	Stages with a span smaller than the cache block size are run one block at a time so each block only has to be
+	brought into cache once. The remaining stages make a full pass over the data each.
+ */
+void CPUFFTPlan::RunComplex(float* data, bool inverse, bool parallel)
+{
+	size_t blocklen = min(m_complexSize, g_fftCacheBlockSize);
+	size_t nblocks = m_complexSize / blocklen;
+
+	#pragma omp parallel for if(parallel && (nblocks > 1))
+	for(size_t i=0; i<nblocks; i++)
+		RunStages(data + i*blocklen*2, 1, blocklen, blocklen, inverse, false);
+
+	RunStages(data, blocklen, m_complexSize, m_complexSize, inverse, parallel);
+}
+
+/**
+	@brief Runs a range of butterfly stages over a contiguous block of complex values
+
+	Consecutive stages are merged in pairs so that each pass over memory does two stages of work.
+
+	@param data			Block to process
+	@param firstHalf	Butterfly span of the first stage to run
+	@param lastHalf		Stages with a butterfly span of lastHalf or more are not run
+	@param len			Number of complex values in the block
+	@param inverse		True to use inverse twiddles
+	@param parallel		True to split each stage across threads
+ */
+void CPUFFTPlan::RunStages(float* data, size_t firstHalf, size_t lastHalf, size_t len, bool inverse, bool parallel)
+{
+	const float* twiddles = inverse ? m_reverseTwiddles.data() : m_forwardTwiddles.data();
+
+	for(size_t half = firstHalf; half < lastHalf; )
+	{
+		bool pair = (half*2 < lastHalf);
+		size_t nunits = pair ? len/4 : len/2;
+
+		if(parallel)
+		{
+			const size_t chunk = 4096;
+			size_t nchunks = (nunits + chunk - 1) / chunk;
+
+			#pragma omp parallel for
+			for(size_t i=0; i<nchunks; i++)
+				RunStage(data, twiddles, half, pair, i*chunk, min((i+1)*chunk, nunits));
+		}
+		else
+			RunStage(data, twiddles, half, pair, 0, nunits);
+
+		half *= pair ? 4 : 2;
+	}
+}
+
+/**
+	@brief Runs part of one FFT stage, or of two consecutive stages, with the best available kernel
+
+	@param data			Complex data (interleaved real/imaginary)
+	@param twiddles		Twiddle table (see m_forwardTwiddles)
+	@param half			Butterfly span of the (first) stage
+	@param pair			True to run stages half and 2*half together
+	@param start		Index of the first butterfly (or butterfly pair) to run
+	@param end			One past the index of the last butterfly (or butterfly pair) to run
+ */
+void CPUFFTPlan::RunStage(float* data, const float* twiddles, size_t half, bool pair, size_t start, size_t end)
+{
+	if(pair)
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2 && (half >= 4))
+			ButterflyStagePairAVX2(data, twiddles, half, start, end);
+		else
+		#endif
+			ButterflyStagePairGeneric(data, twiddles, half, start, end);
+	}
+
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2 && (half >= 4))
+			ButterflyStageAVX2(data, twiddles, half, start, end);
+		else
+		#endif
+			ButterflyStageGeneric(data, twiddles, half, start, end);
+	}
+}
+
+/**
+	@brief Runs a range of radix-2 butterflies from one FFT stage
+
+	Butterfly t operates on complex values i and i+half, where i = (t / half)*2*half + (t % half).
+
+	@param data			Complex data (interleaved real/imaginary)
+	@param twiddles		Twiddle table (see m_forwardTwiddles)
+	@param half			Butterfly span for this stage
+	@param start		Index of the first butterfly to run
+	@param end			One past the index of the last butterfly to run
+ */
+void CPUFFTPlan::ButterflyStageGeneric(float* data, const float* twiddles, size_t half, size_t start, size_t end)
+{
+	size_t shift = __builtin_ctzll(half);
+
+	//First stage has a twiddle of unity
+	if(half == 1)
+	{
+		for(size_t t=start; t<end; t++)
+		{
+			float* pa = data + t*4;
+			float ar = pa[0];
+			float ai = pa[1];
+			float br = pa[2];
+			float bi = pa[3];
+			pa[0] = ar + br;
+			pa[1] = ai + bi;
+			pa[2] = ar - br;
+			pa[3] = ai - bi;
+		}
+		return;
+	}
+
+	for(size_t t=start; t<end; t++)
+	{
+		size_t j = t & (half - 1);
+		size_t i = ((t >> shift) << (shift + 1)) + j;
+
+		float* pa = data + i*2;
+		float* pb = pa + half*2;
+		const float* w = twiddles + (half + j)*2;
+
+		float br = pb[0]*w[0] - pb[1]*w[1];
+		float bi = pb[0]*w[1] + pb[1]*w[0];
+		float ar = pa[0];
+		float ai = pa[1];
+
+		pa[0] = ar + br;
+		pa[1] = ai + bi;
+		pb[0] = ar - br;
+		pb[1] = ai - bi;
+	}
+}
+
+/**
+	@brief Runs a range of butterfly pairs covering two consecutive FFT stages (spans half and 2*half)
+
+	Pair q operates on complex values i, i+half, i+2*half, and i+3*half, where
+	i = (q / half)*4*half + (q % half).
+ */
+void CPUFFTPlan::ButterflyStagePairGeneric(float* data, const float* twiddles, size_t half, size_t start, size_t end)
+{
+	size_t shift = __builtin_ctzll(half);
+
+	for(size_t q=start; q<end; q++)
+	{
+		size_t j = q & (half - 1);
+		size_t i = ((q >> shift) << (shift + 2)) + j;
+
+		float* p0 = data + i*2;
+		float* p1 = p0 + half*2;
+		float* p2 = p0 + half*4;
+		float* p3 = p0 + half*6;
+		const float* w1 = twiddles + (half + j)*2;
+		const float* w2 = twiddles + (2*half + j)*2;
+		const float* w3 = twiddles + (3*half + j)*2;
+
+		//First stage: (p0, p1) and (p2, p3), both with twiddle w1
+		float br = p1[0]*w1[0] - p1[1]*w1[1];
+		float bi = p1[0]*w1[1] + p1[1]*w1[0];
+		float a0r = p0[0] + br;
+		float a0i = p0[1] + bi;
+		float a1r = p0[0] - br;
+		float a1i = p0[1] - bi;
+
+		br = p3[0]*w1[0] - p3[1]*w1[1];
+		bi = p3[0]*w1[1] + p3[1]*w1[0];
+		float a2r = p2[0] + br;
+		float a2i = p2[1] + bi;
+		float a3r = p2[0] - br;
+		float a3i = p2[1] - bi;
+
+		//Second stage: (a0, a2) with twiddle w2, (a1, a3) with twiddle w3
+		br = a2r*w2[0] - a2i*w2[1];
+		bi = a2r*w2[1] + a2i*w2[0];
+		p0[0] = a0r + br;
+		p0[1] = a0i + bi;
+		p2[0] = a0r - br;
+		p2[1] = a0i - bi;
+
+		br = a3r*w3[0] - a3i*w3[1];
+		bi = a3r*w3[1] + a3i*w3[0];
+		p1[0] = a1r + br;
+		p1[1] = a1i + bi;
+		p3[0] = a1r - br;
+		p3[1] = a1i - bi;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief Complex multiply of four interleaved values
+ */
+__attribute__((target("avx2")))
+static inline __m256 ComplexMultiplyAVX2(__m256 b, __m256 w)
+{
+	//(br*wr - bi*wi, bi*wr + br*wi)
+	__m256 wr = _mm256_moveldup_ps(w);
+	__m256 wi = _mm256_movehdup_ps(w);
+	__m256 bswap = _mm256_permute_ps(b, 0xb1);
+	return _mm256_addsub_ps(_mm256_mul_ps(b, wr), _mm256_mul_ps(bswap, wi));
+}
+
+/**
+	@brief AVX2 version of ButterflyStageGeneric(), four butterflies per iteration
+
+	Requires half >= 4 so that each group of four butterflies shares a contiguous run of twiddles.
+ */
+__attribute__((target("avx2")))
+void CPUFFTPlan::ButterflyStageAVX2(float* data, const float* twiddles, size_t half, size_t start, size_t end)
+{
+	size_t shift = __builtin_ctzll(half);
+	size_t end_rounded = start + ((end - start) & ~3ULL);
+
+	size_t t = start;
+	for(; t<end_rounded; t += 4)
+	{
+		size_t j = t & (half - 1);
+		size_t i = ((t >> shift) << (shift + 1)) + j;
+
+		float* pa = data + i*2;
+		float* pb = pa + half*2;
+
+		__m256 a = _mm256_loadu_ps(pa);
+		__m256 b = _mm256_loadu_ps(pb);
+		__m256 bw = ComplexMultiplyAVX2(b, _mm256_loadu_ps(twiddles + (half + j)*2));
+
+		_mm256_storeu_ps(pa, _mm256_add_ps(a, bw));
+		_mm256_storeu_ps(pb, _mm256_sub_ps(a, bw));
+	}
+
+	if(t < end)
+		ButterflyStageGeneric(data, twiddles, half, t, end);
+}
+/**
+	@brief AVX2 version of ButterflyStagePairGeneric(), four butterfly pairs per iteration
+
+	Requires half >= 4.
+ */
+__attribute__((target("avx2")))
+void CPUFFTPlan::ButterflyStagePairAVX2(float* data, const float* twiddles, size_t half, size_t start, size_t end)
+{
+	size_t shift = __builtin_ctzll(half);
+	size_t end_rounded = start + ((end - start) & ~3ULL);
+
+	size_t q = start;
+	for(; q<end_rounded; q += 4)
+	{
+		size_t j = q & (half - 1);
+		size_t i = ((q >> shift) << (shift + 2)) + j;
+
+		float* p0 = data + i*2;
+		float* p1 = p0 + half*2;
+		float* p2 = p0 + half*4;
+		float* p3 = p0 + half*6;
+
+		__m256 w1 = _mm256_loadu_ps(twiddles + (half + j)*2);
+		__m256 w2 = _mm256_loadu_ps(twiddles + (2*half + j)*2);
+		__m256 w3 = _mm256_loadu_ps(twiddles + (3*half + j)*2);
+
+		__m256 x0 = _mm256_loadu_ps(p0);
+		__m256 x1 = _mm256_loadu_ps(p1);
+		__m256 x2 = _mm256_loadu_ps(p2);
+		__m256 x3 = _mm256_loadu_ps(p3);
+
+		//First stage
+		__m256 b = ComplexMultiplyAVX2(x1, w1);
+		__m256 a0 = _mm256_add_ps(x0, b);
+		__m256 a1 = _mm256_sub_ps(x0, b);
+		b = ComplexMultiplyAVX2(x3, w1);
+		__m256 a2 = _mm256_add_ps(x2, b);
+		__m256 a3 = _mm256_sub_ps(x2, b);
+
+		//Second stage
+		b = ComplexMultiplyAVX2(a2, w2);
+		_mm256_storeu_ps(p0, _mm256_add_ps(a0, b));
+		_mm256_storeu_ps(p2, _mm256_sub_ps(a0, b));
+		b = ComplexMultiplyAVX2(a3, w3);
+		_mm256_storeu_ps(p1, _mm256_add_ps(a1, b));
+		_mm256_storeu_ps(p3, _mm256_sub_ps(a1, b));
+	}
+
+	if(q < end)
+		ButterflyStagePairGeneric(data, twiddles, half, q, end);
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Real transform support
+
+/**
+	@brief Converts the output of a N/2 point complex FFT of packed real data into the first N/2+1 bins of the
+	real FFT, in place
+
+	With Z = FFT(x[2n] + i*x[2n+1]), M = N/2 and W = e^(-2 pi i / N):
+		E[k] = (Z[k] + conj(Z[M-k])) / 2
+		O[k] = (Z[k] - conj(Z[M-k])) / 2i
+		X[k] = E[k] + W^k O[k]
+		X[M-k] = conj(E[k] - W^k O[k])
+
+	@param data		Complex FFT output, with space for one extra complex value at the end
+	@param parallel	True to split the work across threads
+ */
+void CPUFFTPlan::PostprocessReal(float* data, bool parallel)
+{
+	size_t m = m_complexSize;
+	const float* tw = m_realTwiddles.data();
+
+	float z0r = data[0];
+	float z0i = data[1];
+
+	#pragma omp parallel for if(parallel)
+	for(size_t k=1; k<=m/2; k++)
+	{
+		size_t mk = m - k;
+		float zkr = data[k*2];
+		float zki = data[k*2 + 1];
+		float zmr = data[mk*2];
+		float zmi = data[mk*2 + 1];
+
+		float er = 0.5f * (zkr + zmr);
+		float ei = 0.5f * (zki - zmi);
+		float or_ = 0.5f * (zki + zmi);
+		float oi = -0.5f * (zkr - zmr);
+
+		float wr = tw[k*2];
+		float wi = tw[k*2 + 1];
+		float tr = wr*or_ - wi*oi;
+		float ti = wr*oi + wi*or_;
+
+		data[k*2] = er + tr;
+		data[k*2 + 1] = ei + ti;
+		data[mk*2] = er - tr;
+		data[mk*2 + 1] = ti - ei;
+	}
+
+	//DC and Nyquist bins are purely real
+	data[0] = z0r + z0i;
+	data[1] = 0;
+	data[m*2] = z0r - z0i;
+	data[m*2 + 1] = 0;
+}
+
+/**
+	@brief Packs the first N/2+1 bins of a real signal's spectrum into the input of a N/2 point inverse complex FFT,
+	whose output is then the real signal (scaled by N) as interleaved even/odd samples
+
+	This is the inverse of PostprocessReal(), with the factors of 1/2 folded into the inverse FFT scale:
+		Z[k] = (X[k] + conj(X[M-k])) + i * (X[k] - conj(X[M-k])) * conj(W^k)
+
+	@param dst		Output buffer for the complex FFT (in natural order), N/2 complex values
+	@param src		Spectrum, N/2+1 complex values
+	@param parallel	True to split the work across threads
+ */
+void CPUFFTPlan::PreprocessReal(float* dst, const float* src, bool parallel)
+{
+	size_t m = m_complexSize;
+	const float* tw = m_realTwiddles.data();
+
+	//DC and Nyquist bins (imaginary parts are ignored)
+	float x0 = src[0];
+	float xm = src[m*2];
+	dst[0] = x0 + xm;
+	dst[1] = x0 - xm;
+
+	#pragma omp parallel for if(parallel)
+	for(size_t k=1; k<=m/2; k++)
+	{
+		size_t mk = m - k;
+		float xkr = src[k*2];
+		float xki = src[k*2 + 1];
+		float xmr = src[mk*2];
+		float xmi = src[mk*2 + 1];
+
+		float er = xkr + xmr;
+		float ei = xki - xmi;
+		float dr = xkr - xmr;
+		float di = xki + xmi;
+
+		float wr = tw[k*2];
+		float wi = tw[k*2 + 1];
+		float or_ = dr*wr + di*wi;
+		float oi = di*wr - dr*wi;
+
+		dst[k*2] = er - oi;
+		dst[k*2 + 1] = ei + or_;
+		dst[mk*2] = er + oi;
+		dst[mk*2 + 1] = or_ - ei;
+	}
+}
@@ -0,0 +1,140 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of CPUFFTPlan
+	@ingroup core
+ */
+#ifndef CPUFFTPlan_h
+#define CPUFFTPlan_h
+
+#include "VulkanFFTPlan.h"
+
+/**
+	@brief Native CPU implementation of the same transforms as VulkanFFTPlan
+
+	Takes the same configuration as VulkanFFTPlan and produces data in the same layout (interleaved complex frequency
+	domain data, unnormalized inverse), so filters can switch between the two backends on each refresh.
+
+	The transform is an iterative radix-2 decimation-in-time FFT. Real transforms of N points are computed as a N/2
+	point complex FFT plus a pre/post processing pass. Stages which fit in cache are run block by block so that large
+	transforms make as few passes over memory as possible; butterflies are vectorized with AVX2 where available and
+	large transforms or batches are split across threads with OpenMP.
+
+	Only power-of-two sizes are supported.
+
+	@ingroup core
+ */
+class CPUFFTPlan
+{
+public:
+	CPUFFTPlan(
+		size_t npoints,
+		size_t nouts,
+		VulkanFFTPlan::VulkanFFTPlanDirection dir,
+		size_t numBatches = 1,
+		VulkanFFTPlan::VulkanFFTDataType timeDomainType = VulkanFFTPlan::TYPE_REAL);
+	~CPUFFTPlan();
+
+	//not copyable or assignable
+	CPUFFTPlan(const CPUFFTPlan&) =delete;
+	CPUFFTPlan& operator=(const CPUFFTPlan&) =delete;
+
+	void Forward(const float* dataIn, float* dataOut);
+	void Reverse(const float* dataIn, float* dataOut);
+
+	void Forward(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut);
+	void Reverse(AcceleratorBuffer<float>& dataIn, AcceleratorBuffer<float>& dataOut);
+
+	///@brief Return the number of points in the FFT
+	size_t size() const
+	{ return m_size; }
+
+	///@brief Return the number of transforms done by each call
+	size_t GetBatchCount() const
+	{ return m_numBatches; }
+
+	static bool IsSizeSupported(size_t npoints);
+	static bool IsPreferred(size_t npoints, size_t numBatches, bool inputOnGpu);
+
+protected:
+	void RunComplex(float* data, bool inverse, bool parallel);
+	void RunStages(float* data, size_t firstHalf, size_t lastHalf, size_t len, bool inverse, bool parallel);
+	void GatherBitReversed(float* dst, const float* src, bool parallel);
+	void SwapBitReversed(float* data);
+
+	void PostprocessReal(float* data, bool parallel);
+	void PreprocessReal(float* dst, const float* src, bool parallel);
+
+	static void RunStage(float* data, const float* twiddles, size_t half, bool pair, size_t start, size_t end);
+	static void ButterflyStageGeneric(float* data, const float* twiddles, size_t half, size_t start, size_t end);
+	static void ButterflyStagePairGeneric(float* data, const float* twiddles, size_t half, size_t start, size_t end);
+#ifdef __x86_64__
+	static void ButterflyStageAVX2(float* data, const float* twiddles, size_t half, size_t start, size_t end);
+	static void ButterflyStagePairAVX2(float* data, const float* twiddles, size_t half, size_t start, size_t end);
+#endif
+
+	///@brief Number of points in the FFT
+	size_t m_size;
+
+	///@brief Number of frequency domain outputs per transform
+	size_t m_nouts;
+
+	///@brief Number of transforms done by each call
+	size_t m_numBatches;
+
+	///@brief Type of the time domain data
+	VulkanFFTPlan::VulkanFFTDataType m_type;
+
+	///@brief Number of points in the underlying complex FFT
+	size_t m_complexSize;
+
+	///@brief Bit reversal permutation of the complex FFT inputs
+	std::vector<uint32_t, AlignedAllocator<uint32_t, 64> > m_bitrev;
+
+	/**
+		@brief Forward twiddle factors, as interleaved complex values
+
+		The twiddles for the stage with butterfly span h are stored contiguously starting at complex index h.
+	 */
+	std::vector<float, AlignedAllocator<float, 64> > m_forwardTwiddles;
+
+	///@brief Inverse twiddle factors, same layout as m_forwardTwiddles
+	std::vector<float, AlignedAllocator<float, 64> > m_reverseTwiddles;
+
+	///@brief Temporary buffer for large inverse real transforms
+	std::vector<float, AlignedAllocator<float, 64> > m_scratch;
+
+	///@brief Twiddle factors e^(-2 pi i k / N) for splitting and merging real transforms, k = 0 ... N/4
+	std::vector<float, AlignedAllocator<float, 64> > m_realTwiddles;
+};
+
+#endif
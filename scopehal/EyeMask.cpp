@@ -37,6 +37,10 @@
 #include "EyeWaveform.h"
 #include "EyeMask.h"
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
 //WORKAROUND for Cairo >=1.16 support
 #if ((CAIROMM_MAJOR_VERSION == 1) && (CAIROMM_MINOR_VERSION >= 16)) || (CAIROMM_MAJOR_VERSION > 1)
 #define FORMAT_ARGB32 Surface::Format::ARGB32
@@ -209,32 +213,48 @@ void EyeMask::RenderInternal(
 		float height) const
 {
 	//Draw each polygon
-	for(auto poly : m_polygons)
+	for(auto& poly : m_polygons)
+		RenderPolygon(cr, poly, waveform, xscale, xoff, yscale, yoff, height);
+}
+
+void EyeMask::RenderPolygon(
+		Cairo::RefPtr<Cairo::Context> cr,
+		const EyeMaskPolygon& poly,
+		EyeWaveform* waveform,
+		float xscale,
+		float xoff,
+		float yscale,
+		float yoff,
+		float height) const
+{
+	for(size_t i=0; i<poly.m_points.size(); i++)
 	{
-		for(size_t i=0; i<poly.m_points.size(); i++)
-		{
-			auto point = poly.m_points[i];
+		auto point = poly.m_points[i];
 
-			//Convert from ps to UI if needed
-			float time = point.m_time;
-			if(m_timebaseIsRelative)
-				time *= waveform->GetUIWidth();
+		//Convert from ps to UI if needed
+		float time = point.m_time;
+		if(m_timebaseIsRelative)
+			time *= waveform->GetUIWidth();
 
-			float x = (time - xoff) * xscale;
+		float x = (time - xoff) * xscale;
 
-			float y = height/2 - ( (point.m_voltage + yoff) * yscale );
+		float y = height/2 - ( (point.m_voltage + yoff) * yscale );
 
-			if(i == 0)
-				cr->move_to(x, y);
-			else
-				cr->line_to(x, y);
-		}
-		cr->fill();
+		if(i == 0)
+			cr->move_to(x, y);
+		else
+			cr->line_to(x, y);
 	}
+	cr->fill();
 }
 
 /**
 	@brief Checks a raw eye pattern dataset against the mask
+
+	The mask is rasterized once and cached as runs of covered pixels, so each call only has to reduce over the pixels
+	inside the mask. Per-polygon results are available from GetPolygonHits() afterwards.
+
+	@return The highest hit rate of any pixel inside the mask
  */
 float EyeMask::CalculateHitRate(
 	EyeWaveform* cap,
@@ -245,76 +265,279 @@ float EyeMask::CalculateHitRate(
 	float xoff
 	) const
 {
-	//TODO: performance optimization, don't re-render mask every waveform, only when we resize
+	UpdateRasterCache(cap, width, height, fullscalerange, xscale, xoff);
 
-	//Create the Cairo surface we're drawing on
-	Cairo::RefPtr< Cairo::ImageSurface > surface =
-		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
-	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
-
-	//Clear to a blank background
-	cr->set_source_rgba(0, 0, 0, 1);
-	cr->rectangle(0, 0, width, height);
-	cr->fill();
-
-	//Software rendering
-	float yscale = height / fullscalerange;
-	RenderForAnalysis(
-		cr,
-		cap,
-		xscale,
-		xoff,
-		yscale,
-		0,
-		height);
+	m_polygonHits.clear();
+	m_polygonHits.resize(m_polygons.size());
 
 	//Test each pixel of the eye pattern against the mask
 	float nmax = 0;
 	if(cap->GetType() == EyeWaveform::EYE_NORMAL)
 	{
 		auto accum = cap->GetAccumData();
-		uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
-		int stride = surface->get_stride() / sizeof(uint32_t);
-		for(size_t y=0; y<height; y++)
+		for(auto& span : m_cachedSpans)
 		{
-			auto row = data + (y*stride);
-			auto eyerow = accum + (y*width);
-			for(size_t x=0; x<width; x++)
-			{
-				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				if( (pix & 0xff) != 0)
-				{
-					float rate = (eyerow[x] * 1.0f / cap->GetTotalUIs());
-					if(rate > nmax)
-						nmax = rate;
-				}
-			}
+			int64_t sum = 0;
+			int64_t peak = 0;
+
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				ReduceSpanAVX2(accum + span.m_start, span.m_len, sum, peak);
+			else
+			#endif
+				ReduceSpanGeneric(accum + span.m_start, span.m_len, sum, peak);
+
+			auto& hits = m_polygonHits[span.m_polygon];
+			float rate = peak * 1.0f / cap->GetTotalUIs();
+			hits.m_pixels += span.m_len;
+			hits.m_hits += sum;
+			if(rate > hits.m_maxRate)
+				hits.m_maxRate = rate;
 		}
 	}
 	else //if(cap->GetType() == EyeWaveform::EYE_BER)
 	{
+		//BER eyes don't need any preprocessing since the pixel values are already raw BER
 		auto accum = cap->GetData();
+		for(auto& span : m_cachedSpans)
+		{
+			int64_t nonzero = 0;
+			float peak = 0;
+
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				ReduceSpanAVX2(accum + span.m_start, span.m_len, nonzero, peak);
+			else
+			#endif
+				ReduceSpanGeneric(accum + span.m_start, span.m_len, nonzero, peak);
+
+			auto& hits = m_polygonHits[span.m_polygon];
+			hits.m_pixels += span.m_len;
+			hits.m_hits += nonzero;
+			if(peak > hits.m_maxRate)
+				hits.m_maxRate = peak;
+		}
+	}
+
+	for(auto& hits : m_polygonHits)
+	{
+		if(hits.m_maxRate > nmax)
+			nmax = hits.m_maxRate;
+	}
+
+	return nmax;
+}
+
+/**
+	@brief Makes sure the cached mask rasterization matches the current pixel-space mask geometry
+
+	@return True if the cache was rebuilt
+ */
+bool EyeMask::UpdateRasterCache(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff) const
+{
+	//Transform every vertex to pixel coordinates, same as RenderPolygon(), and quantize
+	vector<int64_t> geometry;
+	geometry.push_back(width);
+	geometry.push_back(height);
+	float yscale = height / fullscalerange;
+	float uiwidth = cap->GetUIWidth();
+	for(auto& poly : m_polygons)
+	{
+		geometry.push_back(poly.m_points.size());
+		for(auto& point : poly.m_points)
+		{
+			float time = point.m_time;
+			if(m_timebaseIsRelative)
+				time *= uiwidth;
+
+			float x = (time - xoff) * xscale;
+			float y = height/2 - (point.m_voltage * yscale);
+			geometry.push_back(llround(x * 64));
+			geometry.push_back(llround(y * 64));
+		}
+	}
+
+	if(geometry == m_cachedGeometry)
+		return false;
+
+	m_cachedGeometry = geometry;
+	RasterizeSpans(cap, width, height, fullscalerange, xscale, xoff);
+	return true;
+}
+
+/**
+	@brief Renders the mask in software and converts it to runs of covered pixels
+ */
+void EyeMask::RasterizeSpans(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff) const
+{
+	m_cachedSpans.clear();
+
+	//Create the Cairo surface we're drawing on
+	Cairo::RefPtr< Cairo::ImageSurface > surface =
+		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
+
+	//Render each polygon on its own so every covered pixel can be attributed to one polygon.
+	//Pixels are numbered from 1, 0 is outside the mask. If polygons overlap the last one wins.
+	vector<uint32_t> plane(width * height, 0);
+	float yscale = height / fullscalerange;
+	for(size_t i=0; i<m_polygons.size(); i++)
+	{
+		//Clear to a blank background
+		cr->set_source_rgba(0, 0, 0, 1);
+		cr->rectangle(0, 0, width, height);
+		cr->fill();
+
+		//Software rendering
+		cr->set_source_rgba(1, 1, 1, 1);
+		RenderPolygon(cr, m_polygons[i], cap, xscale, xoff, yscale, 0, height);
+		surface->flush();
+
 		uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
 		int stride = surface->get_stride() / sizeof(uint32_t);
 		for(size_t y=0; y<height; y++)
 		{
 			auto row = data + (y*stride);
-			auto eyerow = accum + (y*width);
+			auto planerow = plane.data() + (y*width);
 			for(size_t x=0; x<width; x++)
 			{
-				//If mask pixel isn't black, count violations
-				uint32_t pix = row[x];
-				if( (pix & 0xff) != 0)
-				{
-					//BER eyes don't need any preprocessing since the pixel values are already raw BER
-					float rate = eyerow[x];
-					if(rate > nmax)
-						nmax = rate;
-				}
+				//Mask pixel isn't black
+				if( (row[x] & 0xff) != 0)
+					planerow[x] = i+1;
 			}
 		}
 	}
 
-	return nmax;
+	//Convert to runs
+	for(size_t y=0; y<height; y++)
+	{
+		auto planerow = plane.data() + (y*width);
+		size_t x = 0;
+		while(x < width)
+		{
+			uint32_t id = planerow[x];
+			size_t start = x;
+			while( (x < width) && (planerow[x] == id) )
+				x++;
+
+			if(id != 0)
+				m_cachedSpans.push_back(MaskSpan{y*width + start, x - start, id - 1});
+		}
+	}
+}
+
+/**
+	@brief Sums the hit counts in a run of pixels and finds the largest
+
+	@param p	Accumulator bins
+	@param len	Number of bins
+	@param sum	Running sum of bins
+	@param peak	Running maximum of bins
+ */
+void EyeMask::ReduceSpanGeneric(const int64_t* p, size_t len, int64_t& sum, int64_t& peak)
+{
+	for(size_t i=0; i<len; i++)
+	{
+		sum += p[i];
+		if(p[i] > peak)
+			peak = p[i];
+	}
+}
+
+/**
+	@brief Counts nonzero pixels in a run of BER values and finds the largest
+
+	@param p		BER values
+	@param len		Number of values
+	@param nonzero	Running count of values greater than zero
+	@param peak		Running maximum of values
+ */
+void EyeMask::ReduceSpanGeneric(const float* p, size_t len, int64_t& nonzero, float& peak)
+{
+	for(size_t i=0; i<len; i++)
+	{
+		if(p[i] > 0)
+			nonzero ++;
+		if(p[i] > peak)
+			peak = p[i];
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void EyeMask::ReduceSpanAVX2(const int64_t* p, size_t len, int64_t& sum, int64_t& peak)
+{
+	size_t end = len - (len % 4);
+
+	__m256i vsum = _mm256_setzero_si256();
+	__m256i vpeak = _mm256_set1_epi64x(peak);
+	for(size_t i=0; i<end; i+=4)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+		vsum = _mm256_add_epi64(vsum, v);
+		vpeak = _mm256_blendv_epi8(vpeak, v, _mm256_cmpgt_epi64(v, vpeak));
+	}
+
+	//Horizontal reduction
+	int64_t sums[4];
+	int64_t peaks[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), vsum);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(peaks), vpeak);
+	for(size_t i=0; i<4; i++)
+	{
+		sum += sums[i];
+		if(peaks[i] > peak)
+			peak = peaks[i];
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	ReduceSpanGeneric(p + end, len - end, sum, peak);
+}
+
+__attribute__((target("avx2")))
+void EyeMask::ReduceSpanAVX2(const float* p, size_t len, int64_t& nonzero, float& peak)
+{
+	size_t end = len - (len % 8);
+
+	__m256 zero = _mm256_setzero_ps();
+	__m256 vpeak = _mm256_set1_ps(peak);
+	__m256i vcount = _mm256_setzero_si256();
+	for(size_t i=0; i<end; i+=8)
+	{
+		__m256 v = _mm256_loadu_ps(p + i);
+
+		//Compare mask is all ones (-1) in lanes greater than zero
+		vcount = _mm256_sub_epi32(vcount, _mm256_castps_si256(_mm256_cmp_ps(v, zero, _CMP_GT_OQ)));
+
+		//max_ps returns the second operand if either is NaN, so NaNs never become the peak
+		vpeak = _mm256_max_ps(v, vpeak);
+	}
+
+	//Horizontal reduction
+	int32_t counts[8];
+	float peaks[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), vcount);
+	_mm256_storeu_ps(peaks, vpeak);
+	for(size_t i=0; i<8; i++)
+	{
+		nonzero += counts[i];
+		if(peaks[i] > peak)
+			peak = peaks[i];
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	ReduceSpanGeneric(p + end, len - end, nonzero, peak);
 }
+#endif /* __x86_64__ */
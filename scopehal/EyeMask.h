@@ -67,6 +67,28 @@ public:
 	std::vector<EyeMaskPoint> m_points;
 };
 
+/**
+	@brief Results of testing a single EyeMaskPolygon against an eye pattern
+ */
+class EyeMaskPolygonHits
+{
+public:
+	EyeMaskPolygonHits()
+	: m_pixels(0)
+	, m_hits(0)
+	, m_maxRate(0)
+	{}
+
+	///@brief Number of eye pattern pixels covered by the polygon
+	size_t m_pixels;
+
+	///@brief Number of hits inside the polygon (sum of bins for normal eyes, count of nonzero pixels for BER eyes)
+	int64_t m_hits;
+
+	///@brief Highest hit rate of any pixel inside the polygon
+	float m_maxRate;
+};
+
 /**
 	@brief A mask used for checking eye patterns
  */
@@ -123,7 +145,25 @@ public:
 	const std::vector<EyeMaskPolygon>& GetPolygons() const
 	{ return m_polygons; }
 
+	/**
+		@brief Returns per-polygon results from the most recent call to CalculateHitRate()
+
+		Indexes match GetPolygons().
+	 */
+	const std::vector<EyeMaskPolygonHits>& GetPolygonHits() const
+	{ return m_polygonHits; }
+
 protected:
+	void RenderPolygon(
+		Cairo::RefPtr<Cairo::Context> cr,
+		const EyeMaskPolygon& poly,
+		EyeWaveform* waveform,
+		float xscale,
+		float xoff,
+		float yscale,
+		float yoff,
+		float height) const;
+
 	void RenderInternal(
 		Cairo::RefPtr<Cairo::Context> cr,
 		EyeWaveform* waveform,
@@ -143,6 +183,57 @@ protected:
 	bool m_timebaseIsRelative;
 
 	std::string m_maskname;
+
+	/**
+		@brief A horizontal run of eye pattern pixels covered by one polygon
+	 */
+	struct MaskSpan
+	{
+		///@brief Index of the first pixel (y*width + x)
+		size_t m_start;
+
+		///@brief Number of pixels in the run
+		size_t m_len;
+
+		///@brief Index of the polygon covering the run
+		size_t m_polygon;
+	};
+
+	bool UpdateRasterCache(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
+		float xscale,
+		float xoff) const;
+	void RasterizeSpans(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
+		float xscale,
+		float xoff) const;
+
+	static void ReduceSpanGeneric(const int64_t* p, size_t len, int64_t& sum, int64_t& peak);
+	static void ReduceSpanGeneric(const float* p, size_t len, int64_t& nonzero, float& peak);
+#ifdef __x86_64__
+	static void ReduceSpanAVX2(const int64_t* p, size_t len, int64_t& sum, int64_t& peak);
+	static void ReduceSpanAVX2(const float* p, size_t len, int64_t& nonzero, float& peak);
+#endif
+
+	/**
+		@brief Pixel-space geometry the raster cache was built for
+
+		Image size followed by every polygon vertex, in 1/64 pixel units. The cache is rebuilt whenever this changes,
+		which covers loading a new mask as well as resizing or rescaling the eye.
+	 */
+	mutable std::vector<int64_t> m_cachedGeometry;
+
+	///@brief Cached rasterization of the mask, as runs of covered pixels
+	mutable std::vector<MaskSpan> m_cachedSpans;
+
+	///@brief Per-polygon results of the last hit rate calculation
+	mutable std::vector<EyeMaskPolygonHits> m_polygonHits;
 };
 
 #endif
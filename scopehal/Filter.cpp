@@ -38,6 +38,7 @@
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
+#include <omp.h>
 
 using namespace std;
 
@@ -45,7 +46,8 @@ Filter::CreateMapType Filter::m_createprocs;
 set<Filter*> Filter::m_filters;
 
 mutex Filter::m_cacheMutex;
-map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_zeroCrossingCache;
+map<Filter::EdgeCacheKey, shared_future<Filter::EdgeList> > Filter::m_edgeCache;
+map<pair<WaveformBase*, uint64_t>, shared_future<Filter::StatisticsRef> > Filter::m_statisticsCache;
 
 map<string, unsigned int> Filter::m_instanceCount;
 
@@ -250,9 +252,11 @@ bool Filter::VerifyAllInputsOKAndSparseOrUniformDigital()
 		if(data->size() == 0)
 			return false;
 
+		//Packed waveforms are unpacked to uniform by GetInputWaveform()
 		auto ddata = dynamic_cast<SparseDigitalWaveform*>(data);
 		auto udata = dynamic_cast<UniformDigitalWaveform*>(data);
-		if( (ddata == nullptr) && (udata == nullptr) )
+		auto pdata = dynamic_cast<PackedDigitalWaveform*>(data);
+		if( (ddata == nullptr) && (udata == nullptr) && (pdata == nullptr) )
 			return false;
 	}
 
@@ -316,37 +320,7 @@ void Filter::FillDurationsAVX2(SparseWaveformBase& wfm)
  */
 void Filter::FindRisingEdges(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
 {
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
-	int64_t phoff = data->m_triggerPhase;
-	size_t len = data->size();
-	float fscale = data->m_timescale;
-
-	for(size_t i=1; i<len; i++)
-	{
-		bool value = data->m_samples[i] > threshold;
-
-		//Save the last value
-		if(first)
-		{
-			last = value;
-			first = false;
-			continue;
-		}
-		if(!value)
-			last = false;
-
-		//Skip samples with no rising edge
-		if(!value || last)
-			continue;
-
-		//Midpoint of the sample, plus the zero crossing
-		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-		int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-		edges.push_back(t);
-		last = true;
-	}
+	FindUniformEdges(data, threshold, edges, true);
 }
 
 /**
@@ -393,19 +367,6 @@ void Filter::FindRisingEdges(SparseAnalogWaveform* data, float threshold, std::v
  */
 void Filter::FindZeroCrossings(SparseAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
 {
-	pair<WaveformBase*, float> cachekey(data, threshold);
-
-	//Check cache
-	{
-		lock_guard<mutex> lock(m_cacheMutex);
-		auto it = m_zeroCrossingCache.find(cachekey);
-		if(it != m_zeroCrossingCache.end())
-		{
-			edges = it->second;
-			return;
-		}
-	}
-
 	//Find times of the zero crossings
 	bool first = true;
 	bool last = false;
@@ -435,10 +396,6 @@ void Filter::FindZeroCrossings(SparseAnalogWaveform* data, float threshold, std:
 		edges.push_back(t);
 		last = value;
 	}
-
-	//Add to cache
-	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache[cachekey] = edges;
 }
 
 /**
@@ -446,106 +403,229 @@ void Filter::FindZeroCrossings(SparseAnalogWaveform* data, float threshold, std:
  */
 void Filter::FindZeroCrossings(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
 {
-	pair<WaveformBase*, float> cachekey(data, threshold);
+	FindUniformEdges(data, threshold, edges, false);
+}
+
+/**
+	@brief Find threshold crossings in a uniform analog waveform, interpolating as necessary
 
-	//Check cache
+	Large waveforms are split into one block per thread. Since a crossing at sample i only depends on samples i-1
+	and i, each block is searched independently (looking back one sample across its starting boundary) and the
+	results concatenated in order.
+
+	For compatibility with the original implementation, crossings between the first two samples are not reported.
+
+	@param data			Input waveform
+	@param threshold	Threshold to compare against
+	@param edges		Timestamps of crossings are appended here
+	@param risingOnly	True to only report rising edges, false to report both polarities
+ */
+void Filter::FindUniformEdges(UniformAnalogWaveform* data, float threshold, vector<int64_t>& edges, bool risingOnly)
+{
+	size_t len = data->size();
+	if(len < 3)
+		return;
+
+	//Small waveforms aren't worth the threading overhead
+	size_t first = 2;
+	size_t count = len - first;
+	size_t numblocks = 1;
+	if(count >= 1024*1024)
+		numblocks = omp_get_max_threads();
+	if(numblocks <= 1)
 	{
-		lock_guard<mutex> lock(m_cacheMutex);
-		auto it = m_zeroCrossingCache.find(cachekey);
-		if(it != m_zeroCrossingCache.end())
-		{
-			edges = it->second;
-			return;
-		}
+		FindUniformEdgesBlock(data, threshold, edges, first, len, risingOnly);
+		return;
 	}
 
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
+	size_t lastblock = numblocks - 1;
+	size_t blocksize = count / numblocks;
+	blocksize = blocksize - (blocksize % 64);
+
+	vector<vector<int64_t>> blockEdges(numblocks);
+	#pragma omp parallel for
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t istart = first + i*blocksize;
+		size_t iend = istart + blocksize;
+		if(i == lastblock)
+			iend = len;
+
+		FindUniformEdgesBlock(data, threshold, blockEdges[i], istart, iend, risingOnly);
+	}
+
+	//Stitch the blocks back together
+	size_t total = edges.size();
+	for(auto& b : blockEdges)
+		total += b.size();
+	edges.reserve(total);
+	for(auto& b : blockEdges)
+		edges.insert(edges.end(), b.begin(), b.end());
+}
+
+/**
+	@brief Finds threshold crossings ending at samples [istart, iend) of a uniform analog waveform
+
+	Dispatches to the best available implementation for the current CPU.
+
+	@param istart	Index of the first sample to check for a crossing from the previous sample. Must be at least 1.
+	@param iend		One past the index of the last sample to check
+ */
+void Filter::FindUniformEdgesBlock(
+	UniformAnalogWaveform* data,
+	float threshold,
+	vector<int64_t>& edges,
+	size_t istart,
+	size_t iend,
+	bool risingOnly)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx512F)
+		FindUniformEdgesAVX512F(data, threshold, edges, istart, iend, risingOnly);
+	else if(g_hasAvx2)
+		FindUniformEdgesAVX2(data, threshold, edges, istart, iend, risingOnly);
+	else
+	#endif
+		FindUniformEdgesGeneric(data, threshold, edges, istart, iend, risingOnly);
+}
+
+/**
+	@brief Portable implementation of FindUniformEdgesBlock()
+ */
+void Filter::FindUniformEdgesGeneric(
+	UniformAnalogWaveform* data,
+	float threshold,
+	vector<int64_t>& edges,
+	size_t istart,
+	size_t iend,
+	bool risingOnly)
+{
 	int64_t phoff = data->m_triggerPhase;
-	size_t len = data->m_samples.size();
 	float fscale = data->m_timescale;
+	const float* samples = data->m_samples.GetCpuPointer();
 
-	for(size_t i=1; i<len; i++)
+	bool last = samples[istart-1] > threshold;
+	for(size_t i=istart; i<iend; i++)
 	{
-		bool value = data->m_samples[i] > threshold;
-
-		//Save the last value
-		if(first)
-		{
-			last = value;
-			first = false;
-			continue;
-		}
+		bool value = samples[i] > threshold;
 
 		//Skip samples with no transition
 		if(last == value)
 			continue;
+		last = value;
+		if(risingOnly && !value)
+			continue;
 
 		//Midpoint of the sample, plus the zero crossing
 		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
 		int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
 		edges.push_back(t);
-		last = value;
 	}
-
-	//Add to cache
-	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache[cachekey] = edges;
 }
 
+#ifdef __x86_64__
 /**
-	@brief Find edges in a waveform, discarding repeated samples
+	@brief AVX2 implementation of FindUniformEdgesBlock()
+
+	Compares eight samples (and the eight samples before them) per iteration, then only does any scalar work for
+	the set bits of the transition mask.
  */
-void Filter::FindZeroCrossings(SparseDigitalWaveform* data, vector<int64_t>& edges)
+__attribute__((target("avx2")))
+void Filter::FindUniformEdgesAVX2(
+	UniformAnalogWaveform* data,
+	float threshold,
+	vector<int64_t>& edges,
+	size_t istart,
+	size_t iend,
+	bool risingOnly)
 {
-	pair<WaveformBase*, float> cachekey(data, 0);
+	int64_t phoff = data->m_triggerPhase;
+	float fscale = data->m_timescale;
+	const float* samples = data->m_samples.GetCpuPointer();
+
+	__m256 vthresh = _mm256_set1_ps(threshold);
 
-	//Check cache
+	size_t i = istart;
+	for(; i+8 <= iend; i += 8)
 	{
-		lock_guard<mutex> lock(m_cacheMutex);
-		auto it = m_zeroCrossingCache.find(cachekey);
-		if(it != m_zeroCrossingCache.end())
+		__m256 cur = _mm256_loadu_ps(samples + i);
+		__m256 prev = _mm256_loadu_ps(samples + i - 1);
+
+		//Ordered compare, so NaNs are below threshold just like in the scalar code
+		unsigned int curmask = _mm256_movemask_ps(_mm256_cmp_ps(cur, vthresh, _CMP_GT_OQ));
+		unsigned int prevmask = _mm256_movemask_ps(_mm256_cmp_ps(prev, vthresh, _CMP_GT_OQ));
+		unsigned int hits = curmask ^ prevmask;
+		if(risingOnly)
+			hits &= curmask;
+
+		while(hits)
 		{
-			edges = it->second;
-			return;
+			size_t j = i + __builtin_ctz(hits);
+			hits &= hits - 1;
+
+			int64_t tfrac = fscale * InterpolateTime(data, j-1, threshold);
+			edges.push_back(phoff + data->m_timescale*(j-1) + tfrac);
 		}
 	}
 
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = data->m_samples[0];
-	int64_t phoff = data->m_timescale/2 + data->m_triggerPhase;
-	size_t len = data->m_samples.size();
-	for(size_t i=1; i<len; i++)
+	//Scalar cleanup of the last few samples
+	if(i < iend)
+		FindUniformEdgesGeneric(data, threshold, edges, i, iend, risingOnly);
+}
+
+/**
+	@brief AVX512F implementation of FindUniformEdgesBlock()
+
+	Same as the AVX2 version, but sixteen samples at a time using mask registers.
+ */
+__attribute__((target("avx512f")))
+void Filter::FindUniformEdgesAVX512F(
+	UniformAnalogWaveform* data,
+	float threshold,
+	vector<int64_t>& edges,
+	size_t istart,
+	size_t iend,
+	bool risingOnly)
+{
+	int64_t phoff = data->m_triggerPhase;
+	float fscale = data->m_timescale;
+	const float* samples = data->m_samples.GetCpuPointer();
+
+	__m512 vthresh = _mm512_set1_ps(threshold);
+
+	size_t i = istart;
+	for(; i+16 <= iend; i += 16)
 	{
-		bool value = data->m_samples[i];
+		__m512 cur = _mm512_loadu_ps(samples + i);
+		__m512 prev = _mm512_loadu_ps(samples + i - 1);
 
-		//Save the last value
-		if(first)
-		{
-			last = value;
-			first = false;
-			continue;
-		}
+		unsigned int curmask = _mm512_cmp_ps_mask(cur, vthresh, _CMP_GT_OQ);
+		unsigned int prevmask = _mm512_cmp_ps_mask(prev, vthresh, _CMP_GT_OQ);
+		unsigned int hits = curmask ^ prevmask;
+		if(risingOnly)
+			hits &= curmask;
 
-		//Skip samples with no transition
-		if(last == value)
-			continue;
+		while(hits)
+		{
+			size_t j = i + __builtin_ctz(hits);
+			hits &= hits - 1;
 
-		edges.push_back(phoff + data->m_timescale * data->m_offsets[i]);
-		last = value;
+			int64_t tfrac = fscale * InterpolateTime(data, j-1, threshold);
+			edges.push_back(phoff + data->m_timescale*(j-1) + tfrac);
+		}
 	}
 
-	//Add to cache
-	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache[cachekey] = edges;
+	//Scalar cleanup of the last few samples
+	if(i < iend)
+		FindUniformEdgesGeneric(data, threshold, edges, i, iend, risingOnly);
 }
+#endif /* __x86_64__ */
 
 /**
 	@brief Find edges in a waveform, discarding repeated samples
  */
-void Filter::FindZeroCrossings(UniformDigitalWaveform* data, vector<int64_t>& edges)
+void Filter::FindZeroCrossings(SparseDigitalWaveform* data, vector<int64_t>& edges)
 {
 	//Find times of the zero crossings
 	bool first = true;
@@ -568,11 +648,19 @@ void Filter::FindZeroCrossings(UniformDigitalWaveform* data, vector<int64_t>& ed
 		if(last == value)
 			continue;
 
-		edges.push_back(phoff + data->m_timescale * i);
+		edges.push_back(phoff + data->m_timescale * data->m_offsets[i]);
 		last = value;
 	}
 }
 
+/**
+	@brief Find edges in a waveform, discarding repeated samples
+ */
+void Filter::FindZeroCrossings(UniformDigitalWaveform* data, vector<int64_t>& edges)
+{
+	FindUniformDigitalEdges(data, edges, EDGE_ANY);
+}
+
 /**
 	@brief Find rising edges in a waveform
  */
@@ -608,29 +696,7 @@ void Filter::FindRisingEdges(SparseDigitalWaveform* data, vector<int64_t>& edges
  */
 void Filter::FindRisingEdges(UniformDigitalWaveform* data, vector<int64_t>& edges)
 {
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = data->m_samples[0];
-	int64_t phoff = data->m_timescale/2 + data->m_triggerPhase;
-	size_t len = data->m_samples.size();
-	for(size_t i=1; i<len; i++)
-	{
-		bool value = data->m_samples[i];
-
-		//Save the last value
-		if(first)
-		{
-			last = value;
-			first = false;
-			continue;
-		}
-
-		//Save samples with an edge
-		if(value && !last)
-			edges.push_back(phoff + data->m_timescale * i);
-
-		last = value;
-	}
+	FindUniformDigitalEdges(data, edges, EDGE_RISING);
 }
 
 /**
@@ -668,31 +734,159 @@ void Filter::FindFallingEdges(SparseDigitalWaveform* data, vector<int64_t>& edge
  */
 void Filter::FindFallingEdges(UniformDigitalWaveform* data, vector<int64_t>& edges)
 {
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = data->m_samples[0];
+	FindUniformDigitalEdges(data, edges, EDGE_FALLING);
+}
+
+/**
+	@brief Find edges in a uniform digital waveform, using the vectorized transition search
+
+	For compatibility with the original implementation, a transition between the first two samples is not reported.
+
+	@param data		Input waveform
+	@param edges	Timestamps of edges are appended here
+	@param type		Polarity of edges to report
+ */
+void Filter::FindUniformDigitalEdges(UniformDigitalWaveform* data, vector<int64_t>& edges, EdgeType type)
+{
+	vector<int64_t> index;
+	FindTransitionIndex(data, index);
 	int64_t phoff = data->m_timescale/2 + data->m_triggerPhase;
-	size_t len = data->m_samples.size();
-	for(size_t i=1; i<len; i++)
+	auto samples = data->m_samples.GetCpuPointer();
+
+	for(auto i : index)
 	{
-		bool value = data->m_samples[i];
+		if(i < 2)
+			continue;
 
-		//Save the last value
-		if(first)
-		{
-			last = value;
-			first = false;
+		if( (type == EDGE_RISING) && !samples[i] )
+			continue;
+		if( (type == EDGE_FALLING) && samples[i] )
 			continue;
-		}
 
-		//Save samples with an edge
-		if(!value && last)
-			edges.push_back(phoff + data->m_timescale * i);
+		edges.push_back(phoff + data->m_timescale * i);
+	}
+}
 
-		last = value;
+/**
+	@brief Find times of all transitions in a packed waveform, one 64-sample word at a time
+
+	Timestamps and edge positions match the UniformDigitalWaveform version, including not reporting a transition
+	between the first two samples.
+ */
+void Filter::FindZeroCrossings(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	data->FindEdges(
+		edges,
+		PackedDigitalWaveform::EDGE_ANY,
+		2,
+		data->m_timescale/2 + data->m_triggerPhase,
+		data->m_timescale);
+}
+
+/**
+	@brief Find rising edges in a packed waveform, one 64-sample word at a time
+
+	Timestamps and edge positions match the UniformDigitalWaveform version, including not reporting a transition
+	between the first two samples.
+ */
+void Filter::FindRisingEdges(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	data->FindEdges(
+		edges,
+		PackedDigitalWaveform::EDGE_RISING,
+		2,
+		data->m_timescale/2 + data->m_triggerPhase,
+		data->m_timescale);
+}
+
+/**
+	@brief Find falling edges in a packed waveform, one 64-sample word at a time
+
+	Timestamps and edge positions match the UniformDigitalWaveform version, including not reporting a transition
+	between the first two samples.
+ */
+void Filter::FindFallingEdges(PackedDigitalWaveform* data, vector<int64_t>& edges)
+{
+	data->FindEdges(
+		edges,
+		PackedDigitalWaveform::EDGE_FALLING,
+		2,
+		data->m_timescale/2 + data->m_triggerPhase,
+		data->m_timescale);
+}
+
+/**
+	@brief Finds the index of every sample in a uniform digital waveform which differs from the sample before it
+
+	Unlike FindZeroCrossings(), the output is in sample indexes rather than timestamps, and a transition between
+	the first two samples is reported.
+
+	@param data		Input waveform
+	@param indexes	Indexes of transitions are appended here, in ascending order
+ */
+void Filter::FindTransitionIndex(UniformDigitalWaveform* data, vector<int64_t>& indexes)
+{
+	size_t len = data->size();
+	if(len < 2)
+		return;
+
+	auto samples = reinterpret_cast<const uint8_t*>(data->m_samples.GetCpuPointer());
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		FindTransitionIndexAVX2(samples, indexes, 1, len);
+	else
+	#endif
+		FindTransitionIndexGeneric(samples, indexes, 1, len);
+}
+
+/**
+	@brief Portable implementation of FindTransitionIndex()
+
+	@param samples	Sample data (one byte per sample, 0 or 1)
+	@param indexes	Indexes of transitions are appended here
+	@param istart	First sample to compare against the one before it. Must be at least 1.
+	@param iend		One past the last sample to compare
+ */
+void Filter::FindTransitionIndexGeneric(const uint8_t* samples, vector<int64_t>& indexes, size_t istart, size_t iend)
+{
+	for(size_t i=istart; i<iend; i++)
+	{
+		if(samples[i] != samples[i-1])
+			indexes.push_back(i);
 	}
 }
 
+#ifdef __x86_64__
+/**
+	@brief AVX2 implementation of FindTransitionIndex()
+
+	Compares 32 samples against the 32 samples before them per iteration. Runs of constant samples cost one compare
+	per block, so only the transitions themselves need any scalar work.
+ */
+__attribute__((target("avx2")))
+void Filter::FindTransitionIndexAVX2(const uint8_t* samples, vector<int64_t>& indexes, size_t istart, size_t iend)
+{
+	size_t i = istart;
+	for(; i+32 <= iend; i += 32)
+	{
+		__m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+		__m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i - 1));
+		uint32_t hits = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(cur, prev)));
+
+		while(hits)
+		{
+			indexes.push_back(i + __builtin_ctz(hits));
+			hits &= hits - 1;
+		}
+	}
+
+	//Scalar cleanup of the last few samples
+	if(i < iend)
+		FindTransitionIndexGeneric(samples, indexes, i, iend);
+}
+#endif
+
 /**
 	@brief Find indices of peaks in a waveform
  */
@@ -809,6 +1003,271 @@ void Filter::FindPeaks(SparseAnalogWaveform* data, float peak_threshold, vector<
 	delete thresh_diff;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Averaging helpers
+
+/**
+	@brief Sums a block of samples
+
+	Accumulation is done in double precision so that long records don't lose the contribution of individual samples.
+	Large blocks are split across threads.
+
+	@param samples	Pointer to the first sample
+	@param len		Number of samples to sum
+ */
+double Filter::SumSamples(const float* samples, size_t len)
+{
+	//Small blocks aren't worth the threading overhead
+	size_t numblocks = 1;
+	if(len >= 1024*1024)
+		numblocks = omp_get_max_threads();
+	if(numblocks <= 1)
+		return SumSamplesBlock(samples, len);
+
+	size_t blocksize = len / numblocks;
+	blocksize = blocksize - (blocksize % 64);
+
+	double sum = 0;
+	#pragma omp parallel for reduction(+:sum)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t istart = i*blocksize;
+		size_t count = blocksize;
+		if(i == (numblocks - 1))
+			count = len - istart;
+
+		sum += SumSamplesBlock(samples + istart, count);
+	}
+	return sum;
+}
+
+/**
+	@brief Sums a block of samples on the current thread, using the best available implementation for the current CPU
+ */
+double Filter::SumSamplesBlock(const float* samples, size_t len)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return SumSamplesAVX2(samples, len);
+	else
+	#endif
+		return SumSamplesGeneric(samples, len);
+}
+
+/**
+	@brief Portable implementation of SumSamplesBlock()
+ */
+double Filter::SumSamplesGeneric(const float* samples, size_t len)
+{
+	double sum = 0;
+	for(size_t i=0; i<len; i++)
+		sum += samples[i];
+	return sum;
+}
+
+/**
+	@brief Computes a boxcar (moving) average of a block of samples
+
+	Output sample i is the mean of input samples [i, i+depth), so the input must have at least nout + depth - 1
+	samples.
+
+	The cost is independent of the depth: each output is computed from the previous one by adding the sample entering
+	the window and subtracting the one leaving it. The running sum is kept in double precision and the output is split
+	into chunks, each of which seeds its sum directly from the input. This bounds the accumulated rounding error and
+	allows the chunks to be processed in parallel.
+
+	@param in		Input samples
+	@param out		Output samples
+	@param nout		Number of output samples
+	@param depth	Number of input samples averaged into each output
+ */
+void Filter::MovingAverageSamples(const float* in, float* out, size_t nout, size_t depth)
+{
+	if(!nout || !depth)
+		return;
+
+	//Make chunks big enough that seeding the window sum is a small fraction of the work
+	size_t chunksize = max((size_t)65536, 16*depth);
+	size_t numchunks = (nout + chunksize - 1) / chunksize;
+
+	#pragma omp parallel for if(numchunks > 1)
+	for(size_t i=0; i<numchunks; i++)
+	{
+		size_t istart = i*chunksize;
+		size_t iend = min(istart + chunksize, nout);
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			MovingAverageSamplesAVX2(in, out, istart, iend, depth);
+		else
+		#endif
+			MovingAverageSamplesGeneric(in, out, istart, iend, depth);
+	}
+}
+
+/**
+	@brief Portable implementation of MovingAverageSamples() for output samples [istart, iend)
+ */
+void Filter::MovingAverageSamplesGeneric(const float* in, float* out, size_t istart, size_t iend, size_t depth)
+{
+	double scale = 1.0 / depth;
+	double sum = SumSamplesGeneric(in + istart, depth);
+	out[istart] = sum * scale;
+
+	for(size_t i=istart+1; i<iend; i++)
+	{
+		sum += static_cast<double>(in[i + depth - 1]) - static_cast<double>(in[i - 1]);
+		out[i] = sum * scale;
+	}
+}
+
+/**
+	@brief Blends a new waveform into an exponentially weighted running average
+
+	Computes acc[i] = acc[i]*decay + in[i]*(1-decay) for every sample.
+
+	@param acc		Running average, updated in place
+	@param in		New samples
+	@param len		Number of samples
+	@param decay	Weight given to the previous value of the running average
+ */
+void Filter::ExponentialBlendSamples(float* acc, const float* in, size_t len, float decay)
+{
+	//Small blocks aren't worth the threading overhead
+	size_t numblocks = 1;
+	if(len >= 1024*1024)
+		numblocks = omp_get_max_threads();
+
+	size_t blocksize = len / numblocks;
+	blocksize = blocksize - (blocksize % 64);
+
+	#pragma omp parallel for if(numblocks > 1)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t istart = i*blocksize;
+		size_t count = blocksize;
+		if(i == (numblocks - 1))
+			count = len - istart;
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ExponentialBlendSamplesAVX2(acc + istart, in + istart, count, decay);
+		else
+		#endif
+			ExponentialBlendSamplesGeneric(acc + istart, in + istart, count, decay);
+	}
+}
+
+/**
+	@brief Portable implementation of ExponentialBlendSamples() for a single block
+ */
+void Filter::ExponentialBlendSamplesGeneric(float* acc, const float* in, size_t len, float decay)
+{
+	float keep = 1 - decay;
+	for(size_t i=0; i<len; i++)
+		acc[i] = acc[i]*decay + in[i]*keep;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 implementation of SumSamplesBlock()
+ */
+__attribute__((target("avx2")))
+double Filter::SumSamplesAVX2(const float* samples, size_t len)
+{
+	//Two independent accumulators to hide the latency of the adds
+	__m256d sum0 = _mm256_setzero_pd();
+	__m256d sum1 = _mm256_setzero_pd();
+
+	size_t i = 0;
+	for(; i+8 <= len; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(samples + i);
+		sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+		sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+	}
+
+	//Horizontal sum of the accumulators
+	__m256d vsum = _mm256_add_pd(sum0, sum1);
+	__m128d hsum = _mm_add_pd(_mm256_castpd256_pd128(vsum), _mm256_extractf128_pd(vsum, 1));
+	double sum = _mm_cvtsd_f64(_mm_add_sd(hsum, _mm_unpackhi_pd(hsum, hsum)));
+
+	//Scalar cleanup of the last few samples
+	for(; i<len; i++)
+		sum += samples[i];
+	return sum;
+}
+
+/**
+	@brief AVX2 implementation of MovingAverageSamples() for output samples [istart, iend)
+
+	Computes the change in the window sum for four outputs at a time, then turns them into running sums with an
+	in-register prefix sum so the only serial dependency is one add per vector.
+ */
+__attribute__((target("avx2")))
+void Filter::MovingAverageSamplesAVX2(const float* in, float* out, size_t istart, size_t iend, size_t depth)
+{
+	double scale = 1.0 / depth;
+	double sum = SumSamplesAVX2(in + istart, depth);
+	out[istart] = sum * scale;
+
+	__m256d vscale = _mm256_set1_pd(scale);
+	__m256d vsum = _mm256_set1_pd(sum);
+	__m256d zero = _mm256_setzero_pd();
+
+	size_t i = istart + 1;
+	for(; i+4 <= iend; i += 4)
+	{
+		__m256d enter = _mm256_cvtps_pd(_mm_loadu_ps(in + i + depth - 1));
+		__m256d leave = _mm256_cvtps_pd(_mm_loadu_ps(in + i - 1));
+		__m256d delta = _mm256_sub_pd(enter, leave);
+
+		//Inclusive prefix sum of the four deltas: shift by one lane and add, then by two lanes and add
+		delta = _mm256_add_pd(delta, _mm256_blend_pd(_mm256_permute4x64_pd(delta, 0x90), zero, 0x1));
+		delta = _mm256_add_pd(delta, _mm256_blend_pd(_mm256_permute4x64_pd(delta, 0x40), zero, 0x3));
+
+		__m256d sums = _mm256_add_pd(vsum, delta);
+		_mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_mul_pd(sums, vscale)));
+
+		//Broadcast the last running sum for the next iteration
+		vsum = _mm256_permute4x64_pd(sums, 0xff);
+	}
+
+	//Scalar cleanup of the last few samples
+	sum = _mm256_cvtsd_f64(vsum);
+	for(; i<iend; i++)
+	{
+		sum += static_cast<double>(in[i + depth - 1]) - static_cast<double>(in[i - 1]);
+		out[i] = sum * scale;
+	}
+}
+
+/**
+	@brief AVX2 implementation of ExponentialBlendSamples() for a single block
+ */
+__attribute__((target("avx2")))
+void Filter::ExponentialBlendSamplesAVX2(float* acc, const float* in, size_t len, float decay)
+{
+	float keep = 1 - decay;
+	__m256 vdecay = _mm256_set1_ps(decay);
+	__m256 vkeep = _mm256_set1_ps(keep);
+
+	size_t i = 0;
+	for(; i+8 <= len; i += 8)
+	{
+		__m256 a = _mm256_mul_ps(_mm256_loadu_ps(acc + i), vdecay);
+		__m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i), vkeep);
+		_mm256_storeu_ps(acc + i, _mm256_add_ps(a, b));
+	}
+
+	//Scalar cleanup of the last few samples
+	for(; i<len; i++)
+		acc[i] = acc[i]*decay + in[i]*keep;
+}
+#endif /* __x86_64__ */
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Evaluation
 
@@ -829,6 +1288,75 @@ void Filter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> qu
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Incremental decoding
+
+/**
+	@brief Records the state of our inputs, configuration, and outputs after a call to Refresh()
+ */
+void Filter::MarkRefreshed()
+{
+	FlowGraphNode::MarkRefreshed();
+
+	m_lastRefreshOutputs.resize(m_streams.size());
+	for(size_t i=0; i<m_streams.size(); i++)
+	{
+		auto& snap = m_lastRefreshOutputs[i];
+		snap.m_data = m_streams[i].m_waveform;
+		snap.m_revision = snap.m_data ? snap.m_data->m_revision : 0;
+	}
+}
+
+/**
+	@brief Checks if our outputs are exactly as the last call to Refresh() left them
+
+	Derived classes with other output state (such as decoded packets) should extend this to check it as well.
+ */
+bool Filter::AreOutputsUnchangedSinceLastRefresh()
+{
+	if(m_lastRefreshOutputs.size() != m_streams.size())
+		return false;
+
+	for(size_t i=0; i<m_streams.size(); i++)
+	{
+		auto& snap = m_lastRefreshOutputs[i];
+		auto data = m_streams[i].m_waveform;
+		if(data != snap.m_data)
+			return false;
+		if(data && (data->m_revision != snap.m_revision))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Determines whether this refresh can resume decoding from where the last one left off
+
+	This is the entry point of the incremental decode contract for filters whose input is a live capture which is
+	appended to in place (see Oscilloscope::IsAppendingToWaveform()), such as the output of SocketCANAnalyzer.
+
+	A filter implementing the contract keeps its decoder state in member variables rather than locals. At the start
+	of Refresh() it calls this function; if it returns true, the filter restores that state, processes input samples
+	[start, size), and appends the new symbols (and packets, for a PacketDecoder) to its existing outputs. Otherwise
+	it resets its state and decodes the whole input into freshly cleared outputs, as usual.
+
+	Outputs which were only appended to should be marked with WaveformBase::MarkSamplesAppended(), so that
+	downstream filters can decode incrementally too. Outputs which had any existing samples changed or removed
+	must have m_revision incremented instead.
+
+	@param i		Index of the input which may have grown
+	@param start	Set to the index of the first input sample not yet decoded if the return value is true
+
+	@return True if the filter may resume decoding at sample start
+ */
+bool Filter::GetAppendedInputStart(size_t i, size_t& start)
+{
+	if(!IsInputAppendedSinceLastRefresh(i, start))
+		return false;
+	return AreOutputsUnchangedSinceLastRefresh();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
@@ -1031,10 +1559,557 @@ float Filter::InterpolateValue(UniformAnalogWaveform* cap, size_t index, float f
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Measurement helpers
 
+/**
+	@brief Clears the edge and statistics caches.
+
+	Edge lists and statistics already handed out remain valid for as long as their holders keep a reference.
+ */
 void Filter::ClearAnalysisCache()
 {
 	lock_guard<mutex> lock(m_cacheMutex);
-	m_zeroCrossingCache.clear();
+	m_edgeCache.clear();
+	m_statisticsCache.clear();
+}
+
+/**
+	@brief Looks up a list of edges in the cache, calling the finder to create it if not present
+
+	The cache is keyed by waveform pointer, revision, threshold, and edge type, so a recycled or modified waveform
+	never returns stale results. If another thread is already searching the same waveform, we block until it's done
+	and share its result rather than repeating the work.
+ */
+Filter::EdgeList Filter::GetCachedEdges(
+	WaveformBase* data,
+	float threshold,
+	EdgeType type,
+	function<void(vector<int64_t>&)> finder)
+{
+	if(data == nullptr)
+		return make_shared<const vector<int64_t> >();
+
+	EdgeCacheKey key{data, data->m_revision, threshold, type};
+
+	//See if somebody has already found (or is currently finding) these edges.
+	//If not, promise to do it ourself.
+	promise<EdgeList> result;
+	shared_future<EdgeList> pending;
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_edgeCache.find(key);
+		if(it != m_edgeCache.end())
+			pending = it->second;
+		else
+			m_edgeCache.emplace(key, result.get_future().share());
+	}
+
+	//Cache hit, wait for whoever got there first to finish (usually they already have)
+	if(pending.valid())
+		return pending.get();
+
+	//Do the actual search without holding the lock
+	auto edges = make_shared<vector<int64_t> >();
+	finder(*edges);
+
+	EdgeList ret = edges;
+	result.set_value(ret);
+	return ret;
+}
+
+/**
+	@brief Gets the statistics of a waveform (cached)
+ */
+Filter::StatisticsRef Filter::GetStatistics(SparseAnalogWaveform* wfm)
+{
+	if(wfm == nullptr)
+		return GetCachedStatistics(nullptr, nullptr, 0);
+	return GetCachedStatistics(wfm, wfm->m_samples.GetCpuPointer(), wfm->size());
+}
+
+/**
+	@brief Gets the statistics of a waveform (cached)
+ */
+Filter::StatisticsRef Filter::GetStatistics(UniformAnalogWaveform* wfm)
+{
+	if(wfm == nullptr)
+		return GetCachedStatistics(nullptr, nullptr, 0);
+	return GetCachedStatistics(wfm, wfm->m_samples.GetCpuPointer(), wfm->size());
+}
+
+/**
+	@brief Looks up the statistics of a waveform in the cache, computing them if not present
+
+	Like the edge cache, entries are keyed by waveform pointer and revision, and concurrent requests for the same
+	waveform share a single computation. The samples must already be accessible from the CPU.
+ */
+Filter::StatisticsRef Filter::GetCachedStatistics(WaveformBase* wfm, const float* samples, size_t len)
+{
+	if(wfm == nullptr)
+	{
+		auto empty = make_shared<WaveformStatistics>();
+		ComputeStatistics(nullptr, 0, *empty);
+		return empty;
+	}
+
+	auto key = make_pair(wfm, wfm->m_revision);
+
+	//See if somebody has already computed (or is currently computing) these statistics.
+	//If not, promise to do it ourself.
+	promise<StatisticsRef> result;
+	shared_future<StatisticsRef> pending;
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_statisticsCache.find(key);
+		if(it != m_statisticsCache.end())
+			pending = it->second;
+		else
+			m_statisticsCache.emplace(key, result.get_future().share());
+	}
+
+	//Cache hit, wait for whoever got there first to finish (usually they already have)
+	if(pending.valid())
+	{
+		auto ret = pending.get();
+
+		//Sanity check: a waveform resized without bumping the revision is a bug elsewhere, but don't return garbage
+		if(ret->m_count == len)
+			return ret;
+
+		auto fresh = make_shared<WaveformStatistics>();
+		ComputeStatistics(samples, len, *fresh);
+		return fresh;
+	}
+
+	//Do the actual computation without holding the lock
+	auto stats = make_shared<WaveformStatistics>();
+	ComputeStatistics(samples, len, *stats);
+
+	StatisticsRef ret = stats;
+	result.set_value(ret);
+	return ret;
+}
+
+/**
+	@brief Gets the most probable "0" level of the waveform
+
+	This is the center of the tallest histogram bin in the lowest quarter of the range.
+ */
+float Filter::WaveformStatistics::GetBase() const
+{
+	const size_t nbins = HISTOGRAM_BINS;
+
+	//Find the highest peak in the first quarter of the histogram
+	size_t binval = 0;
+	size_t idx = 0;
+	for(size_t i=0; i<(nbins/4); i++)
+	{
+		if(m_histogram[i] > binval)
+		{
+			binval = m_histogram[i];
+			idx = i;
+		}
+	}
+
+	float fbin = (idx + 0.5f)/nbins;
+	return fbin*(m_max - m_min) + m_min;
+}
+
+/**
+	@brief Gets the most probable "1" level of the waveform
+
+	This is the center of the tallest histogram bin in the highest quarter of the range.
+ */
+float Filter::WaveformStatistics::GetTop() const
+{
+	const size_t nbins = HISTOGRAM_BINS;
+
+	//Find the highest peak in the last quarter of the histogram
+	size_t binval = 0;
+	size_t idx = 0;
+	for(size_t i=(nbins*3)/4; i<nbins; i++)
+	{
+		if(m_histogram[i] > binval)
+		{
+			binval = m_histogram[i];
+			idx = i;
+		}
+	}
+
+	float fbin = (idx + 0.5f)/nbins;
+	return fbin*(m_max - m_min) + m_min;
+}
+
+/**
+	@brief Computes all of the statistics for a block of samples
+
+	The moments are computed in one pass over the data. The histogram needs the final range, so it takes a second pass.
+	Large waveforms are split across threads for both passes.
+ */
+void Filter::ComputeStatistics(const float* samples, size_t len, WaveformStatistics& stats)
+{
+	const size_t nbins = WaveformStatistics::HISTOGRAM_BINS;
+
+	stats.m_count = len;
+	stats.m_min = FLT_MAX;
+	stats.m_max = -FLT_MAX;
+	stats.m_sum = 0;
+	stats.m_sumSquares = 0;
+	stats.m_histogram.assign(nbins, 0);
+	if(len == 0)
+		return;
+
+	//Small waveforms aren't worth the threading overhead
+	size_t numblocks = 1;
+	if(len >= 1024*1024)
+		numblocks = omp_get_max_threads();
+
+	size_t blocksize = len / numblocks;
+	blocksize = blocksize - (blocksize % 64);
+
+	//First pass: range and moments
+	vector<float> mins(numblocks);
+	vector<float> maxes(numblocks);
+	vector<double> sums(numblocks);
+	vector<double> squares(numblocks);
+	#pragma omp parallel for if(numblocks > 1)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t istart = i*blocksize;
+		size_t count = blocksize;
+		if(i == (numblocks - 1))
+			count = len - istart;
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ComputeMomentsAVX2(samples + istart, count, mins[i], maxes[i], sums[i], squares[i]);
+		else
+		#endif
+			ComputeMomentsGeneric(samples + istart, count, mins[i], maxes[i], sums[i], squares[i]);
+	}
+
+	for(size_t i=0; i<numblocks; i++)
+	{
+		stats.m_min = min(stats.m_min, mins[i]);
+		stats.m_max = max(stats.m_max, maxes[i]);
+		stats.m_sum += sums[i];
+		stats.m_sumSquares += squares[i];
+	}
+
+	//Constant waveform, everything goes in the first bin
+	if(!(stats.m_max > stats.m_min))
+	{
+		stats.m_histogram[0] = len;
+		return;
+	}
+
+	//Second pass: histogram
+	vector<vector<size_t> > hists(numblocks, vector<size_t>(nbins, 0));
+	#pragma omp parallel for if(numblocks > 1)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		size_t istart = i*blocksize;
+		size_t count = blocksize;
+		if(i == (numblocks - 1))
+			count = len - istart;
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ComputeHistogramAVX2(samples + istart, count, stats.m_min, stats.m_max, hists[i]);
+		else
+		#endif
+			ComputeHistogramGeneric(samples + istart, count, stats.m_min, stats.m_max, hists[i]);
+	}
+
+	for(auto& h : hists)
+	{
+		for(size_t i=0; i<nbins; i++)
+			stats.m_histogram[i] += h[i];
+	}
+}
+
+/**
+	@brief Portable implementation of the first ComputeStatistics() pass for a single block
+
+	NaN samples are ignored by the minimum and maximum.
+ */
+void Filter::ComputeMomentsGeneric(
+	const float* samples, size_t len, float& vmin, float& vmax, double& sum, double& sumSquares)
+{
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
+	sum = 0;
+	sumSquares = 0;
+	for(size_t i=0; i<len; i++)
+	{
+		float f = samples[i];
+		if(f < vmin)
+			vmin = f;
+		if(f > vmax)
+			vmax = f;
+		sum += f;
+		sumSquares += static_cast<double>(f) * f;
+	}
+}
+
+/**
+	@brief Portable implementation of the histogram pass of ComputeStatistics() for a single block
+
+	Bins are computed the same way as MakeHistogram(). Values outside the range, and NaNs, are clamped to the end bins.
+ */
+void Filter::ComputeHistogramGeneric(
+	const float* samples, size_t len, float low, float high, vector<size_t>& hist)
+{
+	size_t bins = hist.size();
+	float delta = high - low;
+	for(size_t i=0; i<len; i++)
+	{
+		float fbin = (samples[i] - low) / delta;
+		size_t bin = 0;
+		if(fbin > 0)
+			bin = min(static_cast<size_t>(fbin * bins), bins-1);
+		hist[bin] ++;
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 implementation of the first ComputeStatistics() pass for a single block
+ */
+__attribute__((target("avx2")))
+void Filter::ComputeMomentsAVX2(
+	const float* samples, size_t len, float& vmin, float& vmax, double& sum, double& sumSquares)
+{
+	__m256 vmin8 = _mm256_set1_ps(FLT_MAX);
+	__m256 vmax8 = _mm256_set1_ps(-FLT_MAX);
+	__m256d sum4 = _mm256_setzero_pd();
+	__m256d squares4 = _mm256_setzero_pd();
+
+	size_t i = 0;
+	for(; i+8 <= len; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(samples + i);
+
+		//If either input is NaN the second operand is returned, so NaN samples are ignored
+		vmin8 = _mm256_min_ps(v, vmin8);
+		vmax8 = _mm256_max_ps(v, vmax8);
+
+		__m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+		__m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+		sum4 = _mm256_add_pd(sum4, _mm256_add_pd(lo, hi));
+		squares4 = _mm256_add_pd(squares4, _mm256_add_pd(_mm256_mul_pd(lo, lo), _mm256_mul_pd(hi, hi)));
+	}
+
+	//Horizontal reductions
+	float mins[8];
+	float maxes[8];
+	double sums[4];
+	double squares[4];
+	_mm256_storeu_ps(mins, vmin8);
+	_mm256_storeu_ps(maxes, vmax8);
+	_mm256_storeu_pd(sums, sum4);
+	_mm256_storeu_pd(squares, squares4);
+
+	//Scalar cleanup of the last few samples
+	ComputeMomentsGeneric(samples + i, len - i, vmin, vmax, sum, sumSquares);
+	for(int j=0; j<8; j++)
+	{
+		vmin = min(vmin, mins[j]);
+		vmax = max(vmax, maxes[j]);
+	}
+	for(int j=0; j<4; j++)
+	{
+		sum += sums[j];
+		sumSquares += squares[j];
+	}
+}
+
+/**
+	@brief AVX2 implementation of the histogram pass of ComputeStatistics() for a single block
+
+	Bin indexes are computed eight at a time with exactly the same floating point operations as the scalar version,
+	then the counts are incremented one at a time.
+ */
+__attribute__((target("avx2")))
+void Filter::ComputeHistogramAVX2(
+	const float* samples, size_t len, float low, float high, vector<size_t>& hist)
+{
+	size_t bins = hist.size();
+	__m256 vlow = _mm256_set1_ps(low);
+	__m256 vdelta = _mm256_set1_ps(high - low);
+	__m256 vbins = _mm256_set1_ps(bins);
+	__m256i vzero = _mm256_setzero_si256();
+	__m256i vlast = _mm256_set1_epi32(bins - 1);
+
+	size_t i = 0;
+	int32_t idx[8];
+	for(; i+8 <= len; i += 8)
+	{
+		__m256 fbin = _mm256_div_ps(_mm256_sub_ps(_mm256_loadu_ps(samples + i), vlow), vdelta);
+
+		//Truncation is the same as floor for positive values, and NaNs convert to INT_MIN and clamp to zero
+		__m256i bin = _mm256_cvttps_epi32(_mm256_mul_ps(fbin, vbins));
+		bin = _mm256_min_epi32(_mm256_max_epi32(bin, vzero), vlast);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(idx), bin);
+
+		for(int j=0; j<8; j++)
+			hist[idx[j]] ++;
+	}
+
+	//Scalar cleanup of the last few samples
+	ComputeHistogramGeneric(samples + i, len - i, low, high, hist);
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Find zero crossings in a waveform, interpolating as necessary (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(SparseAnalogWaveform* data, float threshold)
+{
+	return GetCachedEdges(data, threshold, EDGE_ANY,
+		[&](vector<int64_t>& edges){ FindZeroCrossings(data, threshold, edges); });
+}
+
+/**
+	@brief Find zero crossings in a waveform, interpolating as necessary (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(UniformAnalogWaveform* data, float threshold)
+{
+	return GetCachedEdges(data, threshold, EDGE_ANY,
+		[&](vector<int64_t>& edges){ FindZeroCrossings(data, threshold, edges); });
+}
+
+/**
+	@brief Find zero crossings in a sparse or uniform analog waveform (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(WaveformBase* data, float threshold)
+{
+	auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
+	if(udata)
+		return FindZeroCrossings(udata, threshold);
+	else
+		return FindZeroCrossings(dynamic_cast<SparseAnalogWaveform*>(data), threshold);
+}
+
+/**
+	@brief Find edges in a waveform, discarding repeated samples (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(SparseDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_ANY,
+		[&](vector<int64_t>& edges){ FindZeroCrossings(data, edges); });
+}
+
+/**
+	@brief Find edges in a waveform, discarding repeated samples (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(UniformDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_ANY,
+		[&](vector<int64_t>& edges){ FindZeroCrossings(data, edges); });
+}
+
+/**
+	@brief Find rising edges in a waveform, interpolating as necessary (cached)
+ */
+Filter::EdgeList Filter::FindRisingEdges(SparseAnalogWaveform* data, float threshold)
+{
+	return GetCachedEdges(data, threshold, EDGE_RISING,
+		[&](vector<int64_t>& edges){ FindRisingEdges(data, threshold, edges); });
+}
+
+/**
+	@brief Find rising edges in a waveform, interpolating as necessary (cached)
+ */
+Filter::EdgeList Filter::FindRisingEdges(UniformAnalogWaveform* data, float threshold)
+{
+	return GetCachedEdges(data, threshold, EDGE_RISING,
+		[&](vector<int64_t>& edges){ FindRisingEdges(data, threshold, edges); });
+}
+
+/**
+	@brief Find rising edges in a waveform (cached)
+ */
+Filter::EdgeList Filter::FindRisingEdges(SparseDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_RISING,
+		[&](vector<int64_t>& edges){ FindRisingEdges(data, edges); });
+}
+
+/**
+	@brief Find rising edges in a waveform (cached)
+ */
+Filter::EdgeList Filter::FindRisingEdges(UniformDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_RISING,
+		[&](vector<int64_t>& edges){ FindRisingEdges(data, edges); });
+}
+
+/**
+	@brief Find falling edges in a waveform (cached)
+ */
+Filter::EdgeList Filter::FindFallingEdges(SparseDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_FALLING,
+		[&](vector<int64_t>& edges){ FindFallingEdges(data, edges); });
+}
+
+/**
+	@brief Find falling edges in a waveform (cached)
+ */
+Filter::EdgeList Filter::FindFallingEdges(UniformDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_FALLING,
+		[&](vector<int64_t>& edges){ FindFallingEdges(data, edges); });
+}
+
+/**
+	@brief Find times of all transitions in a packed waveform (cached)
+ */
+Filter::EdgeList Filter::FindZeroCrossings(PackedDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_ANY,
+		[&](vector<int64_t>& edges){ FindZeroCrossings(data, edges); });
+}
+
+/**
+	@brief Find rising edges in a packed waveform (cached)
+ */
+Filter::EdgeList Filter::FindRisingEdges(PackedDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_RISING,
+		[&](vector<int64_t>& edges){ FindRisingEdges(data, edges); });
+}
+
+/**
+	@brief Find falling edges in a packed waveform (cached)
+ */
+Filter::EdgeList Filter::FindFallingEdges(PackedDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_FALLING,
+		[&](vector<int64_t>& edges){ FindFallingEdges(data, edges); });
+}
+
+/**
+	@brief Gets the sample indexes of all transitions in a uniform digital waveform (cached)
+
+	The index is built the first time it's asked for on each revision of a waveform, and shared by every filter
+	walking the same input. Event driven decoders should walk it with a TransitionCursor rather than calling this
+	once per edge.
+ */
+Filter::EdgeList Filter::GetTransitionIndex(UniformDigitalWaveform* data)
+{
+	return GetCachedEdges(data, 0, EDGE_TRANSITION_INDEX,
+		[&](vector<int64_t>& indexes){ FindTransitionIndex(data, indexes); });
+}
+
+/**
+	@brief Positions the cursor at the first transition after sample i, fetching the index if we don't have it yet
+ */
+void Filter::TransitionCursor::Seek(size_t i)
+{
+	if(!m_index)
+		m_index = GetTransitionIndex(m_wfm);
+	m_pos = upper_bound(m_index->begin(), m_index->end(), static_cast<int64_t>(i)) - m_index->begin();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1053,13 +2128,8 @@ void Filter::ClearAnalysisCache()
  */
 UniformAnalogWaveform* Filter::SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear)
 {
-	//Create the waveform, but only if necessary
-	auto cap = dynamic_cast<UniformAnalogWaveform*>(GetData(stream));
-	if(cap == NULL)
-	{
-		cap = new UniformAnalogWaveform;
-		SetData(cap, stream);
-	}
+	//Reuse the existing waveform if possible, otherwise get one from the pool
+	auto cap = GetPooledOutputWaveform<UniformAnalogWaveform>(stream, din->size());
 
 	//Copy configuration
 	cap->m_startTimestamp 		= din->m_startTimestamp;
@@ -1090,13 +2160,8 @@ UniformAnalogWaveform* Filter::SetupEmptyUniformAnalogOutputWaveform(WaveformBas
  */
 SparseAnalogWaveform* Filter::SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear)
 {
-	//Create the waveform, but only if necessary
-	auto cap = dynamic_cast<SparseAnalogWaveform*>(GetData(stream));
-	if(cap == NULL)
-	{
-		cap = new SparseAnalogWaveform;
-		SetData(cap, stream);
-	}
+	//Reuse the existing waveform if possible, otherwise get one from the pool
+	auto cap = GetPooledOutputWaveform<SparseAnalogWaveform>(stream, din->size());
 
 	//Copy configuration
 	cap->m_startTimestamp 		= din->m_startTimestamp;
@@ -1126,13 +2191,8 @@ SparseAnalogWaveform* Filter::SetupEmptySparseAnalogOutputWaveform(WaveformBase*
  */
 UniformDigitalWaveform* Filter::SetupEmptyUniformDigitalOutputWaveform(WaveformBase* din, size_t stream)
 {
-	//Create the waveform, but only if necessary
-	auto cap = dynamic_cast<UniformDigitalWaveform*>(GetData(stream));
-	if(cap == NULL)
-	{
-		cap = new UniformDigitalWaveform;
-		SetData(cap, stream);
-	}
+	//Reuse the existing waveform if possible, otherwise get one from the pool
+	auto cap = GetPooledOutputWaveform<UniformDigitalWaveform>(stream, din->size());
 
 	//Copy configuration
 	cap->m_startTimestamp 		= din->m_startTimestamp;
@@ -1161,13 +2221,8 @@ UniformDigitalWaveform* Filter::SetupEmptyUniformDigitalOutputWaveform(WaveformB
  */
 SparseDigitalWaveform* Filter::SetupEmptySparseDigitalOutputWaveform(WaveformBase* din, size_t stream)
 {
-	//Create the waveform, but only if necessary
-	auto cap = dynamic_cast<SparseDigitalWaveform*>(GetData(stream));
-	if(cap == NULL)
-	{
-		cap = new SparseDigitalWaveform;
-		SetData(cap, stream);
-	}
+	//Reuse the existing waveform if possible, otherwise get one from the pool
+	auto cap = GetPooledOutputWaveform<SparseDigitalWaveform>(stream, din->size());
 
 	//Copy configuration
 	cap->m_startTimestamp 		= din->m_startTimestamp;
@@ -1233,13 +2288,8 @@ SparseAnalogWaveform* Filter::SetupSparseOutputWaveform(SparseWaveformBase* din,
  */
 SparseDigitalWaveform* Filter::SetupSparseDigitalOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend)
 {
-	//Create the waveform, but only if necessary
-	auto cap = dynamic_cast<SparseDigitalWaveform*>(GetData(stream));
-	if(cap == NULL)
-	{
-		cap = new SparseDigitalWaveform;
-		SetData(cap, stream);
-	}
+	//Reuse the existing waveform if possible, otherwise get one from the pool
+	auto cap = GetPooledOutputWaveform<SparseDigitalWaveform>(stream, din->size());
 
 	//Copy configuration
 	cap->m_timescale 			= din->m_timescale;
@@ -1348,6 +2398,25 @@ void Filter::AdvanceToTimestampScaled(SparseWaveformBase* wfm, size_t& i, size_t
 		i ++;
 }
 
+/**
+	@brief Gets the timestamp of the next transition (if any) on a uniform digital waveform
+
+	Unlike the generic uniform version, this skips over runs of identical samples using a cursor into the waveform's
+	transition index, so a decoder stepping from event to event does work proportional to the number of edges rather
+	than the number of samples. The last sample of the waveform is always reported as an event so that a quiet input
+	doesn't end the decode early.
+
+	Works in native X axis units
+ */
+int64_t Filter::GetNextEventTimestampScaled(
+	UniformDigitalWaveform* wfm, TransitionCursor& cursor, size_t i, size_t len, int64_t timestamp)
+{
+	if(i+1 < len)
+		return (cursor.Next(i, len) * wfm->m_timescale) + wfm->m_triggerPhase;
+	else
+		return timestamp;
+}
+
 /**
 	@brief Advance the waveform to a given timestamp
 
@@ -1356,9 +2425,18 @@ void Filter::AdvanceToTimestampScaled(SparseWaveformBase* wfm, size_t& i, size_t
 void Filter::AdvanceToTimestampScaled(UniformWaveformBase* wfm, size_t& i, size_t len, int64_t timestamp)
 {
 	timestamp -= wfm->m_triggerPhase;
+	if( (timestamp <= 0) || (len == 0) )
+		return;
+	if(wfm->m_timescale <= 0)
+	{
+		i = len - 1;
+		return;
+	}
 
-	while( ((i+1) < len) && ( ( static_cast<int64_t>(i+1) * wfm->m_timescale) <= timestamp) )
-		i ++;
+	//Jump straight to the last sample at or before the timestamp, never moving backwards
+	size_t target = min(static_cast<size_t>(timestamp / wfm->m_timescale), len - 1);
+	if(target > i)
+		i = target;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1559,6 +2637,10 @@ float Filter::GetVoltageRange(size_t stream)
 
 void Filter::SetVoltageRange(float range, size_t stream)
 {
+	//Some filters (eye patterns etc) render differently depending on our vertical scale
+	if(m_ranges[stream] != range)
+		MarkConfigurationChanged();
+
 	m_ranges[stream] = range;
 }
 
@@ -1577,5 +2659,8 @@ float Filter::GetOffset(size_t stream)
 
 void Filter::SetOffset(float offset, size_t stream)
 {
+	if(m_offsets[stream] != offset)
+		MarkConfigurationChanged();
+
 	m_offsets[stream] = offset;
 }
@@ -38,6 +38,10 @@
 
 #include "OscilloscopeChannel.h"
 #include "FlowGraphNode.h"
+#include "PackedDigitalBusWaveform.h"
+
+#include <functional>
+#include <future>
 
 class QueueHandle;
 
@@ -194,6 +198,77 @@ public:
 	//GPU accelerated refresh method
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Segmented execution
+
+	/**
+		@brief Returns true if this filter produces correct output when its inputs are split into time segments
+		which are processed one at a time (see FilterGraphExecutor::RunSegmentedBlocking).
+
+		The filter must be causal apart from a bounded amount of context, reported by GetStreamingOverlap(), and must
+		not integrate data across refreshes.
+	 */
+	virtual bool IsStreamingCapable()
+	{ return false; }
+
+	/**
+		@brief Returns the amount of input context, in X axis units, this filter needs on each side of a segment in
+		order for its output within the segment to match what it would produce from the entire record.
+
+		This covers both filter kernel length and any state (PLL lock, frame alignment, etc) which must be recovered
+		at the start of each segment.
+	 */
+	virtual int64_t GetStreamingOverlap()
+	{ return 0; }
+
+	/**
+		@brief Returns true if this filter is a source which can produce its output one time segment at a time with
+		ReadSegment(), without loading the whole record.
+	 */
+	virtual bool CanReadSegments()
+	{ return false; }
+
+	/**
+		@brief Gets the time range of the record ReadSegment() reads from, and its sample interval
+
+		@return False if there is nothing to read
+	 */
+	virtual bool GetSegmentSpan(int64_t& /*start*/, int64_t& /*end*/, int64_t& /*interval*/)
+	{ return false; }
+
+	/**
+		@brief Sets the outputs of this filter to the samples of its record within [tstart, tend)
+
+		Called by FilterGraphExecutor::RunSegmentedBlocking() for each segment, in place of Refresh(), on sources
+		which return true from CanReadSegments().
+	 */
+	virtual void ReadSegment(int64_t /*tstart*/, int64_t /*tend*/)
+	{}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Incremental decoding
+
+	virtual void MarkRefreshed() override;
+
+protected:
+	virtual bool AreOutputsUnchangedSinceLastRefresh();
+	bool GetAppendedInputStart(size_t i, size_t& start);
+
+	///@brief State of one output stream as of the last call to MarkRefreshed()
+	struct OutputSnapshot
+	{
+		///@brief The waveform we left on the stream
+		WaveformBase* m_data;
+
+		///@brief Revision of m_data
+		uint64_t m_revision;
+	};
+
+	///@brief State of each output stream as of the last call to MarkRefreshed()
+	std::vector<OutputSnapshot> m_lastRefreshOutputs;
+
+public:
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Vertical scaling
 
@@ -263,8 +338,18 @@ public:
 			AdvanceToTimestamp(uwfm, i, len, timestamp);
 	}
 
+	class TransitionCursor;
+
 	static int64_t GetNextEventTimestampScaled(SparseWaveformBase* wfm, size_t i, size_t len, int64_t timestamp);
 	static int64_t GetNextEventTimestampScaled(UniformWaveformBase* wfm, size_t i, size_t len, int64_t timestamp);
+	static int64_t GetNextEventTimestampScaled(
+		UniformDigitalWaveform* wfm, TransitionCursor& cursor, size_t i, size_t len, int64_t timestamp);
+
+	///@brief Sparse waveforms already store one sample per event, so there's no index for the cursor to use
+	static int64_t GetNextEventTimestampScaled(
+		SparseDigitalWaveform* wfm, TransitionCursor& /*cursor*/, size_t i, size_t len, int64_t timestamp)
+	{ return GetNextEventTimestampScaled(wfm, i, len, timestamp); }
+
 	static void AdvanceToTimestampScaled(SparseWaveformBase* wfm, size_t& i, size_t len, int64_t timestamp);
 	static void AdvanceToTimestampScaled(UniformWaveformBase* wfm, size_t& i, size_t len, int64_t timestamp);
 
@@ -286,6 +371,20 @@ public:
 			return GetNextEventTimestampScaled(uwfm, i, len, timestamp);
 	}
 
+	static int64_t GetNextEventTimestampScaled(
+		SparseDigitalWaveform* swfm,
+		UniformDigitalWaveform* uwfm,
+		TransitionCursor& cursor,
+		size_t i,
+		size_t len,
+		int64_t timestamp)
+	{
+		if(swfm)
+			return GetNextEventTimestampScaled(swfm, i, len, timestamp);
+		else
+			return GetNextEventTimestampScaled(uwfm, cursor, i, len, timestamp);
+	}
+
 protected:
 	UniformAnalogWaveform* SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
 	SparseAnalogWaveform* SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
@@ -294,6 +393,25 @@ protected:
 	SparseAnalogWaveform* SetupSparseOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 	SparseDigitalWaveform* SetupSparseDigitalOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 
+	/**
+		@brief Gets the output waveform of a stream as type T, taking a new one from the global waveform pool if the
+		stream is empty or holds a waveform of another type (which is returned to the pool).
+
+		@param stream	Stream index
+		@param capacity	Expected number of samples, so that a pooled waveform which won't need reallocating is chosen
+	 */
+	template<class T>
+	T* GetPooledOutputWaveform(size_t stream, size_t capacity)
+	{
+		auto cap = dynamic_cast<T*>(GetData(stream));
+		if(cap == nullptr)
+		{
+			cap = g_waveformPool.Allocate<T>(capacity);
+			SetData(cap, stream);
+		}
+		return cap;
+	}
+
 public:
 	//Helpers for sub-sample interpolation
 
@@ -354,7 +472,69 @@ public:
 	static float InterpolateValue(UniformAnalogWaveform* cap, size_t index, float frac_ticks);
 
 	//Helpers for more complex measurements
-	//TODO: create some process for caching this so we don't waste CPU time
+
+	/**
+		@brief Summary statistics of an analog waveform
+
+		Computed by GetStatistics() and shared by all filters looking at the same revision of a waveform, so a set of
+		measurements on one signal only reads the samples once.
+	 */
+	class WaveformStatistics
+	{
+	public:
+		///@brief Number of bins in m_histogram
+		static const size_t HISTOGRAM_BINS = 100;
+
+		///@brief Number of samples in the waveform
+		size_t m_count;
+
+		///@brief Lowest sample value, or FLT_MAX if the waveform is empty
+		float m_min;
+
+		///@brief Highest sample value, or -FLT_MAX if the waveform is empty
+		float m_max;
+
+		///@brief Sum of all sample values
+		double m_sum;
+
+		///@brief Sum of the squares of all sample values
+		double m_sumSquares;
+
+		///@brief Histogram of sample values with HISTOGRAM_BINS bins spanning [m_min, m_max]
+		std::vector<size_t> m_histogram;
+
+		///@brief Gets the mean of the sample values
+		float GetAverage() const
+		{ return m_sum / m_count; }
+
+		///@brief Gets the RMS of the sample values
+		float GetRMS() const
+		{ return sqrt(m_sumSquares / m_count); }
+
+		float GetBase() const;
+		float GetTop() const;
+	};
+
+	/**
+		@brief Immutable statistics of a waveform, shared by all filters looking at the same waveform
+
+		Holding a reference keeps the statistics alive even after the cache is cleared.
+	 */
+	typedef std::shared_ptr<const WaveformStatistics> StatisticsRef;
+
+	static StatisticsRef GetStatistics(SparseAnalogWaveform* wfm);
+	static StatisticsRef GetStatistics(UniformAnalogWaveform* wfm);
+
+	/**
+		@brief Gets the statistics of a waveform which may be sparse or uniform
+	 */
+	static StatisticsRef GetStatistics(SparseAnalogWaveform* swfm, UniformAnalogWaveform* uwfm)
+	{
+		if(swfm)
+			return GetStatistics(swfm);
+		else
+			return GetStatistics(uwfm);
+	}
 
 	/**
 		@brief Gets the lowest and highest voltage of a waveform
@@ -365,15 +545,9 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		vmin = FLT_MAX;
-		vmax = FLT_MIN;
-		for(float f : cap->m_samples)
-		{
-			if(f < vmin)
-				vmin = f;
-			if(f > vmax)
-				vmax = f;
-		}
+		auto stats = GetStatistics(cap);
+		vmin = stats->m_min;
+		vmax = stats->m_max;
 	}
 
 	/**
@@ -385,14 +559,7 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		//Loop over samples and find the minimum
-		float tmp = FLT_MAX;
-		for(float f : cap->m_samples)
-		{
-			if(f < tmp)
-				tmp = f;
-		}
-		return tmp;
+		return GetStatistics(cap)->m_min;
 	}
 
 	/**
@@ -415,14 +582,7 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		//Loop over samples and find the maximum
-		float tmp = -FLT_MAX;
-		for(float f : cap->m_samples)
-		{
-			if(f > tmp)
-				tmp = f;
-		}
-		return tmp;
+		return GetStatistics(cap)->m_max;
 	}
 
 	/**
@@ -445,26 +605,7 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		float vmin = GetMinVoltage(cap);
-		float vmax = GetMaxVoltage(cap);
-		float delta = vmax - vmin;
-		const int nbins = 100;
-		auto hist = MakeHistogram(cap, vmin, vmax, nbins);
-
-		//Find the highest peak in the first quarter of the histogram
-		size_t binval = 0;
-		int idx = 0;
-		for(int i=0; i<(nbins/4); i++)
-		{
-			if(hist[i] > binval)
-			{
-				binval = hist[i];
-				idx = i;
-			}
-		}
-
-		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		return GetStatistics(cap)->GetBase();
 	}
 
 	/**
@@ -487,26 +628,7 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		float vmin = GetMinVoltage(cap);
-		float vmax = GetMaxVoltage(cap);
-		float delta = vmax - vmin;
-		const int nbins = 100;
-		auto hist = MakeHistogram(cap, vmin, vmax, nbins);
-
-		//Find the highest peak in the third quarter of the histogram
-		size_t binval = 0;
-		int idx = 0;
-		for(int i=(nbins*3)/4; i<nbins; i++)
-		{
-			if(hist[i] > binval)
-			{
-				binval = hist[i];
-				idx = i;
-			}
-		}
-
-		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		return GetStatistics(cap)->GetTop();
 	}
 
 	/**
@@ -529,12 +651,7 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
-		//Loop over samples and find the average
-		//TODO: more numerically stable summation algorithm for deep captures
-		double sum = 0;
-		for(float f : cap->m_samples)
-			sum += f;
-		return sum / cap->m_samples.size();
+		return GetStatistics(cap)->GetAverage();
 	}
 
 	/**
@@ -563,6 +680,14 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
+		//If asking for the same histogram as the cached statistics, reuse it
+		if(bins == WaveformStatistics::HISTOGRAM_BINS)
+		{
+			auto stats = GetStatistics(cap);
+			if( (low == stats->m_min) && (high == stats->m_max) )
+				return stats->m_histogram;
+		}
+
 		std::vector<size_t> ret;
 		for(size_t i=0; i<bins; i++)
 			ret.push_back(0);
@@ -643,6 +768,42 @@ public:
 		return ret;
 	}
 
+	/**
+		@brief Gets the index of the next clock sample after i which might be an edge, or len if there are none
+
+		Every sample is a candidate in the generic case. Uniform digital clocks skip straight to the next transition
+		using the cursor.
+	 */
+	static size_t NextClockTransition(TransitionCursor& cursor, size_t i, size_t len)
+	{
+		size_t next = cursor.Next(i, len);
+		return (next > i) ? next : len;
+	}
+
+	/**
+		@brief Moves ndata forward to the last data sample starting before a clock edge
+
+		Uniform waveforms compute the index directly rather than walking every sample in between.
+	 */
+	template<class T>
+	static void AdvanceDataToClock(T* data, size_t& ndata, size_t dlen, int64_t clkstart)
+	{
+		if(std::is_base_of<UniformWaveformBase, T>::value && (data->m_timescale > 0) )
+		{
+			int64_t delta = clkstart - data->m_triggerPhase;
+			if( (delta <= 0) || (dlen == 0) )
+				return;
+
+			size_t target = std::min(static_cast<size_t>((delta - 1) / data->m_timescale), dlen - 1);
+			if(target > ndata)
+				ndata = target;
+			return;
+		}
+
+		while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
+			ndata ++;
+	}
+
 	/**
 		@brief Samples a waveform on all edges of a clock
 
@@ -674,7 +835,8 @@ public:
 		size_t dlen = data->size();
 
 		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		TransitionCursor clockEdges(clock);
+		for(size_t i=1; i<len; i = NextClockTransition(clockEdges, i, len))
 		{
 			//Throw away clock samples until we find an edge
 			if(clock->m_samples[i] == clock->m_samples[i-1])
@@ -682,8 +844,7 @@ public:
 
 			//Throw away data samples until the data is synced with us
 			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
+			AdvanceDataToClock(data, ndata, dlen, clkstart);
 			if(ndata >= dlen)
 				break;
 
@@ -770,7 +931,8 @@ public:
 		size_t dlen = data->size();
 
 		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		TransitionCursor clockEdges(clock);
+		for(size_t i=1; i<len; i = NextClockTransition(clockEdges, i, len))
 		{
 			//Throw away clock samples until we find a rising edge
 			if(!(clock->m_samples[i] && !clock->m_samples[i-1]))
@@ -778,8 +940,7 @@ public:
 
 			//Throw away data samples until the data is synced with us
 			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
+			AdvanceDataToClock(data, ndata, dlen, clkstart);
 			if(ndata >= dlen)
 				break;
 
@@ -866,7 +1027,8 @@ public:
 		size_t dlen = data->size();
 
 		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		TransitionCursor clockEdges(clock);
+		for(size_t i=1; i<len; i = NextClockTransition(clockEdges, i, len))
 		{
 			//Throw away clock samples until we find a falling edge
 			if(!(!clock->m_samples[i] && clock->m_samples[i-1]))
@@ -874,8 +1036,7 @@ public:
 
 			//Throw away data samples until the data is synced with us
 			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
+			AdvanceDataToClock(data, ndata, dlen, clkstart);
 			if(ndata >= dlen)
 				break;
 
@@ -924,7 +1085,8 @@ public:
 		size_t dlen = data->size();
 
 		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		TransitionCursor clockEdges(clock);
+		for(size_t i=1; i<len; i = NextClockTransition(clockEdges, i, len))
 		{
 			//Throw away clock samples until we find an edge
 			if(clock->m_samples[i] == clock->m_samples[i-1])
@@ -932,8 +1094,7 @@ public:
 
 			//Throw away data samples until the data is synced with us
 			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
+			AdvanceDataToClock(data, ndata, dlen, clkstart);
 			if(ndata >= dlen)
 				break;
 
@@ -1018,6 +1179,131 @@ public:
 			u->PrepareForGpuAccess();
 	}
 
+	/**
+		@brief Immutable list of edge timestamps, shared by all filters looking at the same waveform
+
+		Returned by the cached edge finding functions. Holding a reference keeps the list alive even after the cache
+		is cleared.
+	 */
+	typedef std::shared_ptr<const std::vector<int64_t> > EdgeList;
+
+	static EdgeList FindZeroCrossings(SparseAnalogWaveform* data, float threshold);
+	static EdgeList FindZeroCrossings(UniformAnalogWaveform* data, float threshold);
+	static EdgeList FindZeroCrossings(SparseDigitalWaveform* data);
+	static EdgeList FindZeroCrossings(UniformDigitalWaveform* data);
+	static EdgeList FindRisingEdges(SparseAnalogWaveform* data, float threshold);
+	static EdgeList FindRisingEdges(UniformAnalogWaveform* data, float threshold);
+	static EdgeList FindRisingEdges(SparseDigitalWaveform* data);
+	static EdgeList FindRisingEdges(UniformDigitalWaveform* data);
+	static EdgeList FindFallingEdges(SparseDigitalWaveform* data);
+	static EdgeList FindFallingEdges(UniformDigitalWaveform* data);
+	static EdgeList FindZeroCrossings(PackedDigitalWaveform* data);
+	static EdgeList FindRisingEdges(PackedDigitalWaveform* data);
+	static EdgeList FindFallingEdges(PackedDigitalWaveform* data);
+
+	static EdgeList GetTransitionIndex(UniformDigitalWaveform* data);
+
+	/**
+		@brief Steps forward through the transitions of a uniform digital waveform
+
+		Keeps a reference to the waveform's transition index and a position in it, so each call only moves past the
+		transitions skipped since the last one. Create one per input at the start of a refresh and let it go out of
+		scope at the end, which also releases the index.
+
+		Any other waveform type has no index, and every sample is a candidate.
+	 */
+	class TransitionCursor
+	{
+	public:
+		TransitionCursor(WaveformBase* wfm)
+		: m_wfm(dynamic_cast<UniformDigitalWaveform*>(wfm))
+		, m_pos(0)
+		{}
+
+		/**
+			@brief Gets the index of the next sample after i which differs from the one before it
+
+			@return Index of the next transition, or the last sample of the waveform if there are no more
+		 */
+		size_t Next(size_t i, size_t len)
+		{
+			if(!m_wfm)
+				return i+1;
+
+			//Callers normally only move forward, so only search the index when starting out or going backwards
+			if(!m_index || ( (m_pos > 0) && (static_cast<size_t>((*m_index)[m_pos-1]) > i) ) )
+				Seek(i);
+
+			auto& index = *m_index;
+			while( (m_pos < index.size()) && (static_cast<size_t>(index[m_pos]) <= i) )
+				m_pos ++;
+
+			if(m_pos >= index.size())
+				return len - 1;
+			return std::min(static_cast<size_t>(index[m_pos]), len - 1);
+		}
+
+	protected:
+		void Seek(size_t i);
+
+		///@brief The waveform being walked, or null if it's not uniform digital
+		UniformDigitalWaveform* m_wfm;
+
+		///@brief Transition index of m_wfm, fetched on first use
+		EdgeList m_index;
+
+		///@brief Position of the first transition after the last sample asked about
+		size_t m_pos;
+	};
+
+	static EdgeList FindZeroCrossings(WaveformBase* data, float threshold);
+
+	///@brief Finds zero crossings in a sparse or uniform analog waveform (cached)
+	static EdgeList FindZeroCrossings(SparseAnalogWaveform* sdata, UniformAnalogWaveform* udata, float threshold)
+	{
+		if(sdata)
+			return FindZeroCrossings(sdata, threshold);
+		else
+			return FindZeroCrossings(udata, threshold);
+	}
+
+	///@brief Finds edges in a sparse or uniform digital waveform (cached)
+	static EdgeList FindZeroCrossings(SparseDigitalWaveform* sdata, UniformDigitalWaveform* udata)
+	{
+		if(sdata)
+			return FindZeroCrossings(sdata);
+		else
+			return FindZeroCrossings(udata);
+	}
+
+	///@brief Finds rising edges in a sparse or uniform analog waveform (cached)
+	static EdgeList FindRisingEdges(SparseAnalogWaveform* sdata, UniformAnalogWaveform* udata, float threshold)
+	{
+		if(sdata)
+			return FindRisingEdges(sdata, threshold);
+		else
+			return FindRisingEdges(udata, threshold);
+	}
+
+	///@brief Finds rising edges in a sparse or uniform digital waveform (cached)
+	static EdgeList FindRisingEdges(SparseDigitalWaveform* sdata, UniformDigitalWaveform* udata)
+	{
+		if(sdata)
+			return FindRisingEdges(sdata);
+		else
+			return FindRisingEdges(udata);
+	}
+
+	///@brief Finds falling edges in a sparse or uniform digital waveform (cached)
+	static EdgeList FindFallingEdges(SparseDigitalWaveform* sdata, UniformDigitalWaveform* udata)
+	{
+		if(sdata)
+			return FindFallingEdges(sdata);
+		else
+			return FindFallingEdges(udata);
+	}
+
+	//Uncached versions, appending to a caller-provided vector
 	static void FindRisingEdges(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
 	static void FindRisingEdges(SparseAnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
 	static void FindZeroCrossings(SparseAnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
@@ -1028,6 +1314,10 @@ public:
 	static void FindRisingEdges(SparseDigitalWaveform* data, std::vector<int64_t>& edges);
 	static void FindFallingEdges(UniformDigitalWaveform* data, std::vector<int64_t>& edges);
 	static void FindFallingEdges(SparseDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindZeroCrossings(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindRisingEdges(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindFallingEdges(PackedDigitalWaveform* data, std::vector<int64_t>& edges);
+	static void FindTransitionIndex(UniformDigitalWaveform* data, std::vector<int64_t>& indexes);
 	static void FindPeaks(UniformAnalogWaveform* data, float peak_threshold, std::vector<int64_t>& peak_indices);
 	static void FindPeaks(SparseAnalogWaveform* data, float peak_threshold, std::vector<int64_t>& peak_indices);
 
@@ -1087,8 +1377,55 @@ public:
 			FindZeroCrossings(udata, edges);
 	}
 
+	//Vectorized averaging helpers
+	static double SumSamples(const float* samples, size_t len);
+	static void MovingAverageSamples(const float* in, float* out, size_t nout, size_t depth);
+	static void ExponentialBlendSamples(float* acc, const float* in, size_t len, float decay);
+
 	static void ClearAnalysisCache();
 
+protected:
+	///@brief Types of edge list stored in the analysis cache
+	enum EdgeType
+	{
+		EDGE_ANY,
+		EDGE_RISING,
+		EDGE_FALLING,
+
+		//Sample indexes (not timestamps) of all transitions in a uniform digital waveform
+		EDGE_TRANSITION_INDEX
+	};
+
+	/**
+		@brief Key for the edge cache: identifies one revision of a waveform plus the search settings
+	 */
+	struct EdgeCacheKey
+	{
+		WaveformBase* m_wfm;
+		uint64_t m_rev;
+		float m_threshold;
+		EdgeType m_type;
+
+		bool operator<(const EdgeCacheKey& rhs) const
+		{
+			if(m_wfm != rhs.m_wfm)
+				return m_wfm < rhs.m_wfm;
+			if(m_rev != rhs.m_rev)
+				return m_rev < rhs.m_rev;
+			if(m_threshold != rhs.m_threshold)
+				return m_threshold < rhs.m_threshold;
+			return m_type < rhs.m_type;
+		}
+	};
+
+	static EdgeList GetCachedEdges(
+		WaveformBase* data,
+		float threshold,
+		EdgeType type,
+		std::function<void(std::vector<int64_t>&)> finder);
+
+	static StatisticsRef GetCachedStatistics(WaveformBase* wfm, const float* samples, size_t len);
+
 protected:
 	//Helpers for sparse waveforms
 	static void FillDurationsGeneric(SparseWaveformBase& wfm);
@@ -1096,6 +1433,73 @@ protected:
 	static void FillDurationsAVX2(SparseWaveformBase& wfm);
 #endif
 
+	//Edge finding kernels for uniform analog waveforms
+	static void FindUniformEdges(
+		UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges, bool risingOnly);
+	static void FindUniformEdgesBlock(
+		UniformAnalogWaveform* data,
+		float threshold,
+		std::vector<int64_t>& edges,
+		size_t istart,
+		size_t iend,
+		bool risingOnly);
+	static void FindUniformEdgesGeneric(
+		UniformAnalogWaveform* data,
+		float threshold,
+		std::vector<int64_t>& edges,
+		size_t istart,
+		size_t iend,
+		bool risingOnly);
+#ifdef __x86_64__
+	static void FindUniformEdgesAVX2(
+		UniformAnalogWaveform* data,
+		float threshold,
+		std::vector<int64_t>& edges,
+		size_t istart,
+		size_t iend,
+		bool risingOnly);
+	static void FindUniformEdgesAVX512F(
+		UniformAnalogWaveform* data,
+		float threshold,
+		std::vector<int64_t>& edges,
+		size_t istart,
+		size_t iend,
+		bool risingOnly);
+#endif
+
+	//Edge finding and transition index kernels for uniform digital waveforms
+	static void FindUniformDigitalEdges(UniformDigitalWaveform* data, std::vector<int64_t>& edges, EdgeType type);
+	static void FindTransitionIndexGeneric(
+		const uint8_t* samples, std::vector<int64_t>& indexes, size_t istart, size_t iend);
+#ifdef __x86_64__
+	static void FindTransitionIndexAVX2(
+		const uint8_t* samples, std::vector<int64_t>& indexes, size_t istart, size_t iend);
+#endif
+
+	//Averaging kernels
+	static double SumSamplesBlock(const float* samples, size_t len);
+	static double SumSamplesGeneric(const float* samples, size_t len);
+	static void MovingAverageSamplesGeneric(const float* in, float* out, size_t istart, size_t iend, size_t depth);
+	static void ExponentialBlendSamplesGeneric(float* acc, const float* in, size_t len, float decay);
+#ifdef __x86_64__
+	static double SumSamplesAVX2(const float* samples, size_t len);
+	static void MovingAverageSamplesAVX2(const float* in, float* out, size_t istart, size_t iend, size_t depth);
+	static void ExponentialBlendSamplesAVX2(float* acc, const float* in, size_t len, float decay);
+#endif
+
+	//Statistics kernels
+	static void ComputeStatistics(const float* samples, size_t len, WaveformStatistics& stats);
+	static void ComputeMomentsGeneric(
+		const float* samples, size_t len, float& vmin, float& vmax, double& sum, double& sumSquares);
+	static void ComputeHistogramGeneric(
+		const float* samples, size_t len, float low, float high, std::vector<size_t>& hist);
+#ifdef __x86_64__
+	static void ComputeMomentsAVX2(
+		const float* samples, size_t len, float& vmin, float& vmax, double& sum, double& sumSquares);
+	static void ComputeHistogramAVX2(
+		const float* samples, size_t len, float low, float high, std::vector<size_t>& hist);
+#endif
+
 public:
 	sigc::signal<void()> signal_outputsChanged()
 	{ return m_outputsChangedSignal; }
@@ -1131,7 +1535,8 @@ protected:
 
 	//Caching
 	static std::mutex m_cacheMutex;
-	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_zeroCrossingCache;
+	static std::map<EdgeCacheKey, std::shared_future<EdgeList> > m_edgeCache;
+	static std::map<std::pair<WaveformBase*, uint64_t>, std::shared_future<StatisticsRef> > m_statisticsCache;
 };
 
 #define PROTOCOL_DECODER_INITPROC(T) \
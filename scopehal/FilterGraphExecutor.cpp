@@ -28,16 +28,45 @@
 ***********************************************************************************************************************/
 
 #include "scopehal.h"
+#include "PacketDecoder.h"
+#include <algorithm>
+#include <cinttypes>
 
 using namespace std;
 
+///@brief Number of events kept in each worker's trace ring
+static const size_t g_traceRingSize = 4096;
+
+///@brief Number of passes kept in the pass history
+static const size_t g_tracePassHistory = 256;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 FilterGraphExecutor::FilterGraphExecutor(size_t numThreads)
-	: m_allWorkersComplete(true)
+	: m_pendingInputsCapacity(0)
+	, m_remainingNodes(0)
+	, m_workEpoch(0)
+	, m_sleepingWorkers(0)
+	, m_incremental(true)
+	, m_executedNodes(0)
+	, m_skippedNodes(0)
+	, m_prefetch(true)
+	, m_prefetchedBytes(0)
+	, m_pass(0)
+	, m_passActive(false)
+	, m_activeWorkers(0)
 	, m_terminating(false)
+	, m_tracing(false)
+	, m_passTracing(false)
 {
+	//Create run queues and trace rings before the threads, since they're accessed by index
+	for(size_t i=0; i<numThreads; i++)
+	{
+		m_queues.push_back(make_unique<WorkStealingDeque>());
+		m_traceRings.push_back(make_unique<TraceRing>(g_traceRingSize));
+	}
+
 	//Create our thread pool
 	for(size_t i=0; i<numThreads; i++)
 		m_threads.push_back(make_unique<thread>(&FilterGraphExecutor::ExecutorThread, this, i));
@@ -46,7 +75,10 @@ FilterGraphExecutor::FilterGraphExecutor(size_t numThreads)
 FilterGraphExecutor::~FilterGraphExecutor()
 {
 	//Terminate worker threads
-	m_terminating = true;
+	{
+		lock_guard<mutex> lock(m_controlMutex);
+		m_terminating = true;
+	}
 	m_workerCvar.notify_all();
 	for(auto& t : m_threads)
 		t->join();
@@ -60,114 +92,828 @@ FilterGraphExecutor::~FilterGraphExecutor()
  */
 void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 {
+	m_executedNodes = 0;
+	m_skippedNodes = 0;
+	m_prefetchedBytes = 0;
+
 	//Nothing to do if we have no nodes to run
 	if(nodes.empty())
 		return;
 
+	//Workers are all idle at this point (the previous pass doesn't end until they've all left it),
+	//so it's safe to rebuild the graph without any synchronization
+	m_passTracing = m_tracing.load();
+	int64_t passStart = m_passTracing ? GetTraceTimestamp() : 0;
+	BuildGraph(nodes, passStart);
+	if(m_nodes.empty())
+		return;
+
+	Filter::ClearAnalysisCache();
+
+	//Start the pass and wake up our workers
+	uint64_t pass;
+	{
+		lock_guard<mutex> lock(m_controlMutex);
+		m_pass ++;
+		pass = m_pass;
+		m_passActive = true;
+	}
+	m_workerCvar.notify_all();
+
+	//Block until they're finished
 	{
-		lock_guard<mutex> lock(m_mutex);
+		unique_lock<mutex> lock(m_controlMutex);
+		m_completionCvar.wait(lock, [this]{return !m_passActive;});
+	}
 
-		if(!m_allWorkersComplete)
-			LogWarning("Entering RunBlocking() but not all workers are complete from previous run\n");
+	//Nobody is using the unpacked copies of packed inputs any more, so only keep the packed form around
+	UnpackedWaveformCache::ReleaseAll();
 
-		m_incompleteNodes = nodes;
-		m_incompleteNodes.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
+	if(m_passTracing)
+	{
+		lock_guard<mutex> lock(m_traceMutex);
+		m_tracePasses.push_back({
+			pass,
+			passStart,
+			GetTraceTimestamp(),
+			m_executedNodes.load(),
+			m_skippedNodes.load(),
+			m_prefetchedBytes.load()});
+		while(m_tracePasses.size() > g_tracePassHistory)
+			m_tracePasses.pop_front();
+	}
+}
+
+/**
+	@brief Builds the dependency graph for a pass and seeds the run queues with nodes that have no dependencies
 
-		m_runnableNodes.clear();
-		m_allWorkersComplete = false;
+	@param nodes		Nodes to evaluate
+	@param passStart	Trace timestamp of the start of the pass (only used if tracing)
+ */
+void FilterGraphExecutor::BuildGraph(const set<FlowGraphNode*>& nodes, int64_t passStart)
+{
+	m_nodes.clear();
+	m_nodeIndexes.clear();
 
-		Filter::ClearAnalysisCache();
+	//Assign an index to each node
+	for(auto f : nodes)
+	{
+		//don't crash if a null filter somehow ended up in the list
+		if(f == nullptr)
+			continue;
+
+		m_nodeIndexes[f] = m_nodes.size();
+		m_nodes.push_back({f, {}, 0, passStart});
 	}
 
-	//Wake up our workers
-	m_workerCvar.notify_all();
+	//Look up trace names now, so workers never touch the name table
+	if(m_passTracing)
+	{
+		lock_guard<mutex> lock(m_traceMutex);
+		for(auto& n : m_nodes)
+			n.m_traceName = GetTraceNameID(n.m_node);
+	}
 
-	//Block until they're finished
-	while(true)
+	size_t count = m_nodes.size();
+	if(count > m_pendingInputsCapacity)
 	{
-		unique_lock<mutex> lock(m_completionCvarMutex);
-		m_completionCvar.wait(lock, [this]{return m_allWorkersComplete;});
+		m_pendingInputs = make_unique<atomic<size_t>[]>(count);
+		m_pendingInputsCapacity = count;
+	}
+
+	//Count inputs driven by other nodes in this pass, and record the reverse edges.
+	//Inputs driven by anything outside the pass are already up to date.
+	for(size_t i=0; i<count; i++)
+	{
+		auto f = m_nodes[i].m_node;
+		size_t pending = 0;
+		for(size_t j=0; j<f->GetInputCount(); j++)
+		{
+			auto in = f->GetInput(j).m_channel;
+			if( (in == nullptr) || (in == f) )
+				continue;
+
+			auto it = m_nodeIndexes.find(in);
+			if(it == m_nodeIndexes.end())
+				continue;
 
-		lock_guard<mutex> lock2(m_mutex);
-		if(m_runnableNodes.empty())
-			break;
+			m_nodes[it->second].m_dependents.push_back(i);
+			pending ++;
+		}
+		m_pendingInputs[i].store(pending, memory_order_relaxed);
 	}
+
+	//Each queue can hold every node, since no node is pushed more than once per pass
+	for(auto& q : m_queues)
+		q->Reset(count);
+
+	//Distribute the initially runnable nodes round robin across the workers
+	size_t nqueue = 0;
+	for(size_t i=0; i<count; i++)
+	{
+		if(m_pendingInputs[i].load(memory_order_relaxed) == 0)
+		{
+			m_queues[nqueue]->Push(i);
+			nqueue = (nqueue + 1) % m_queues.size();
+		}
+	}
+
+	m_remainingNodes.store(count);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Scheduling
+// Segmented execution
 
 /**
-	@brief Returns the next filter available to run, blocking if none are ready.
+	@brief Divides a by b (which must be positive), rounding towards positive infinity
+ */
+static int64_t CeilDiv(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	if( (a % b) > 0)
+		q ++;
+	return q;
+}
 
-	Returns null if there are no remaining filters to evaluate.
+/**
+	@brief Gets the time range covered by a waveform and the typical interval between its samples
+
+	@return False if the waveform is empty or of an unknown type
  */
-FlowGraphNode* FilterGraphExecutor::GetNextRunnableNode()
+static bool GetWaveformSpan(WaveformBase* wfm, int64_t& start, int64_t& end, int64_t& interval)
 {
-	while(true)
+	size_t len = wfm->size();
+	if(len == 0)
+		return false;
+
+	auto uw = dynamic_cast<UniformWaveformBase*>(wfm);
+	auto sw = dynamic_cast<SparseWaveformBase*>(wfm);
+	if(uw)
+	{
+		start = uw->m_triggerPhase;
+		end = start + len*uw->m_timescale;
+		interval = uw->m_timescale;
+	}
+	else if(sw)
+	{
+		sw->m_offsets.PrepareForCpuAccess();
+		sw->m_durations.PrepareForCpuAccess();
+		start = GetOffsetScaled(sw, 0);
+		end = GetOffsetScaled(sw, len-1) + GetDurationScaled(sw, len-1);
+		interval = max((int64_t)1, (end - start) / (int64_t)len);
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/**
+	@brief Copies the metadata of a waveform into a segment of it
+ */
+static void CopySegmentMetadata(WaveformBase* src, WaveformBase* dst)
+{
+	dst->m_timescale = src->m_timescale;
+	dst->m_startTimestamp = src->m_startTimestamp;
+	dst->m_startFemtoseconds = src->m_startFemtoseconds;
+	dst->m_triggerPhase = src->m_triggerPhase;
+	dst->m_flags = src->m_flags;
+}
+
+/**
+	@brief Creates a new waveform containing the samples of a uniform waveform within [tstart, tend)
+ */
+template<class T>
+static WaveformBase* SliceUniformWaveform(UniformWaveform<T>* wfm, int64_t tstart, int64_t tend)
+{
+	int64_t len = wfm->size();
+	int64_t first = clamp(CeilDiv(tstart - wfm->m_triggerPhase, wfm->m_timescale), (int64_t)0, len);
+	int64_t last = clamp(CeilDiv(tend - wfm->m_triggerPhase, wfm->m_timescale), first, len);
+
+	auto ret = new UniformWaveform<T>;
+	CopySegmentMetadata(wfm, ret);
+	ret->m_triggerPhase += first * wfm->m_timescale;
+
+	wfm->PrepareForCpuAccess();
+	ret->Resize(last - first);
+	ret->PrepareForCpuAccess();
+	for(int64_t i=first; i<last; i++)
+		ret->m_samples[i - first] = wfm->m_samples[i];
+	ret->MarkModifiedFromCpu();
+	return ret;
+}
+
+/**
+	@brief Creates a new waveform containing the samples of a sparse waveform within [tstart, tend)
+
+	A sample which starts before tstart but is still active at tstart is included, so that the state of the signal
+	at the start of the segment is known.
+ */
+template<class T>
+static WaveformBase* SliceSparseWaveform(SparseWaveform<T>* wfm, int64_t tstart, int64_t tend)
+{
+	wfm->PrepareForCpuAccess();
+	auto offsets = wfm->m_offsets.GetCpuPointer();
+	auto durations = wfm->m_durations.GetCpuPointer();
+	size_t len = wfm->size();
+
+	int64_t from = CeilDiv(tstart - wfm->m_triggerPhase, wfm->m_timescale);
+	int64_t to = CeilDiv(tend - wfm->m_triggerPhase, wfm->m_timescale);
+	size_t first = lower_bound(offsets, offsets + len, from) - offsets;
+	size_t last = lower_bound(offsets + first, offsets + len, to) - offsets;
+	if( (first > 0) && (offsets[first-1] + durations[first-1] > from) )
+		first --;
+
+	auto ret = new SparseWaveform<T>;
+	CopySegmentMetadata(wfm, ret);
+
+	ret->Resize(last - first);
+	ret->PrepareForCpuAccess();
+	for(size_t i=first; i<last; i++)
+	{
+		ret->m_offsets[i - first] = offsets[i];
+		ret->m_durations[i - first] = durations[i];
+		ret->m_samples[i - first] = wfm->m_samples[i];
+	}
+	ret->MarkModifiedFromCpu();
+	return ret;
+}
+
+/**
+	@brief Creates a new waveform containing the samples of a waveform within [tstart, tend)
+
+	@return The new waveform, or nullptr if the waveform type is not supported
+ */
+static WaveformBase* SliceWaveform(WaveformBase* wfm, int64_t tstart, int64_t tend)
+{
+	if(auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm))
+		return SliceUniformWaveform(ua, tstart, tend);
+	if(auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm))
+		return SliceUniformWaveform(ud, tstart, tend);
+	if(auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm))
+		return SliceSparseWaveform(sa, tstart, tend);
+	if(auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm))
+		return SliceSparseWaveform(sd, tstart, tend);
+	return nullptr;
+}
+
+/**
+	@brief Checks if SliceWaveform() can handle a waveform
+ */
+static bool CanSliceWaveform(WaveformBase* wfm)
+{
+	return
+		(dynamic_cast<UniformAnalogWaveform*>(wfm) != nullptr) ||
+		(dynamic_cast<UniformDigitalWaveform*>(wfm) != nullptr) ||
+		(dynamic_cast<SparseAnalogWaveform*>(wfm) != nullptr) ||
+		(dynamic_cast<SparseDigitalWaveform*>(wfm) != nullptr);
+}
+
+/**
+	@brief Finds the range of samples in a waveform which start within [tstart, tend)
+
+	@param wfm			The waveform
+	@param tstart		Start of the time range
+	@param tend			End of the time range
+	@param openStart	True to ignore tstart and start at the first sample
+	@param openEnd		True to ignore tend and end at the last sample
+	@param first		Index of the first sample in the range
+	@param last			One past the index of the last sample in the range
+ */
+static void FindSegmentSamples(
+	WaveformBase* wfm,
+	int64_t tstart,
+	int64_t tend,
+	bool openStart,
+	bool openEnd,
+	size_t& first,
+	size_t& last)
+{
+	size_t len = wfm->size();
+	first = 0;
+	last = len;
+
+	int64_t from = CeilDiv(tstart - wfm->m_triggerPhase, wfm->m_timescale);
+	int64_t to = CeilDiv(tend - wfm->m_triggerPhase, wfm->m_timescale);
+
+	auto sw = dynamic_cast<SparseWaveformBase*>(wfm);
+	if(sw)
 	{
-		//Check for stuff
+		sw->m_offsets.PrepareForCpuAccess();
+		auto offsets = sw->m_offsets.GetCpuPointer();
+		if(!openStart)
+			first = lower_bound(offsets, offsets + len, from) - offsets;
+		if(!openEnd)
+			last = lower_bound(offsets + first, offsets + len, to) - offsets;
+	}
+	else
+	{
+		if(!openStart)
+			first = clamp(from, (int64_t)0, (int64_t)len);
+		if(!openEnd)
+			last = clamp(to, (int64_t)first, (int64_t)len);
+	}
+}
+
+/**
+	@brief Gets the overlap needed at the inputs of a streaming filter so that every streaming filter downstream of
+	it produces correct output within a segment
+
+	@param node		The filter
+	@param consumers	Streaming filters consuming each streaming filter's outputs
+	@param needed		Memoized results
+ */
+static int64_t GetSegmentContext(
+	FlowGraphNode* node,
+	const map<FlowGraphNode*, set<FlowGraphNode*>>& consumers,
+	map<FlowGraphNode*, int64_t>& needed)
+{
+	auto it = needed.find(node);
+	if(it != needed.end())
+		return it->second;
+	needed[node] = 0;
+
+	int64_t downstream = 0;
+	auto cit = consumers.find(node);
+	if(cit != consumers.end())
+	{
+		for(auto c : cit->second)
+			downstream = max(downstream, GetSegmentContext(c, consumers, needed));
+	}
+
+	int64_t ret = downstream;
+	auto f = dynamic_cast<Filter*>(node);
+	if(f)
+		ret += max((int64_t)0, f->GetStreamingOverlap());
+	needed[node] = ret;
+	return ret;
+}
+
+/**
+	@brief Gets the overlap needed on each side of a segment by a group of streaming filters
+ */
+static int64_t GetSegmentMargin(
+	const set<FlowGraphNode*>& streaming,
+	const map<FlowGraphNode*, set<FlowGraphNode*>>& consumers)
+{
+	map<FlowGraphNode*, int64_t> needed;
+	int64_t margin = 0;
+	for(auto n : streaming)
+		margin = max(margin, GetSegmentContext(n, consumers, needed));
+	return margin;
+}
+
+/**
+	@brief Checks if every node consuming any output of a node is in a given group
+
+	@return False if nothing in nodes consumes the node's outputs
+ */
+static bool IsConsumedOnlyBy(FlowGraphNode* node, const set<FlowGraphNode*>& group, const set<FlowGraphNode*>& nodes)
+{
+	bool consumed = false;
+	for(auto n : nodes)
+	{
+		if( (n == nullptr) || (n == node) )
+			continue;
+
+		for(size_t i=0; i<n->GetInputCount(); i++)
 		{
-			lock_guard<mutex> lock(m_mutex);
+			if(n->GetInput(i).m_channel != node)
+				continue;
+			if(group.find(n) == group.end())
+				return false;
+			consumed = true;
+		}
+	}
+	return consumed;
+}
 
-			//Nothing left to run? Stop
-			if(m_incompleteNodes.empty())
-				return nullptr;
+/**
+	@brief Evaluates the filter graph one time segment at a time, blocking until execution has completed
 
-			//Nothing ready to run? Update the run queue
-			if(m_runnableNodes.empty())
-				UpdateRunnable();
+	Intended for records too large to process, or even hold, in one go. The nodes are split into groups:
+	* Sources which can read their record a segment at a time (see Filter::CanReadSegments()), and whose outputs are
+	  consumed only by streaming filters, are never refreshed. They are asked for one segment at a time instead.
+	* Other nodes which do not depend on any streaming-capable filter are evaluated first, on the whole record.
+	* Streaming-capable filters (see Filter::IsStreamingCapable()) fed only by the above or by each other are
+	  evaluated once per segment. Their inputs are segments of about segmentSize samples, padded on each side by the
+	  overlap the downstream filters need (see Filter::GetStreamingOverlap()).
+	* Everything else is evaluated last, on the stitched outputs.
 
-			//If there is something ready to run, grab it
-			if(!m_runnableNodes.empty())
-			{
-				auto f = *m_runnableNodes.begin();
-				m_runnableNodes.erase(f);
-				m_runningNodes.emplace(f);
-				return f;
-			}
+	Afterwards, outputs of streaming filters which are consumed outside the streaming group, or not at all, hold their
+	full-length results, stitched together in pageable memory which is paged out as each segment is appended. Outputs
+	consumed only by other streaming filters, and the outputs of segment sources, are set to null rather than left
+	holding the last segment. They're rebuilt by the next RunBlocking().
+
+	With segment sources, peak memory therefore scales with segmentSize rather than the record length (apart from
+	packets, and stitched outputs still in the page cache).
+
+	@param nodes		Nodes to evaluate
+	@param segmentSize	Number of samples of the most finely sampled input to process per segment
+ */
+void FilterGraphExecutor::RunSegmentedBlocking(const set<FlowGraphNode*>& nodes, size_t segmentSize)
+{
+	map<FlowGraphNode*, SegmentRole> roles;
+	set<FlowGraphNode*> before;
+	set<FlowGraphNode*> streaming;
+	set<FlowGraphNode*> after;
+	for(auto n : nodes)
+	{
+		if(n == nullptr)
+			continue;
+
+		switch(ClassifySegmentedNode(n, nodes, roles))
+		{
+			case SEGMENT_BEFORE:
+				before.insert(n);
+				break;
+
+			case SEGMENT_STREAMING:
+				streaming.insert(n);
+				break;
+
+			case SEGMENT_AFTER:
+			default:
+				after.insert(n);
+				break;
 		}
+	}
+
+	//Don't load the whole record of sources which can be read a segment at a time
+	set<FlowGraphNode*> sources;
+	for(auto n : before)
+	{
+		auto f = dynamic_cast<Filter*>(n);
+		if(f && f->CanReadSegments() && IsConsumedOnlyBy(n, streaming, nodes))
+			sources.insert(n);
+	}
+	for(auto n : sources)
+		before.erase(n);
 
-		//Still nothing to run? Block
-		unique_lock<mutex> lock(m_workerCvarMutex);
-		m_workerCvar.wait(lock);
+	RunBlocking(before);
+	if(!RunSegments(streaming, sources, nodes, segmentSize))
+	{
+		RunBlocking(sources);
+		RunBlocking(streaming);
 	}
+	RunBlocking(after);
 }
 
 /**
-	@brief Searches m_incompleteNodes for any that are unblocked, and adds them to m_runnableNodes
+	@brief Decides which group a node is evaluated in during segmented execution
 
-	Assumes m_mutex is locked
+	@param node		The node to classify
+	@param nodes	All nodes being evaluated
+	@param roles	Memoized results
  */
-void FilterGraphExecutor::UpdateRunnable()
+FilterGraphExecutor::SegmentRole FilterGraphExecutor::ClassifySegmentedNode(
+	FlowGraphNode* node,
+	const set<FlowGraphNode*>& nodes,
+	map<FlowGraphNode*, SegmentRole>& roles)
 {
-	//Do nothing if we already have other filters marked runnable
-	if(!m_runnableNodes.empty())
-		return;
+	auto it = roles.find(node);
+	if(it != roles.end())
+		return it->second;
 
-	//Look for new filters that are eligible to run
-	for(auto f : m_incompleteNodes)
+	//Provisional result, in case of a loop in the graph
+	roles[node] = SEGMENT_AFTER;
+
+	//Find the latest group any of our inputs within this evaluation are in
+	SegmentRole upstream = SEGMENT_BEFORE;
+	for(size_t i=0; i<node->GetInputCount(); i++)
 	{
-		//If the filter is already running, nothing we can do
-		if(m_runningNodes.find(f) != m_runningNodes.end())
+		FlowGraphNode* in = node->GetInput(i).m_channel;
+		if( (in == nullptr) || (in == node) || (nodes.find(in) == nodes.end()) )
 			continue;
+		upstream = max(upstream, ClassifySegmentedNode(in, nodes, roles));
+	}
+
+	SegmentRole role;
+	auto f = dynamic_cast<Filter*>(node);
+	if(upstream == SEGMENT_AFTER)
+		role = SEGMENT_AFTER;
+	else if(f && f->IsStreamingCapable())
+		role = SEGMENT_STREAMING;
+	else if(upstream == SEGMENT_STREAMING)
+		role = SEGMENT_AFTER;
+	else
+		role = SEGMENT_BEFORE;
+
+	roles[node] = role;
+	return role;
+}
+
+/**
+	@brief Evaluates a group of streaming-capable filters one segment at a time
+
+	@param streaming	The streaming filters to evaluate
+	@param sources		Sources to read a segment at a time instead of refreshing
+	@param nodes		All nodes being evaluated
+	@param segmentSize	Number of samples of the most finely sampled input to process per segment
+
+	@return False if the record fits in a single segment or cannot be segmented, in which case nothing was done
+ */
+bool FilterGraphExecutor::RunSegments(
+	const set<FlowGraphNode*>& streaming,
+	const set<FlowGraphNode*>& sources,
+	const set<FlowGraphNode*>& nodes,
+	size_t segmentSize)
+{
+	if(streaming.empty() || (segmentSize == 0) )
+		return false;
 
-		//Not actively running.
-		//Is it blocked by any of our incomplete filters?
-		bool ok = true;
-		for(size_t i=0; i<f->GetInputCount(); i++)
+	//Find the streams coming into the group from outside it (roots) other than segment sources, which streaming
+	//filters feed which, and which of their outputs are needed outside the group
+	vector<StreamDescriptor> roots;
+	map<FlowGraphNode*, set<FlowGraphNode*>> consumers;
+	set<StreamDescriptor> consumedInside;
+	set<StreamDescriptor> consumedOutside;
+	for(auto n : nodes)
+	{
+		if(n == nullptr)
+			continue;
+
+		bool isStreaming = (streaming.find(n) != streaming.end());
+		for(size_t i=0; i<n->GetInputCount(); i++)
 		{
-			auto in = f->GetInput(i).m_channel;
-			if(m_incompleteNodes.find(in) != m_incompleteNodes.end())
+			auto in = n->GetInput(i);
+			if( (in.m_channel == nullptr) || (in.m_channel == n) )
+				continue;
+
+			bool fromStreaming = (streaming.find(in.m_channel) != streaming.end());
+			bool fromSource = (sources.find(in.m_channel) != sources.end());
+			if(isStreaming && fromStreaming)
+			{
+				consumers[in.m_channel].insert(n);
+				consumedInside.insert(in);
+			}
+			else if(fromStreaming)
+				consumedOutside.insert(in);
+			else if(isStreaming && !fromSource)
 			{
-				ok = false;
+				if(find(roots.begin(), roots.end(), in) == roots.end())
+					roots.push_back(in);
+			}
+		}
+	}
+
+	//Stitch outputs which are used outside the group, or are final results.
+	//Streams only passed between streaming filters are dropped at the end instead.
+	vector<StreamDescriptor> outputs;
+	vector<StreamDescriptor> intermediates;
+	for(auto n : streaming)
+	{
+		auto f = dynamic_cast<Filter*>(n);
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			StreamDescriptor stream(f, i);
+			bool inside = (consumedInside.find(stream) != consumedInside.end());
+			bool outside = (consumedOutside.find(stream) != consumedOutside.end());
+			if(inside && !outside)
+				intermediates.push_back(stream);
+			else
+				outputs.push_back(stream);
+		}
+	}
+
+	//Find the span of the record and the finest sample interval
+	int64_t tstart = INT64_MAX;
+	int64_t tend = INT64_MIN;
+	int64_t interval = INT64_MAX;
+	for(auto& r : roots)
+	{
+		auto data = r.GetData();
+		if(data == nullptr)
+			continue;
+		if(!CanSliceWaveform(data))
+		{
+			LogDebug("Input %s cannot be segmented, evaluating the whole record at once\n", r.GetName().c_str());
+			return false;
+		}
+
+		int64_t start;
+		int64_t end;
+		int64_t rinterval;
+		if(!GetWaveformSpan(data, start, end, rinterval))
+			continue;
+
+		tstart = min(tstart, start);
+		tend = max(tend, end);
+		interval = min(interval, rinterval);
+	}
+	vector<Filter*> segmentSources;
+	for(auto n : sources)
+	{
+		auto f = dynamic_cast<Filter*>(n);
+		int64_t start;
+		int64_t end;
+		int64_t rinterval;
+		if(!f->GetSegmentSpan(start, end, rinterval))
+		{
+			LogDebug("Source %s cannot be read in segments, evaluating the whole record at once\n",
+				f->GetDisplayName().c_str());
+			return false;
+		}
+		segmentSources.push_back(f);
+
+		tstart = min(tstart, start);
+		tend = max(tend, end);
+		interval = min(interval, rinterval);
+	}
+	if(tend <= tstart)
+		return false;
+
+	int64_t segmentLen = segmentSize * interval;
+	int64_t numSegments = CeilDiv(tend - tstart, segmentLen);
+	if(numSegments <= 1)
+		return false;
+
+	LogTrace("Segmented execution: %zu filters, %" PRId64 " segments of %" PRId64 " fs\n",
+		streaming.size(), numSegments, segmentLen);
+
+	int64_t margin = GetSegmentMargin(streaming, consumers);
+
+	//Take ownership of the full inputs
+	vector<WaveformBase*> fullInputs;
+	for(auto& r : roots)
+		fullInputs.push_back(r.m_channel->Detach(r.m_stream));
+
+	//Inputs change every segment, so never skip anything
+	bool incremental = m_incremental.load();
+	m_incremental = false;
+
+	vector<WaveformBase*> stitched(outputs.size(), nullptr);
+	vector<bool> paged(outputs.size(), false);
+	vector<PacketDecoder*> decoders;
+	for(auto n : streaming)
+	{
+		auto pd = dynamic_cast<PacketDecoder*>(n);
+		if(pd)
+			decoders.push_back(pd);
+	}
+	vector<vector<Packet*>> packets(decoders.size());
+	vector<PacketStore> stores(decoders.size());
+
+	for(int64_t seg=0; seg<numSegments; seg++)
+	{
+		int64_t segStart = tstart + seg*segmentLen;
+		int64_t segEnd = segStart + segmentLen;
+		bool isFirst = (seg == 0);
+		bool isLast = (seg == numSegments - 1);
+
+		//The overlap can depend on the data (e.g. filter lengths computed on the first refresh, or a recovered
+		//clock rate), so check it again after each run and redo the segment if it grew
+		for(size_t attempt=0; attempt<4; attempt++)
+		{
+			for(size_t i=0; i<roots.size(); i++)
+			{
+				if(fullInputs[i] == nullptr)
+					continue;
+				roots[i].m_channel->SetData(
+					SliceWaveform(fullInputs[i], segStart - margin, segEnd + margin),
+					roots[i].m_stream);
+			}
+			for(auto f : segmentSources)
+				f->ReadSegment(segStart - margin, segEnd + margin);
+
+			RunBlocking(streaming);
+
+			int64_t needed = GetSegmentMargin(streaming, consumers);
+			bool grew = (needed > margin);
+			margin = needed;
+			if(!grew)
 				break;
+		}
+
+		//Trim the overlap off each output and append it to the stitched result
+		for(size_t i=0; i<outputs.size(); i++)
+		{
+			auto f = dynamic_cast<Filter*>(outputs[i].m_channel);
+			auto data = f->GetData(outputs[i].m_stream);
+			if(data == nullptr)
+				continue;
+
+			size_t first;
+			size_t last;
+			FindSegmentSamples(data, segStart, segEnd, isFirst, isLast, first, last);
+
+			if(stitched[i] == nullptr)
+			{
+				stitched[i] = f->Detach(outputs[i].m_stream);
+				if(!stitched[i]->Crop(first, last - first))
+				{
+					LogWarning("Output %s of %s cannot be segmented, only the first segment will be kept\n",
+						f->GetStreamName(outputs[i].m_stream).c_str(),
+						f->GetDisplayName().c_str());
+				}
+			}
+			else
+				stitched[i]->AppendSamples(data, first, last - first);
+
+			if(!paged[i] && (stitched[i]->size() > segmentSize) )
+			{
+				stitched[i]->UsePagedMemory();
+				paged[i] = true;
+			}
+
+			//Only the last segment has to stay resident, the rest is in the backing file
+			if(paged[i])
+				stitched[i]->PageOut();
+		}
+
+		//Keep packets which start within the segment
+		for(size_t i=0; i<decoders.size(); i++)
+		{
+			for(auto p : decoders[i]->GetPacketObjects())
+			{
+				if( (isFirst || (p->m_offset >= segStart)) && (isLast || (p->m_offset < segEnd)) )
+					packets[i].push_back(p);
+				else
+					delete p;
+			}
+			decoders[i]->DetachPackets();
+
+			//Copy runs of packets from the columnar store, which is cleared by the next refresh
+			auto& store = decoders[i]->GetPacketStore();
+			size_t runStart = 0;
+			for(size_t j=0; j<=store.size(); j++)
+			{
+				bool keep = false;
+				if(j < store.size())
+				{
+					auto off = store.GetOffset(j);
+					keep = (isFirst || (off >= segStart)) && (isLast || (off < segEnd));
+				}
+				if(!keep)
+				{
+					stores[i].AppendPackets(store, runStart, j);
+					runStart = j+1;
+				}
 			}
 		}
+	}
+
+	//Put the full inputs back, then replace the last segment's outputs with the stitched ones.
+	//Segment sources and intermediate streams would only hold the last segment, so drop them.
+	for(size_t i=0; i<roots.size(); i++)
+		roots[i].m_channel->SetData(fullInputs[i], roots[i].m_stream);
+	for(auto f : segmentSources)
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+			f->SetData(nullptr, i);
+	}
+	for(auto& s : intermediates)
+		s.m_channel->SetData(nullptr, s.m_stream);
+	for(size_t i=0; i<outputs.size(); i++)
+	{
+		if(stitched[i] == nullptr)
+			continue;
+		stitched[i]->m_revision ++;
+		outputs[i].m_channel->SetData(stitched[i], outputs[i].m_stream);
+	}
+	for(size_t i=0; i<decoders.size(); i++)
+		decoders[i]->SetPackets(std::move(packets[i]), std::move(stores[i]));
+
+	m_incremental = incremental;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+
+/**
+	@brief Gets the next node for worker i to run, from its own queue if possible or stolen from another worker.
+
+	@return True if a node was found, false if there is currently nothing runnable
+ */
+bool FilterGraphExecutor::GetNextRunnableNode(size_t i, size_t& node)
+{
+	if(m_queues[i]->Pop(node))
+		return true;
+
+	//Nothing local, try stealing starting from our neighbor so thieves don't all pile onto worker 0
+	size_t n = m_queues.size();
+	for(size_t j=1; j<n; j++)
+	{
+		if(m_queues[(i + j) % n]->Steal(node))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+	@brief Notifies idle workers that new work is available (or the pass is over)
+ */
+void FilterGraphExecutor::WakeWorkers()
+{
+	m_workEpoch ++;
 
-		//Not blocked. It's runnable.
-		if(ok)
-			m_runnableNodes.emplace(f);
+	//Only take the lock if somebody is actually asleep
+	if(m_sleepingWorkers.load() != 0)
+	{
+		lock_guard<mutex> lock(m_controlMutex);
+		m_workerCvar.notify_all();
 	}
 }
 
@@ -219,27 +965,90 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 	}
 
 	//Main loop
+	uint64_t lastPass = 0;
 	while(true)
 	{
+		//Wait until the main thread starts a new round of execution
 		{
-			//Wait until the main thread starts a new round of execution, or the timeout elapses
-			//When we time out, check if we're shutting down
-			unique_lock<mutex> lock(m_workerCvarMutex);
-			m_workerCvar.wait_for(lock, chrono::milliseconds(50));
+			unique_lock<mutex> lock(m_controlMutex);
+			m_workerCvar.wait(lock, [&]{ return m_terminating || (m_passActive && (m_pass != lastPass)); });
+
+			//If they woke us up because the context is being destroyed, we're done
+			if(m_terminating)
+				break;
+
+			lastPass = m_pass;
+			m_activeWorkers ++;
 		}
 
-		//If they woke us up because the context is being destroyed, we're done
-		if(m_terminating)
-			break;
+		//Evaluate nodes until the whole pass is done
+		RunPass(i, lastPass, cmdbuf, queue);
 
-		//If we're already done, nothing to do
-		if(m_allWorkersComplete)
+		//If we were the last one out, wake up the main thread
+		bool done = false;
+		{
+			lock_guard<mutex> lock(m_controlMutex);
+			m_activeWorkers --;
+			if(m_activeWorkers == 0)
+			{
+				m_passActive = false;
+				done = true;
+			}
+		}
+		if(done)
+			m_completionCvar.notify_all();
+	}
+}
+
+/**
+	@brief Runs nodes on worker i until every node in the pass has completed
+ */
+void FilterGraphExecutor::RunPass(
+	size_t i,
+	uint64_t pass,
+	vk::raii::CommandBuffer& cmdbuf,
+	shared_ptr<QueueHandle> queue)
+{
+	auto& localQueue = *m_queues[i];
+
+	bool tracing = m_passTracing;
+	int64_t idleStart = tracing ? GetTraceTimestamp() : 0;
+
+	while(m_remainingNodes.load() != 0)
+	{
+		//Look for work. Grab the epoch first so we can tell if anything got pushed while we were looking.
+		uint64_t epoch = m_workEpoch.load();
+		size_t inode;
+		if(!GetNextRunnableNode(i, inode))
+		{
+			//Nothing to do, sleep until somebody pushes more work or the pass ends
+			m_sleepingWorkers ++;
+			{
+				unique_lock<mutex> lock(m_controlMutex);
+				m_workerCvar.wait(lock, [&]
+					{ return (m_workEpoch.load() != epoch) || (m_remainingNodes.load() == 0); });
+			}
+			m_sleepingWorkers --;
 			continue;
+		}
 
-		//Evaluate nodes as they become available, then stop when there's nothing left to do
-		FlowGraphNode* f;
-		while( (f = GetNextRunnableNode()) != nullptr)
+		auto f = m_nodes[inode].m_node;
+
+		//If nothing has changed since the last time we ran, the node's outputs are still valid.
+		//We still have to release its dependents below.
+		if(m_incremental && !f->IsRefreshRequired())
+			m_skippedNodes ++;
+
+		else
 		{
+			int64_t start = 0;
+			AcceleratorTransferCounters transfersBefore = {0, 0, 0};
+			if(tracing)
+			{
+				start = GetTraceTimestamp();
+				transfersBefore = GetAcceleratorTransferCounters();
+			}
+
 			//Make sure the filter's inputs are where we need them
 			auto loc = f->GetInputLocation();
 			if(loc != Filter::LOC_DONTCARE)
@@ -261,31 +1070,358 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 
 			//Actually execute the filter
 			f->Refresh(cmdbuf, queue);
+			f->MarkRefreshed();
+			m_executedNodes ++;
 
-			//Filter execution has completed, remove it from the running list and mark as completed
-			lock_guard<mutex> lock2(m_mutex);
-			m_runningNodes.erase(f);
-			m_incompleteNodes.erase(f);
+			if(tracing)
+			{
+				auto& transfersAfter = GetAcceleratorTransferCounters();
 
-			//Wake up all threads that might have been waiting on this filter to complete
-			m_workerCvar.notify_all();
-		}
+				TraceEvent event;
+				event.m_pass = pass;
+				event.m_name = m_nodes[inode].m_traceName;
+				event.m_worker = i;
+				event.m_readyTime = m_nodes[inode].m_readyTime;
+				event.m_startTime = start;
+				event.m_endTime = GetTraceTimestamp();
+				event.m_idleTime = start - idleStart;
+				event.m_bytesToCpu = transfersAfter.m_bytesToCpu - transfersBefore.m_bytesToCpu;
+				event.m_bytesToGpu = transfersAfter.m_bytesToGpu - transfersBefore.m_bytesToGpu;
+				event.m_transferWait = transfersAfter.m_nsBlocked - transfersBefore.m_nsBlocked;
+				m_traceRings[i]->Push(event);
+			}
 
-		//We have no more filters to run.
-		//If this was the last filter (nothing left incomplete), we're done - wake up the main thread
-		bool empty = false;
-		{
-			lock_guard<mutex> lock2(m_mutex);
-			empty = m_incompleteNodes.empty();
+			//Get our outputs moving towards our dependents while whatever else they're waiting on finishes.
+			//None of them can have started yet, since we haven't released them.
+			if(m_prefetch)
+				PrefetchOutputs(inode);
 		}
-		if(empty)
+
+		int64_t doneTime = tracing ? GetTraceTimestamp() : 0;
+		idleStart = doneTime;
+
+		//Release our dependents. Anything that just became runnable goes on our own queue,
+		//since its inputs are most likely still hot in our cache.
+		size_t pushed = 0;
+		for(auto d : m_nodes[inode].m_dependents)
 		{
+			if(m_pendingInputs[d].fetch_sub(1) == 1)
 			{
-				lock_guard<mutex> lock3(m_completionCvarMutex);
-				m_allWorkersComplete = true;
+				m_nodes[d].m_readyTime = doneTime;
+				localQueue.Push(d);
+				pushed ++;
 			}
+		}
 
-			m_completionCvar.notify_all();
+		//We'll run one of the new nodes ourself, so only wake others if there's more than that
+		bool last = (m_remainingNodes.fetch_sub(1) == 1);
+		if(last || (pushed > 1))
+			WakeWorkers();
+	}
+}
+
+/**
+	@brief Starts asynchronous copies of a just-completed node's outputs to wherever its dependents expect their inputs
+
+	Consumers wait for the copies in PrepareForCpuAccess() / PrepareForGpuAccess() when they start, by which time the
+	copies have usually completed in the background. Several consumers of the same output may do this concurrently;
+	AcceleratorBuffer only touches the pending transfer atomically so each waits on its own reference.
+ */
+void FilterGraphExecutor::PrefetchOutputs(size_t inode)
+{
+	auto f = m_nodes[inode].m_node;
+	auto& counters = GetAcceleratorTransferCounters();
+	uint64_t bytesBefore = counters.m_bytesToCpu + counters.m_bytesToGpu;
+
+	//Dependents contains one entry per edge, but copies of an input that's already up to date are no-ops
+	for(auto d : m_nodes[inode].m_dependents)
+	{
+		auto consumer = m_nodes[d].m_node;
+		auto loc = consumer->GetInputLocation();
+		if(loc == Filter::LOC_DONTCARE)
+			continue;
+
+		for(size_t j=0; j<consumer->GetInputCount(); j++)
+		{
+			auto in = consumer->GetInput(j);
+			if(in.m_channel != f)
+				continue;
+
+			auto data = in.GetData();
+			if(data == nullptr)
+				continue;
+
+			if(loc == Filter::LOC_GPU)
+				data->PrepareForGpuAccessAsync();
+			else
+				data->PrepareForCpuAccessAsync();
+		}
+	}
+
+	m_prefetchedBytes += counters.m_bytesToCpu + counters.m_bytesToGpu - bytesBefore;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tracing
+
+/**
+	@brief Gets the current time for trace events, in nanoseconds from an arbitrary epoch
+ */
+int64_t FilterGraphExecutor::GetTraceTimestamp()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+	@brief Looks up (or assigns) the index of a node's name in the trace name table
+
+	Names are stored by value since nodes may be deleted while their events are still in the rings.
+	Must be called with m_traceMutex held.
+ */
+uint32_t FilterGraphExecutor::GetTraceNameID(FlowGraphNode* node)
+{
+	pair<string, string> key;
+	auto f = dynamic_cast<Filter*>(node);
+	if(f)
+	{
+		key.first = f->GetDisplayName();
+		key.second = f->GetProtocolDisplayName();
+	}
+	else
+		key.first = "(unnamed node)";
+
+	auto it = m_traceNameIDs.find(key);
+	if(it != m_traceNameIDs.end())
+		return it->second;
+
+	uint32_t id = m_traceNames.size();
+	m_traceNames.push_back(key);
+	m_traceNameIDs[key] = id;
+	return id;
+}
+
+/**
+	@brief Appends a copy of all valid events in the ring to a vector
+ */
+void FilterGraphExecutor::TraceRing::Snapshot(vector<TraceEvent>& events) const
+{
+	size_t capacity = m_events.size();
+	uint64_t head = m_head.load(memory_order_acquire);
+	uint64_t first = (head > capacity) ? (head - capacity) : 0;
+
+	size_t base = events.size();
+	for(uint64_t j=first; j<head; j++)
+		events.push_back(m_events[j % capacity]);
+
+	//The writer may have lapped us while we were copying. Its next write goes to the slot of event
+	//(newHead - capacity), so anything at or before that is potentially torn.
+	atomic_thread_fence(memory_order_acquire);
+	uint64_t newHead = m_head.load(memory_order_relaxed);
+	if(newHead >= capacity)
+	{
+		uint64_t firstValid = newHead - capacity + 1;
+		if(firstValid > first)
+		{
+			size_t ndrop = min(firstValid - first, head - first);
+			events.erase(events.begin() + base, events.begin() + base + ndrop);
+		}
+	}
+}
+
+/**
+	@brief Returns the nearest-rank percentile of a sorted list
+ */
+static int64_t Percentile(const vector<int64_t>& sorted, double p)
+{
+	size_t rank = ceil(p * sorted.size());
+	if(rank < 1)
+		rank = 1;
+	return sorted[min(rank, sorted.size()) - 1];
+}
+
+/**
+	@brief Computes execution time statistics for each filter over the most recent passes
+
+	Only passes still in the trace rings are included, so very large graphs may see fewer than numPasses.
+
+	@param numPasses	Number of passes to include
+
+	@return Statistics for each filter, slowest (by median) first
+ */
+vector<FilterGraphExecutor::FilterTimingStats> FilterGraphExecutor::GetFilterTimingStats(size_t numPasses)
+{
+	vector<TraceEvent> events;
+	for(auto& ring : m_traceRings)
+		ring->Snapshot(events);
+
+	uint64_t newest = 0;
+	for(auto& e : events)
+		newest = max(newest, e.m_pass);
+	uint64_t oldest = (newest >= numPasses) ? (newest - numPasses + 1) : 0;
+
+	//Group by filter
+	map<uint32_t, vector<int64_t>> durations;
+	map<uint32_t, pair<uint64_t, uint64_t>> bytes;
+	map<uint32_t, int64_t> waits;
+	for(auto& e : events)
+	{
+		if(e.m_pass < oldest)
+			continue;
+		durations[e.m_name].push_back(e.m_endTime - e.m_startTime);
+		auto& b = bytes[e.m_name];
+		b.first += e.m_bytesToCpu;
+		b.second += e.m_bytesToGpu;
+		waits[e.m_name] += e.m_transferWait;
+	}
+
+	vector<FilterTimingStats> ret;
+	{
+		lock_guard<mutex> lock(m_traceMutex);
+		for(auto& it : durations)
+		{
+			auto& times = it.second;
+			sort(times.begin(), times.end());
+
+			FilterTimingStats stats;
+			stats.m_name = m_traceNames[it.first].first;
+			stats.m_protocol = m_traceNames[it.first].second;
+			stats.m_count = times.size();
+			stats.m_p50 = Percentile(times, 0.5);
+			stats.m_p99 = Percentile(times, 0.99);
+			stats.m_max = times.back();
+			stats.m_bytesToCpu = bytes[it.first].first / times.size();
+			stats.m_bytesToGpu = bytes[it.first].second / times.size();
+			stats.m_transferWait = waits[it.first] / (int64_t)times.size();
+			ret.push_back(stats);
 		}
 	}
+
+	sort(ret.begin(), ret.end(),
+		[](const FilterTimingStats& a, const FilterTimingStats& b) { return a.m_p50 > b.m_p50; });
+	return ret;
+}
+
+/**
+	@brief Exports the most recent passes in Chrome trace event format
+
+	Each worker thread is shown as a track, with one slice per filter evaluation. Slice arguments give the time the
+	filter spent waiting for its inputs and in the run queue, how long the worker was idle before picking it up, how
+	many bytes were copied between CPU and GPU memory, and how long it was blocked waiting for those copies. Passes
+	themselves are shown on a separate track, along with how many bytes were prefetched for downstream filters.
+
+	@param numPasses	Number of passes to include
+
+	@return JSON document, loadable in Perfetto or chrome://tracing
+ */
+string FilterGraphExecutor::GetChromeTrace(size_t numPasses)
+{
+	vector<TraceEvent> events;
+	for(auto& ring : m_traceRings)
+		ring->Snapshot(events);
+
+	lock_guard<mutex> lock(m_traceMutex);
+
+	uint64_t newest = 0;
+	for(auto& e : events)
+		newest = max(newest, e.m_pass);
+	for(auto& p : m_tracePasses)
+		newest = max(newest, p.m_pass);
+	uint64_t oldest = (newest >= numPasses) ? (newest - numPasses + 1) : 0;
+
+	//Make timestamps relative to the start of the oldest pass so the numbers stay readable
+	map<uint64_t, int64_t> passStarts;
+	int64_t epoch = INT64_MAX;
+	for(auto& p : m_tracePasses)
+	{
+		if(p.m_pass < oldest)
+			continue;
+		passStarts[p.m_pass] = p.m_startTime;
+		epoch = min(epoch, p.m_startTime);
+	}
+	for(auto& e : events)
+	{
+		if(e.m_pass >= oldest)
+			epoch = min(epoch, e.m_readyTime);
+	}
+	if(epoch == INT64_MAX)
+		epoch = 0;
+
+	string ret = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	char tmp[512];
+
+	//Track names
+	ret += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Passes\"}}";
+	for(size_t i=0; i<m_traceRings.size(); i++)
+	{
+		snprintf(tmp, sizeof(tmp),
+			",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"FilterGraph[%zu]\"}}",
+			i+1, i);
+		ret += tmp;
+	}
+
+	for(auto& p : m_tracePasses)
+	{
+		if(p.m_pass < oldest)
+			continue;
+		snprintf(tmp, sizeof(tmp),
+			",\n{\"name\":\"Pass %" PRIu64 "\",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":1,\"tid\":0,"
+			"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"executed\":%zu,\"skipped\":%zu,\"prefetchedBytes\":%" PRIu64 "}}",
+			p.m_pass,
+			(p.m_startTime - epoch) * 1e-3,
+			(p.m_endTime - p.m_startTime) * 1e-3,
+			p.m_executed,
+			p.m_skipped,
+			p.m_prefetchedBytes);
+		ret += tmp;
+	}
+
+	for(auto& e : events)
+	{
+		if(e.m_pass < oldest)
+			continue;
+
+		auto& name = m_traceNames[e.m_name];
+		auto it = passStarts.find(e.m_pass);
+		int64_t dependencyWait = (it != passStarts.end()) ? (e.m_readyTime - it->second) : 0;
+
+		ret += ",\n{\"name\":\"" + JSONEscape(name.first) + "\",\"cat\":\"" + JSONEscape(name.second) + "\",";
+		snprintf(tmp, sizeof(tmp),
+			"\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{"
+			"\"pass\":%" PRIu64 ",\"dependencyWaitUs\":%.3f,\"queueDelayUs\":%.3f,\"workerIdleUs\":%.3f,"
+			"\"bytesToCpu\":%" PRIu64 ",\"bytesToGpu\":%" PRIu64 ",\"transferWaitUs\":%.3f}}",
+			e.m_worker + 1,
+			(e.m_startTime - epoch) * 1e-3,
+			(e.m_endTime - e.m_startTime) * 1e-3,
+			e.m_pass,
+			dependencyWait * 1e-3,
+			(e.m_startTime - e.m_readyTime) * 1e-3,
+			e.m_idleTime * 1e-3,
+			e.m_bytesToCpu,
+			e.m_bytesToGpu,
+			e.m_transferWait * 1e-3);
+		ret += tmp;
+	}
+
+	ret += "\n]}\n";
+	return ret;
+}
+
+/**
+	@brief Writes the most recent passes to a file in Chrome trace event format
+
+	@return True on success
+ */
+bool FilterGraphExecutor::WriteChromeTrace(const string& path, size_t numPasses)
+{
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Failed to open trace file %s\n", path.c_str());
+		return false;
+	}
+
+	auto trace = GetChromeTrace(numPasses);
+	bool ok = (fwrite(trace.c_str(), 1, trace.size(), fp) == trace.size());
+	fclose(fp);
+	return ok;
 }
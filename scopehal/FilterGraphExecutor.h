@@ -32,9 +32,26 @@
 
 #include <condition_variable>
 #include <atomic>
+#include <unordered_map>
 
 /**
 	@brief Execution manager / scheduler for the filter graph
+
+	Each call to RunBlocking() builds a dependency-counted DAG of the nodes to be evaluated. Every worker thread owns
+	a work-stealing deque; when a node completes, any dependents whose last input just became ready are pushed onto
+	the finishing worker's deque, and idle workers steal from their peers. No locks are taken on the dispatch path.
+
+	If incremental evaluation is enabled (the default), nodes whose inputs and configuration are unchanged since their
+	last refresh (see FlowGraphNode::IsRefreshRequired()) are skipped. Their outputs are left as-is, so downstream
+	nodes see the same waveform revisions and are typically skipped as well.
+
+	RunSegmentedBlocking() evaluates streaming-capable filters one time segment at a time, so that records much larger
+	than GPU or pinned memory can be processed. Each pass works on a bounded amount of data, and the full-length outputs
+	are stitched together in pageable memory.
+
+	If tracing is enabled, each worker records the timing of every node it evaluates into its own fixed-size ring
+	buffer, without taking any locks. The most recent passes can be exported in Chrome trace format (viewable in
+	Perfetto or chrome://tracing), and per-filter percentiles of execution time are computed from the same data.
  */
 class FilterGraphExecutor
 {
@@ -43,47 +60,315 @@ public:
 	~FilterGraphExecutor();
 
 	void RunBlocking(const std::set<FlowGraphNode*>& nodes);
+	void RunSegmentedBlocking(const std::set<FlowGraphNode*>& nodes, size_t segmentSize = 16*1024*1024);
+
+	/**
+		@brief Enables or disables skipping of nodes whose inputs and configuration haven't changed
+	 */
+	void SetIncrementalEvaluation(bool enable)
+	{ m_incremental = enable; }
+
+	///@brief Checks if incremental evaluation is enabled
+	bool IsIncrementalEvaluation()
+	{ return m_incremental; }
+
+	///@brief Gets the number of nodes actually refreshed during the most recent call to RunBlocking()
+	size_t GetLastPassExecutedCount()
+	{ return m_executedNodes.load(); }
+
+	///@brief Gets the number of nodes skipped as unchanged during the most recent call to RunBlocking()
+	size_t GetLastPassSkippedCount()
+	{ return m_skippedNodes.load(); }
+
+	/**
+		@brief Enables or disables prefetching of node outputs
+
+		When enabled, each node's outputs are copied asynchronously to whichever side (CPU or GPU) the nodes consuming
+		them expect as soon as it completes, rather than when the consumers start.
+	 */
+	void SetTransferPrefetch(bool enable)
+	{ m_prefetch = enable; }
+
+	///@brief Checks if output prefetching is enabled
+	bool IsTransferPrefetch()
+	{ return m_prefetch; }
+
+	///@brief Gets the number of bytes copied by output prefetching during the most recent call to RunBlocking()
+	uint64_t GetLastPassPrefetchedBytes()
+	{ return m_prefetchedBytes.load(); }
+
+	/**
+		@brief Enables or disables recording of per-node execution traces
+
+		Tracing costs a few clock reads per node, and nothing when disabled.
+	 */
+	void SetTracingEnabled(bool enable)
+	{ m_tracing = enable; }
+
+	///@brief Checks if tracing is enabled
+	bool IsTracingEnabled()
+	{ return m_tracing; }
+
+	/**
+		@brief Rolling execution time statistics for a single filter
+	 */
+	struct FilterTimingStats
+	{
+		///@brief Display name of the filter
+		std::string m_name;
+
+		///@brief Protocol name of the filter
+		std::string m_protocol;
+
+		///@brief Number of evaluations the statistics are computed over
+		size_t m_count;
+
+		///@brief Median execution time, in nanoseconds
+		int64_t m_p50;
 
-	FlowGraphNode* GetNextRunnableNode();
+		///@brief 99th percentile execution time, in nanoseconds
+		int64_t m_p99;
+
+		///@brief Longest execution time, in nanoseconds
+		int64_t m_max;
+
+		///@brief Average number of bytes copied from GPU to CPU memory per evaluation
+		uint64_t m_bytesToCpu;
+
+		///@brief Average number of bytes copied from CPU to GPU memory per evaluation
+		uint64_t m_bytesToGpu;
+
+		///@brief Average time spent blocked waiting for CPU/GPU copies per evaluation, in nanoseconds
+		int64_t m_transferWait;
+	};
+
+	std::vector<FilterTimingStats> GetFilterTimingStats(size_t numPasses = 64);
+	std::string GetChromeTrace(size_t numPasses = 8);
+	bool WriteChromeTrace(const std::string& path, size_t numPasses = 8);
 
 protected:
 	static void ExecutorThread(FilterGraphExecutor* pThis, size_t i);
 	void DoExecutorThread(size_t i);
 
-	void UpdateRunnable();
+	void BuildGraph(const std::set<FlowGraphNode*>& nodes, int64_t passStart);
+	void RunPass(size_t i, uint64_t pass, vk::raii::CommandBuffer& cmdbuf, std::shared_ptr<QueueHandle> queue);
+	bool GetNextRunnableNode(size_t i, size_t& node);
+	void WakeWorkers();
+	void PrefetchOutputs(size_t inode);
+
+	///@brief Group a node is placed in during segmented execution
+	enum SegmentRole
+	{
+		///@brief Evaluated once on the whole record, before any segments
+		SEGMENT_BEFORE,
+
+		///@brief Evaluated once per segment
+		SEGMENT_STREAMING,
+
+		///@brief Evaluated once on the stitched outputs, after all segments
+		SEGMENT_AFTER
+	};
+
+	SegmentRole ClassifySegmentedNode(
+		FlowGraphNode* node,
+		const std::set<FlowGraphNode*>& nodes,
+		std::map<FlowGraphNode*, SegmentRole>& roles);
+	bool RunSegments(
+		const std::set<FlowGraphNode*>& streaming,
+		const std::set<FlowGraphNode*>& sources,
+		const std::set<FlowGraphNode*>& nodes,
+		size_t segmentSize);
+
+	static int64_t GetTraceTimestamp();
+	uint32_t GetTraceNameID(FlowGraphNode* node);
+
+	///@brief Per-node scheduling state for the current pass
+	struct NodeState
+	{
+		///@brief The node to evaluate
+		FlowGraphNode* m_node;
+
+		///@brief Indexes (in m_nodes) of nodes consuming our output, one entry per edge
+		std::vector<size_t> m_dependents;
+
+		///@brief Index of the node's name in m_traceNames (only valid if tracing)
+		uint32_t m_traceName;
+
+		///@brief Time at which the node's last input became ready (only valid if tracing)
+		int64_t m_readyTime;
+	};
+
+	///@brief Timing of one node evaluation
+	struct TraceEvent
+	{
+		///@brief Sequence number of the pass the node was evaluated in
+		uint64_t m_pass;
+
+		///@brief Index of the node's name in m_traceNames
+		uint32_t m_name;
+
+		///@brief Index of the worker thread that evaluated the node
+		uint32_t m_worker;
+
+		///@brief Time at which the node's last input became ready
+		int64_t m_readyTime;
 
-	//Mutex for access to shared state
-	std::mutex m_mutex;
+		///@brief Time at which the worker started on the node (including moving its inputs)
+		int64_t m_startTime;
 
-	//Nodes that have not yet been updated
-	std::set<FlowGraphNode*> m_incompleteNodes;
+		///@brief Time at which the node's refresh completed
+		int64_t m_endTime;
 
-	//Nodes that have no dependencies and are eligible to run now
-	std::set<FlowGraphNode*> m_runnableNodes;
+		///@brief Time the worker spent idle or looking for work before starting the node
+		int64_t m_idleTime;
 
-	//Nodes that are actively being run
-	std::set<FlowGraphNode*> m_runningNodes;
+		///@brief Bytes copied from GPU to CPU memory while evaluating the node
+		uint64_t m_bytesToCpu;
+
+		///@brief Bytes copied from CPU to GPU memory while evaluating the node
+		uint64_t m_bytesToGpu;
+
+		///@brief Time spent blocked waiting for CPU/GPU copies while evaluating the node
+		int64_t m_transferWait;
+	};
+
+	/**
+		@brief Fixed-size ring of trace events, written by a single worker and readable from any thread
+
+		The writer never blocks. Readers copy the ring and then discard any entries the writer may have overwritten
+		while they were copying.
+	 */
+	class TraceRing
+	{
+	public:
+		TraceRing(size_t capacity)
+			: m_events(capacity)
+			, m_head(0)
+		{}
+
+		///@brief Appends an event, overwriting the oldest one if the ring is full (owning worker only)
+		void Push(const TraceEvent& event)
+		{
+			uint64_t head = m_head.load(std::memory_order_relaxed);
+			m_events[head % m_events.size()] = event;
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		void Snapshot(std::vector<TraceEvent>& events) const;
+
+	protected:
+		///@brief Event storage
+		std::vector<TraceEvent> m_events;
+
+		///@brief Total number of events ever pushed
+		std::atomic<uint64_t> m_head;
+	};
+
+	///@brief Start and end of one call to RunBlocking()
+	struct PassRecord
+	{
+		///@brief Sequence number of the pass
+		uint64_t m_pass;
+
+		///@brief Time at which the pass started
+		int64_t m_startTime;
+
+		///@brief Time at which the last node completed
+		int64_t m_endTime;
+
+		///@brief Number of nodes evaluated
+		size_t m_executed;
+
+		///@brief Number of nodes skipped as unchanged
+		size_t m_skipped;
+
+		///@brief Bytes copied by output prefetching
+		uint64_t m_prefetchedBytes;
+	};
+
+	///@brief All nodes to be evaluated in the current pass
+	std::vector<NodeState> m_nodes;
+
+	///@brief Map of nodes to their index in m_nodes
+	std::unordered_map<FlowGraphNode*, size_t> m_nodeIndexes;
+
+	///@brief Number of not-yet-complete inputs for each node in m_nodes
+	std::unique_ptr<std::atomic<size_t>[]> m_pendingInputs;
+
+	///@brief Capacity of m_pendingInputs
+	size_t m_pendingInputsCapacity;
+
+	///@brief Run queue for each worker thread
+	std::vector<std::unique_ptr<WorkStealingDeque>> m_queues;
+
+	///@brief Number of nodes in the current pass that have not yet finished executing
+	std::atomic<size_t> m_remainingNodes;
+
+	///@brief Incremented every time new work is pushed, so idle workers can tell if they missed anything
+	std::atomic<uint64_t> m_workEpoch;
+
+	///@brief Number of workers blocked waiting for work
+	std::atomic<size_t> m_sleepingWorkers;
+
+	///@brief True to skip nodes that don't need to be refreshed
+	std::atomic<bool> m_incremental;
+
+	///@brief Number of nodes refreshed so far in the current pass
+	std::atomic<size_t> m_executedNodes;
+
+	///@brief Number of nodes skipped so far in the current pass
+	std::atomic<size_t> m_skippedNodes;
+
+	///@brief True to start copying each node's outputs to where its consumers expect them as soon as it completes
+	std::atomic<bool> m_prefetch;
+
+	///@brief Bytes copied by output prefetching so far in the current pass
+	std::atomic<uint64_t> m_prefetchedBytes;
 
 	//Set of thread contexts
 	std::vector<std::unique_ptr<std::thread>> m_threads;
 
+	///@brief Mutex for pass start/stop state and the condition variables (never taken on the dispatch path)
+	std::mutex m_controlMutex;
+
 	//Condition variable for waking up worker threads when work arrives
 	std::condition_variable m_workerCvar;
 
-	//Mutex for access to m_workerCvar
-	std::mutex m_workerCvarMutex;
-
 	//Condition variable for waking up main thread when work is complete
 	std::condition_variable m_completionCvar;
 
-	//Mutex for access to m_completionCvar
-	std::mutex m_completionCvarMutex;
+	///@brief Sequence number of the current pass
+	uint64_t m_pass;
+
+	///@brief True if a pass has been started and not all workers have left it yet
+	bool m_passActive;
 
-	///@brief Indicates that all worker threads have finished executing this pass
-	bool m_allWorkersComplete;
+	///@brief Number of workers currently participating in a pass
+	size_t m_activeWorkers;
 
 	//Shutdown flag
 	bool m_terminating;
+
+	///@brief True to record trace events
+	std::atomic<bool> m_tracing;
+
+	///@brief True if the current pass is being traced (only changed while the workers are idle)
+	bool m_passTracing;
+
+	///@brief Trace events recorded by each worker thread
+	std::vector<std::unique_ptr<TraceRing>> m_traceRings;
+
+	///@brief Most recent passes, oldest first
+	std::deque<PassRecord> m_tracePasses;
+
+	///@brief Display and protocol names of every node seen while tracing, indexed by TraceEvent::m_name
+	std::vector<std::pair<std::string, std::string>> m_traceNames;
+
+	///@brief Map of display and protocol names to indexes in m_traceNames
+	std::map<std::pair<std::string, std::string>, uint32_t> m_traceNameIDs;
+
+	///@brief Mutex for m_tracePasses and the name table (taken by the main thread and readers, never by workers)
+	std::mutex m_traceMutex;
 };
 
 #endif
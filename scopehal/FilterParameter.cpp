@@ -36,8 +36,13 @@
 #include "scopehal.h"
 #include "Filter.h"
 
+#include <atomic>
+
 using namespace std;
 
+///@brief Next unused parameter / node change generation
+static atomic<uint64_t> g_nextGeneration(1);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // FilterParameter
 
@@ -56,10 +61,19 @@ FilterParameter::FilterParameter(ParameterTypes type, Unit unit)
 	, m_string("")
 	, m_hidden(false)
 	, m_readOnly(false)
+	, m_generation(AllocateGeneration())
 {
 
 }
 
+/**
+	@brief Returns a new, globally unique, change generation number
+ */
+uint64_t FilterParameter::AllocateGeneration()
+{
+	return g_nextGeneration++;
+}
+
 /**
 	@brief Constructs a FilterParameter object for choosing from available units
  */
@@ -215,6 +229,7 @@ void FilterParameter::ParseString(const string& str, bool useDisplayLocale)
 			break;
 	}
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
 
@@ -297,6 +312,7 @@ void FilterParameter::SetBoolVal(bool b)
 	m_string = b ? "1" : "0";
 	m_8b10bPattern.clear();
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
 
@@ -313,6 +329,7 @@ void FilterParameter::SetIntVal(int64_t i)
 	if(m_reverseEnumMap.find(i) != m_reverseEnumMap.end())
 		m_string = m_reverseEnumMap[i];
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
 
@@ -326,6 +343,7 @@ void FilterParameter::SetFloatVal(float f)
 	m_string = "";
 	m_8b10bPattern.clear();
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
 
@@ -347,6 +365,7 @@ void FilterParameter::SetFileName(const string& f)
 	m_string = f;
 	m_8b10bPattern.clear();
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
 
@@ -357,5 +376,6 @@ void FilterParameter::Set8B10BPattern(const vector<T8B10BSymbol>& pattern)
 	m_8b10bPattern = pattern;
 	m_string = ToString();
 
+	m_generation = AllocateGeneration();
 	m_changeSignal.emit();
 }
@@ -156,7 +156,21 @@ public:
 		@brief Change the units of the parameter
 	 */
 	void SetUnit(Unit u)
-	{ m_unit = u; }
+	{
+		m_unit = u;
+		m_generation = AllocateGeneration();
+	}
+
+	/**
+		@brief Gets the change generation of this parameter
+
+		The generation is updated every time the parameter's value or units change. Generations are drawn from a
+		single global counter, so a generation taken from any parameter (or FlowGraphNode) is never reused.
+	 */
+	uint64_t GetGeneration() const
+	{ return m_generation; }
+
+	static uint64_t AllocateGeneration();
 
 	//File filters for TYPE_FILENAME (otherwise ignored)
 	std::string m_fileFilterMask;
@@ -258,6 +272,8 @@ protected:
 
 	bool						m_hidden;
 	bool						m_readOnly;
+
+	uint64_t					m_generation;
 };
 
 #endif
@@ -49,6 +49,8 @@ string StreamDescriptor::GetName() const
 // Construction / destruction
 
 FlowGraphNode::FlowGraphNode()
+	: m_configGeneration(FilterParameter::AllocateGeneration())
+	, m_lastRefreshGeneration(0)
 {
 }
 
@@ -112,6 +114,154 @@ FlowGraphNode::DataLocation FlowGraphNode::GetInputLocation()
 	return LOC_CPU;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Incremental evaluation
+
+/**
+	@brief Gets the generation of the most recent change to this node's configuration.
+
+	This is the newest of the generations of all of our parameters, and of the last change to our inputs or any other
+	state reported via MarkConfigurationChanged(). Generations come from a single global counter, so any change to the
+	configuration results in a generation that has never been returned before.
+ */
+uint64_t FlowGraphNode::GetConfigurationGeneration()
+{
+	uint64_t gen = m_configGeneration;
+	for(auto& it : m_parameters)
+		gen = max(gen, it.second.GetGeneration());
+	return gen;
+}
+
+/**
+	@brief Notes that the node's configuration has changed in a way not reflected by any parameter or input.
+
+	This forces the next pass of the filter graph to call Refresh() even if incremental evaluation is enabled
+	and none of the node's inputs have changed.
+ */
+void FlowGraphNode::MarkConfigurationChanged()
+{
+	m_configGeneration = FilterParameter::AllocateGeneration();
+}
+
+/**
+	@brief Records the state of this node's inputs and configuration after a call to Refresh()
+
+	The snapshot is taken after the refresh so that parameters updated by the node itself (for example, read-only
+	values calculated from the input) don't make it look dirty on the next pass.
+ */
+void FlowGraphNode::MarkRefreshed()
+{
+	m_lastRefreshInputs.resize(m_inputs.size());
+	for(size_t i=0; i<m_inputs.size(); i++)
+	{
+		auto& snap = m_lastRefreshInputs[i];
+		snap.m_data = m_inputs[i].GetData();
+		snap.m_revision = snap.m_data ? snap.m_data->m_revision : 0;
+		snap.m_size = snap.m_data ? snap.m_data->size() : 0;
+		snap.m_scalar = m_inputs[i].GetScalarValue();
+	}
+
+	m_lastRefreshGeneration = GetConfigurationGeneration();
+}
+
+/**
+	@brief Checks if any input or configuration setting has changed since the last call to MarkRefreshed()
+ */
+bool FlowGraphNode::HasChangedSinceLastRefresh()
+{
+	//Never been evaluated
+	if(m_lastRefreshGeneration == 0)
+		return true;
+
+	if(GetConfigurationGeneration() != m_lastRefreshGeneration)
+		return true;
+
+	if(m_lastRefreshInputs.size() != m_inputs.size())
+		return true;
+	for(size_t i=0; i<m_inputs.size(); i++)
+	{
+		auto& snap = m_lastRefreshInputs[i];
+		auto data = m_inputs[i].GetData();
+		if(data != snap.m_data)
+			return true;
+		if(data && (data->m_revision != snap.m_revision))
+			return true;
+		if(m_inputs[i].GetScalarValue() != snap.m_scalar)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+	@brief Checks if the only change since the last call to MarkRefreshed() is samples appended to one input
+
+	This is true if the configuration and all other inputs are unchanged, and the waveform on input i is the same
+	object and has only been modified by WaveformBase::MarkSamplesAppended() since then. Nodes which save their
+	state between refreshes can use this to process only the new samples of a live capture which is growing in place,
+	rather than starting over from the beginning every time.
+
+	@param i		Index of the input to check
+	@param start	Set to the number of samples the input had at the last refresh (i.e. the index of the first
+					new sample) if the return value is true
+
+	@return True if samples [0, start) of the input have already been processed
+ */
+bool FlowGraphNode::IsInputAppendedSinceLastRefresh(size_t i, size_t& start)
+{
+	if(m_lastRefreshGeneration == 0)
+		return false;
+	if(GetConfigurationGeneration() != m_lastRefreshGeneration)
+		return false;
+	if( (m_lastRefreshInputs.size() != m_inputs.size()) || (i >= m_inputs.size()) )
+		return false;
+
+	for(size_t j=0; j<m_inputs.size(); j++)
+	{
+		auto& snap = m_lastRefreshInputs[j];
+		auto data = m_inputs[j].GetData();
+		if(data != snap.m_data)
+			return false;
+		if(m_inputs[j].GetScalarValue() != snap.m_scalar)
+			return false;
+		if(!data)
+			continue;
+
+		if(j == i)
+		{
+			if(!data->IsAppendedSince(snap.m_revision) || (data->size() < snap.m_size) )
+				return false;
+		}
+		else if(data->m_revision != snap.m_revision)
+			return false;
+	}
+
+	//Can't append to nothing
+	if(m_lastRefreshInputs[i].m_data == nullptr)
+		return false;
+
+	start = m_lastRefreshInputs[i].m_size;
+	return true;
+}
+
+/**
+	@brief Determines whether the node needs to be refreshed in the current pass of the filter graph.
+
+	The default implementation assumes that a node's outputs are a function of only its inputs and configuration,
+	and thus only requires a refresh if any of these have changed since the previous refresh.
+
+	Nodes with no inputs have no way to tell us when they have new data, so they are always refreshed. Derived classes
+	should override this if their output depends on anything else (wall clock time, random numbers, hardware state,
+	etc) or, in the case of sources whose output only depends on their parameters, to allow them to be skipped.
+ */
+bool FlowGraphNode::IsRefreshRequired()
+{
+	if(m_inputs.empty())
+		return true;
+
+	return HasChangedSinceLastRefresh();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -166,6 +316,8 @@ void FlowGraphNode::SetInput(size_t i, StreamDescriptor stream, bool force)
 		if(stream == m_inputs[i])
 			return;
 
+		MarkConfigurationChanged();
+
 		if(stream.m_channel == nullptr)	//NULL is always legal
 		{
 			m_inputs[i] = StreamDescriptor(nullptr, 0);
@@ -280,6 +432,7 @@ void FlowGraphNode::CreateInput(const string& name)
 {
 	m_signalNames.push_back(name);
 	m_inputs.push_back(StreamDescriptor(NULL, 0));
+	MarkConfigurationChanged();
 }
 
 bool FlowGraphNode::ValidateChannel(size_t /*i*/, StreamDescriptor /*stream*/)
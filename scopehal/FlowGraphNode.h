@@ -37,6 +37,8 @@
 
 class OscilloscopeChannel;
 class WaveformBase;
+class PackedDigitalWaveform;
+class PackedDigitalBusWaveform;
 class StreamDescriptor;
 
 #include "FilterParameter.h"
@@ -122,6 +124,15 @@ public:
 	//Filter evaluation (GPU accelerated)
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Incremental evaluation
+
+	uint64_t GetConfigurationGeneration();
+	void MarkConfigurationChanged();
+
+	virtual bool IsRefreshRequired();
+	virtual void MarkRefreshed();
+
 	//Input handling helpers
 protected:
 
@@ -131,6 +142,8 @@ protected:
 		This function is safe to call on a NULL input and will return NULL in that case.
 	 */
 	WaveformBase* GetInputWaveform(size_t i);	//implementation in FlowGraphNode_inlines.h
+	PackedDigitalWaveform* GetPackedDigitalInputWaveform(size_t i);
+	PackedDigitalBusWaveform* GetPackedDigitalBusInputWaveform(size_t i);
 
 	///@brief Gets the analog waveform attached to the specified input
 	SparseAnalogWaveform* GetSparseAnalogInputWaveform(size_t i)
@@ -156,6 +169,9 @@ protected:
 
 	std::string GetInputDisplayName(size_t i);
 
+	bool HasChangedSinceLastRefresh();
+	bool IsInputAppendedSinceLastRefresh(size_t i, size_t& start);
+
 protected:
 	///Names of signals we take as input
 	std::vector<std::string> m_signalNames;
@@ -166,6 +182,31 @@ protected:
 	//Parameters
 	ParameterMapType m_parameters;
 
+	///@brief Generation of the last change to the node's configuration not tracked by an individual parameter
+	uint64_t m_configGeneration;
+
+	///@brief State of one input as of the last call to MarkRefreshed()
+	struct InputSnapshot
+	{
+		///@brief The waveform that was attached to the input
+		WaveformBase* m_data;
+
+		///@brief Revision of m_data
+		uint64_t m_revision;
+
+		///@brief Number of samples in m_data
+		size_t m_size;
+
+		///@brief Value of the input, if it was a scalar
+		float m_scalar;
+	};
+
+	///@brief Configuration generation as of the last call to MarkRefreshed(), or zero if never refreshed
+	uint64_t m_lastRefreshGeneration;
+
+	///@brief State of each input as of the last call to MarkRefreshed()
+	std::vector<InputSnapshot> m_lastRefreshInputs;
+
 public:
 
 	sigc::signal<void()> signal_parametersChanged()
@@ -41,6 +41,10 @@
 /**
 	@brief Gets the waveform attached to the specified input.
 
+	Packed digital waveforms are returned as their unpacked equivalents, so filters only need to handle the
+	byte-per-sample types. Filters which can read packed data directly should check
+	GetPackedDigitalInputWaveform() first.
+
 	This function is safe to call on a NULL input and will return NULL in that case.
  */
 inline WaveformBase* FlowGraphNode::GetInputWaveform(size_t i)
@@ -48,7 +52,23 @@ inline WaveformBase* FlowGraphNode::GetInputWaveform(size_t i)
 	auto chan = m_inputs[i].m_channel;
 	if(chan == NULL)
 		return NULL;
-	return chan->GetData(m_inputs[i].m_stream);
+	return GetUnpackedWaveform(chan->GetData(m_inputs[i].m_stream));
+}
+
+/**
+	@brief Gets the packed digital waveform attached to the specified input, or NULL if it holds any other type
+ */
+inline PackedDigitalWaveform* FlowGraphNode::GetPackedDigitalInputWaveform(size_t i)
+{
+	return dynamic_cast<PackedDigitalWaveform*>(m_inputs[i].GetData());
+}
+
+/**
+	@brief Gets the packed digital bus waveform attached to the specified input, or NULL if it holds any other type
+ */
+inline PackedDigitalBusWaveform* FlowGraphNode::GetPackedDigitalBusInputWaveform(size_t i)
+{
+	return dynamic_cast<PackedDigitalBusWaveform*>(m_inputs[i].GetData());
 }
 
 inline Stream::StreamType StreamDescriptor::GetType()
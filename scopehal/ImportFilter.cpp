@@ -30,6 +30,13 @@
 #include "../scopehal/scopehal.h"
 #include "ImportFilter.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,7 +44,14 @@ using namespace std;
 
 ImportFilter::ImportFilter(const string& color, Unit xunit)
 	: Filter(color, CAT_GENERATION, xunit)
+	, m_mappedFile(nullptr)
+	, m_mappedSize(0)
+{
+}
+
+ImportFilter::~ImportFilter()
 {
+	UnmapFile();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -70,9 +84,257 @@ bool ImportFilter::NeedsConfig()
 	return true;
 }
 
+/**
+	@brief Imported data only changes when the file name (or another parameter) does, or if a mapped stream has not
+	been loaded yet
+ */
+bool ImportFilter::IsRefreshRequired()
+{
+	for(auto& s : m_mappedStreams)
+	{
+		if(GetData(s.m_stream) == nullptr)
+			return true;
+	}
+
+	return HasChangedSinceLastRefresh();
+}
+
 void ImportFilter::Refresh()
 {
-	//everything happens in OnFileNameChanged
+	//Everything else happens in OnFileNameChanged.
+	//Mapped streams are loaded on first use, and again after segmented execution has dropped them.
+	for(auto& s : m_mappedStreams)
+	{
+		if(GetData(s.m_stream) != nullptr)
+			continue;
+
+		SetData(ReadMappedSamples(s, 0, s.m_count), s.m_stream);
+		if(!s.m_autoscaled)
+		{
+			AutoscaleVertical(s.m_stream);
+			s.m_autoscaled = true;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Segmented execution
+
+/**
+	@brief Segments can be read if every output stream is mapped
+ */
+bool ImportFilter::CanReadSegments()
+{
+	return !m_mappedStreams.empty() && (m_mappedStreams.size() == m_streams.size());
+}
+
+bool ImportFilter::GetSegmentSpan(int64_t& start, int64_t& end, int64_t& interval)
+{
+	if(m_mappedStreams.empty())
+		return false;
+
+	start = INT64_MAX;
+	end = INT64_MIN;
+	interval = INT64_MAX;
+	for(auto& s : m_mappedStreams)
+	{
+		start = min(start, s.m_triggerPhase);
+		end = max(end, s.m_triggerPhase + (int64_t)s.m_count * s.m_timescale);
+		interval = min(interval, s.m_timescale);
+	}
+	return (end > start);
+}
+
+/**
+	@brief Rounds a timestamp up to a sample index of a mapped stream
+ */
+int64_t ImportFilter::GetMappedSampleIndex(const MappedStream& s, int64_t t)
+{
+	int64_t delta = t - s.m_triggerPhase;
+	int64_t i = delta / s.m_timescale;
+	if( (delta % s.m_timescale) > 0)
+		i ++;
+	return clamp(i, (int64_t)0, (int64_t)s.m_count);
+}
+
+/**
+	@brief Converts the samples of each mapped stream within [tstart, tend) to new output waveforms
+ */
+void ImportFilter::ReadSegment(int64_t tstart, int64_t tend)
+{
+	for(auto& s : m_mappedStreams)
+	{
+		int64_t first = GetMappedSampleIndex(s, tstart);
+		int64_t last = max(first, GetMappedSampleIndex(s, tend));
+		SetData(ReadMappedSamples(s, first, last - first), s.m_stream);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// File mapping
+
+/**
+	@brief Maps the file being imported read-only, replacing any existing mapping and mapped streams
+
+	@return True on success
+ */
+bool ImportFilter::MapFile(const string& fname)
+{
+	UnmapFile();
+
+#ifdef _WIN32
+	//No mmap(), just read the whole file
+	m_fileContents = ReadFile(fname);
+	m_mappedFile = reinterpret_cast<const uint8_t*>(m_fileContents.data());
+	m_mappedSize = m_fileContents.size();
+	return !m_fileContents.empty();
+#else
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		LogError("Couldn't open %s\n", fname.c_str());
+		return false;
+	}
+
+	struct stat st;
+	if( (fstat(fd, &st) != 0) || (st.st_size == 0) )
+	{
+		LogError("Couldn't get size of %s\n", fname.c_str());
+		close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED)
+	{
+		LogError("Couldn't map %s\n", fname.c_str());
+		return false;
+	}
+
+	m_mappedFile = reinterpret_cast<const uint8_t*>(p);
+	m_mappedSize = st.st_size;
+	return true;
+#endif
+}
+
+/**
+	@brief Removes all output streams, along with the mapped file they may have been read from
+ */
+void ImportFilter::ClearStreams()
+{
+	UnmapFile();
+	Filter::ClearStreams();
+}
+
+/**
+	@brief Unmaps the file being imported, and forgets about the streams read from it
+ */
+void ImportFilter::UnmapFile()
+{
+	m_mappedStreams.clear();
+
+#ifdef _WIN32
+	m_fileContents.clear();
+#else
+	if(m_mappedFile)
+		munmap(const_cast<uint8_t*>(m_mappedFile), m_mappedSize);
+#endif
+
+	m_mappedFile = nullptr;
+	m_mappedSize = 0;
+}
+
+/**
+	@brief Copies data out of the mapped file
+
+	@return False if the range is past the end of the file
+ */
+bool ImportFilter::ReadMapped(void* dst, size_t len, size_t offset)
+{
+	if( (offset > m_mappedSize) || (len > m_mappedSize - offset) )
+		return false;
+	memcpy(dst, m_mappedFile + offset, len);
+	return true;
+}
+
+/**
+	@brief Adds an output stream whose samples are read from the mapped file
+
+	No data is loaded here. The stream's output stays empty until the next Refresh() or ReadSegment().
+ */
+void ImportFilter::AddMappedStream(const MappedStream& stream)
+{
+	m_mappedStreams.push_back(stream);
+	m_mappedStreams.back().m_autoscaled = false;
+	SetData(nullptr, stream.m_stream);
+}
+
+/**
+	@brief Converts a range of samples of a mapped stream to a new waveform
+
+	@param stream	The stream
+	@param first	Index of the first sample
+	@param count	Number of samples
+ */
+UniformAnalogWaveform* ImportFilter::ReadMappedSamples(const MappedStream& stream, size_t first, size_t count)
+{
+	//Recycle the previous segment's buffer so reading a record in segments doesn't fill the pool
+	auto wfm = g_waveformPool.Allocate<UniformAnalogWaveform>(count);
+	wfm->m_flags = 0;
+	wfm->m_revision ++;
+	wfm->m_timescale = stream.m_timescale;
+	wfm->m_startTimestamp = stream.m_startTimestamp;
+	wfm->m_startFemtoseconds = stream.m_startFemtoseconds;
+	wfm->m_triggerPhase = stream.m_triggerPhase + (int64_t)first * stream.m_timescale;
+	ReserveImportedSamples(wfm, count);
+	wfm->Resize(count);
+	wfm->PrepareForCpuAccess();
+
+	const uint8_t* p = m_mappedFile + stream.m_fileOffset + first*stream.m_stride;
+	switch(stream.m_type)
+	{
+		case MAPPED_FLOAT32:
+			for(size_t i=0; i<count; i++)
+			{
+				//Do not violate strict aliasing, compiler will optimize out the memcpy
+				float v;
+				memcpy(&v, p + i*stream.m_stride, sizeof(v));
+				wfm->m_samples[i] = v*stream.m_scale + stream.m_offset;
+			}
+			break;
+
+		case MAPPED_INT16:
+			for(size_t i=0; i<count; i++)
+			{
+				int16_t v;
+				memcpy(&v, p + i*stream.m_stride, sizeof(v));
+				wfm->m_samples[i] = v*stream.m_scale + stream.m_offset;
+			}
+			break;
+
+		case MAPPED_INT8:
+		default:
+			for(size_t i=0; i<count; i++)
+				wfm->m_samples[i] = static_cast<int8_t>(p[i*stream.m_stride])*stream.m_scale + stream.m_offset;
+			break;
+	}
+
+	wfm->MarkModifiedFromCpu();
+
+	//Drop the file pages we just read, so reading a long record a segment at a time doesn't leave all of it resident.
+	//They're clean and read-only, so they are read back from the file if needed again.
+#ifdef __linux__
+	if(count)
+	{
+		uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+		uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(pagesize - 1);
+		uintptr_t end = reinterpret_cast<uintptr_t>(p + count*stream.m_stride);
+		madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+	}
+#endif
+
+	return wfm;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
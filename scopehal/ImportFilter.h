@@ -44,8 +44,16 @@ class ImportFilter : public Filter
 {
 public:
 	ImportFilter(const std::string& color, Unit xunit = Unit(Unit::UNIT_FS));
+	virtual ~ImportFilter();
 
 	virtual void Refresh();
+	virtual bool IsRefreshRequired() override;
+
+	virtual void ClearStreams() override;
+
+	virtual bool CanReadSegments() override;
+	virtual bool GetSegmentSpan(int64_t& start, int64_t& end, int64_t& interval) override;
+	virtual void ReadSegment(int64_t tstart, int64_t tend) override;
 
 	virtual void SetDefaultName();
 
@@ -60,6 +68,102 @@ protected:
 	std::string m_fpname;
 
 	bool TryNormalizeTimebase(SparseWaveformBase* wfm);
+
+	///@brief Records at least this large (in bytes) are imported into pageable memory
+	static const size_t m_pagedImportThreshold = 256 * 1024 * 1024;
+
+	/**
+		@brief Reserves space for the samples of an imported waveform
+
+		Records too large to reasonably keep resident in RAM are placed in pageable memory, backed by a temporary file,
+		so they can be processed a segment at a time (see FilterGraphExecutor::RunSegmentedBlocking()) without the
+		whole record ever having to be in memory at once.
+
+		@param wfm		The waveform
+		@param depth	Number of samples which will be imported
+	 */
+	template<class T>
+	static void ReserveImportedSamples(UniformWaveform<T>* wfm, size_t depth)
+	{
+		if(depth * sizeof(T) >= m_pagedImportThreshold)
+			wfm->UsePagedMemory();
+		wfm->m_samples.reserve(depth);
+	}
+
+	///@brief Encodings of raw samples which can be converted straight out of the mapped file
+	enum MappedSampleType
+	{
+		MAPPED_FLOAT32,
+		MAPPED_INT16,
+		MAPPED_INT8
+	};
+
+	/**
+		@brief An analog output stream whose samples are converted from the mapped file when needed, rather than when
+		the file is opened
+
+		The whole record is only loaded when the filter is refreshed. Segmented execution reads one segment at a time
+		with ReadSegment() instead, so the record never has to be resident.
+	 */
+	struct MappedStream
+	{
+		///@brief Index of the output stream
+		size_t m_stream;
+
+		///@brief Byte offset of the first sample within the file
+		size_t m_fileOffset;
+
+		///@brief Number of samples
+		size_t m_count;
+
+		///@brief Distance between the starts of consecutive samples in the file, in bytes
+		size_t m_stride;
+
+		///@brief Encoding of each sample
+		MappedSampleType m_type;
+
+		///@brief Raw values are multiplied by this...
+		double m_scale;
+
+		///@brief ... then this is added, to get Y axis units
+		double m_offset;
+
+		///@brief Time scale of the waveform
+		int64_t m_timescale;
+
+		///@brief Trigger phase of the first sample
+		int64_t m_triggerPhase;
+
+		///@brief Start time of the waveform (seconds)
+		time_t m_startTimestamp;
+
+		///@brief Start time of the waveform (femtoseconds within m_startTimestamp)
+		int64_t m_startFemtoseconds;
+
+		///@brief True once the stream has been autoscaled after its first load
+		bool m_autoscaled;
+	};
+
+	bool MapFile(const std::string& fname);
+	void UnmapFile();
+	bool ReadMapped(void* dst, size_t len, size_t offset);
+	void AddMappedStream(const MappedStream& stream);
+	UniformAnalogWaveform* ReadMappedSamples(const MappedStream& stream, size_t first, size_t count);
+	static int64_t GetMappedSampleIndex(const MappedStream& s, int64_t t);
+
+	///@brief Read-only mapping of the imported file, or nullptr if it isn't mapped
+	const uint8_t* m_mappedFile;
+
+	///@brief Size of m_mappedFile, in bytes
+	size_t m_mappedSize;
+
+#ifdef _WIN32
+	///@brief Contents of the file, standing in for the mapping
+	std::string m_fileContents;
+#endif
+
+	///@brief Output streams read from m_mappedFile
+	std::vector<MappedStream> m_mappedStreams;
 };
 
 #endif
@@ -134,7 +134,8 @@ size_t InstrumentChannel::AddStream(Unit yunit, const string& name, Stream::Stre
 
 	Calling this function with pNew == GetData() is a legal no-op.
 
-	Any existing waveform is deleted, unless it is the same as pNew.
+	Any existing waveform is returned to the global waveform pool (which deletes it if it can't be recycled), unless
+	it is the same as pNew.
  */
 void InstrumentChannel::SetData(WaveformBase* pNew, size_t stream)
 {
@@ -142,7 +143,7 @@ void InstrumentChannel::SetData(WaveformBase* pNew, size_t stream)
 		return;
 
 	if(m_streams[stream].m_waveform != NULL)
-		delete m_streams[stream].m_waveform;
+		g_waveformPool.Add(m_streams[stream].m_waveform);
 	m_streams[stream].m_waveform = pNew;
 }
 
@@ -245,7 +245,7 @@ bool LeCroyFWPOscilloscope::AcquireData()
 	{
 		if(headers[i].numSamples > 0)
 		{
-			auto wfm = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+			auto wfm = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname(), headers[i].numSamples);
 			wfm->m_timescale = round(headers[i].horizontalInterval * FS_PER_SECOND);
 			double h_off = headers[i].horizontalOffset * FS_PER_SECOND;
 			auto h_off_frac = fmodf(h_off, wfm->m_timescale);
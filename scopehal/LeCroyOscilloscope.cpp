@@ -1024,6 +1024,15 @@ void LeCroyOscilloscope::DetectAnalogChannels()
 			i));
 	}
 	m_analogChannelCount = nchans;
+
+	for(size_t i=0; i<nchans; i++)
+	{
+		m_analogRawWaveformBuffers.push_back(std::make_unique<AcceleratorBuffer<uint8_t> >());
+		m_analogRawWaveformBuffers[i]->SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		m_analogRawWaveformBuffers[i]->SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_NEVER);
+	}
+	m_wavetimeBuffer.SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+	m_wavetimeBuffer.SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_NEVER);
 }
 
 LeCroyOscilloscope::~LeCroyOscilloscope()
@@ -2302,18 +2311,9 @@ bool LeCroyOscilloscope::PeekTriggerArmed()
 
 bool LeCroyOscilloscope::ReadWaveformBlock(string& data)
 {
-	//Prefix "DESC,\n" or "DAT1,\n". Always seems to be 6 chars and start with a D.
-	//Next is the length header. Looks like #9000000346. #9 followed by nine ASCII length digits.
-	//Ignore that too.
-	string tmp = m_transport->ReadReply();
-	if(tmp.empty())
-		return false;
-	size_t offset = tmp.find("D");
-
-	//Copy the rest of the block
-	data = tmp.substr(offset + 16);
-
-	return true;
+	//Prefix "DESC,\n" or "DAT1,\n", then the length header. Looks like #9000000346.
+	//The transport strips both and hands us just the payload.
+	return m_transport->ReadBlock(data);
 }
 
 /**
@@ -2560,7 +2560,7 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	for(size_t j=0; j<num_sequences; j++)
 	{
 		//Set up the capture we're going to store our data into
-		auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(j)->GetHwname());
+		auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(j)->GetHwname(), num_per_segment);
 		cap->m_timescale = round(interval);
 		cap->m_triggerPhase = h_off_frac;
 		cap->m_startTimestamp = ttime;
@@ -2601,38 +2601,115 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	return ret;
 }
 
+/**
+	@brief Finds the content of an XML tag without copying anything
+
+	Quick and dirty string searching. We only care about a small fraction of the XML in a digital waveform so no sense
+	bringing in a full parser.
+
+	@param xml	The XML text to search
+	@param tag	Name of the tag, without angle brackets
+
+	@return The text between the first <tag> and the following </tag>, or an empty view if not found
+ */
+string_view LeCroyOscilloscope::FindXmlTag(string_view xml, string_view tag)
+{
+	string open = "<" + string(tag) + ">";
+	string close = "</" + string(tag) + ">";
+
+	size_t start = xml.find(open);
+	if(start == string_view::npos)
+		return string_view();
+	start += open.length();
+
+	size_t end = xml.find(close, start);
+	if(end == string_view::npos)
+		return string_view();
+
+	return xml.substr(start, end - start);
+}
+
+/**
+	@brief Converts one lane of a digital waveform from one byte per sample to a sparse waveform, merging runs of
+	identical samples
+
+	@param cap			Waveform to fill, with timestamps etc already set up
+	@param samples		Raw samples for this lane, one byte each (nonzero is high)
+	@param num_samples	Number of samples
+ */
+void LeCroyOscilloscope::UnpackDigitalLane(SparseDigitalWaveform* cap, const uint8_t* samples, size_t num_samples)
+{
+	cap->PrepareForCpuAccess();
+
+	//Preallocate memory assuming no deduplication possible
+	cap->Resize(num_samples);
+
+	//Save the first sample (can't merge with sample -1 because that doesn't exist)
+	size_t k = 0;
+	cap->m_offsets[0] = 0;
+	cap->m_durations[0] = 1;
+	cap->m_samples[0] = samples[0];
+
+	//Read and de-duplicate the other samples
+	//TODO: can we vectorize this somehow?
+	bool last = samples[0];
+	for(size_t j=1; j<num_samples; j++)
+	{
+		bool sample = samples[j];
+
+		//Deduplicate consecutive samples with same value
+		//FIXME: temporary workaround for rendering bugs
+		//if(last == sample)
+		if( (last == sample) && ((j+3) < num_samples) )
+			cap->m_durations[k] ++;
+
+		//Nope, it toggled - store the new value
+		else
+		{
+			k++;
+			cap->m_offsets[k] = j;
+			cap->m_durations[k] = 1;
+			cap->m_samples[k] = sample;
+			last = sample;
+		}
+	}
+
+	//Done, shrink any unused space
+	cap->Resize(k);
+	cap->m_offsets.shrink_to_fit();
+	cap->m_durations.shrink_to_fit();
+	cap->m_samples.shrink_to_fit();
+	cap->MarkSamplesModifiedFromCpu();
+	cap->MarkTimestampsModifiedFromCpu();
+}
+
 map<int, SparseDigitalWaveform*> LeCroyOscilloscope::ProcessDigitalWaveform(string& data, int64_t analog_hoff)
 {
 	map<int, SparseDigitalWaveform*> ret;
 
+	//All searching is done on views of the original block, since it's many megabytes long
+	string_view xml(data);
+
 	//See what channels are enabled
-	string tmp = data.substr(data.find("SelectedLines=") + 14);
-	tmp = tmp.substr(0, 16);
+	size_t linepos = xml.find("SelectedLines=");
+	if(linepos == string_view::npos)
+		return ret;
+	string_view lines = xml.substr(linepos + 14, 16);
 	bool enabledChannels[16];
-	for(int i=0; i<16; i++)
-		enabledChannels[i] = (tmp[i] == '1');
-
-	//Quick and dirty string searching. We only care about a small fraction of the XML
-	//so no sense bringing in a full parser.
-	tmp = data.substr(data.find("<HorPerStep>") + 12);
-	tmp = tmp.substr(0, tmp.find("</HorPerStep>"));
-	float interval = atof(tmp.c_str()) * FS_PER_SECOND;
+	for(size_t i=0; i<16; i++)
+		enabledChannels[i] = (i < lines.length()) && (lines[i] == '1');
+
+	float interval = atof(string(FindXmlTag(xml, "HorPerStep")).c_str()) * FS_PER_SECOND;
 	//LogDebug("Sample interval: %.2f fs\n", interval);
 
-	tmp = data.substr(data.find("<HorStart>") + 10);
-	tmp = tmp.substr(0, tmp.find("</HorStart>"));
-	float horstart = atof(tmp.c_str()) * FS_PER_SECOND;
+	float horstart = atof(string(FindXmlTag(xml, "HorStart")).c_str()) * FS_PER_SECOND;
 
-	tmp = data.substr(data.find("<NumSamples>") + 12);
-	tmp = tmp.substr(0, tmp.find("</NumSamples>"));
-	size_t num_samples = atoi(tmp.c_str());
+	size_t num_samples = atoi(string(FindXmlTag(xml, "NumSamples")).c_str());
 	//LogDebug("Expecting %d samples\n", num_samples);
 
 	//Extract the raw trigger timestamp (nanoseconds since Jan 1 2000)
-	tmp = data.substr(data.find("<FirstEventTime>") + 16);
-	tmp = tmp.substr(0, tmp.find("</FirstEventTime>"));
 	int64_t timestamp;
-	if(1 != sscanf(tmp.c_str(), "%" PRId64, &timestamp))
+	if(1 != sscanf(string(FindXmlTag(xml, "FirstEventTime")).c_str(), "%" PRId64, &timestamp))
 		return ret;
 
 	//Get the client's local time.
@@ -2669,93 +2746,51 @@ map<int, SparseDigitalWaveform*> LeCroyOscilloscope::ProcessDigitalWaveform(stri
 	if(analog_hoff != 0)
 		trigger_phase = horstart - analog_hoff;
 
-	//Pull out the actual binary data (Base64 coded)
-	tmp = data.substr(data.find("<BinaryData>") + 12);
-	tmp = tmp.substr(0, tmp.find("</BinaryData>"));
-
-	//Decode the base64
-	base64_decodestate bstate;
-	base64_init_decodestate(&bstate);
-	unsigned char* block = new unsigned char[tmp.length()];	//base64 is smaller than plaintext, leave room
-	base64_decode_block(tmp.c_str(), tmp.length(), (char*)block, &bstate);
+	//Pull out the actual binary data (Base64 coded) and decode it
+	auto b64 = FindXmlTag(xml, "BinaryData");
+	unsigned char* block = new unsigned char[b64.length() + 1];	//base64 is smaller than plaintext, leave room
+	size_t blocklen = base64_decode_fast(b64.data(), b64.length(), block);
 
-	//We have each channel's data from start to finish before the next (no interleaving).
-	//TODO: Multithread across waveforms
-	unsigned int icapchan = 0;
+	//Allocate waveforms for the enabled lanes
+	vector<SparseDigitalWaveform*> caps;
 	for(unsigned int i=0; i<m_digitalChannelCount; i++)
 	{
-		if(enabledChannels[i])
+		if(!enabledChannels[i])
 		{
-			auto cap = AllocateDigitalWaveform(m_nickname + "." + GetChannel(m_digitalChannelBase + i)->GetHwname());
-			cap->m_timescale = interval;
-			cap->PrepareForCpuAccess();
-
-			//Capture timestamp
-			cap->m_startTimestamp = start_time;
-			cap->m_startFemtoseconds = start_fs;
-			cap->m_triggerPhase = trigger_phase;
-
-			//Preallocate memory assuming no deduplication possible
-			cap->Resize(num_samples);
-
-			//Save the first sample (can't merge with sample -1 because that doesn't exist)
-			size_t base = icapchan*num_samples;
-			size_t k = 0;
-			cap->m_offsets[0] = 0;
-			cap->m_durations[0] = 1;
-			cap->m_samples[0] = block[base];
-
-			//Read and de-duplicate the other samples
-			//TODO: can we vectorize this somehow?
-			bool last = block[base];
-			for(size_t j=1; j<num_samples; j++)
-			{
-				bool sample = block[base + j];
+			//No data here for us!
+			ret[m_digitalChannels[i]->GetIndex()] = nullptr;
+			continue;
+		}
 
-				//Deduplicate consecutive samples with same value
-				//FIXME: temporary workaround for rendering bugs
-				//if(last == sample)
-				if( (last == sample) && ((j+3) < num_samples) )
-					cap->m_durations[k] ++;
+		auto cap = AllocateDigitalWaveform(
+			m_nickname + "." + GetChannel(m_digitalChannelBase + i)->GetHwname(), num_samples);
+		cap->m_timescale = interval;
 
-				//Nope, it toggled - store the new value
-				else
-				{
-					k++;
-					cap->m_offsets[k] = j;
-					cap->m_durations[k] = 1;
-					cap->m_samples[k] = sample;
-					last = sample;
-				}
-
-			}
+		//Capture timestamp
+		cap->m_startTimestamp = start_time;
+		cap->m_startFemtoseconds = start_fs;
+		cap->m_triggerPhase = trigger_phase;
 
-			//Done, shrink any unused space
-			cap->Resize(k);
-			cap->m_offsets.shrink_to_fit();
-			cap->m_durations.shrink_to_fit();
-			cap->m_samples.shrink_to_fit();
-			cap->MarkSamplesModifiedFromCpu();
-			cap->MarkTimestampsModifiedFromCpu();
-
-			//See how much space we saved
-			/*
-			LogDebug("%s: %zu samples deduplicated to %zu (%.1f %%)\n",
-				m_digitalChannels[i]->GetDisplayName().c_str(),
-				num_samples,
-				k,
-				(k * 100.0f) / num_samples);
-			*/
-
-			//Done, save data and go on to next
-			ret[m_digitalChannels[i]->GetIndex()] = cap;
-			icapchan ++;
-		}
+		ret[m_digitalChannels[i]->GetIndex()] = cap;
+		caps.push_back(cap);
+	}
 
-		//No data here for us!
-		else
-			ret[m_digitalChannels[i]->GetIndex()] = NULL;
+	if( (num_samples == 0) || (blocklen < caps.size() * num_samples) )
+	{
+		LogError("LeCroyOscilloscope::ProcessDigitalWaveform: expected %zu samples for each of %zu lanes, got %zu bytes\n",
+			num_samples, caps.size(), blocklen);
+		for(auto cap : caps)
+			cap->clear();
 	}
+	else
+	{
+		//We have each channel's data from start to finish before the next (no interleaving),
+		//so each lane can be unpacked independently
+		#pragma omp parallel for
+		for(size_t i=0; i<caps.size(); i++)
+			UnpackDigitalLane(caps[i], block + i*num_samples, num_samples);
+	}
+
 	delete[] block;
 	return ret;
 }
@@ -2769,14 +2804,14 @@ bool LeCroyOscilloscope::AcquireData()
 	time_t ttime = 0;
 	double basetime = 0;
 	bool denabled = false;
-	map<int, string> analogWaveformData;
-	string wavetime;
 	bool enabled[8] = {false};
 	vector<string> wavedescs;
 	double* pwtime = nullptr;
 	string digitalWaveformData;
+	vector< vector<WaveformBase*> > waveforms;
+	waveforms.resize(m_analogChannelCount);
 
-	//Acquire the data (but don't parse it)
+	//Acquire the data. Analog channels are parsed in the background as soon as each one has been downloaded.
 	{
 		lock_guard<recursive_mutex> lock2(m_transport->GetMutex());
 
@@ -2852,8 +2887,10 @@ bool LeCroyOscilloscope::AcquireData()
 			ttime = ExtractTimestamp(pdesc, basetime);
 			if(num_sequences > 1)
 			{
-				wavetime = m_transport->ReadReply();
-				pwtime = reinterpret_cast<double*>(&wavetime[16]);	//skip 16-byte SCPI header
+				if(m_transport->ReadBlock(m_wavetimeBuffer))
+					pwtime = reinterpret_cast<double*>(m_wavetimeBuffer.GetCpuPointer());
+				else
+					LogError("Failed to download trigger times\n");
 			}
 
 			//If instrument timestamp in the WAVEDESC is not valid, use our local clock instead
@@ -2864,11 +2901,27 @@ bool LeCroyOscilloscope::AcquireData()
 				basetime = t - ttime;
 			}
 
-			//Read the data from each analog waveform
+			//Read the data from each analog waveform, and parse it while we download the next
 			for(unsigned int i=0; i<m_analogChannelCount; i++)
 			{
-				if(enabled[i])
-					analogWaveformData[i] = m_transport->ReadReply();
+				if(!enabled[i])
+					continue;
+
+				if(!m_transport->ReadBlock(*m_analogRawWaveformBuffers[i]))
+					LogError("Failed to download waveform data for channel %u\n", i);
+
+				m_acquisitionPipeline.Submit([&, i]
+				{
+					auto& rawbuf = *m_analogRawWaveformBuffers[i];
+					waveforms[i] = ProcessAnalogWaveform(
+						reinterpret_cast<const char*>(rawbuf.GetCpuPointer()),
+						rawbuf.size(),
+						wavedescs[i],
+						num_sequences,
+						ttime,
+						basetime,
+						pwtime);
+				});
 			}
 		}
 
@@ -2878,6 +2931,14 @@ bool LeCroyOscilloscope::AcquireData()
 			if(!ReadWaveformBlock(digitalWaveformData))
 			{
 				LogDebug("failed to download digital waveform\n");
+
+				//Discard anything we already parsed
+				m_acquisitionPipeline.Flush();
+				for(auto& v : waveforms)
+				{
+					for(auto w : v)
+						delete w;
+				}
 				return false;
 			}
 		}
@@ -2895,9 +2956,10 @@ bool LeCroyOscilloscope::AcquireData()
 	//Offset from start of waveform to trigger
 	double analog_hoff = 0;
 
-	//Process analog waveforms
-	vector< vector<WaveformBase*> > waveforms;
-	waveforms.resize(m_analogChannelCount);
+	//Wait for the analog waveforms to finish parsing
+	m_acquisitionPipeline.Flush();
+
+	//Process analog waveform metadata
 	for(unsigned int i=0; i<m_analogChannelCount; i++)
 	{
 		if(enabled[i])
@@ -2918,15 +2980,6 @@ bool LeCroyOscilloscope::AcquireData()
 			else if(vunit == "A")
 				m_channels[i]->SetYAxisUnits(Unit(Unit::UNIT_AMPS), 0);
 			//else unknown unit, ignore for now
-
-			waveforms[i] = ProcessAnalogWaveform(
-				&analogWaveformData[i][16],			//skip 16-byte SCPI header DATA,\n#9xxxxxxxx
-				analogWaveformData[i].size() - 17,	//skip header plus \n at end
-				wavedescs[i],
-				num_sequences,
-				ttime,
-				basetime,
-				pwtime);
 		}
 	}
 
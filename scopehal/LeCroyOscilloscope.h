@@ -31,6 +31,7 @@
 #define LeCroyOscilloscope_h
 
 #include <mutex>
+#include <string_view>
 
 class DropoutTrigger;
 class EdgeTrigger;
@@ -260,6 +261,10 @@ public:
 	//public so it can be called by TRCImportFilter
 	static time_t ExtractTimestamp(unsigned char* wavedesc, double& basetime);
 
+	//public so they can be benchmarked
+	static std::string_view FindXmlTag(std::string_view xml, std::string_view tag);
+	static void UnpackDigitalLane(SparseDigitalWaveform* cap, const uint8_t* samples, size_t num_samples);
+
 protected:
 
 	//Trigger config
@@ -317,6 +322,12 @@ protected:
 		);
 	std::map<int, SparseDigitalWaveform*> ProcessDigitalWaveform(std::string& data, int64_t analog_hoff);
 
+	///@brief Raw analog sample data, received directly from the transport with no intermediate copies
+	std::vector<std::unique_ptr<AcceleratorBuffer<uint8_t> > > m_analogRawWaveformBuffers;
+
+	///@brief Raw trigger time data for segmented captures
+	AcceleratorBuffer<uint8_t> m_wavetimeBuffer;
+
 	//hardware analog channel count, independent of LA option etc
 	unsigned int m_analogChannelCount;
 	unsigned int m_digitalChannelCount;
@@ -926,62 +926,39 @@ protected:
 	//The trigger
 	Trigger* m_trigger;
 
-	//Pool for reusing memory allocations
-	WaveformPool m_analogWaveformPool;
+	/**
+		@brief Gets an analog waveform from the global waveform pool, or allocates a new one
 
-	WaveformPool m_digitalWaveformPool;
+		@param name		Internal name for the waveform
+		@param depth	Expected number of samples, if known, so a waveform which won't need reallocating is chosen
+	 */
+	UniformAnalogWaveform* AllocateAnalogWaveform(const std::string& name, size_t depth = 0)
+	{ return g_waveformPool.Allocate<UniformAnalogWaveform>(depth, name); }
 
-	UniformAnalogWaveform* AllocateAnalogWaveform(const std::string& name)
-	{
-		auto p = m_analogWaveformPool.Get();
-		auto ret = dynamic_cast<UniformAnalogWaveform*>(p);
-		if(ret)
-		{
-			ret->Rename(name);
-			return ret;
-		}
-
-		//Delete garbage if somebody pushed the wrong type of waveform
-		if(p)
-			delete p;
-
-		//Pool was empty, allocate a new waveform
-		return new UniformAnalogWaveform(name);
-	}
+	/**
+		@brief Gets a digital waveform from the global waveform pool, or allocates a new one
 
-	SparseDigitalWaveform* AllocateDigitalWaveform(const std::string& name)
-	{
-		auto p = m_digitalWaveformPool.Get();
-		auto ret = dynamic_cast<SparseDigitalWaveform*>(p);
-		if(ret)
-		{
-			ret->Rename(name);
-			return ret;
-		}
-
-		//Delete garbage if somebody pushed the wrong type of waveform
-		if(p)
-			delete p;
-
-		//Pool was empty, allocate a new waveform
-		return new SparseDigitalWaveform(name);
-	}
+		@param name		Internal name for the waveform
+		@param depth	Expected number of samples, if known, so a waveform which won't need reallocating is chosen
+	 */
+	SparseDigitalWaveform* AllocateDigitalWaveform(const std::string& name, size_t depth = 0)
+	{ return g_waveformPool.Allocate<SparseDigitalWaveform>(depth, name); }
 
 public:
 
 	/**
-		@brief Free all waveforms in our pool to reclaim memory
+		@brief Free all waveforms in the global waveform pool to reclaim memory
 
-		@return True if memory was freed, false if pools were already empty
+		@return True if memory was freed, false if the pool was already empty
 	 */
 	bool FreeWaveformPools()
-	{ return m_analogWaveformPool.clear() || m_digitalWaveformPool.clear();	}
+	{ return g_waveformPool.clear(); }
 
 	void AddWaveformToAnalogPool(WaveformBase* w)
-	{ m_analogWaveformPool.Add(w); }
+	{ g_waveformPool.Add(w); }
 
 	void AddWaveformToDigitalPool(WaveformBase* w)
-	{ m_digitalWaveformPool.Add(w); }
+	{ g_waveformPool.Add(w); }
 
 public:
 	typedef std::shared_ptr<Oscilloscope> (*CreateProcType)(SCPITransport*);
@@ -0,0 +1,376 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PackedDigitalBusWaveform
+	@ingroup datamodel
+ */
+
+#include "scopehal.h"
+#include "PackedDigitalBusWaveform.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a new, empty packed bus waveform
+
+	@param lanes	Number of lanes in the bus
+	@param name		Internal name for this waveform, to be displayed in debug log messages etc
+ */
+PackedDigitalBusWaveform::PackedDigitalBusWaveform(size_t lanes, const string& name)
+	: m_lanes(lanes)
+	, m_size(0)
+	, m_wordsPerLane(0)
+{
+	Rename(name);
+
+	//Default data to CPU/GPU mirror
+	m_words.SetCpuAccessHint(AcceleratorBuffer<uint64_t>::HINT_LIKELY);
+	m_words.SetGpuAccessHint(AcceleratorBuffer<uint64_t>::HINT_LIKELY);
+	m_words.PrepareForCpuAccess();
+}
+
+PackedDigitalBusWaveform::~PackedDigitalBusWaveform()
+{
+}
+
+void PackedDigitalBusWaveform::Rename(const string& name)
+{
+	if(name.empty())
+		m_words.SetName("PackedDigitalBusWaveform.m_words");
+	else
+		m_words.SetName(name + ".m_words");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sizing
+
+/**
+	@brief Changes the number of samples in each lane
+
+	Samples which remain in range keep their values, newly added samples are zero.
+ */
+void PackedDigitalBusWaveform::Resize(size_t size)
+{
+	Relayout(m_lanes, size);
+}
+
+/**
+	@brief Changes the number of lanes in the bus
+
+	Existing lanes keep their content, newly added lanes are zero.
+ */
+void PackedDigitalBusWaveform::SetLaneCount(size_t lanes)
+{
+	Relayout(lanes, m_size);
+}
+
+/**
+	@brief Moves existing lane data to match a new lane count and/or lane length
+ */
+void PackedDigitalBusWaveform::Relayout(size_t lanes, size_t size)
+{
+	size_t stride = PackedDigitalWaveform::GetWordCount(size);
+
+	//Stride unchanged? Lanes don't move, just grow or shrink the tail of the buffer
+	if(stride == m_wordsPerLane)
+	{
+		m_words.PrepareForCpuAccess();
+		size_t oldtotal = m_lanes * stride;
+		m_words.resize(lanes * stride);
+		for(size_t i=oldtotal; i<lanes*stride; i++)
+			m_words[i] = 0;
+	}
+
+	//Otherwise every lane has to move, go through a temporary copy
+	else
+	{
+		m_words.PrepareForCpuAccess();
+		vector<uint64_t> old(m_words.GetCpuPointer(), m_words.GetCpuPointer() + m_lanes*m_wordsPerLane);
+
+		m_words.resize(lanes * stride);
+		uint64_t* words = m_words.GetCpuPointer();
+		size_t ncopy = min(stride, m_wordsPerLane);
+		for(size_t lane=0; lane<lanes; lane++)
+		{
+			uint64_t* dst = words + lane*stride;
+			size_t n = 0;
+			if(lane < m_lanes)
+			{
+				memcpy(dst, &old[lane*m_wordsPerLane], ncopy * sizeof(uint64_t));
+				n = ncopy;
+			}
+			for(; n<stride; n++)
+				dst[n] = 0;
+		}
+	}
+
+	//Clear stale bits past the new end of each lane
+	if( (size < m_size) && (size & 63) )
+	{
+		uint64_t mask = (1ULL << (size & 63)) - 1;
+		for(size_t lane=0; lane<lanes; lane++)
+			m_words[lane*stride + stride - 1] &= mask;
+	}
+
+	m_lanes = lanes;
+	m_size = size;
+	m_wordsPerLane = stride;
+	m_words.MarkModifiedFromCpu();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+/**
+	@brief Gets the value of the bus at one sample, with lane 0 as the LSB
+
+	Only the first 64 lanes are returned. PrepareForCpuAccess() must have been called.
+ */
+uint64_t PackedDigitalBusWaveform::GetValue(size_t i)
+{
+	uint64_t value = 0;
+	size_t nlanes = min(m_lanes, (size_t)64);
+	size_t word = i >> 6;
+	size_t bit = i & 63;
+	uint64_t* words = m_words.GetCpuPointer();
+	for(size_t lane=0; lane<nlanes; lane++)
+		value |= ((words[lane*m_wordsPerLane + word] >> bit) & 1) << lane;
+	return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Conversion to/from unpacked waveforms
+
+/**
+	@brief Packs a UniformDigitalWaveform into one lane of the bus
+
+	The bus is resized to match the length of the input if necessary. Timebase metadata is copied from the input.
+ */
+void PackedDigitalBusWaveform::PackLane(size_t lane, UniformDigitalWaveform& rhs)
+{
+	m_timescale = rhs.m_timescale;
+	m_startTimestamp = rhs.m_startTimestamp;
+	m_startFemtoseconds = rhs.m_startFemtoseconds;
+	m_triggerPhase = rhs.m_triggerPhase;
+	m_flags = rhs.m_flags;
+
+	if( (lane >= m_lanes) || (rhs.size() != m_size) )
+		Relayout(max(m_lanes, lane+1), rhs.size());
+
+	rhs.PrepareForCpuAccess();
+	m_words.PrepareForCpuAccess();
+	PackedDigitalWaveform::PackSamples(GetLane(lane), rhs.m_samples.GetCpuPointer(), m_size);
+
+	m_words.MarkModifiedFromCpu();
+	m_revision ++;
+}
+
+/**
+	@brief Expands one lane of the bus into a UniformDigitalWaveform, including timebase metadata
+ */
+void PackedDigitalBusWaveform::UnpackLane(size_t lane, UniformDigitalWaveform& out)
+{
+	out.m_timescale = m_timescale;
+	out.m_startTimestamp = m_startTimestamp;
+	out.m_startFemtoseconds = m_startFemtoseconds;
+	out.m_triggerPhase = m_triggerPhase;
+	out.m_flags = m_flags;
+
+	m_words.PrepareForCpuAccess();
+	out.PrepareForCpuAccess();
+
+	out.Resize(m_size);
+	PackedDigitalWaveform::UnpackSamples(out.m_samples.GetCpuPointer(), GetLane(lane), m_size);
+
+	out.MarkModifiedFromCpu();
+	out.m_revision ++;
+}
+
+/**
+	@brief Copies one lane of the bus into a PackedDigitalWaveform, including timebase metadata
+ */
+void PackedDigitalBusWaveform::UnpackLane(size_t lane, PackedDigitalWaveform& out)
+{
+	out.m_timescale = m_timescale;
+	out.m_startTimestamp = m_startTimestamp;
+	out.m_startFemtoseconds = m_startFemtoseconds;
+	out.m_triggerPhase = m_triggerPhase;
+	out.m_flags = m_flags;
+
+	m_words.PrepareForCpuAccess();
+	out.PrepareForCpuAccess();
+
+	out.Resize(m_size);
+	memcpy(out.m_words.GetCpuPointer(), GetLane(lane), m_wordsPerLane * sizeof(uint64_t));
+
+	out.MarkModifiedFromCpu();
+	out.m_revision ++;
+}
+
+/**
+	@brief Copies a PackedDigitalWaveform into one lane of the bus
+
+	The bus is resized to match the length of the input if necessary. Timebase metadata is copied from the input.
+ */
+void PackedDigitalBusWaveform::PackLane(size_t lane, PackedDigitalWaveform& rhs)
+{
+	m_timescale = rhs.m_timescale;
+	m_startTimestamp = rhs.m_startTimestamp;
+	m_startFemtoseconds = rhs.m_startFemtoseconds;
+	m_triggerPhase = rhs.m_triggerPhase;
+	m_flags = rhs.m_flags;
+
+	if( (lane >= m_lanes) || (rhs.size() != m_size) )
+		Relayout(max(m_lanes, lane+1), rhs.size());
+
+	rhs.PrepareForCpuAccess();
+	m_words.PrepareForCpuAccess();
+	memcpy(GetLane(lane), rhs.m_words.GetCpuPointer(), m_wordsPerLane * sizeof(uint64_t));
+
+	m_words.MarkModifiedFromCpu();
+	m_revision ++;
+}
+
+/**
+	@brief Expands the bus into a SparseDigitalBusWaveform with one sample per timebase unit
+
+	This is the adapter used to hand packed data to filters which expect the unpacked bus representation.
+ */
+void PackedDigitalBusWaveform::Unpack(SparseDigitalBusWaveform& out)
+{
+	out.m_timescale = m_timescale;
+	out.m_startTimestamp = m_startTimestamp;
+	out.m_startFemtoseconds = m_startFemtoseconds;
+	out.m_triggerPhase = m_triggerPhase;
+	out.m_flags = m_flags;
+
+	m_words.PrepareForCpuAccess();
+	out.PrepareForCpuAccess();
+
+	out.Resize(m_size);
+	uint64_t* words = m_words.GetCpuPointer();
+	for(size_t i=0; i<m_size; i++)
+	{
+		out.m_offsets[i] = i;
+		out.m_durations[i] = 1;
+
+		auto& s = out.m_samples[i];
+		s.resize(m_lanes);
+		size_t word = i >> 6;
+		size_t bit = i & 63;
+		for(size_t lane=0; lane<m_lanes; lane++)
+			s[lane] = (words[lane*m_wordsPerLane + word] >> bit) & 1;
+	}
+
+	out.MarkModifiedFromCpu();
+	out.m_revision ++;
+}
+
+/**
+	@brief Gets an unpacked copy of this waveform, for filters which can't read packed data
+
+	The copy has the same revision number as this waveform and lasts until UnpackedWaveformCache::ReleaseAll(), or
+	until this waveform is changed and the copy asked for again.
+ */
+SparseDigitalBusWaveform* PackedDigitalBusWaveform::GetUnpacked()
+{
+	return static_cast<SparseDigitalBusWaveform*>(m_unpacked.Get(this, [this]()
+		{
+			auto out = new SparseDigitalBusWaveform;
+			Unpack(*out);
+			out->m_revision = m_revision;
+			return out;
+		}));
+}
+
+/**
+	@brief Returns the waveform a filter which only reads unpacked types should see in place of data
+
+	Packed digital and digital bus waveforms are replaced by their unpacked copies, anything else is returned as-is.
+ */
+WaveformBase* GetUnpackedWaveform(WaveformBase* data)
+{
+	auto packed = dynamic_cast<PackedDigitalWaveform*>(data);
+	if(packed)
+		return packed->GetUnpacked();
+
+	auto bus = dynamic_cast<PackedDigitalBusWaveform*>(data);
+	if(bus)
+		return bus->GetUnpacked();
+
+	return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Word-level analysis
+
+/**
+	@brief Finds every sample at which any lane of the bus changes, appending them to a list
+
+	Each edge is reported as offset + scale*i, where i is the index of the first sample after the edge.
+
+	@param edges	Output edge list
+	@param start	Index of the first sample which may be reported as an edge (must be at least 1)
+	@param offset	Offset added to each reported edge
+	@param scale	Multiplier applied to each sample index
+ */
+void PackedDigitalBusWaveform::FindEdges(vector<int64_t>& edges, size_t start, int64_t offset, int64_t scale)
+{
+	start = max(start, (size_t)1);
+	if(start >= m_size)
+		return;
+
+	m_words.PrepareForCpuAccess();
+
+	for(size_t w = start >> 6; w < m_wordsPerLane; w++)
+	{
+		//Merge transition masks from every lane
+		uint64_t mask = 0;
+		for(size_t lane=0; lane<m_lanes; lane++)
+			mask |= PackedDigitalWaveform::GetEdgeMask(GetLane(lane), w, PackedDigitalWaveform::EDGE_ANY);
+
+		if(w == (start >> 6))
+			mask &= ~0ULL << (start & 63);
+		if( (w == (m_size >> 6)) && (m_size & 63) )
+			mask &= (1ULL << (m_size & 63)) - 1;
+
+		int64_t base = offset + scale*(int64_t)(w << 6);
+		while(mask)
+		{
+			edges.push_back(base + scale*__builtin_ctzll(mask));
+			mask &= mask - 1;
+		}
+	}
+}
@@ -0,0 +1,157 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PackedDigitalBusWaveform
+	@ingroup datamodel
+ */
+
+#ifndef PackedDigitalBusWaveform_h
+#define PackedDigitalBusWaveform_h
+
+#include "PackedDigitalWaveform.h"
+
+/**
+	@brief A uniformly sampled multi-lane digital waveform stored at one bit per sample per lane
+	@ingroup datamodel
+
+	SparseDigitalBusWaveform stores a heap-allocated vector<bool> for every sample. This class instead stores all lanes
+	in a single flat buffer: each lane occupies GetWordsPerLane() consecutive words using the same layout as
+	PackedDigitalWaveform, so per-lane edge searches are word-at-a-time and lanes can be extracted with a memcpy.
+
+	Unpack() converts to SparseDigitalBusWaveform for decoders which expect the unpacked form. Filters get such a copy
+	automatically from FlowGraphNode::GetInputWaveform().
+ */
+class PackedDigitalBusWaveform : public UniformWaveformBase
+{
+public:
+	PackedDigitalBusWaveform(size_t lanes = 0, const std::string& name = "");
+	virtual ~PackedDigitalBusWaveform();
+
+	//not copyable or assignable
+	PackedDigitalBusWaveform(const PackedDigitalBusWaveform&) =delete;
+	PackedDigitalBusWaveform& operator=(const PackedDigitalBusWaveform&) =delete;
+
+	///@brief Packed sample data, lane-major
+	AcceleratorBuffer<uint64_t> m_words;
+
+	///@brief Returns the number of lanes in the bus
+	size_t GetLaneCount() const
+	{ return m_lanes; }
+
+	void SetLaneCount(size_t lanes);
+
+	///@brief Returns the number of words used by each lane
+	size_t GetWordsPerLane() const
+	{ return m_wordsPerLane; }
+
+	///@brief Returns a pointer to the first word of a lane. PrepareForCpuAccess() must have been called.
+	uint64_t* GetLane(size_t lane)
+	{ return m_words.GetCpuPointer() + lane*m_wordsPerLane; }
+
+	///@brief Gets the value of a single sample on one lane. PrepareForCpuAccess() must have been called.
+	bool GetSample(size_t lane, size_t i) const
+	{ return (m_words[lane*m_wordsPerLane + (i >> 6)] >> (i & 63)) & 1; }
+
+	///@brief Sets the value of a single sample on one lane. PrepareForCpuAccess() must have been called.
+	void SetSample(size_t lane, size_t i, bool value)
+	{
+		uint64_t bit = 1ULL << (i & 63);
+		if(value)
+			m_words[lane*m_wordsPerLane + (i >> 6)] |= bit;
+		else
+			m_words[lane*m_wordsPerLane + (i >> 6)] &= ~bit;
+	}
+
+	uint64_t GetValue(size_t i);
+
+	void PackLane(size_t lane, UniformDigitalWaveform& rhs);
+	void UnpackLane(size_t lane, UniformDigitalWaveform& out);
+	void UnpackLane(size_t lane, PackedDigitalWaveform& out);
+	void PackLane(size_t lane, PackedDigitalWaveform& rhs);
+	void Unpack(SparseDigitalBusWaveform& out);
+	SparseDigitalBusWaveform* GetUnpacked();
+
+	void FindEdges(std::vector<int64_t>& edges, size_t start = 1, int64_t offset = 0, int64_t scale = 1);
+
+	virtual void Rename(const std::string& name = "") override;
+
+	virtual void FreeGpuMemory() override
+	{ m_words.FreeGpuBuffer(); }
+
+	virtual bool HasGpuBuffer() override
+	{ return m_words.HasGpuBuffer(); }
+
+	virtual void Resize(size_t size) override;
+
+	virtual size_t size() const override
+	{ return m_size; }
+
+	virtual void clear() override
+	{ Resize(0); }
+
+	virtual void PrepareForCpuAccess() override
+	{ m_words.PrepareForCpuAccess(); }
+
+	virtual void PrepareForGpuAccess() override
+	{ m_words.PrepareForGpuAccess(); }
+
+	virtual void MarkSamplesModifiedFromCpu() override
+	{ m_words.MarkModifiedFromCpu(); }
+
+	virtual void MarkSamplesModifiedFromGpu() override
+	{ m_words.MarkModifiedFromGpu(); }
+
+	virtual void MarkModifiedFromCpu() override
+	{ MarkSamplesModifiedFromCpu(); }
+
+	virtual void MarkModifiedFromGpu() override
+	{ MarkSamplesModifiedFromGpu(); }
+
+protected:
+	void Relayout(size_t lanes, size_t size);
+
+	///@brief Number of lanes in the bus
+	size_t m_lanes;
+
+	///@brief Number of samples in each lane
+	size_t m_size;
+
+	///@brief Number of words allocated to each lane
+	size_t m_wordsPerLane;
+
+	///@brief Unpacked copy for filters which can't read packed data
+	UnpackedWaveformCache m_unpacked;
+};
+
+WaveformBase* GetUnpackedWaveform(WaveformBase* data);
+
+#endif
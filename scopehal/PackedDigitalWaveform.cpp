@@ -0,0 +1,490 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PackedDigitalWaveform
+	@ingroup datamodel
+ */
+
+#include "scopehal.h"
+#include "PackedDigitalWaveform.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+mutex UnpackedWaveformCache::s_cachesMutex;
+set<UnpackedWaveformCache*> UnpackedWaveformCache::s_caches;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// UnpackedWaveformCache
+
+UnpackedWaveformCache::UnpackedWaveformCache()
+	: m_revision(0)
+{
+}
+
+UnpackedWaveformCache::~UnpackedWaveformCache()
+{
+	lock_guard<mutex> lock(s_cachesMutex);
+	s_caches.erase(this);
+}
+
+/**
+	@brief Gets the unpacked copy of a waveform, making it if we don't have one for the current revision
+
+	@param owner	The packed waveform this cache belongs to
+	@param unpack	Creates a new unpacked copy of owner
+ */
+WaveformBase* UnpackedWaveformCache::Get(WaveformBase* owner, function<WaveformBase*()> unpack)
+{
+	//Register before taking our own lock, ReleaseAll() locks in the opposite order
+	{
+		lock_guard<mutex> lock(s_cachesMutex);
+		s_caches.emplace(this);
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	if(!m_view || (m_revision != owner->m_revision) )
+	{
+		m_view.reset(unpack());
+		m_revision = owner->m_revision;
+	}
+	return m_view.get();
+}
+
+/**
+	@brief Frees the unpacked copy, if we have one
+ */
+void UnpackedWaveformCache::Release()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_view.reset();
+}
+
+/**
+	@brief Frees every unpacked copy
+
+	Must not be called while any filter might still be using one. FilterGraphExecutor calls this after each run.
+ */
+void UnpackedWaveformCache::ReleaseAll()
+{
+	lock_guard<mutex> lock(s_cachesMutex);
+	for(auto c : s_caches)
+		c->Release();
+	s_caches.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a new, empty packed digital waveform
+
+	@param name Internal name for this waveform, to be displayed in debug log messages etc
+ */
+PackedDigitalWaveform::PackedDigitalWaveform(const string& name)
+	: m_size(0)
+{
+	Rename(name);
+
+	//Default data to CPU/GPU mirror
+	m_words.SetCpuAccessHint(AcceleratorBuffer<uint64_t>::HINT_LIKELY);
+	m_words.SetGpuAccessHint(AcceleratorBuffer<uint64_t>::HINT_LIKELY);
+	m_words.PrepareForCpuAccess();
+}
+
+/**
+	@brief Creates a packed copy of an existing byte-per-sample digital waveform
+ */
+PackedDigitalWaveform::PackedDigitalWaveform(UniformDigitalWaveform& rhs)
+	: PackedDigitalWaveform()
+{
+	Pack(rhs);
+}
+
+PackedDigitalWaveform::~PackedDigitalWaveform()
+{
+}
+
+void PackedDigitalWaveform::Rename(const string& name)
+{
+	if(name.empty())
+		m_words.SetName("PackedDigitalWaveform.m_words");
+	else
+		m_words.SetName(name + ".m_words");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sizing
+
+/**
+	@brief Changes the number of samples in the waveform
+
+	Samples which remain in range keep their values, newly added samples are zero.
+ */
+void PackedDigitalWaveform::Resize(size_t size)
+{
+	size_t oldwords = GetWordCount(m_size);
+	size_t nwords = GetWordCount(size);
+
+	m_words.PrepareForCpuAccess();
+	m_words.resize(nwords);
+
+	//Zero any newly allocated words
+	for(size_t i=oldwords; i<nwords; i++)
+		m_words[i] = 0;
+
+	//Clear stale bits past the new end so edge and popcount searches never see them
+	if( (size < m_size) && (size & 63) )
+		m_words[nwords-1] &= (1ULL << (size & 63)) - 1;
+
+	m_size = size;
+	m_words.MarkModifiedFromCpu();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Conversion to/from byte-per-sample waveforms
+
+/**
+	@brief Replaces our content with a packed copy of a UniformDigitalWaveform, including timebase metadata
+ */
+void PackedDigitalWaveform::Pack(UniformDigitalWaveform& rhs)
+{
+	m_timescale = rhs.m_timescale;
+	m_startTimestamp = rhs.m_startTimestamp;
+	m_startFemtoseconds = rhs.m_startFemtoseconds;
+	m_triggerPhase = rhs.m_triggerPhase;
+	m_flags = rhs.m_flags;
+
+	rhs.PrepareForCpuAccess();
+	m_words.PrepareForCpuAccess();
+
+	size_t len = rhs.size();
+	m_size = len;
+	m_words.resize(GetWordCount(len));
+	PackSamples(m_words.GetCpuPointer(), rhs.m_samples.GetCpuPointer(), len);
+
+	m_words.MarkModifiedFromCpu();
+	m_revision ++;
+}
+
+/**
+	@brief Expands our content into a UniformDigitalWaveform, including timebase metadata
+
+	This is the adapter used to hand packed data to filters which expect byte-per-sample storage.
+ */
+void PackedDigitalWaveform::Unpack(UniformDigitalWaveform& out)
+{
+	out.m_timescale = m_timescale;
+	out.m_startTimestamp = m_startTimestamp;
+	out.m_startFemtoseconds = m_startFemtoseconds;
+	out.m_triggerPhase = m_triggerPhase;
+	out.m_flags = m_flags;
+
+	m_words.PrepareForCpuAccess();
+	out.PrepareForCpuAccess();
+
+	out.Resize(m_size);
+	UnpackSamples(out.m_samples.GetCpuPointer(), m_words.GetCpuPointer(), m_size);
+
+	out.MarkModifiedFromCpu();
+	out.m_revision ++;
+}
+
+/**
+	@brief Gets a byte-per-sample copy of this waveform, for filters which can't read packed data
+
+	The copy has the same revision number as this waveform and lasts until UnpackedWaveformCache::ReleaseAll(), or
+	until this waveform is changed and the copy asked for again.
+ */
+UniformDigitalWaveform* PackedDigitalWaveform::GetUnpacked()
+{
+	return static_cast<UniformDigitalWaveform*>(m_unpacked.Get(this, [this]()
+		{
+			auto out = new UniformDigitalWaveform;
+			Unpack(*out);
+			out->m_revision = m_revision;
+			return out;
+		}));
+}
+
+/**
+	@brief Packs an array of bools into words, LSB first
+
+	@param dst	Output buffer, must have space for GetWordCount(len) words
+	@param src	Input samples
+	@param len	Number of samples
+ */
+void PackedDigitalWaveform::PackSamples(uint64_t* dst, const bool* src, size_t len)
+{
+	size_t nwords = len / 64;
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		PackSamplesAVX2(dst, src, nwords);
+	else
+	#endif
+		PackSamplesGeneric(dst, src, nwords);
+
+	//Partial last word
+	size_t tail = len & 63;
+	if(tail)
+	{
+		const bool* p = src + nwords*64;
+		uint64_t w = 0;
+		for(size_t i=0; i<tail; i++)
+			w |= (uint64_t)p[i] << i;
+		dst[nwords] = w;
+	}
+}
+
+void PackedDigitalWaveform::PackSamplesGeneric(uint64_t* dst, const bool* src, size_t nwords)
+{
+	for(size_t i=0; i<nwords; i++)
+	{
+		const bool* p = src + i*64;
+		uint64_t w = 0;
+		for(size_t j=0; j<64; j++)
+			w |= (uint64_t)p[j] << j;
+		dst[i] = w;
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void PackedDigitalWaveform::PackSamplesAVX2(uint64_t* dst, const bool* src, size_t nwords)
+{
+	__m256i zero = _mm256_setzero_si256();
+
+	for(size_t i=0; i<nwords; i++)
+	{
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i*64));
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i*64 + 32));
+
+		//bool is stored as 0/1, so compare against zero to get one full byte per sample then grab the MSBs
+		uint32_t mlo = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+		uint32_t mhi = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+
+		dst[i] = ((uint64_t)mhi << 32) | mlo;
+	}
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Expands packed words into an array of bools
+
+	@param dst	Output samples
+	@param src	Packed input, GetWordCount(len) words
+	@param len	Number of samples
+ */
+void PackedDigitalWaveform::UnpackSamples(bool* dst, const uint64_t* src, size_t len)
+{
+	size_t nwords = len / 64;
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		UnpackSamplesAVX2(dst, src, nwords);
+	else
+	#endif
+		UnpackSamplesGeneric(dst, src, nwords);
+
+	//Partial last word
+	size_t tail = len & 63;
+	if(tail)
+	{
+		bool* p = dst + nwords*64;
+		uint64_t w = src[nwords];
+		for(size_t i=0; i<tail; i++)
+			p[i] = (w >> i) & 1;
+	}
+}
+
+void PackedDigitalWaveform::UnpackSamplesGeneric(bool* dst, const uint64_t* src, size_t nwords)
+{
+	for(size_t i=0; i<nwords; i++)
+	{
+		bool* p = dst + i*64;
+		uint64_t w = src[i];
+		for(size_t j=0; j<64; j++)
+			p[j] = (w >> j) & 1;
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void PackedDigitalWaveform::UnpackSamplesAVX2(bool* dst, const uint64_t* src, size_t nwords)
+{
+	//Byte n of the output takes its bit from byte (n / 8) of the input
+	__m256i shuf = _mm256_set_epi64x(
+		0x0303030303030303LL, 0x0202020202020202LL,
+		0x0101010101010101LL, 0x0000000000000000LL);
+	__m256i bits = _mm256_set1_epi64x(0x8040201008040201LL);
+	__m256i ones = _mm256_set1_epi8(1);
+
+	for(size_t i=0; i<nwords; i++)
+	{
+		uint64_t w = src[i];
+
+		for(size_t half=0; half<2; half++)
+		{
+			//Broadcast 32 input bits to every lane, spread each byte across eight output bytes, and test one bit each
+			__m256i v = _mm256_set1_epi32((uint32_t)(w >> (half*32)));
+			v = _mm256_shuffle_epi8(v, shuf);
+			v = _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+			v = _mm256_and_si256(v, ones);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i*64 + half*32), v);
+		}
+	}
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Word-level analysis
+
+/**
+	@brief Returns the number of samples which are high
+ */
+size_t PackedDigitalWaveform::CountOnes()
+{
+	m_words.PrepareForCpuAccess();
+
+	size_t count = 0;
+	size_t nwords = GetWordCount(m_size);
+	uint64_t* words = m_words.GetCpuPointer();
+	for(size_t i=0; i<nwords; i++)
+		count += __builtin_popcountll(words[i]);
+	return count;
+}
+
+/**
+	@brief Gets the edge mask for one word, discarding edges before the start sample or past the end of the waveform
+ */
+uint64_t PackedDigitalWaveform::GetClippedEdgeMask(size_t w, EdgeDirection dir, size_t start)
+{
+	uint64_t mask = GetEdgeMask(m_words.GetCpuPointer(), w, dir);
+
+	if(w == (start >> 6))
+		mask &= ~0ULL << (start & 63);
+	if( (w == (m_size >> 6)) && (m_size & 63) )
+		mask &= (1ULL << (m_size & 63)) - 1;
+
+	return mask;
+}
+
+/**
+	@brief Counts edges in the waveform
+
+	@param dir		Type of edge to count
+	@param start	Index of the first sample which may be reported as an edge (must be at least 1)
+ */
+size_t PackedDigitalWaveform::CountEdges(EdgeDirection dir, size_t start)
+{
+	start = max(start, (size_t)1);
+	if(start >= m_size)
+		return 0;
+
+	m_words.PrepareForCpuAccess();
+
+	size_t count = 0;
+	size_t nwords = GetWordCount(m_size);
+	for(size_t w = start >> 6; w < nwords; w++)
+		count += __builtin_popcountll(GetClippedEdgeMask(w, dir, start));
+	return count;
+}
+
+/**
+	@brief Finds the first edge at or after a given sample
+
+	@param dir		Type of edge to search for
+	@param start	Index of the first sample which may be reported as an edge (must be at least 1)
+
+	@return Index of the first sample after the edge, or size() if there are no more edges
+ */
+size_t PackedDigitalWaveform::FindNextEdge(EdgeDirection dir, size_t start)
+{
+	start = max(start, (size_t)1);
+	if(start >= m_size)
+		return m_size;
+
+	m_words.PrepareForCpuAccess();
+
+	size_t nwords = GetWordCount(m_size);
+	for(size_t w = start >> 6; w < nwords; w++)
+	{
+		uint64_t mask = GetClippedEdgeMask(w, dir, start);
+		if(mask)
+			return (w << 6) + __builtin_ctzll(mask);
+	}
+	return m_size;
+}
+
+/**
+	@brief Finds all edges in the waveform, appending them to a list
+
+	Each edge is reported as offset + scale*i, where i is the index of the first sample after the edge. The defaults
+	report raw sample indexes.
+
+	@param edges	Output edge list
+	@param dir		Type of edge to search for
+	@param start	Index of the first sample which may be reported as an edge (must be at least 1)
+	@param offset	Offset added to each reported edge
+	@param scale	Multiplier applied to each sample index
+ */
+void PackedDigitalWaveform::FindEdges(
+	vector<int64_t>& edges,
+	EdgeDirection dir,
+	size_t start,
+	int64_t offset,
+	int64_t scale)
+{
+	start = max(start, (size_t)1);
+	if(start >= m_size)
+		return;
+
+	//Size the output exactly, this is only one popcount per 64 samples
+	edges.reserve(edges.size() + CountEdges(dir, start));
+
+	size_t nwords = GetWordCount(m_size);
+	for(size_t w = start >> 6; w < nwords; w++)
+	{
+		uint64_t mask = GetClippedEdgeMask(w, dir, start);
+		int64_t base = offset + scale*(int64_t)(w << 6);
+		while(mask)
+		{
+			edges.push_back(base + scale*__builtin_ctzll(mask));
+			mask &= mask - 1;
+		}
+	}
+}
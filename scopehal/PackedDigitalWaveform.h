@@ -0,0 +1,237 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PackedDigitalWaveform
+	@ingroup datamodel
+ */
+
+#ifndef PackedDigitalWaveform_h
+#define PackedDigitalWaveform_h
+
+#include "Waveform.h"
+
+#include <functional>
+#include <mutex>
+#include <set>
+
+/**
+	@brief Unpacked copy of a packed waveform, made on demand for filters which only read the unpacked types
+	@ingroup datamodel
+
+	The copy is rebuilt whenever the owning waveform's revision changes. ReleaseAll() drops every copy once the filter
+	graph is done with them, so only the packed form is kept between refreshes.
+ */
+class UnpackedWaveformCache
+{
+public:
+	UnpackedWaveformCache();
+	~UnpackedWaveformCache();
+
+	//not copyable or assignable
+	UnpackedWaveformCache(const UnpackedWaveformCache&) =delete;
+	UnpackedWaveformCache& operator=(const UnpackedWaveformCache&) =delete;
+
+	WaveformBase* Get(WaveformBase* owner, std::function<WaveformBase*()> unpack);
+	void Release();
+
+	static void ReleaseAll();
+
+protected:
+	///@brief Mutex guarding m_view and m_revision, since several filters may read the same input at once
+	std::mutex m_mutex;
+
+	///@brief The unpacked copy, if we have one
+	std::unique_ptr<WaveformBase> m_view;
+
+	///@brief Revision of the owning waveform when m_view was made
+	uint64_t m_revision;
+
+	///@brief Mutex guarding s_caches
+	static std::mutex s_cachesMutex;
+
+	///@brief Every cache currently holding a copy
+	static std::set<UnpackedWaveformCache*> s_caches;
+};
+
+/**
+	@brief A uniformly sampled digital waveform stored at one bit per sample
+	@ingroup datamodel
+
+	UniformDigitalWaveform spends a full byte on every sample. This class stores the same data packed 64 samples to a
+	word, LSB first: sample i is bit (i % 64) of word (i / 64). Bits past the end of the waveform in the last word are
+	always zero.
+
+	Edge searches operate on entire words at a time: the transition mask of a word is computed with a shift and XOR,
+	then individual edges are extracted with count-trailing-zeroes.
+
+	Pack() / Unpack() convert to and from UniformDigitalWaveform so that data can be handed to existing decoders which
+	expect byte-per-sample storage. Filters get such a copy automatically from FlowGraphNode::GetInputWaveform(); those
+	which read packed data directly use GetPackedDigitalInputWaveform() instead.
+ */
+class PackedDigitalWaveform : public UniformWaveformBase
+{
+public:
+	PackedDigitalWaveform(const std::string& name = "");
+	PackedDigitalWaveform(UniformDigitalWaveform& rhs);
+	virtual ~PackedDigitalWaveform();
+
+	//not copyable or assignable
+	PackedDigitalWaveform(const PackedDigitalWaveform&) =delete;
+	PackedDigitalWaveform& operator=(const PackedDigitalWaveform&) =delete;
+
+	///@brief Types of edge to search for
+	enum EdgeDirection
+	{
+		EDGE_ANY,
+		EDGE_RISING,
+		EDGE_FALLING
+	};
+
+	///@brief Packed sample data, 64 samples per word
+	AcceleratorBuffer<uint64_t> m_words;
+
+	///@brief Returns the number of words needed to store a given number of samples
+	static size_t GetWordCount(size_t samples)
+	{ return (samples + 63) / 64; }
+
+	///@brief Gets the value of a single sample. PrepareForCpuAccess() must have been called.
+	bool GetSample(size_t i) const
+	{ return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+	///@brief Sets the value of a single sample. PrepareForCpuAccess() must have been called.
+	void SetSample(size_t i, bool value)
+	{
+		uint64_t bit = 1ULL << (i & 63);
+		if(value)
+			m_words[i >> 6] |= bit;
+		else
+			m_words[i >> 6] &= ~bit;
+	}
+
+	void Pack(UniformDigitalWaveform& rhs);
+	void Unpack(UniformDigitalWaveform& out);
+	UniformDigitalWaveform* GetUnpacked();
+
+	size_t CountOnes();
+	size_t CountEdges(EdgeDirection dir, size_t start = 1);
+	size_t FindNextEdge(EdgeDirection dir, size_t start = 1);
+	void FindEdges(
+		std::vector<int64_t>& edges,
+		EdgeDirection dir,
+		size_t start = 1,
+		int64_t offset = 0,
+		int64_t scale = 1);
+
+	/**
+		@brief Returns a mask of samples in a given word which differ from the previous sample
+
+		Bit 0 of word 0 has no predecessor and is never reported as an edge.
+
+		@param words	Packed sample data
+		@param w		Index of the word to process
+		@param dir		Type of edge to report
+	 */
+	static uint64_t GetEdgeMask(const uint64_t* words, size_t w, EdgeDirection dir)
+	{
+		uint64_t cur = words[w];
+		uint64_t carry = w ? (words[w-1] >> 63) : (cur & 1);
+		uint64_t delta = cur ^ ((cur << 1) | carry);
+
+		switch(dir)
+		{
+			case EDGE_RISING:
+				return delta & cur;
+
+			case EDGE_FALLING:
+				return delta & ~cur;
+
+			case EDGE_ANY:
+			default:
+				return delta;
+		}
+	}
+
+	static void PackSamples(uint64_t* dst, const bool* src, size_t len);
+	static void UnpackSamples(bool* dst, const uint64_t* src, size_t len);
+
+	virtual void Rename(const std::string& name = "") override;
+
+	virtual void FreeGpuMemory() override
+	{ m_words.FreeGpuBuffer(); }
+
+	virtual bool HasGpuBuffer() override
+	{ return m_words.HasGpuBuffer(); }
+
+	virtual void Resize(size_t size) override;
+
+	virtual size_t size() const override
+	{ return m_size; }
+
+	virtual void clear() override
+	{ Resize(0); }
+
+	virtual void PrepareForCpuAccess() override
+	{ m_words.PrepareForCpuAccess(); }
+
+	virtual void PrepareForGpuAccess() override
+	{ m_words.PrepareForGpuAccess(); }
+
+	virtual void MarkSamplesModifiedFromCpu() override
+	{ m_words.MarkModifiedFromCpu(); }
+
+	virtual void MarkSamplesModifiedFromGpu() override
+	{ m_words.MarkModifiedFromGpu(); }
+
+	virtual void MarkModifiedFromCpu() override
+	{ MarkSamplesModifiedFromCpu(); }
+
+	virtual void MarkModifiedFromGpu() override
+	{ MarkSamplesModifiedFromGpu(); }
+
+protected:
+	uint64_t GetClippedEdgeMask(size_t w, EdgeDirection dir, size_t start);
+
+	static void PackSamplesGeneric(uint64_t* dst, const bool* src, size_t nwords);
+	static void UnpackSamplesGeneric(bool* dst, const uint64_t* src, size_t nwords);
+#ifdef __x86_64__
+	static void PackSamplesAVX2(uint64_t* dst, const bool* src, size_t nwords);
+	static void UnpackSamplesAVX2(bool* dst, const uint64_t* src, size_t nwords);
+#endif
+
+	///@brief Number of samples in the waveform
+	size_t m_size;
+
+	///@brief Byte-per-sample copy for filters which can't read packed data
+	UnpackedWaveformCache m_unpacked;
+};
+
+#endif
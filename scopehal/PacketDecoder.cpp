@@ -30,6 +30,8 @@
 #include "scopehal.h"
 #include "PacketDecoder.h"
 
+using namespace std;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Color schemes
 
@@ -60,11 +62,323 @@ Packet::~Packet()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketStore
+
+PacketStore::PacketStore()
+{
+	//Standard colors get the same IDs as their PacketColor values
+	for(size_t i=0; i<PacketDecoder::PROTO_STANDARD_COLOR_COUNT; i++)
+		GetColorID(PacketDecoder::m_backgroundColors[i]);
+
+	m_defaultForeground = GetColorID("#ffffff");
+}
+
+/**
+	@brief Removes all packets, but keeps interned column names and colors
+ */
+void PacketStore::clear()
+{
+	m_records.clear();
+	m_cells.clear();
+	m_data.clear();
+	m_strings.clear();
+}
+
+/**
+	@brief Preallocates space for a given number of packets and payload bytes
+ */
+void PacketStore::reserve(size_t packets, size_t bytes)
+{
+	m_records.reserve(packets);
+	m_data.reserve(bytes);
+}
+
+/**
+	@brief Returns the approximate number of bytes of packet data held by the store, excluding interning tables
+ */
+size_t PacketStore::GetMemoryUsage() const
+{
+	return
+		m_records.capacity() * sizeof(Record) +
+		m_cells.capacity() * sizeof(Cell) +
+		m_data.capacity() +
+		m_strings.capacity();
+}
+
+/**
+	@brief Returns the ID of a header column, creating it if it doesn't already exist
+ */
+uint16_t PacketStore::GetColumnID(const string& name)
+{
+	auto it = m_columnIDs.find(name);
+	if(it != m_columnIDs.end())
+		return it->second;
+
+	uint16_t id = m_columns.size();
+	m_columns.push_back(name);
+	m_columnIDs[name] = id;
+	return id;
+}
+
+/**
+	@brief Returns the ID of a color, creating it if it doesn't already exist
+ */
+uint16_t PacketStore::GetColorID(const string& color)
+{
+	auto it = m_colorIDs.find(color);
+	if(it != m_colorIDs.end())
+		return it->second;
+
+	uint16_t id = m_colors.size();
+	m_colors.push_back(color);
+	m_colorIDs[color] = id;
+	return id;
+}
+
+/**
+	@brief Creates a new packet with no headers or data
+
+	@param offset	Start time of the packet
+	@param bgcolor	Color ID of the background, defaults to PROTO_COLOR_DEFAULT
+
+	@return Index of the new packet
+ */
+size_t PacketStore::AddPacket(int64_t offset, uint16_t bgcolor)
+{
+	Record r;
+	r.m_offset = offset;
+	r.m_len = 0;
+	r.m_dataStart = m_data.size();
+	r.m_dataLen = 0;
+	r.m_firstCell = m_cells.size();
+	r.m_cellCount = 0;
+	r.m_fgcolor = m_defaultForeground;
+	r.m_bgcolor = bgcolor;
+	m_records.push_back(r);
+	return m_records.size() - 1;
+}
+
+/**
+	@brief Deletes the most recently created packet, along with its headers and data
+
+	String header values are not reclaimed until the next clear().
+ */
+void PacketStore::DiscardLastPacket()
+{
+	auto& r = m_records.back();
+	m_data.resize(r.m_dataStart);
+	m_cells.resize(r.m_firstCell);
+	m_records.pop_back();
+}
+
+/**
+	@brief Appends payload bytes to the most recently created packet
+ */
+void PacketStore::AppendData(const uint8_t* p, size_t len)
+{
+	m_data.insert(m_data.end(), p, p + len);
+	m_records.back().m_dataLen += len;
+}
+
+/**
+	@brief Gets the cell for a column of the most recently created packet, creating it if necessary
+ */
+PacketStore::Cell& PacketStore::AddCell(uint16_t column)
+{
+	auto& r = m_records.back();
+	for(size_t i=0; i<r.m_cellCount; i++)
+	{
+		auto& cell = m_cells[r.m_firstCell + i];
+		if(cell.m_column == column)
+			return cell;
+	}
+
+	r.m_cellCount ++;
+	m_cells.push_back(Cell());
+	auto& cell = m_cells.back();
+	cell.m_column = column;
+	return cell;
+}
+
+/**
+	@brief Sets a string header on the most recently created packet
+ */
+void PacketStore::SetHeader(uint16_t column, const string& value)
+{
+	auto& cell = AddCell(column);
+	cell.m_type = VALUE_STRING;
+	cell.m_width = 0;
+	cell.m_len = value.length();
+	cell.m_value = m_strings.size();
+	m_strings.insert(m_strings.end(), value.begin(), value.end());
+}
+
+/**
+	@brief Sets a numeric header on the most recently created packet
+
+	@param column	Column ID
+	@param type		Formatting to apply when the value is read
+	@param value	The value
+	@param width	Number of digits for VALUE_HEX
+ */
+void PacketStore::SetHeader(uint16_t column, ValueType type, int64_t value, uint8_t width)
+{
+	auto& cell = AddCell(column);
+	cell.m_type = type;
+	cell.m_width = width;
+	cell.m_len = 0;
+	cell.m_value = value;
+}
+
+/**
+	@brief Checks if a packet has a value for a given column
+ */
+bool PacketStore::HasHeader(size_t packet, uint16_t column) const
+{
+	auto& r = m_records[packet];
+	for(size_t i=0; i<r.m_cellCount; i++)
+	{
+		if(m_cells[r.m_firstCell + i].m_column == column)
+			return true;
+	}
+	return false;
+}
+
+/**
+	@brief Gets the formatted value of one header, or an empty string if the packet has no value for that column
+ */
+string PacketStore::GetHeader(size_t packet, uint16_t column) const
+{
+	auto& r = m_records[packet];
+	for(size_t i=0; i<r.m_cellCount; i++)
+	{
+		auto& cell = m_cells[r.m_firstCell + i];
+		if(cell.m_column == column)
+			return FormatCell(cell);
+	}
+	return "";
+}
+
+/**
+	@brief Converts a header value to its display form
+ */
+string PacketStore::FormatCell(const Cell& cell) const
+{
+	char tmp[32];
+	switch(cell.m_type)
+	{
+		case VALUE_STRING:
+			return string(&m_strings[cell.m_value], cell.m_len);
+
+		case VALUE_DECIMAL:
+			snprintf(tmp, sizeof(tmp), "%" PRId64, cell.m_value);
+			return tmp;
+
+		case VALUE_HEX:
+			snprintf(tmp, sizeof(tmp), "%0*" PRIx64, (int)cell.m_width, (uint64_t)cell.m_value);
+			return tmp;
+
+		case VALUE_MAC:
+			snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
+				(int)((cell.m_value >> 40) & 0xff),
+				(int)((cell.m_value >> 32) & 0xff),
+				(int)((cell.m_value >> 24) & 0xff),
+				(int)((cell.m_value >> 16) & 0xff),
+				(int)((cell.m_value >> 8) & 0xff),
+				(int)(cell.m_value & 0xff));
+			return tmp;
+
+		default:
+			return "";
+	}
+}
+
+/**
+	@brief Creates a standalone Packet object holding a copy of one packet
+ */
+Packet* PacketStore::Materialize(size_t packet) const
+{
+	auto& r = m_records[packet];
+
+	Packet* pack = new Packet;
+	pack->m_offset = r.m_offset;
+	pack->m_len = r.m_len;
+	pack->m_displayForegroundColor = m_colors[r.m_fgcolor];
+	pack->m_displayBackgroundColor = m_colors[r.m_bgcolor];
+
+	for(size_t i=0; i<r.m_cellCount; i++)
+	{
+		auto& cell = m_cells[r.m_firstCell + i];
+		pack->m_headers[m_columns[cell.m_column]] = FormatCell(cell);
+	}
+
+	auto p = m_data.data() + r.m_dataStart;
+	pack->m_data.assign(p, p + r.m_dataLen);
+
+	return pack;
+}
+
+/**
+	@brief Copies a range of packets from another store to the end of this one
+
+	Columns and colors of the source are interned in the order they were created there, so appending to an empty
+	store gives every column and color the same ID it had in the source.
+
+	@param src		Store to copy from
+	@param first	Index of the first packet to copy
+	@param last		One past the index of the last packet to copy
+ */
+void PacketStore::AppendPackets(const PacketStore& src, size_t first, size_t last)
+{
+	if(first >= last)
+		return;
+
+	vector<uint16_t> columns(src.m_columns.size());
+	for(size_t i=0; i<src.m_columns.size(); i++)
+		columns[i] = GetColumnID(src.m_columns[i]);
+	vector<uint16_t> colors(src.m_colors.size());
+	for(size_t i=0; i<src.m_colors.size(); i++)
+		colors[i] = GetColorID(src.m_colors[i]);
+
+	m_records.reserve(m_records.size() + last - first);
+	for(size_t i=first; i<last; i++)
+	{
+		auto r = src.m_records[i];
+		auto p = src.m_data.data() + r.m_dataStart;
+		auto firstCell = r.m_firstCell;
+
+		r.m_dataStart = m_data.size();
+		r.m_firstCell = m_cells.size();
+		r.m_fgcolor = colors[r.m_fgcolor];
+		r.m_bgcolor = colors[r.m_bgcolor];
+		m_records.push_back(r);
+
+		m_data.insert(m_data.end(), p, p + r.m_dataLen);
+
+		for(size_t j=0; j<r.m_cellCount; j++)
+		{
+			auto cell = src.m_cells[firstCell + j];
+			cell.m_column = columns[cell.m_column];
+			if(cell.m_type == VALUE_STRING)
+			{
+				auto str = src.m_strings.data() + cell.m_value;
+				cell.m_value = m_strings.size();
+				m_strings.insert(m_strings.end(), str, str + cell.m_len);
+			}
+			m_cells.push_back(cell);
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 PacketDecoder::PacketDecoder(const std::string& color, Category cat)
 	: Filter(color, cat, Unit(Unit::UNIT_FS))
+	, m_detachedStorePackets(0)
+	, m_lastRefreshPacketCount(0)
+	, m_lastRefreshPacketStoreSize(0)
 {
 	AddProtocolStream("data");
 }
@@ -82,6 +396,90 @@ void PacketDecoder::ClearPackets()
 	for(auto p : m_packets)
 		delete p;
 	m_packets.clear();
+
+	m_packetStore.clear();
+
+	lock_guard<mutex> lock(m_packetViewMutex);
+	for(auto p : m_materializedPackets)
+		delete p;
+	m_materializedPackets.clear();
+	m_packetView.clear();
+	m_detachedStorePackets = 0;
+}
+
+/**
+	@brief Returns the decoded packets as Packet objects
+
+	Packets in the columnar store are converted on first access and cached until the next ClearPackets(), so decoders
+	which only write to the store pay for the conversion only when a client asks for Packet objects. Filters reading
+	a store-backed decoder should use GetPacketStore() instead.
+ */
+const vector<Packet*>& PacketDecoder::GetPackets()
+{
+	lock_guard<mutex> lock(m_packetViewMutex);
+
+	size_t storeLen = m_packetStore.size() - m_detachedStorePackets;
+	if(storeLen == 0)
+		return m_packets;
+
+	//Convert any packets added to the store since the last call
+	if(m_materializedPackets.size() < storeLen)
+	{
+		m_materializedPackets.reserve(storeLen);
+		for(size_t i=m_materializedPackets.size(); i<storeLen; i++)
+			m_materializedPackets.push_back(m_packetStore.Materialize(m_detachedStorePackets + i));
+	}
+
+	if(m_packetView.size() != m_packets.size() + m_materializedPackets.size())
+	{
+		m_packetView = m_packets;
+		m_packetView.insert(m_packetView.end(), m_materializedPackets.begin(), m_materializedPackets.end());
+	}
+	return m_packetView;
+}
+
+/**
+	@brief Clears the list of packets attached to this filter *without* freeing memory.
+
+	Typically used after copying the packets somewhere else and assuming ownership of them. This includes packets
+	converted from the columnar store by GetPackets(); the store itself is kept, but GetPackets() won't return those
+	rows again.
+ */
+void PacketDecoder::DetachPackets()
+{
+	m_packets.clear();
+
+	lock_guard<mutex> lock(m_packetViewMutex);
+	m_detachedStorePackets += m_materializedPackets.size();
+	m_materializedPackets.clear();
+	m_packetView.clear();
+}
+
+/**
+	@brief Records the state of our inputs, configuration, outputs, and packets after a call to Refresh()
+ */
+void PacketDecoder::MarkRefreshed()
+{
+	Filter::MarkRefreshed();
+
+	m_lastRefreshPacketCount = m_packets.size();
+	m_lastRefreshPacketStoreSize = m_packetStore.size();
+}
+
+/**
+	@brief Checks if our outputs and packets are exactly as the last call to Refresh() left them
+
+	Packets which have been detached (e.g. by segmented execution or a client taking ownership of them) can't be
+	appended to, so any change in the number of packets forces a full decode.
+ */
+bool PacketDecoder::AreOutputsUnchangedSinceLastRefresh()
+{
+	if(m_packets.size() != m_lastRefreshPacketCount)
+		return false;
+	if(m_packetStore.size() != m_lastRefreshPacketStoreSize)
+		return false;
+
+	return Filter::AreOutputsUnchangedSinceLastRefresh();
 }
 
 bool PacketDecoder::GetShowDataColumn()
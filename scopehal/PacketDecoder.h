@@ -77,6 +77,177 @@ public:
 	}
 };
 
+/**
+	@class
+	@brief Columnar storage for the packets produced by a PacketDecoder
+
+	Packet holds a std::map of strings, two color strings and a byte vector, which works out to a dozen or so heap
+	allocations for every packet. A long capture can decode to millions of packets, so decoders may instead write into
+	a PacketStore:
+
+	* Fixed-size per-packet records live in one array
+	* Header columns are interned to small integer IDs
+	* Header values are typed (string, decimal, hex, MAC address) and only formatted when read
+	* String header values and payload bytes are appended to shared arenas
+	* Colors are interned to indexes; the first PROTO_STANDARD_COLOR_COUNT entries are PacketDecoder::m_backgroundColors
+
+	Packets are built in order. Headers and payload bytes may only be added to the most recently created packet.
+ */
+class PacketStore
+{
+public:
+	PacketStore();
+
+	///@brief Types of header value
+	enum ValueType
+	{
+		VALUE_STRING,		//Arbitrary text, stored in the string arena
+		VALUE_DECIMAL,		//Signed integer, printed in decimal
+		VALUE_HEX,			//Unsigned integer, printed in hex with a fixed number of digits
+		VALUE_MAC			//48-bit MAC address, printed as colon separated bytes
+	};
+
+	void clear();
+	void reserve(size_t packets, size_t bytes);
+
+	///@brief Returns the number of packets in the store
+	size_t size() const
+	{ return m_records.size(); }
+
+	size_t GetMemoryUsage() const;
+
+	uint16_t GetColumnID(const std::string& name);
+
+	///@brief Returns the name of a header column
+	const std::string& GetColumnName(uint16_t id) const
+	{ return m_columns[id]; }
+
+	uint16_t GetColorID(const std::string& color);
+
+	///@brief Returns the string form of an interned color
+	const std::string& GetColor(uint16_t id) const
+	{ return m_colors[id]; }
+
+	//Writing
+	size_t AddPacket(int64_t offset, uint16_t bgcolor = 0);
+	void DiscardLastPacket();
+
+	///@brief Sets the start time of a packet
+	void SetOffset(size_t packet, int64_t offset)
+	{ m_records[packet].m_offset = offset; }
+
+	///@brief Sets the duration of a packet
+	void SetLength(size_t packet, int64_t len)
+	{ m_records[packet].m_len = len; }
+
+	///@brief Sets the background color of a packet to a value returned by GetColorID()
+	void SetBackgroundColor(size_t packet, uint16_t color)
+	{ m_records[packet].m_bgcolor = color; }
+
+	///@brief Sets the text color of a packet to a value returned by GetColorID()
+	void SetForegroundColor(size_t packet, uint16_t color)
+	{ m_records[packet].m_fgcolor = color; }
+
+	///@brief Appends one payload byte to the most recently created packet
+	void AppendData(uint8_t b)
+	{
+		m_data.push_back(b);
+		m_records.back().m_dataLen ++;
+	}
+
+	void AppendData(const uint8_t* p, size_t len);
+
+	void SetHeader(uint16_t column, const std::string& value);
+	void SetHeader(uint16_t column, ValueType type, int64_t value, uint8_t width = 0);
+
+	//Reading
+	///@brief Returns the start time of a packet
+	int64_t GetOffset(size_t packet) const
+	{ return m_records[packet].m_offset; }
+
+	///@brief Returns the duration of a packet
+	int64_t GetLength(size_t packet) const
+	{ return m_records[packet].m_len; }
+
+	///@brief Returns a pointer to the payload of a packet
+	const uint8_t* GetData(size_t packet) const
+	{ return m_data.data() + m_records[packet].m_dataStart; }
+
+	///@brief Returns the payload size of a packet, in bytes
+	size_t GetDataSize(size_t packet) const
+	{ return m_records[packet].m_dataLen; }
+
+	///@brief Returns the background color of a packet
+	const std::string& GetBackgroundColor(size_t packet) const
+	{ return m_colors[m_records[packet].m_bgcolor]; }
+
+	///@brief Returns the text color of a packet
+	const std::string& GetForegroundColor(size_t packet) const
+	{ return m_colors[m_records[packet].m_fgcolor]; }
+
+	bool HasHeader(size_t packet, uint16_t column) const;
+	std::string GetHeader(size_t packet, uint16_t column) const;
+
+	Packet* Materialize(size_t packet) const;
+
+	void AppendPackets(const PacketStore& src, size_t first, size_t last);
+
+	///@brief Color ID of the default packet text color
+	uint16_t m_defaultForeground;
+
+protected:
+
+	///@brief Fixed-size record for a single packet
+	struct Record
+	{
+		int64_t m_offset;
+		int64_t m_len;
+		uint64_t m_dataStart;
+		uint32_t m_dataLen;
+		uint32_t m_firstCell;
+		uint16_t m_cellCount;
+		uint16_t m_fgcolor;
+		uint16_t m_bgcolor;
+	};
+
+	///@brief A single header value
+	struct Cell
+	{
+		uint16_t m_column;
+		uint8_t m_type;
+		uint8_t m_width;
+		uint32_t m_len;
+		int64_t m_value;
+	};
+
+	Cell& AddCell(uint16_t column);
+	std::string FormatCell(const Cell& cell) const;
+
+	///@brief Per-packet records
+	std::vector<Record> m_records;
+
+	///@brief Header values for all packets, grouped by packet
+	std::vector<Cell> m_cells;
+
+	///@brief Payload bytes for all packets
+	std::vector<uint8_t> m_data;
+
+	///@brief Backing storage for VALUE_STRING header values
+	std::vector<char> m_strings;
+
+	///@brief Interned header column names
+	std::vector<std::string> m_columns;
+
+	///@brief Map of column names to IDs
+	std::map<std::string, uint16_t> m_columnIDs;
+
+	///@brief Interned color strings
+	std::vector<std::string> m_colors;
+
+	///@brief Map of color strings to IDs
+	std::map<std::string, uint16_t> m_colorIDs;
+};
+
 /**
 	@class
 	@brief A protocol decoder that outputs packetized data
@@ -87,9 +258,22 @@ public:
 	PacketDecoder(const std::string& color, Filter::Category cat);
 	virtual ~PacketDecoder();
 
-	const std::vector<Packet*>& GetPackets()
+	const std::vector<Packet*>& GetPackets();
+
+	/**
+		@brief Returns only the packets created as Packet objects, without converting the columnar store
+	 */
+	const std::vector<Packet*>& GetPacketObjects()
 	{ return m_packets; }
 
+	///@brief Returns the columnar packet store
+	const PacketStore& GetPacketStore()
+	{ return m_packetStore; }
+
+	///@brief Returns the total number of packets, whether created as Packet objects or in the packet store
+	size_t GetPacketCount()
+	{ return m_packets.size() + m_packetStore.size(); }
+
 	virtual std::vector<std::string> GetHeaders() =0;
 
 	virtual bool GetShowDataColumn();
@@ -118,18 +302,62 @@ public:
 
 	static std::string m_backgroundColors[PROTO_STANDARD_COLOR_COUNT];
 
+	void DetachPackets();
+
+	/**
+		@brief Replaces the list of packets attached to this filter, taking ownership of the new ones.
+
+		Used to hand back packets accumulated over several refreshes, e.g. during segmented execution.
+	 */
+	void SetPackets(std::vector<Packet*>&& packets)
+	{
+		ClearPackets();
+		m_packets = std::move(packets);
+	}
+
 	/**
-		@brief Clears the list of packets attached to this filter *without* freeing memory.
+		@brief Replaces both the Packet objects and the packet store contents of this filter.
 
-		Typically used after copying the packets somewhere else and assuming ownership of them.
+		The store must have been filled with PacketStore::AppendPackets() starting from an empty store, so that column
+		and color IDs cached by the decoder are still valid.
 	 */
-	void DetachPackets()
-	{ m_packets.clear(); }
+	void SetPackets(std::vector<Packet*>&& packets, PacketStore&& store)
+	{
+		ClearPackets();
+		m_packets = std::move(packets);
+		m_packetStore = std::move(store);
+	}
+
+	virtual void MarkRefreshed() override;
 
 protected:
 	void ClearPackets();
 
+	virtual bool AreOutputsUnchangedSinceLastRefresh() override;
+
+	///@brief Packets created directly as Packet objects
 	std::vector<Packet*> m_packets;
+
+	///@brief Columnar packet storage
+	PacketStore m_packetStore;
+
+	///@brief Mutex guarding the GetPackets() view of the packet store
+	std::mutex m_packetViewMutex;
+
+	///@brief m_packets followed by m_materializedPackets, as returned by GetPackets()
+	std::vector<Packet*> m_packetView;
+
+	///@brief Packet objects converted from m_packetStore by GetPackets(), owned by this decoder
+	std::vector<Packet*> m_materializedPackets;
+
+	///@brief Number of packets at the start of m_packetStore which were handed off by DetachPackets()
+	size_t m_detachedStorePackets;
+
+	///@brief Size of m_packets as of the last call to MarkRefreshed()
+	size_t m_lastRefreshPacketCount;
+
+	///@brief Size of m_packetStore as of the last call to MarkRefreshed()
+	size_t m_lastRefreshPacketStoreSize;
 };
 
 #endif
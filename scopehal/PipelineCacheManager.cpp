@@ -38,6 +38,9 @@
 #include <shlobj.h>
 #else
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <wordexp.h>
 #endif
 
@@ -45,6 +48,25 @@ using namespace std;
 
 unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
 
+///@brief Magic number at the start of the cache file
+static const char g_cacheFileMagic[8] = {'P', 'L', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+///@brief Cache file format version, bump when PipelineCacheFileHeader or PipelineCacheRecordHeader change
+static const uint32_t g_cacheFileVersion = 1;
+
+///@brief Magic number at the start of each record ("PCRC")
+static const uint32_t g_cacheRecordMagic = 0x43524350;
+
+/**
+	@brief CRC of a blob, with empty blobs (which CRC32() can't handle) defined as zero
+ */
+static uint32_t BlobCRC(const uint8_t* data, size_t len)
+{
+	if(len == 0)
+		return 0;
+	return CRC32(data, 0, len-1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -52,6 +74,11 @@ unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
 	@brief
  */
 PipelineCacheManager::PipelineCacheManager()
+	: m_fileData(nullptr)
+	, m_fileSize(0)
+	, m_validEnd(0)
+	, m_deadBytes(0)
+	, m_fileHeaderValid(false)
 {
 	FindPath();
 	LoadFromDisk();
@@ -64,6 +91,7 @@ PipelineCacheManager::~PipelineCacheManager()
 {
 	SaveToDisk();
 	Clear();
+	UnmapFile();
 }
 
 void PipelineCacheManager::FindPath()
@@ -102,6 +130,8 @@ void PipelineCacheManager::FindPath()
 	m_cacheRootDir = ExpandPath("~/.cache/ngscopeclient") + "/";
 #endif
 
+	m_cachePath = m_cacheRootDir + "pipeline_cache.bin";
+
 	LogTrace("Cache root directory is %s\n", m_cacheRootDir.c_str());
 }
 
@@ -130,6 +160,24 @@ shared_ptr< vector<uint8_t> > PipelineCacheManager::LookupRaw(const string& key)
 		return m_rawDataCache[key];
 	}
 
+	//Not loaded yet, but it might be in the cache file
+	auto it = m_rawIndex.find(key);
+	if(it != m_rawIndex.end())
+	{
+		auto& entry = it->second;
+		if(ValidateEntry(key, entry))
+		{
+			LogTrace("Hit for raw %s (loaded from disk)\n", key.c_str());
+			auto data = m_fileData + entry.m_offset;
+			auto ret = make_shared< vector<uint8_t> >(data, data + entry.m_len);
+			m_rawDataCache[key] = ret;
+			return ret;
+		}
+
+		m_deadBytes += entry.m_recordSize;
+		m_rawIndex.erase(it);
+	}
+
 	LogTrace("Miss for raw %s\n", key.c_str());
 	return nullptr;
 }
@@ -141,6 +189,7 @@ void PipelineCacheManager::StoreRaw(const string& key, shared_ptr< vector<uint8_
 {
 	lock_guard<mutex> lock(m_mutex);
 	m_rawDataCache[key] = value;
+	m_dirtyRaw.emplace(key);
 
 	LogTrace("Store raw: %s (%zu bytes)\n", key.c_str(), value->size());
 }
@@ -166,9 +215,32 @@ shared_ptr<vk::raii::PipelineCache> PipelineCacheManager::Lookup(const string& k
 		}
 	}
 
+	//Not loaded yet, but it might be in the cache file
+	const uint8_t* initialData = nullptr;
+	size_t initialLen = 0;
+	auto it = m_pipelineIndex.find(key);
+	if(it != m_pipelineIndex.end())
+	{
+		auto& entry = it->second;
+		if(entry.m_mtime != target)
+			LogTrace("Ignoring out of date cache entry for %s\n", key.c_str());
+		else if(ValidateEntry(key, entry))
+		{
+			LogTrace("Hit for pipeline %s (loaded from disk)\n", key.c_str());
+			initialData = m_fileData + entry.m_offset;
+			initialLen = entry.m_len;
+		}
+		else
+		{
+			m_deadBytes += entry.m_recordSize;
+			m_pipelineIndex.erase(it);
+		}
+	}
+
 	//Nope, make a new empty cache object and return it
-	LogTrace("Miss for pipeline %s\n", key.c_str());
-	vk::PipelineCacheCreateInfo info({},{});
+	if(!initialData)
+		LogTrace("Miss for pipeline %s\n", key.c_str());
+	vk::PipelineCacheCreateInfo info({}, initialLen, initialData);
 	auto ret = make_shared<vk::raii::PipelineCache>(*g_vkComputeDevice, info);
 	m_vkCache[key] = ret;
 	m_vkCacheTimestamps[key] = target;
@@ -190,8 +262,11 @@ shared_ptr<vk::raii::PipelineCache> PipelineCacheManager::Lookup(const string& k
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
+
 /**
-	@brief Loads cache content from disk
+	@brief Maps the cache file and indexes its content
+
+	Only the record headers are read here. Blob content isn't touched (or CRC checked) until it's looked up.
  */
 void PipelineCacheManager::LoadFromDisk()
 {
@@ -200,95 +275,193 @@ void PipelineCacheManager::LoadFromDisk()
 	LogTrace("Loading pipeline cache\n");
 	LogIndenter li;
 
-	PipelineCacheFileHeader header;
-	int vkfft_expected = VkFFTGetVersion();
+	double start = GetTime();
+	UnmapFile();
+	MapFile();
+	IndexFile();
+	double dt = GetTime() - start;
+
+	LogDebug("Pipeline cache: indexed %zu raw and %zu pipeline blobs (%zu kB) in %.2f ms\n",
+		m_rawIndex.size(),
+		m_pipelineIndex.size(),
+		m_fileSize / 1024,
+		dt * 1000);
+}
 
-	string rawPrefix = "raw_";
-	string shaderPrefix = "pipeline_";
-	string shaderSuffix = ".bin";
+/**
+	@brief Maps the cache file into memory, if it exists
 
-	//Load raw binary blobs (mostly for vkFFT)
-	auto prefix = m_cacheRootDir + "shader_";
-	auto files = Glob(prefix + "*", false);
-	for(auto f : files)
-	{
-		if(f.find(prefix) == string::npos)
-			f = m_cacheRootDir + f;
-
-		//Extract the key from the file name
-		auto key = f.substr(prefix.length());
-		key = key.substr(0, key.length() - shaderSuffix.length());
-		bool typeIsRaw = (key.find(rawPrefix) == 0);
-		if(typeIsRaw)
-			key = key.substr(rawPrefix.length());
-		else
-			key = key.substr(shaderPrefix.length());
+	On Windows the file is read into m_fileBuffer instead, until we figure out memory mapping there.
+ */
+void PipelineCacheManager::MapFile()
+{
+	m_fileData = nullptr;
+	m_fileSize = 0;
 
-		//Read the header and make sure it checks out
-		FILE* fp = fopen(f.c_str(), "rb");
-		if(1 != fread(&header, sizeof(header), 1, fp))
+#ifdef _WIN32
+	FILE* fp = fopen(m_cachePath.c_str(), "rb");
+	if(!fp)
+		return;
+
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if(len > 0)
+	{
+		m_fileBuffer.resize(len);
+		if((size_t)len != fread(&m_fileBuffer[0], 1, len, fp))
 		{
-			LogWarning("Read cache header failed (%s)\n", f.c_str());
-			fclose(fp);
-			continue;
+			LogWarning("Read pipeline cache failed (%s)\n", m_cachePath.c_str());
+			m_fileBuffer.clear();
 		}
+	}
+	fclose(fp);
 
-		LogTrace("Loading cache object %s (from %s, timestamp %zu)\n", key.c_str(), f.c_str(), (size_t)header.file_mtime);
-		LogIndenter li2;
+	m_fileData = m_fileBuffer.data();
+	m_fileSize = m_fileBuffer.size();
+#else
+	int fd = open(m_cachePath.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
 
-		if(0 != memcmp(header.cache_uuid, g_vkComputeDeviceUuid, 16))
-		{
-			LogTrace("Rejecting cache file (%s) due to mismatching UUID\n", f.c_str());
-			fclose(fp);
-			continue;
-		}
-		if(header.vkfft_ver != vkfft_expected)
-		{
-			LogTrace("Rejecting cache file (%s) due to mismatching vkFFT version\n", f.c_str());
-			fclose(fp);
-			continue;
-		}
-		if(header.driver_ver != g_vkComputeDeviceDriverVer)
+	struct stat st;
+	if( (0 == fstat(fd, &st)) && (st.st_size > 0) )
+	{
+		void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(ptr == MAP_FAILED)
+			LogWarning("Failed to map pipeline cache (%s)\n", m_cachePath.c_str());
+		else
 		{
-			LogTrace("Rejecting cache file (%s) due to mismatching driver version\n", f.c_str());
-			fclose(fp);
-			continue;
+			m_fileData = reinterpret_cast<const uint8_t*>(ptr);
+			m_fileSize = st.st_size;
 		}
+	}
 
-		//All good. Read the file content
-		auto p = make_shared< vector<uint8_t> >();
-		p->resize(header.len);
-		if(header.len != fread(&((*p)[0]), 1, header.len, fp))
-		{
-			LogWarning("Read cache content failed (%s)\n", f.c_str());
-			fclose(fp);
-			continue;
-		}
-		fclose(fp);
+	//The mapping stays valid after the descriptor is closed
+	close(fd);
+#endif
+}
+
+/**
+	@brief Unmaps the cache file and forgets its index
+ */
+void PipelineCacheManager::UnmapFile()
+{
+#ifdef _WIN32
+	m_fileBuffer.clear();
+	m_fileBuffer.shrink_to_fit();
+#else
+	if(m_fileData)
+		munmap(const_cast<uint8_t*>(m_fileData), m_fileSize);
+#endif
+
+	m_fileData = nullptr;
+	m_fileSize = 0;
+	m_validEnd = 0;
+	m_deadBytes = 0;
+	m_fileHeaderValid = false;
+	m_rawIndex.clear();
+	m_pipelineIndex.clear();
+}
+
+/**
+	@brief Scans the record headers of the mapped cache file and builds the key index
+
+	Later records for the same key supersede earlier ones. Scanning stops at the first damaged or truncated record,
+	which is what an interrupted append leaves behind.
+ */
+void PipelineCacheManager::IndexFile()
+{
+	m_rawIndex.clear();
+	m_pipelineIndex.clear();
+	m_validEnd = 0;
+	m_deadBytes = 0;
+	m_fileHeaderValid = false;
+
+	if(m_fileSize < sizeof(PipelineCacheFileHeader))
+		return;
 
-		//Verify the CRC
-		if(header.crc != CRC32(*p))
+	//Read the header and make sure it checks out
+	PipelineCacheFileHeader header;
+	memcpy(&header, m_fileData, sizeof(header));
+	if( (0 != memcmp(header.magic, g_cacheFileMagic, sizeof(g_cacheFileMagic))) ||
+		(header.version != g_cacheFileVersion) )
+	{
+		LogTrace("Rejecting cache file (%s) due to unknown format\n", m_cachePath.c_str());
+		return;
+	}
+	if(0 != memcmp(header.cache_uuid, g_vkComputeDeviceUuid, 16))
+	{
+		LogTrace("Rejecting cache file (%s) due to mismatching UUID\n", m_cachePath.c_str());
+		return;
+	}
+	if(header.vkfft_ver != VkFFTGetVersion())
+	{
+		LogTrace("Rejecting cache file (%s) due to mismatching vkFFT version\n", m_cachePath.c_str());
+		return;
+	}
+	if(header.driver_ver != g_vkComputeDeviceDriverVer)
+	{
+		LogTrace("Rejecting cache file (%s) due to mismatching driver version\n", m_cachePath.c_str());
+		return;
+	}
+	m_fileHeaderValid = true;
+
+	size_t off = sizeof(header);
+	PipelineCacheRecordHeader rec;
+	while(off + sizeof(rec) <= m_fileSize)
+	{
+		memcpy(&rec, m_fileData + off, sizeof(rec));
+		size_t recordSize = sizeof(rec) + rec.keylen + rec.len;
+		if( (rec.magic != g_cacheRecordMagic) ||
+			( (rec.type != RECORD_RAW) && (rec.type != RECORD_PIPELINE) ) ||
+			(recordSize > m_fileSize - off) )
 		{
-			LogWarning("Rejecting cache file (%s) due to bad CRC\n", f.c_str());
-			continue;
+			LogWarning("Pipeline cache (%s) is damaged at offset %zu, ignoring the rest\n", m_cachePath.c_str(), off);
+			break;
 		}
 
-		//Done, add to cache if we get this far
-		if(typeIsRaw)
-			m_rawDataCache[key] = p;
-		else
+		string key(reinterpret_cast<const char*>(m_fileData + off + sizeof(rec)), rec.keylen);
+		IndexEntry entry;
+		entry.m_offset = off + sizeof(rec) + rec.keylen;
+		entry.m_len = rec.len;
+		entry.m_crc = rec.crc;
+		entry.m_mtime = rec.file_mtime;
+		entry.m_recordSize = recordSize;
+
+		auto& index = (rec.type == RECORD_RAW) ? m_rawIndex : m_pipelineIndex;
+		auto it = index.find(key);
+		if(it != index.end())
 		{
-			vector<uint8_t>& vec = *p;
-			vk::PipelineCacheCreateInfo info({}, vec.size(), &vec[0]);
-			auto ret = make_shared<vk::raii::PipelineCache>(*g_vkComputeDevice, info);
-			m_vkCache[key] = ret;
-			m_vkCacheTimestamps[key] = header.file_mtime;
+			m_deadBytes += it->second.m_recordSize;
+			it->second = entry;
 		}
+		else
+			index[key] = entry;
+
+		off += recordSize;
 	}
+	m_validEnd = off;
+}
+
+/**
+	@brief Checks the CRC of a blob in the cache file
+ */
+bool PipelineCacheManager::ValidateEntry(const string& key, const IndexEntry& entry)
+{
+	if(entry.m_crc == BlobCRC(m_fileData + entry.m_offset, entry.m_len))
+		return true;
+
+	LogWarning("Rejecting cache entry %s due to bad CRC\n", key.c_str());
+	return false;
 }
 
 /**
 	@brief Writes cache content out to disk
+
+	Only blobs that are new or changed since the file was loaded are written, appended to the end of the file. If that
+	would leave more than half of the file as superseded records, or the existing file is unusable, the file is
+	rewritten with only the live records instead.
  */
 void PipelineCacheManager::SaveToDisk()
 {
@@ -297,66 +470,175 @@ void PipelineCacheManager::SaveToDisk()
 	LogTrace("Saving cache\n");
 	LogIndenter li;
 
-	PipelineCacheFileHeader header;
-	memcpy(header.cache_uuid, g_vkComputeDeviceUuid, 16);
-	header.driver_ver = g_vkComputeDeviceDriverVer;
-	header.vkfft_ver = VkFFTGetVersion();
+	vector<PendingRecord> pending;
+	size_t superseded = 0;
+	size_t appendSize = 0;
 
-	//Save raw data
-	for(auto it : m_rawDataCache)
+	//Raw blobs only change when someone stores them
+	for(auto& key : m_dirtyRaw)
 	{
-		auto key = it.first;
-		auto& vec = *it.second;
-		auto fname = m_cacheRootDir + "shader_raw_" + key + ".bin";
-		LogTrace("Saving shader %s (%zu bytes)\n", fname.c_str(), vec.size());
-		FILE* fp = fopen(fname.c_str(), "wb");
-
-		//Write the cache header
-		header.len = vec.size();
-		header.crc = CRC32(vec);
-		header.file_mtime = 0;	//not used
-		if(1 != fwrite(&header, sizeof(header), 1, fp))
-		{
-			LogWarning("Write cache header failed (%s)\n", fname.c_str());
-			fclose(fp);
+		auto it = m_rawDataCache.find(key);
+		if(it == m_rawDataCache.end())
 			continue;
-		}
 
-		//Write the data
-		if(header.len != fwrite(&vec[0], 1, header.len, fp))
-			LogWarning("Write cache data failed (%s)\n", fname.c_str());
+		auto jt = m_rawIndex.find(key);
+		if(jt != m_rawIndex.end())
+			superseded += jt->second.m_recordSize;
 
-		fclose(fp);
+		pending.push_back({RECORD_RAW, key, *it->second, 0});
+		appendSize += sizeof(PipelineCacheRecordHeader) + key.length() + it->second->size();
 	}
 
-	//Save Vulkan shader cache
+	//Vulkan pipeline caches may have grown since we loaded them
 	for(auto it : m_vkCache)
 	{
 		auto key = it.first;
-		auto pcache = it.second;
-		auto fname = m_cacheRootDir + "shader_pipeline_" + key + ".bin";
+		auto vec = it.second->getData();
+		auto mtime = m_vkCacheTimestamps[key];
+
+		auto jt = m_pipelineIndex.find(key);
+		if(jt != m_pipelineIndex.end())
+		{
+			auto& entry = jt->second;
+			if( (entry.m_len == vec.size()) && (entry.m_mtime == mtime) && (entry.m_crc == BlobCRC(vec.data(), vec.size())) )
+				continue;
+			superseded += entry.m_recordSize;
+		}
 
-		//Extract the raw shader content
-		auto vec = pcache->getData();
-		LogTrace("Saving shader %s (%zu bytes)\n", fname.c_str(), vec.size());
+		LogTrace("Saving shader %s (%zu bytes)\n", key.c_str(), vec.size());
+		appendSize += sizeof(PipelineCacheRecordHeader) + key.length() + vec.size();
+		pending.push_back({RECORD_PIPELINE, key, std::move(vec), mtime});
+	}
+
+	if(pending.empty())
+		return;
 
-		FILE* fp = fopen(fname.c_str(), "wb");
+	//Decide whether to append or compact
+	bool rewrite = !m_fileHeaderValid || (m_validEnd != m_fileSize);
+	size_t dead = m_deadBytes + superseded;
+	if(dead * 2 > m_validEnd + appendSize)
+	{
+		LogTrace("Compacting pipeline cache (%zu of %zu bytes superseded)\n", dead, m_validEnd + appendSize);
+		rewrite = true;
+	}
 
-		//Write the cache header
-		header.len = vec.size();
-		header.crc = CRC32(vec);
-		header.file_mtime = m_vkCacheTimestamps[key];
+	if(WriteFile(pending, rewrite))
+		m_dirtyRaw.clear();
+
+	//Re-index so lookups of blobs we haven't loaded yet see the new file
+	UnmapFile();
+	MapFile();
+	IndexFile();
+}
+
+/**
+	@brief Writes pending records to the cache file
+
+	@param pending	Records to write
+	@param rewrite	If true, write a new file containing the header, all live records from the current file that aren't
+					superseded by pending ones, and then the pending ones. If false, append to the current file.
+
+	@return True on success
+ */
+bool PipelineCacheManager::WriteFile(const vector<PendingRecord>& pending, bool rewrite)
+{
+	string path = m_cachePath;
+	if(rewrite)
+		path += ".tmp";
+
+	FILE* fp = fopen(path.c_str(), rewrite ? "wb" : "r+b");
+	if(!fp)
+	{
+		LogWarning("Failed to open pipeline cache (%s) for writing\n", path.c_str());
+		return false;
+	}
+
+	bool ok = true;
+	auto writeRecord = [&](RecordType type, const string& key, const uint8_t* data, size_t len, uint32_t crc, time_t mtime)
+	{
+		PipelineCacheRecordHeader rec;
+		rec.magic = g_cacheRecordMagic;
+		rec.type = type;
+		rec.keylen = key.length();
+		rec.len = len;
+		rec.crc = crc;
+		rec.file_mtime = mtime;
+		if( (1 != fwrite(&rec, sizeof(rec), 1, fp)) ||
+			(key.length() != fwrite(key.c_str(), 1, key.length(), fp)) ||
+			(len != fwrite(data, 1, len, fp)) )
+		{
+			ok = false;
+		}
+	};
+
+	if(rewrite)
+	{
+		PipelineCacheFileHeader header;
+		memcpy(header.magic, g_cacheFileMagic, sizeof(g_cacheFileMagic));
+		header.version = g_cacheFileVersion;
+		memcpy(header.cache_uuid, g_vkComputeDeviceUuid, 16);
+		header.vkfft_ver = VkFFTGetVersion();
+		header.driver_ver = g_vkComputeDeviceDriverVer;
 		if(1 != fwrite(&header, sizeof(header), 1, fp))
+			ok = false;
+
+		//Copy live records we aren't replacing straight across from the old file, still unvalidated
+		set<string> replacedRaw;
+		set<string> replacedPipeline;
+		for(auto& r : pending)
 		{
-			LogWarning("Write cache header failed (%s)\n", fname.c_str());
-			fclose(fp);
-			continue;
+			if(r.m_type == RECORD_RAW)
+				replacedRaw.emplace(r.m_key);
+			else
+				replacedPipeline.emplace(r.m_key);
+		}
+
+		for(auto& it : m_rawIndex)
+		{
+			if(replacedRaw.find(it.first) == replacedRaw.end())
+			{
+				auto& e = it.second;
+				writeRecord(RECORD_RAW, it.first, m_fileData + e.m_offset, e.m_len, e.m_crc, e.m_mtime);
+			}
+		}
+		for(auto& it : m_pipelineIndex)
+		{
+			if(replacedPipeline.find(it.first) == replacedPipeline.end())
+			{
+				auto& e = it.second;
+				writeRecord(RECORD_PIPELINE, it.first, m_fileData + e.m_offset, e.m_len, e.m_crc, e.m_mtime);
+			}
 		}
+	}
+	else
+		fseek(fp, m_validEnd, SEEK_SET);
 
-		//Write the data
-		if(header.len != fwrite(&vec[0], 1, header.len, fp))
-			LogWarning("Write cache data failed (%s)\n", fname.c_str());
+	for(auto& r : pending)
+		writeRecord(r.m_type, r.m_key, r.m_data.data(), r.m_data.size(), BlobCRC(r.m_data.data(), r.m_data.size()), r.m_mtime);
 
-		fclose(fp);
+	if(0 != fclose(fp))
+		ok = false;
+
+	if(!ok)
+	{
+		LogWarning("Write pipeline cache failed (%s)\n", path.c_str());
+		if(rewrite)
+			remove(path.c_str());
+		return false;
+	}
+
+	//Atomically replace the old file
+	if(rewrite)
+	{
+		#ifdef _WIN32
+			remove(m_cachePath.c_str());
+		#endif
+		if(0 != rename(path.c_str(), m_cachePath.c_str()))
+		{
+			LogWarning("Failed to replace pipeline cache (%s)\n", m_cachePath.c_str());
+			return false;
+		}
 	}
+
+	return true;
 }
@@ -35,26 +35,43 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 
 #pragma pack(push, 1)
+
+///@brief Header at the start of the pipeline cache file
 struct PipelineCacheFileHeader
 {
+	char		magic[8];
+	uint32_t	version;
 	uint8_t		cache_uuid[16];
-	time_t		file_mtime;
 	int32_t		vkfft_ver;
 	uint32_t	driver_ver;
+};
+
+///@brief Header of one blob in the pipeline cache file, followed by the key and then the data
+struct PipelineCacheRecordHeader
+{
+	uint32_t	magic;
+	uint32_t	type;
+	uint32_t	keylen;
 	uint32_t	len;
 	uint32_t	crc;
+	int64_t		file_mtime;
 };
+
 #pragma pack(pop)
 
 /**
 	@brief Helper for managing Vulkan / vkFFT pipeline cache objects
 
-	The cache is stored on disk under the .cache/glscopeclient directory on Linux, or FIXME on Windows.
+	The cache is stored on disk under the .cache/ngscopeclient directory on Linux, or %appdata%/ngscopeclient on
+	Windows, as a single file ($cachedir/pipeline_cache.bin) of blobs appended one after another.
 
-	Raw data: $cachedir/shader_raw_[key].bin
-	Vulkan shader data: $cachedir/shader_pipeline_[key].bin
+	At startup the file is memory mapped and only the record headers are scanned, to build an index of key to
+	offset/length/CRC. Blobs are CRC checked and copied out the first time they're looked up, so large vkFFT kernels we
+	never use in a session cost nothing. SaveToDisk() appends new and changed blobs to the end of the file; once more
+	than half of the file is superseded records it is compacted by rewriting only the live ones.
  */
 class PipelineCacheManager
 {
@@ -74,6 +91,47 @@ public:
 protected:
 	void FindPath();
 
+	///@brief Types of record in the cache file
+	enum RecordType
+	{
+		RECORD_RAW = 1,
+		RECORD_PIPELINE = 2
+	};
+
+	///@brief Location of one blob within the cache file
+	struct IndexEntry
+	{
+		///@brief Offset of the blob data from the start of the file
+		size_t m_offset;
+
+		///@brief Length of the blob data
+		uint32_t m_len;
+
+		///@brief Expected CRC of the blob data
+		uint32_t m_crc;
+
+		///@brief Source file timestamp (pipeline records only)
+		time_t m_mtime;
+
+		///@brief Total size of the record including its header and key, for compaction bookkeeping
+		size_t m_recordSize;
+	};
+
+	///@brief A blob waiting to be written to the cache file
+	struct PendingRecord
+	{
+		RecordType m_type;
+		std::string m_key;
+		std::vector<uint8_t> m_data;
+		time_t m_mtime;
+	};
+
+	void MapFile();
+	void UnmapFile();
+	void IndexFile();
+	bool ValidateEntry(const std::string& key, const IndexEntry& entry);
+	bool WriteFile(const std::vector<PendingRecord>& pending, bool rewrite);
+
 	///@brief Mutex to interlock access to the STL containers
 	std::mutex m_mutex;
 
@@ -86,8 +144,40 @@ protected:
 	///@brief Modification timestamps of the files
 	std::map<std::string, time_t> m_vkCacheTimestamps;
 
+	///@brief Raw blobs stored since the last save
+	std::set<std::string> m_dirtyRaw;
+
+	///@brief On-disk locations of raw blobs
+	std::map<std::string, IndexEntry> m_rawIndex;
+
+	///@brief On-disk locations of pipeline cache blobs
+	std::map<std::string, IndexEntry> m_pipelineIndex;
+
 	///@brief Root directory of the cache
 	std::string m_cacheRootDir;
+
+	///@brief Full path to the cache file
+	std::string m_cachePath;
+
+	///@brief Contents of the cache file (memory mapped, or read into m_fileBuffer on Windows)
+	const uint8_t* m_fileData;
+
+	///@brief Size of the cache file
+	size_t m_fileSize;
+
+	///@brief End of the last intact record in the cache file
+	size_t m_validEnd;
+
+	///@brief Bytes of the cache file taken up by superseded records
+	size_t m_deadBytes;
+
+	///@brief True if the file header matched our device and vkFFT version
+	bool m_fileHeaderValid;
+
+#ifdef _WIN32
+	///@brief Contents of the cache file, since we don't memory map on Windows yet
+	std::vector<uint8_t> m_fileBuffer;
+#endif
 };
 
 extern std::unique_ptr<PipelineCacheManager> g_pipelineCacheMgr;
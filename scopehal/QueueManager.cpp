@@ -101,6 +101,15 @@ void QueueHandle::Submit(vk::raii::CommandBuffer const& cmdBuf)
 	m_queue->submit(info, **m_fence);
 }
 
+void QueueHandle::Submit(vk::raii::CommandBuffer const& cmdBuf, vk::raii::Fence const& fence)
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+
+	//The caller owns the fence and waits on it, so there is no need to wait for or replace m_fence
+	vk::SubmitInfo info({}, {}, *cmdBuf);
+	m_queue->submit(info, *fence);
+}
+
 void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
@@ -60,6 +60,8 @@ public:
 
 	/// Submit the given command buffer on the queue
 	void Submit(vk::raii::CommandBuffer const& cmdBuf);
+	/// Submit the given command buffer on the queue, signaling a caller-owned fence on completion
+	void Submit(vk::raii::CommandBuffer const& cmdBuf, vk::raii::Fence const& fence);
 	/// Submit the given command buffer on the queue and wait until completion
 	void SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf);
 
@@ -814,13 +814,24 @@ bool RSRTO6Oscilloscope::AcquireData()
 
 			LogDebug("[%3d%%] Query ...`DATA?%s` (B)\n", (int)(100*((float)transferred/(float)length)), params.c_str());
 
-			//Ask for the data
-			size_t len_bytes;
-			unsigned char* samples = (unsigned char*)m_transport->SendCommandImmediateWithRawBlockReply(m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI", len_bytes);
+			//Ask for the data, and receive it straight into the waveform.
+			//Hold the transport lock from the query to the end of the reply so nobody else's query can get in between.
+			lock_guard<recursive_mutex> transportLock(m_transport->GetMutex());
+			unsigned char* cpy_target = dest_buf+(transferred*sizeof(float));
+			size_t expected_bytes = this_length*sizeof(float);
+			m_transport->SendCommandImmediate(m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI");
+
+			//Check the length in the block header, so an oversized reply is caught rather than truncated
+			size_t len_bytes = 0;
+			bool ok = m_transport->ReadBlockHeader(len_bytes) && (len_bytes == expected_bytes);
+			if(ok)
+				ok = (expected_bytes == m_transport->ReadBlockData(expected_bytes, cpy_target));
+			m_transport->EndBlock();
 
-			if (len_bytes != (this_length*sizeof(float)))
+			if (!ok)
 			{
-				LogError("Unexpected number of bytes back; aborting acquisition");
+				LogError("Unexpected number of bytes back (%zu, expected %zu); aborting acquisition\n",
+					len_bytes, expected_bytes);
 				std::this_thread::sleep_for(std::chrono::microseconds(100000));
 				m_transport->FlushRXBuffer();
 
@@ -831,17 +842,10 @@ bool RSRTO6Oscilloscope::AcquireData()
 					delete c;
 				}
 
-				delete[] samples;
-
 				return false;
 			}
 
-			unsigned char* cpy_target = dest_buf+(transferred*sizeof(float));
-			// LogDebug("Copying %zuB from %p to %p\n", len_bytes, samples, cpy_target);
-
-			memcpy(cpy_target, samples, len_bytes);
 			transferred += this_length;
-			delete[] samples;
 
 			//Discard trailing newline
 			uint8_t disregard;
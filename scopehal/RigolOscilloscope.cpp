@@ -786,7 +786,6 @@ bool RigolOscilloscope::AcquireData()
 	else if(m_protocol == MSO5)
 		maxpoints = GetSampleDepth();	 //You can use 250E6 points too, but it is very slow
 
-	unsigned char* temp_buf = new unsigned char[(m_highDefinition ? (maxpoints * 2) : maxpoints) + 1];
 	map<int, vector<UniformAnalogWaveform*>> pending_waveforms;
 	for(size_t i = 0; i < m_analogChannelCount; i++)
 	{
@@ -851,8 +850,9 @@ bool RigolOscilloscope::AcquireData()
 			continue;
 
 		//Set up the capture we're going to store our data into
-		auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
-		cap->Resize(0);
+		//Size it for the whole record up front, so chunks can be converted in the background without reallocating
+		auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname(), npoints);
+		cap->Resize(npoints);
 		cap->m_timescale = fs_per_sample;
 		cap->m_triggerPhase = 0;
 		cap->m_startTimestamp = floor(now);
@@ -889,34 +889,20 @@ bool RigolOscilloscope::AcquireData()
 			m_transport->FlushCommandQueue();
 
 			//Read block header, should be maximally 11 long on MSO5 scope with >= 100 MPoints
-			unsigned char header[12] = {0};
-
-			unsigned char header_size;
-			m_transport->ReadRawData(2, header);
-			//LogWarning("Time %f\n", (GetTime() - start));
-
-			sscanf((char*)header, "#%c", &header_size);
-			header_size = header_size - '0';
-
-			if(header_size > 12)
-			{
-				header_size = 12;
-			}
-
-			m_transport->ReadRawData(header_size, header);
-
-			//Look up the block size
-			//size_t blocksize = end - npoints;
-			//LogDebug("Block size = %zu\n", blocksize);
-			size_t header_blocksize;
+			size_t header_blocksize = 0;
 			size_t header_blocksize_bytes;
-			sscanf((char*)header, "%zu", &header_blocksize);
+			if(!m_transport->ReadBlockHeader(header_blocksize))
+				LogWarning("Failed to read block header\n");
 			//LogDebug("Header block size = %zu\n", header_blocksize);
 
 			if(header_blocksize == 0)
 			{
 				LogWarning("Ran out of data after %zu points\n", npoint);
-				m_transport->ReadRawData(1, temp_buf);	  //discard the trailing newline
+				unsigned char newline;
+				m_transport->ReadRawData(1, &newline);	  //discard the trailing newline
+
+				//Make sure nothing is still converting into the waveform before we shrink or free it
+				m_acquisitionPipeline.Flush();
 
 				//If this happened after zero samples, free the waveform so it doesn't leak
 				if(npoint == 0)
@@ -924,6 +910,8 @@ bool RigolOscilloscope::AcquireData()
 					AddWaveformToAnalogPool(cap);
 					cap = nullptr;
 				}
+				else
+					cap->Resize(npoint);
 				break;
 			}
 
@@ -935,6 +923,8 @@ bool RigolOscilloscope::AcquireData()
 			{
 				header_blocksize = maxpoints;
 			}
+			if(header_blocksize > (npoints - npoint))
+				header_blocksize = npoints - npoint;
 
 			//Read actual block content and decode it
 			//Scale: (value - Yorigin - Yref) * Yinc
@@ -946,32 +936,39 @@ bool RigolOscilloscope::AcquireData()
 				float bytes_total = npoints * (m_highDefinition ? 2 : 1);
 				ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, bytes_progress / bytes_total);
 			};
+			auto temp_buf = m_acquisitionPipeline.GetStagingBuffer(bytesToRead);
 			m_transport->ReadRawData(bytesToRead, temp_buf, downloadCallback);
 
+			//Convert this chunk in the background while we download the next one
 			double ydelta = yorigin + yreference;
-			cap->Resize(cap->m_samples.size() + header_blocksize);
-			cap->PrepareForCpuAccess();
-
-			const uint16_t* temp_buf_int16 = m_highDefinition ? reinterpret_cast<const uint16_t*>(temp_buf) : NULL;
-			for(size_t j = 0; j < header_blocksize; j++)
-			{	// Handle 8bit / 16bit acquisition modes
-				float v;
-				if(m_highDefinition)
-				{
- 					v = (((static_cast<float>(temp_buf_int16[j]))) - ydelta) * yincrement;	
-					//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf_int16[j], ydelta, yincrement);
-				}
-				else
+			bool highDefinition = m_highDefinition;
+			bool oldProtocol = (m_protocol == DS_OLD);
+			m_acquisitionPipeline.Submit(temp_buf, header_blocksize,
+				[cap, npoint, ydelta, yincrement, highDefinition, oldProtocol](const uint8_t* raw, size_t count)
 				{
- 					v = (static_cast<float>(temp_buf[j]) - ydelta) * yincrement;	
-					//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf[j], ydelta, yincrement);
-				}
-				if(m_protocol == DS_OLD)
-					v = (128 - static_cast<float>(temp_buf[j])) * yincrement - ydelta;
-				//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, temp_buf[j], ydelta, yincrement);
-				cap->m_samples[npoint + j] = v;
-			}
-			cap->MarkSamplesModifiedFromCpu();
+					cap->PrepareForCpuAccess();
+
+					const uint16_t* raw_int16 = highDefinition ? reinterpret_cast<const uint16_t*>(raw) : NULL;
+					for(size_t j = 0; j < count; j++)
+					{	// Handle 8bit / 16bit acquisition modes
+						float v;
+						if(highDefinition)
+						{
+							v = (((static_cast<float>(raw_int16[j]))) - ydelta) * yincrement;
+							//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, raw_int16[j], ydelta, yincrement);
+						}
+						else
+						{
+							v = (static_cast<float>(raw[j]) - ydelta) * yincrement;
+							//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, raw[j], ydelta, yincrement);
+						}
+						if(oldProtocol)
+							v = (128 - static_cast<float>(raw[j])) * yincrement - ydelta;
+						//LogDebug("V = %.3f, temp=%d, delta=%f, inc=%f\n", v, raw[j], ydelta, yincrement);
+						cap->m_samples[npoint + j] = v;
+					}
+					cap->MarkSamplesModifiedFromCpu();
+				});
 
 			npoint += header_blocksize;
 		}
@@ -983,6 +980,9 @@ bool RigolOscilloscope::AcquireData()
 			pending_waveforms[i].push_back(cap);
 	}
 
+	//Wait for conversion of the last chunks to finish
+	m_acquisitionPipeline.Flush();
+
 	//Now that we have all of the pending waveforms, save them in sets across all channels
 	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	   //TODO: segmented capture support
@@ -998,9 +998,6 @@ bool RigolOscilloscope::AcquireData()
 	}
 	m_pendingWaveformsMutex.unlock();
 
-	//Clean up
-	delete[] temp_buf;
-
 	// Everything is done, and nothing else has anything in its buffer anymore.
 	for(size_t i = 0; i < m_analogChannelCount; i++)
 		ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_NONE, 1.0);
@@ -536,22 +536,16 @@ bool RohdeSchwarzOscilloscope::AcquireData()
 		//Ask for the data
 		m_transport->SendCommand(m_channels[i]->GetHwname() + ":DATA?");
 
-		//Read and discard the length header
-		char tmp[16] = {0};
-		m_transport->ReadRawData(2, (unsigned char*)tmp);
-		int num_digits = atoi(tmp+1);
-		m_transport->ReadRawData(num_digits, (unsigned char*)tmp);
-		//int actual_len = atoi(tmp);
-
 		//Read the actual data.
-		//Super easy, it comes across the wire in IEEE754 already!
+		//Super easy, it comes across the wire in IEEE754 already, so receive it straight into the waveform!
 		cap->Resize(length);
 		cap->PrepareForCpuAccess();
-		m_transport->ReadRawData(length*sizeof(float), (unsigned char*)cap->m_samples.GetCpuPointer());
+		m_transport->ReadBlock(length*sizeof(float), (unsigned char*)cap->m_samples.GetCpuPointer());
 		cap->MarkSamplesModifiedFromCpu();
 
 		//Discard trailing newline
-		m_transport->ReadRawData(1, (unsigned char*)tmp);
+		char tmp;
+		m_transport->ReadRawData(1, (unsigned char*)&tmp);
 
 		//Done, update the data
 		pending_waveforms[i].push_back(cap);
@@ -0,0 +1,161 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RollingSparseWaveform
+	@ingroup datamodel
+ */
+
+#ifndef RollingSparseWaveform_h
+#define RollingSparseWaveform_h
+
+#include "Waveform.h"
+
+/**
+	@brief A sparse waveform which is only ever appended to, keeping a bounded window of the most recent samples
+	@ingroup datamodel
+
+	Meant for producers such as trend plots which add a few samples at a time and drop the oldest ones.
+
+	Offsets are absolute, and are never rewritten as the window moves. Instead, SetBaseOffset() adjusts the trigger
+	phase so that any chosen offset displays at time zero.
+
+	Every consumer of a sparse waveform indexes it from sample zero, so the window is kept contiguous at the start of
+	the buffers rather than wrapping around. To keep appends O(1) amortized, samples are expired in batches of
+	1/16 of the depth. The waveform therefore holds between 15/16 of the depth and the full depth once it has
+	filled up.
+ */
+template<class S>
+class RollingSparseWaveform : public SparseWaveform<S>
+{
+public:
+	RollingSparseWaveform(const std::string& name = "")
+		: SparseWaveform<S>(name)
+		, m_depth(0)
+	{}
+
+	/**
+		@brief Sets the maximum number of samples to keep
+
+		@param depth	Sample count, or zero for no limit
+	 */
+	void SetDepth(size_t depth)
+	{
+		m_depth = depth;
+		if(m_depth && (this->size() > m_depth) )
+			Expire(this->size() - m_depth);
+	}
+
+	///@brief Gets the maximum number of samples to keep (zero for no limit)
+	size_t GetDepth() const
+	{ return m_depth; }
+
+	/**
+		@brief Appends a sample to the end of the waveform, expiring old samples if it is full
+
+		The caller must have called PrepareForCpuAccess() first, and should call MarkModifiedFromCpu() once done
+		appending.
+
+		@param offset	Start time of the sample, in time scale units
+		@param duration	Length of the sample, in time scale units
+		@param sample	Sample value
+	 */
+	void Append(int64_t offset, int64_t duration, const S& sample)
+	{
+		size_t len = this->size();
+		if(m_depth && (len >= m_depth) )
+		{
+			Expire(len + 1 - m_depth + (m_depth / 16));
+			len = this->size();
+		}
+
+		this->Resize(len + 1);
+		this->m_offsets[len] = offset;
+		this->m_durations[len] = duration;
+		this->m_samples[len] = sample;
+	}
+
+	/**
+		@brief Removes the oldest samples from the waveform
+
+		@param count	Number of samples to remove
+	 */
+	void Expire(size_t count)
+	{
+		this->m_offsets.pop_front(count);
+		this->m_durations.pop_front(count);
+		this->m_samples.pop_front(count);
+	}
+
+	/**
+		@brief Moves the waveform along the X axis so that the given offset is displayed at time zero
+
+		@param base	Offset, in time scale units
+	 */
+	void SetBaseOffset(int64_t base)
+	{ this->m_triggerPhase = -base * this->m_timescale; }
+
+	/**
+		@brief Subtracts a constant from every offset, without changing where samples are displayed
+
+		This is O(n), but producers only need to do it occasionally to stop absolute offsets growing without bound.
+
+		@param delta	Amount to subtract, in time scale units
+	 */
+	void RebaseOffsets(int64_t delta)
+	{
+		this->m_offsets.PrepareForCpuAccess();
+		size_t len = this->size();
+		for(size_t i=0; i<len; i++)
+			this->m_offsets[i] -= delta;
+		this->m_offsets.MarkModifiedFromCpu();
+
+		this->m_triggerPhase += delta * this->m_timescale;
+	}
+
+	virtual bool AppendSamples(WaveformBase* src, size_t start, size_t count) override
+	{
+		if(!SparseWaveform<S>::AppendSamples(src, start, count))
+			return false;
+		if(m_depth && (this->size() > m_depth) )
+			Expire(this->size() - m_depth);
+		return true;
+	}
+
+protected:
+
+	///@brief Maximum number of samples to keep, or zero for no limit
+	size_t m_depth;
+};
+
+typedef RollingSparseWaveform<float> RollingSparseAnalogWaveform;
+
+#endif
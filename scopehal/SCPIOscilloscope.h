@@ -48,6 +48,9 @@ protected:
 
 	//Mutexing for thread safety
 	std::recursive_mutex m_cacheMutex;
+
+	///@brief Overlaps waveform download with sample conversion in AcquireData()
+	AcquisitionPipeline m_acquisitionPipeline;
 };
 
 #endif
@@ -42,6 +42,7 @@ using namespace std;
 
 SCPISocketTransport::SCPISocketTransport(const string& args)
 	: m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_rxBuffer(m_socket)
 {
 	char hostname[128];
 	unsigned int port = 0;
@@ -62,6 +63,7 @@ SCPISocketTransport::SCPISocketTransport(const string& args)
 
 SCPISocketTransport::SCPISocketTransport(const string& hostname, unsigned short port)
 	: m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_rxBuffer(m_socket)
 	, m_hostname(hostname)
 	, m_port(port)
 {
@@ -129,25 +131,15 @@ bool SCPISocketTransport::SendCommand(const string& cmd)
 
 string SCPISocketTransport::ReadReply(bool endOnSemicolon)
 {
-	//FIXME: there *has* to be a more efficient way to do this...
-	char tmp = ' ';
 	string ret;
-	while(true)
-	{
-		if(!m_socket.RecvLooped((unsigned char*)&tmp, 1))
-			break;
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
-			break;
-		else
-			ret += tmp;
-	}
+	m_rxBuffer.ReadLine(ret, endOnSemicolon);
 	LogTrace("[%s] Got %s\n", m_hostname.c_str(), ret.c_str());
 	return ret;
 }
 
 void SCPISocketTransport::FlushRXBuffer(void)
 {
-	m_socket.FlushRxBuffer();
+	m_rxBuffer.Flush();
 }
 
 void SCPISocketTransport::SendRawData(size_t len, const unsigned char* buf)
@@ -157,31 +149,8 @@ void SCPISocketTransport::SendRawData(size_t len, const unsigned char* buf)
 
 size_t SCPISocketTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
 {
-	size_t chunk_size = len;
-	if (progress)
-	{
-		/* carve up the chunk_size into either 1% or 32kB chunks, whichever is larger; later, we'll want RecvLooped to do this for us */
-		chunk_size /= 100;
-		if (chunk_size < 32768)
-			chunk_size = 32768;
-	}
-
-	for (size_t pos = 0; pos < len; )
-	{
-		size_t n = chunk_size;
-		if (n > (len - pos))
-			n = len - pos;
-		if(!m_socket.RecvLooped(buf + pos, n))
-		{
-			LogTrace("Failed to get %zu bytes (@ pos %zu)\n", len, pos);
-			return 0;
-		}
-		pos += n;
-		if (progress)
-		{
-			progress((float)pos / (float)len);
-		}
-	}
+	if(!m_rxBuffer.Read(buf, len, progress))
+		return 0;
 
 	LogTrace("Got %zu bytes\n", len);
 	return len;
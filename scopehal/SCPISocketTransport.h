@@ -80,6 +80,9 @@ protected:
 
 	Socket m_socket;
 
+	///@brief Receive buffer shared by ReadReply() and ReadRawData()
+	SocketRxBuffer m_rxBuffer;
+
 	std::string m_hostname;
 	unsigned short m_port;
 };
@@ -242,6 +242,8 @@ void SCPITransport::SendCommandImmediate(string cmd)
 
 /**
 	@brief Sends a command (jumping ahead of the queue) which reads a binary block response
+
+	The returned buffer is allocated with new[] and must be freed by the caller.
  */
 void* SCPITransport::SendCommandImmediateWithRawBlockReply(string cmd, size_t& len)
 {
@@ -251,26 +253,206 @@ void* SCPITransport::SendCommandImmediateWithRawBlockReply(string cmd, size_t& l
 		RateLimitingWait();
 	SendCommand(cmd);
 
-	//Read the length
-	char tmplen[3] = {0};
-	if(2 != ReadRawData(2, (unsigned char*)tmplen))			//expect #n
-		return NULL;
-	if(tmplen[0] == 0)	//Not sure how this happens, but sometimes occurs on Tek MSO6?
-		return NULL;
-	size_t ndigits = stoull(tmplen+1);
-
-	//Read the digits
-	char digits[10] = {0};
-	if(ndigits != ReadRawData(ndigits, (unsigned char*)digits))
+	if(!ReadBlockHeader(len))
 		return NULL;
-	len = stoull(digits);
 
 	//Read the actual data
 	unsigned char* buf = new unsigned char[len];
-	len = ReadRawData(len, buf);
+	len = ReadBlockData(len, buf);
+	EndBlock();
 	return buf;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary block reads
+
+/**
+	@brief Reads the header of an IEEE 488.2 definite-length block
+
+	Any response header preceding the '#' (for example "DAT1,") is discarded.
+
+	@param len	Length of the block payload, in bytes
+
+	@return True on success, false if the header could not be read or was malformed
+ */
+bool SCPITransport::ReadBlockHeader(size_t& len)
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	//Read and discard data until we see the '#'
+	const int maxPrefix = 32;
+	unsigned char c = 0;
+	for(int i=0; ; i++)
+	{
+		if(1 != ReadBlockData(1, &c))
+			return false;
+		if(c == '#')
+			break;
+
+		if(i == maxPrefix)
+		{
+			LogError("ReadBlockHeader: threw away %d bytes of data and never saw a '#'\n", maxPrefix);
+			return false;
+		}
+	}
+
+	//Read length of the length field
+	if(1 != ReadBlockData(1, &c))
+		return false;
+	if( (c < '1') || (c > '9') )
+	{
+		LogError("ReadBlockHeader: indefinite-length or malformed block header (#%c)\n", c);
+		return false;
+	}
+	size_t ndigits = c - '0';
+
+	//Read the actual length field
+	char digits[10] = {0};
+	if(ndigits != ReadBlockData(ndigits, (unsigned char*)digits))
+		return false;
+	len = strtoull(digits, NULL, 10);
+	return true;
+}
+
+/**
+	@brief Reads payload bytes of the block currently being received
+
+	The default implementation is a thin wrapper around ReadRawData(). Transports with their own message framing
+	override this to strip it.
+
+	@return Number of bytes read
+ */
+size_t SCPITransport::ReadBlockData(size_t len, unsigned char* buf, function<void(float)> progress)
+{
+	return ReadRawData(len, buf, progress);
+}
+
+/**
+	@brief Finishes reading a block, discarding any transport framing after it
+
+	The default implementation does nothing.
+ */
+void SCPITransport::EndBlock()
+{
+}
+
+/**
+	@brief Reads a definite-length block into a caller-supplied buffer
+
+	If the block is larger than the buffer, the excess data is read and discarded.
+
+	@param maxsize	Size of the buffer, in bytes
+	@param buf		Buffer to read into
+	@param progress	Optional progress callback
+
+	@return Number of bytes stored in buf, or zero on failure
+ */
+size_t SCPITransport::ReadBlock(size_t maxsize, unsigned char* buf, function<void(float)> progress)
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	size_t len;
+	if(!ReadBlockHeader(len))
+	{
+		EndBlock();
+		return 0;
+	}
+
+	size_t nread = min(len, maxsize);
+	if(nread != ReadBlockData(nread, buf, progress))
+	{
+		LogError("ReadBlock: failed to read %zu bytes of block data\n", nread);
+		EndBlock();
+		return 0;
+	}
+
+	//Discard anything that didn't fit
+	if(len > nread)
+	{
+		LogWarning("ReadBlock: block of %zu bytes exceeds buffer size of %zu, truncating\n", len, maxsize);
+
+		unsigned char trash[4096];
+		for(size_t remaining = len - nread; remaining > 0; )
+		{
+			size_t n = min(remaining, sizeof(trash));
+			if(n != ReadBlockData(n, trash))
+				break;
+			remaining -= n;
+		}
+	}
+
+	EndBlock();
+	return nread;
+}
+
+/**
+	@brief Reads a definite-length block into an AcceleratorBuffer
+
+	The buffer is resized to fit the block and the payload is received directly into its CPU-side memory. Use a
+	pinned (MEM_TYPE_CPU_DMA_CAPABLE) buffer to allow the GPU to consume the data with no further copies.
+
+	@param buf		Buffer to read into
+	@param progress	Optional progress callback
+
+	@return True on success, false on failure
+ */
+bool SCPITransport::ReadBlock(AcceleratorBuffer<uint8_t>& buf, function<void(float)> progress)
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	size_t len;
+	if(!ReadBlockHeader(len))
+	{
+		EndBlock();
+		return false;
+	}
+
+	buf.resize(len);
+	buf.PrepareForCpuAccess();
+	size_t nread = ReadBlockData(len, buf.GetCpuPointer(), progress);
+	buf.MarkModifiedFromCpu();
+	EndBlock();
+
+	if(nread != len)
+	{
+		LogError("ReadBlock: failed to read %zu bytes of block data\n", len);
+		return false;
+	}
+	return true;
+}
+
+/**
+	@brief Reads a definite-length block into a string
+
+	@param buf		String to read into
+	@param progress	Optional progress callback
+
+	@return True on success, false on failure
+ */
+bool SCPITransport::ReadBlock(string& buf, function<void(float)> progress)
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
+	size_t len;
+	if(!ReadBlockHeader(len))
+	{
+		EndBlock();
+		return false;
+	}
+
+	buf.resize(len);
+	size_t nread = ReadBlockData(len, reinterpret_cast<unsigned char*>(&buf[0]), progress);
+	EndBlock();
+
+	if(nread != len)
+	{
+		LogError("ReadBlock: failed to read %zu bytes of block data\n", len);
+		buf.resize(nread);
+		return false;
+	}
+	return true;
+}
+
 void SCPITransport::FlushRXBuffer(void)
 {
 	LogError("SCPITransport::FlushRXBuffer is unimplemented\n");
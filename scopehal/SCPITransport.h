@@ -81,6 +81,20 @@ public:
 	virtual bool IsCommandBatchingSupported() =0;
 	virtual bool IsConnected() =0;
 
+	/*
+		Definite-length binary block API (IEEE 488.2 "#<n><n length digits><payload>")
+
+		Payload data is received directly into the caller's buffer with no intermediate copies. Any terminator
+		following the block is left in the stream for the caller to handle, except on message-framed transports
+		(such as VICP) where EndBlock() discards the remainder of the message.
+	 */
+	bool ReadBlockHeader(size_t& len);
+	virtual size_t ReadBlockData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr);
+	virtual void EndBlock();
+	size_t ReadBlock(size_t maxsize, unsigned char* buf, std::function<void(float)> progress = nullptr);
+	bool ReadBlock(AcceleratorBuffer<uint8_t>& buf, std::function<void(float)> progress = nullptr);
+	bool ReadBlock(std::string& buf, std::function<void(float)> progress = nullptr);
+
 	/**
 		@brief Enables rate limiting. Rate limiting is only applied to the queued command API.
 
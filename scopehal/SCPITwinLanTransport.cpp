@@ -38,6 +38,7 @@ SCPITwinLanTransport::SCPITwinLanTransport(const string& args)
 	: SCPISocketTransport(args)
 	, m_dataport(5026)
 	, m_secondarysocket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_secondaryRxBuffer(m_secondarysocket)
 {
 	//Figure out the data port number
 	char hostname[128] = "";
@@ -85,9 +86,15 @@ string SCPITwinLanTransport::GetConnectionString()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Secondary socket I/O
 
-size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> /*progress*/)
+void SCPITwinLanTransport::FlushRXBuffer(void)
 {
-	if(m_secondarysocket.RecvLooped(buf, len))
+	SCPISocketTransport::FlushRXBuffer();
+	m_secondaryRxBuffer.Flush();
+}
+
+size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
+{
+	if(m_secondaryRxBuffer.Read(buf, len, progress))
 		return len;
 	else
 		return 0;
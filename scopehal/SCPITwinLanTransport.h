@@ -53,6 +53,7 @@ public:
 	unsigned short GetDataPort()
 	{ return m_dataport; }
 
+	virtual void FlushRXBuffer(void) override;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
 	virtual void SendRawData(size_t len, const unsigned char* buf) override;
 
@@ -65,6 +66,9 @@ protected:
 	unsigned short m_dataport;
 
 	Socket m_secondarysocket;
+
+	///@brief Receive buffer for the data plane socket
+	SocketRxBuffer m_secondaryRxBuffer;
 };
 
 #endif
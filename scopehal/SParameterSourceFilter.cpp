@@ -50,6 +50,14 @@ bool SParameterSourceFilter::NeedsConfig()
 	return true;
 }
 
+/**
+	@brief Our S-parameters only change when our configuration does, so there's no need to refresh otherwise
+ */
+bool SParameterSourceFilter::IsRefreshRequired()
+{
+	return HasChangedSinceLastRefresh();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
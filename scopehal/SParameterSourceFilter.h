@@ -45,6 +45,7 @@ public:
 	virtual ~SParameterSourceFilter();
 
 	virtual bool NeedsConfig();
+	virtual bool IsRefreshRequired() override;
 
 	const SParameters& GetParams() const
 	{ return m_params; }
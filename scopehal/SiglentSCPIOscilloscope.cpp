@@ -1547,41 +1547,24 @@ Oscilloscope::TriggerMode SiglentSCPIOscilloscope::PollTrigger()
 
 int SiglentSCPIOscilloscope::ReadWaveformBlock(uint32_t maxsize, char* data, bool hdSizeWorkaround, std::function<void(float)> progress)
 {
-	//Read and discard data until we see the '#'
-	uint8_t tmp;
-	for(int i=0; i<20; i++)
-	{
-		m_transport->ReadRawData(1, &tmp);
-		if(tmp == '#')
-			break;
+	//Plain definite-length block, let the transport handle it
+	if(!hdSizeWorkaround)
+		return m_transport->ReadBlock(maxsize, (unsigned char*)data, progress);
 
-		//shouldn't ever get here
-		if(i == 19)
-		{
-			LogError("ReadWaveformBlock: threw away 20 bytes of data and never saw a '#'\n");
-			return 0;
-		}
+	//In high definition mode, some firmware reports the length in samples rather than bytes.
+	//Parse the header ourselves so we can fix it up.
+	size_t getLength;
+	if(!m_transport->ReadBlockHeader(getLength))
+	{
+		LogError("ReadWaveformBlock: failed to read block header\n");
+		return 0;
 	}
 
-	//Read length of the length field
-	m_transport->ReadRawData(1, &tmp);
-	int lengthOfLength = tmp - '0';
-
-	//Read the actual length field
-	char textlen[10] = {0};
-	m_transport->ReadRawData(lengthOfLength, (unsigned char*)textlen);
-	uint32_t getLength = atoi(textlen);
-
-	uint32_t len = getLength;
-	if(hdSizeWorkaround)
-		len *= 2;
-	len = min(len, maxsize);
+	size_t len = min(getLength * 2, (size_t)maxsize);
+	m_transport->ReadBlockData(len, (unsigned char*)data, progress);
+	m_transport->EndBlock();
 
-	m_transport->ReadRawData(len, (unsigned char*)data, progress);
-
-	if(hdSizeWorkaround)
-		return getLength*2;
-	return getLength;
+	return getLength*2;
 }
 
 /**
@@ -1841,7 +1824,7 @@ vector<WaveformBase*> SiglentSCPIOscilloscope::ProcessAnalogWaveform(const char*
 	return ret;
 }
 
-vector<SparseDigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(const char* data,
+vector<PackedDigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(const char* data,
 	size_t datalen,
 	char* wavedesc,
 	uint32_t num_sequences,
@@ -1850,7 +1833,7 @@ vector<SparseDigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(c
 	double* wavetime,
 	int /*ch*/)
 {
-	vector<SparseDigitalWaveform*> ret;
+	vector<PackedDigitalWaveform*> ret;
 
 	//Parse the wavedesc headers
 	auto pdesc = wavedesc;
@@ -1876,10 +1859,10 @@ vector<SparseDigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(c
 	//We have each channel's data from start to finish before the next (no interleaving).
 	for(size_t numSeq = 0; numSeq < num_sequences; numSeq++)
 	{
-		SparseDigitalWaveform* cap = new SparseDigitalWaveform;
+		PackedDigitalWaveform* cap = new PackedDigitalWaveform;
 		// Since the LA sample rate is a fraction of the sample rate of the analog channels, timescale needs to be updated accordingly
 		cap->m_timescale = round(interval)*digitalToAnalogSampleRatio;
-		cap->PrepareForCpuAccess();
+		cap->m_triggerPhase = 0;
 
 		//Capture timestamp
 		cap->m_startTimestamp = ttime;
@@ -1889,48 +1872,17 @@ vector<SparseDigitalWaveform*> SiglentSCPIOscilloscope::ProcessDigitalWaveform(c
 		else
 			cap->m_startFemtoseconds = static_cast<int64_t>(basetime * FS_PER_SECOND);
 
-		//Preallocate memory assuming no deduplication possible
+		//The scope sends eight samples per byte, LSB first, which is already our layout.
+		//Just gather each group of eight bytes into a word.
 		cap->Resize(numSamples);
-
-		size_t k = 0;
-		size_t sampleIndex = 0;
-		bool sampleValue = false;
-		bool lastSampleValue = false;
-
-
-		//Read and de-duplicate the other samples
-		for (size_t curByteIndex = 0; curByteIndex < datalen; curByteIndex++)
+		cap->PrepareForCpuAccess();
+		uint64_t* words = cap->m_words.GetCpuPointer();
+		for(size_t curByteIndex = 0; curByteIndex < datalen; curByteIndex++)
 		{
-			char samples = data[curByteIndex];
-			for (int ii = 0; ii < 8; ii++, samples >>= 1)
-			{	// Check if the current scope sample bit is set.
-				sampleValue = (samples & 0x1);
-				if((sampleIndex > 0) && (lastSampleValue == sampleValue) && ((sampleIndex + 3) < numSamples))
-				{	//Deduplicate consecutive samples with same value
-					cap->m_durations[k]++;
-				}
-				else
-				{	//Nope, it toggled - store the new value
-					cap->m_offsets[k] = sampleIndex;
-					cap->m_durations[k] = 1;
-					cap->m_samples[k] = sampleValue;
-					lastSampleValue = sampleValue;
-					k++;
-				}
-				sampleIndex++;
-			}
+			uint64_t samples = static_cast<uint8_t>(data[curByteIndex]);
+			words[curByteIndex / 8] |= samples << ((curByteIndex % 8) * 8);
 		}
-
-		//Done, shrink any unused space
-		cap->Resize(k);
-		cap->m_offsets.shrink_to_fit();
-		cap->m_durations.shrink_to_fit();
-		cap->m_samples.shrink_to_fit();
 		cap->MarkSamplesModifiedFromCpu();
-		cap->MarkTimestampsModifiedFromCpu();
-
-		//See how much space we saved
-		//LogDebug("%zu samples deduplicated to %zu (%.1f %%)\n",	numSamples,	k, (k * 100.0f) / (numSamples));
 
 		//Done, save data and go on to next
 		ret.push_back(cap);
@@ -1956,7 +1908,7 @@ bool SiglentSCPIOscilloscope::AcquireData()
 	double basetime = 0;
 	double h_off_frac = 0;
 	vector<vector<WaveformBase*>> waveforms;
-	vector<vector<SparseDigitalWaveform*>> digitalWaveforms;
+	vector<vector<PackedDigitalWaveform*>> digitalWaveforms;
 	unsigned char* pdesc = NULL;
 	string wavetime;
 	bool analogEnabled[MAX_ANALOG] = {false};
@@ -298,7 +298,7 @@ protected:
 		double* wavetime,
 		int i);
 	
-	std::vector<SparseDigitalWaveform*> ProcessDigitalWaveform(const char* data,
+	std::vector<PackedDigitalWaveform*> ProcessDigitalWaveform(const char* data,
 		size_t datalen,
 		char* wavedesc,
 		uint32_t num_sequences,
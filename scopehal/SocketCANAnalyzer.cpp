@@ -189,22 +189,13 @@ bool SocketCANAnalyzer::PopPendingWaveform()
 			auto data = dynamic_cast<CANWaveform*>(it.second);
 			auto nstream = it.first.m_stream;
 
-			//If there is an existing waveform, append to it
-			//TODO: make this more efficient
+			//If there is an existing waveform, append the whole new block to it at once.
+			//Both waveforms count offsets from the start of the capture, so no conversion is needed.
 			auto oldWaveform = dynamic_cast<CANWaveform*>(chan->GetData(nstream));
-			if(oldWaveform && data && m_appendingNext)
+			if(oldWaveform && data && m_appendingNext && oldWaveform->AppendSamples(data, 0, data->size()))
 			{
-				size_t len = data->size();
-				oldWaveform->PrepareForCpuAccess();
-				data->PrepareForCpuAccess();
-				for(size_t i=0; i<len; i++)
-				{
-					oldWaveform->m_samples.push_back(data->m_samples[i]);
-					oldWaveform->m_offsets.push_back(data->m_offsets[i]);
-					oldWaveform->m_durations.push_back(data->m_durations[i]);
-				}
-				oldWaveform->m_revision ++;
-				oldWaveform->MarkModifiedFromCpu();
+				oldWaveform->MarkSamplesAppended();
+				delete data;
 			}
 			else
 				chan->SetData(data, nstream);
@@ -0,0 +1,223 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SocketRxBuffer
+	@ingroup transports
+ */
+
+#include "scopehal.h"
+#include <string.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a receive buffer
+
+	@param socket	Socket to read from. Must outlive the buffer.
+	@param size		Size of the buffer, in bytes
+ */
+SocketRxBuffer::SocketRxBuffer(Socket& socket, size_t size)
+	: m_socket(socket)
+	, m_buffer(size)
+	, m_readPtr(0)
+	, m_writePtr(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Buffer management
+
+/**
+	@brief Receives as much data as the socket has available (blocking until at least one byte arrives)
+
+	@return True on success, false on a socket error or timeout
+ */
+bool SocketRxBuffer::Refill()
+{
+	//Buffer fully consumed, start over from the beginning
+	if(m_readPtr == m_writePtr)
+	{
+		m_readPtr = 0;
+		m_writePtr = 0;
+	}
+
+	//Out of space at the end, move the unconsumed tail to the front
+	else if(m_writePtr == m_buffer.size())
+	{
+		size_t remaining = m_writePtr - m_readPtr;
+		memmove(&m_buffer[0], &m_buffer[m_readPtr], remaining);
+		m_readPtr = 0;
+		m_writePtr = remaining;
+	}
+
+	while(true)
+	{
+		auto len = recv(
+			(ZSOCKET)m_socket,
+			reinterpret_cast<char*>(&m_buffer[m_writePtr]),
+			m_buffer.size() - m_writePtr,
+			0);
+
+		if(len > 0)
+		{
+			m_writePtr += len;
+			return true;
+		}
+
+		#ifndef _WIN32
+		if( (len < 0) && (errno == EINTR) )
+			continue;
+		#endif
+
+		return false;
+	}
+}
+
+/**
+	@brief Discards all buffered data, as well as anything pending in the socket's kernel buffer
+ */
+void SocketRxBuffer::Flush()
+{
+	m_readPtr = 0;
+	m_writePtr = 0;
+	m_socket.FlushRxBuffer();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reading
+
+/**
+	@brief Reads a line of text, not including the terminator
+
+	@param line				Output string. Contains whatever data was received before the failure if we return false.
+	@param endOnSemicolon	True to treat ';' as a terminator in addition to '\n'
+
+	@return True on success, false on a socket error or timeout
+ */
+bool SocketRxBuffer::ReadLine(string& line, bool endOnSemicolon)
+{
+	line.clear();
+
+	while(true)
+	{
+		//Look for a terminator in the data we already have
+		auto start = &m_buffer[m_readPtr];
+		size_t avail = m_writePtr - m_readPtr;
+		auto end = static_cast<uint8_t*>(memchr(start, '\n', avail));
+		if(endOnSemicolon)
+		{
+			size_t searchlen = end ? (end - start) : avail;
+			auto semi = static_cast<uint8_t*>(memchr(start, ';', searchlen));
+			if(semi)
+				end = semi;
+		}
+
+		//Found it, consume everything up to and including the terminator
+		if(end)
+		{
+			size_t len = end - start;
+			line.append(reinterpret_cast<char*>(start), len);
+			m_readPtr += len + 1;
+			return true;
+		}
+
+		//No terminator yet, save what we have and go get more
+		line.append(reinterpret_cast<char*>(start), avail);
+		m_readPtr = m_writePtr;
+		if(!Refill())
+			return false;
+	}
+}
+
+/**
+	@brief Reads exactly len bytes of raw data
+
+	Anything already in the buffer is consumed first. Large reads then bypass the buffer and go straight into the
+	caller's memory.
+
+	@param buf		Output buffer
+	@param len		Number of bytes to read
+	@param progress	Optional callback for reporting fractional completion of large transfers
+
+	@return True on success, false on a socket error or timeout
+ */
+bool SocketRxBuffer::Read(uint8_t* buf, size_t len, function<void(float)> progress)
+{
+	size_t pos = 0;
+
+	//Carve large reads into 1% or 32 kB chunks, whichever is larger, so we can report progress
+	size_t chunkSize = len;
+	if(progress)
+		chunkSize = max(len / 100, (size_t)32768);
+
+	while(pos < len)
+	{
+		size_t remaining = len - pos;
+
+		//Consume buffered data first
+		size_t avail = m_writePtr - m_readPtr;
+		if(avail)
+		{
+			size_t n = min(avail, remaining);
+			memcpy(buf + pos, &m_buffer[m_readPtr], n);
+			m_readPtr += n;
+			pos += n;
+		}
+
+		//Big read: skip the intermediate copy and receive directly into the caller's buffer
+		else if(remaining >= m_buffer.size() / 2)
+		{
+			size_t n = min(remaining, chunkSize);
+			if(!m_socket.RecvLooped(buf + pos, n))
+			{
+				LogTrace("Failed to get %zu bytes (@ pos %zu)\n", len, pos);
+				return false;
+			}
+			pos += n;
+		}
+
+		//Small read: pull in a full buffer worth of data so the next few reads don't need syscalls
+		else if(!Refill())
+		{
+			LogTrace("Failed to get %zu bytes (@ pos %zu)\n", len, pos);
+			return false;
+		}
+
+		if(progress)
+			progress((float)pos / (float)len);
+	}
+
+	return true;
+}
@@ -0,0 +1,80 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SocketRxBuffer
+	@ingroup transports
+ */
+
+#ifndef SocketRxBuffer_h
+#define SocketRxBuffer_h
+
+#include "../xptools/Socket.h"
+
+/**
+	@brief Receive-side buffer shared by the line and raw-data read paths of a socket based transport
+
+	Pulls data from the socket in large chunks rather than one byte per syscall. Line oriented reads scan the buffered
+	data for terminators with memchr(), while large raw reads drain whatever is already buffered and then receive the
+	remainder directly into the caller's buffer with no intermediate copy.
+
+	@ingroup transports
+ */
+class SocketRxBuffer
+{
+public:
+	SocketRxBuffer(Socket& socket, size_t size = 256 * 1024);
+
+	bool ReadLine(std::string& line, bool endOnSemicolon);
+	bool Read(uint8_t* buf, size_t len, std::function<void(float)> progress = nullptr);
+	void Flush();
+
+	///@brief Returns the number of bytes received from the socket but not yet consumed
+	size_t GetBufferedSize() const
+	{ return m_writePtr - m_readPtr; }
+
+protected:
+	bool Refill();
+
+	///@brief The socket we're reading from
+	Socket& m_socket;
+
+	///@brief Backing storage for received data
+	std::vector<uint8_t> m_buffer;
+
+	///@brief Offset of the first unconsumed byte in m_buffer
+	size_t m_readPtr;
+
+	///@brief Offset one past the last valid byte in m_buffer
+	size_t m_writePtr;
+};
+
+#endif
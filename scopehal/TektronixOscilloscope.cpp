@@ -1455,7 +1455,8 @@ bool TektronixOscilloscope::AcquireData()
 		case FAMILY_MSO6:
 			if(!AcquireDataMSO56(pending_waveforms))
 			{
-				//Clean up any partially acquired data
+				//Clean up any partially acquired data, once the pipeline is done converting it
+				m_acquisitionPipeline.Flush();
 				for(auto it : pending_waveforms)
 				{
 					auto vec = it.second;
@@ -1544,6 +1545,9 @@ bool TektronixOscilloscope::AcquireData()
 			break;
 	}
 
+	//Wait for conversion of the last analog channels to finish
+	m_acquisitionPipeline.Flush();
+
 	//Now that we have all of the pending waveforms, save them in sets across all channels
 	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;	//TODO: segmented capture support
@@ -1826,9 +1830,10 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			LogIndenter li2;
 
 			//Read the data block
+			m_transport->SendCommandImmediate("CURV?");
 			size_t nsamples;
-			int8_t* samples = (int8_t*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", nsamples);
-			if(samples == NULL)
+			auto samples = m_acquisitionPipeline.ReadBlock(m_transport, nsamples);
+			if(!samples)
 			{
 				LogWarning("Didn't get any samples (timeout?)\n");
 
@@ -1841,39 +1846,40 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			{
 				LogWarning("Didn't get the right number of points\n");
 
+				m_acquisitionPipeline.Release(samples);
 				ResynchronizeSCPI();
 
-				delete[] samples;
-
 				continue; // retry
 			}
 
 			//Set up the capture we're going to store our data into
 			//(no TDC data or fine timestamping available on Tektronix scopes?)
-			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname(), nsamples);
 			cap->m_timescale = timebase;
 			cap->m_triggerPhase = 0;
 			cap->m_startTimestamp = time(NULL);
 			double t = GetTime();
 			cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
 			cap->Resize(nsamples);
-			cap->PrepareForCpuAccess();
-
-			Convert8BitSamples(
-				cap->m_samples.GetCpuPointer(),
-				samples,
-				preamble.ymult,
-				-preamble.yoff,
-				nsamples);
 
-			cap->MarkSamplesModifiedFromCpu();
+			//Convert in the background while we download the next channel
+			float gain = preamble.ymult;
+			float offset = -preamble.yoff;
+			m_acquisitionPipeline.Submit(samples, nsamples, [cap, gain, offset](const uint8_t* data, size_t n)
+			{
+				cap->PrepareForCpuAccess();
+				Convert8BitSamples(
+					cap->m_samples.GetCpuPointer(),
+					reinterpret_cast<const int8_t*>(data),
+					gain,
+					offset,
+					n);
+				cap->MarkSamplesModifiedFromCpu();
+			});
 
 			//Done, update the data
 			pending_waveforms[i].push_back(cap);
 
-			//Done
-			delete[] samples;
-
 			//Throw out garbage at the end of the message (why is this needed?)
 			if (m_transport->ReadReply() != "")
 				LogWarning("Tek has junk after CURV? reply\n");
@@ -1932,9 +1938,8 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			m_channelOffsets[i] = -preamble.yoff;
 
 			//Read the data block
-			size_t msglen;
-			double* samples = (double*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", msglen);
-			if(samples == NULL)
+			m_transport->SendCommandImmediate("CURV?");
+			if(!m_transport->ReadBlock(m_curveBuffer))
 			{
 				LogWarning("Didn't get any samples (timeout?)\n");
 
@@ -1943,6 +1948,9 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 				continue; // retry
 			}
 
+			size_t msglen = m_curveBuffer.size();
+			auto samples = reinterpret_cast<const double*>(m_curveBuffer.GetCpuPointer());
+
 			size_t nsamples = msglen/8;
 
 			if (nsamples != (size_t)preamble.nr_pt)
@@ -1951,8 +1959,6 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 
 				ResynchronizeSCPI();
 
-				delete[] samples;
-
 				continue; // retry
 			}
 
@@ -1977,9 +1983,6 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			cap->MarkSamplesModifiedFromCpu();
 			pending_waveforms[nchan].push_back(cap);
 
-			//Done
-			delete[] samples;
-
 			//Throw out garbage at the end of the message (why is this needed?)
 			m_transport->ReadReply();
 
@@ -2056,9 +2059,8 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			timebase = preamble.xincrement * FS_PER_SECOND;	//scope gives sec, not fs
 
 			//And the acutal data
-			size_t msglen;
-			char* samples = (char*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", msglen);
-			if(samples == NULL)
+			m_transport->SendCommandImmediate("CURV?");
+			if(!m_transport->ReadBlock(m_curveBuffer))
 			{
 				LogWarning("Didn't get any samples (timeout?)\n");
 
@@ -2067,14 +2069,15 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 				continue; // retry
 			}
 
+			size_t msglen = m_curveBuffer.size();
+			auto samples = reinterpret_cast<const char*>(m_curveBuffer.GetCpuPointer());
+
 			if (msglen != (size_t)preamble.nr_pt)
 			{
 				LogWarning("Didn't get the right number of points\n");
 
 				ResynchronizeSCPI();
 
-				delete[] samples;
-
 				continue; // retry
 			}
 
@@ -2137,9 +2140,6 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 				pending_waveforms[m_digitalChannelBase + i*8 + j].push_back(cap);
 			}
 
-			//Done
-			delete[] samples;
-
 			//Throw out garbage at the end of the message (why is this needed?)
 			m_transport->ReadReply();
 
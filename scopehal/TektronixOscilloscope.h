@@ -228,6 +228,9 @@ protected:
 	///@brief Function generator output
 	FunctionGeneratorChannel* m_awgChannel;
 
+	///@brief Staging buffer for CURV? block data, reused across acquisitions
+	AcceleratorBuffer<uint8_t> m_curveBuffer;
+
 	/**
 		@brief Binary waveform header
 
@@ -36,7 +36,9 @@
  */
 #include "scopehal.h"
 #include "TestWaveformSource.h"
+#include "avx_mathfun.h"
 #include <complex>
+#include <omp.h>
 
 using namespace std;
 
@@ -99,14 +101,14 @@ WaveformBase* TestWaveformSource::GenerateStep(
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
+	float* samples = ret->m_samples.GetCpuPointer();
 	size_t mid = depth/2;
-	for(size_t i=0; i<depth; i++)
+	ParallelBlocks(depth, [&](size_t /*blk*/, size_t istart, size_t iend)
 	{
-		if(i < mid)
-			ret->m_samples[i] = vlo;
-		else
-			ret->m_samples[i] = vhi;
-	}
+		size_t split = min(max(mid, istart), iend);
+		fill(samples + istart, samples + split, vlo);
+		fill(samples + split, samples + iend, vhi);
+	});
 
 	return ret;
 }
@@ -119,6 +121,7 @@ WaveformBase* TestWaveformSource::GenerateStep(
 	@param period		Period of the sine, in femtoseconds
 	@param sampleperiod	Interval between samples, in femtoseconds
 	@param depth		Total number of samples to generate
+	@param downloadCallback	Progress callback, may be null
 	@param noise_stdev	Standard deviation of the AWGN in volts
  */
 WaveformBase* TestWaveformSource::GenerateNoisySinewave(
@@ -134,23 +137,27 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewave(
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
-	normal_distribution<> noise(0, noise_stdev);
-
 	float samples_per_cycle = period * 1.0 / sampleperiod;
 	float radians_per_sample = 2 * M_PI / samples_per_cycle;
 
 	//sin is +/- 1, so need to divide amplitude by 2 to get scaling factor
 	float scale = amplitude / 2;
 
-	for(size_t i=0; i<depth; i++)
+	//Phase is a function of the sample index only, so blocks can be generated independently
+	float* samples = ret->m_samples.GetCpuPointer();
+	ParallelBlocks(depth, [&](size_t blk, size_t istart, size_t iend)
 	{
-		ret->m_samples[i] = scale * sinf(i*radians_per_sample + startphase) + noise(m_rng);
-		if (i % 1024 == 0)
+		for(size_t i=istart; i<iend; i++)
 		{
-			downloadCallback((float)i / (float)depth);
+			samples[i] = scale * sinf(i*radians_per_sample + startphase);
+
+			//Report progress from the first block only, since the blocks all run at about the same speed
+			if(downloadCallback && (blk == 0) && ((i % 1024) == 0) )
+				downloadCallback((float)(i - istart) / (float)(iend - istart));
 		}
-	}
+	});
 
+	AddNoise(samples, depth, noise_stdev);
 	return ret;
 }
 
@@ -164,6 +171,7 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewave(
 	@param period2		Period of the second sine, in femtoseconds
 	@param sampleperiod	Interval between samples, in femtoseconds
 	@param depth		Total number of samples to generate
+	@param downloadCallback	Progress callback, may be null
 	@param noise_stdev	Standard deviation of the AWGN in volts
  */
 WaveformBase* TestWaveformSource::GenerateNoisySinewaveSum(
@@ -181,8 +189,6 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewaveSum(
 	ret->m_timescale = sampleperiod;
 	ret->Resize(depth);
 
-	normal_distribution<> noise(0, noise_stdev);
-
 	float radians_per_sample1 = 2 * M_PI * sampleperiod / period1;
 	float radians_per_sample2 = 2 * M_PI * sampleperiod / period2;
 
@@ -190,18 +196,20 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewaveSum(
 	//Divide by 2 again to avoid clipping the sum of them
 	float scale = amplitude / 4;
 
-	for(size_t i=0; i<depth; i++)
+	float* samples = ret->m_samples.GetCpuPointer();
+	ParallelBlocks(depth, [&](size_t blk, size_t istart, size_t iend)
 	{
-		ret->m_samples[i] = scale *
-			(sinf(i*radians_per_sample1 + startphase1) + sinf(i*radians_per_sample2 + startphase2))
-			+ noise(m_rng);
-		if (i % 1024 == 0)
+		for(size_t i=istart; i<iend; i++)
 		{
-			downloadCallback((float)i / (float)depth);
-		}
+			samples[i] = scale *
+				(sinf(i*radians_per_sample1 + startphase1) + sinf(i*radians_per_sample2 + startphase2));
 
-	}
+			if(downloadCallback && (blk == 0) && ((i % 1024) == 0) )
+				downloadCallback((float)(i - istart) / (float)(iend - istart));
+		}
+	});
 
+	AddNoise(samples, depth, noise_stdev);
 	return ret;
 }
 
@@ -214,6 +222,7 @@ WaveformBase* TestWaveformSource::GenerateNoisySinewaveSum(
 	@param period		Unit interval, in femtoseconds
 	@param sampleperiod	Interval between samples, in femtoseconds
 	@param depth		Total number of samples to generate
+	@param downloadCallback	Progress callback, may be null
 	@param lpf			Emulate a lossy channel if true, no channel emulation if false
 	@param noise_stdev	Standard deviation of the AWGN in volts
  */
@@ -229,52 +238,53 @@ WaveformBase* TestWaveformSource::GeneratePRBS31(
 	float noise_stdev
 	)
 {
-	auto ret = new UniformAnalogWaveform("PRBS31");
-	ret->m_timescale = sampleperiod;
-	ret->Resize(depth);
-
-	//Generate the PRBS as a square wave. Interpolate zero crossings as needed.
-	uint32_t prbs = rand();
-	float scale = amplitude / 2;
-	float phase_to_next_edge = period;
-	bool value = false;
-	for(size_t i=0; i<depth; i++)
-	{
-		//Increment phase accumulator
-		float last_phase = phase_to_next_edge;
-		phase_to_next_edge -= sampleperiod;
-
-		bool last = value;
-		if(phase_to_next_edge < 0)
-		{
-			uint32_t next = ( (prbs >> 30) ^ (prbs >> 27) ) & 1;
-			prbs = (prbs << 1) | next;
-			value = next;
-
-			phase_to_next_edge += period;
-		}
+	return GeneratePRBS(
+		cmdBuf, queue, PRBS_31, amplitude, period, sampleperiod, depth, downloadCallback, lpf, noise_stdev);
+}
 
-		//Not an edge, just repeat the value
-		if(last == value)
-			ret->m_samples[i] = value ? scale : -scale;
+/**
+	@brief Generates a PRBS waveform through a lossy channel with AWGN
 
-		//Edge - interpolate
-		else
-		{
-			float last_voltage = last ? scale : -scale;
-			float cur_voltage = value ? scale : -scale;
+	Each block of the waveform jumps the LFSR directly to its first bit, so the output does not depend on how many
+	threads it was generated with.
 
-			float frac = 1 - (last_phase / sampleperiod);
-			float delta = cur_voltage - last_voltage;
+	@param cmdBuf		Vulkan command buffer to use for channel emulation
+	@param queue		Vulkan queue to use for channel emulation
+	@param poly			PRBS polynomial
+	@param amplitude	P-P amplitude of the waveform in volts
+	@param period		Unit interval, in femtoseconds
+	@param sampleperiod	Interval between samples, in femtoseconds
+	@param depth		Total number of samples to generate
+	@param downloadCallback	Progress callback, may be null
+	@param lpf			Emulate a lossy channel if true, no channel emulation if false
+	@param noise_stdev	Standard deviation of the AWGN in volts
+ */
+WaveformBase* TestWaveformSource::GeneratePRBS(
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	PRBSPolynomial poly,
+	float amplitude,
+	float period,
+	int64_t sampleperiod,
+	size_t depth,
+	std::function<void(float)> downloadCallback,
+	bool lpf,
+	float noise_stdev)
+{
+	auto ret = new UniformAnalogWaveform(string("PRBS") + to_string(poly));
+	ret->m_timescale = sampleperiod;
+	ret->Resize(depth);
 
-			ret->m_samples[i] = last_voltage + delta*frac;
-		}
+	//Random nonzero starting state
+	uint32_t mask = (1U << poly) - 1;
+	uint32_t seed = m_rng() & mask;
+	if(seed == 0)
+		seed = 1;
 
-		if (i % 1024 == 0)
-		{
-			downloadCallback((float)i / (float)depth);
-		}
-	}
+	RenderSerialData(ret, amplitude, period, sampleperiod, depth,
+		[&](uint64_t firstbit, size_t nbits, uint8_t* bits)
+		{ GeneratePRBSBits(poly, seed, firstbit, nbits, bits); },
+		downloadCallback);
 
 	DegradeSerialData(ret, sampleperiod, depth, lpf, noise_stdev, cmdBuf, queue);
 
@@ -290,6 +300,7 @@ WaveformBase* TestWaveformSource::GeneratePRBS31(
 	@param period		Unit interval, in femtoseconds
 	@param sampleperiod	Interval between samples, in femtoseconds
 	@param depth		Total number of samples to generate
+	@param downloadCallback	Progress callback, may be null
 	@param lpf			Emulate a lossy channel if true, no channel emulation if false
 	@param noise_stdev	Standard deviation of the AWGN in volts
  */
@@ -309,58 +320,98 @@ WaveformBase* TestWaveformSource::Generate8b10b(
 	ret->Resize(depth);
 
 	const int patternlen = 20;
-	const bool pattern[patternlen] =
+	const uint8_t pattern[patternlen] =
 	{
 		0, 0, 1, 1, 1, 1, 1, 0, 1, 0,		//K28.5
 		1, 0, 0, 1, 0, 0, 0, 1, 0, 1		//D16.2
 	};
 
-	//Generate the data stream as a square wave. Interpolate zero crossings as needed.
+	RenderSerialData(ret, amplitude, period, sampleperiod, depth,
+		[&](uint64_t firstbit, size_t nbits, uint8_t* bits)
+		{
+			size_t nbit = firstbit % patternlen;
+			for(size_t i=0; i<nbits; i++)
+			{
+				bits[i] = pattern[nbit ++];
+				if(nbit >= patternlen)
+					nbit = 0;
+			}
+		},
+		downloadCallback);
+
+	DegradeSerialData(ret, sampleperiod, depth, lpf, noise_stdev, cmdBuf, queue);
+
+	return ret;
+}
+
+/**
+	@brief Renders a serial bit stream as a square wave, interpolating zero crossings as needed
+
+	Sample i falls in unit interval floor(i * sampleperiod / period). Each block of samples asks getBits for the
+	span of bits it covers, starting with the bit under the sample just before the block, so blocks can be rendered
+	in parallel with identical results.
+
+	@param cap				Waveform to write to, already sized to depth
+	@param amplitude		P-P amplitude of the waveform in volts
+	@param period			Unit interval, in femtoseconds
+	@param sampleperiod		Interval between samples, in femtoseconds
+	@param depth			Total number of samples to generate
+	@param getBits			Called as getBits(firstbit, nbits, bits) to fill bits[] with one bit per byte
+	@param downloadCallback	Progress callback, may be null
+ */
+void TestWaveformSource::RenderSerialData(
+	UniformAnalogWaveform* cap,
+	float amplitude,
+	float period,
+	int64_t sampleperiod,
+	size_t depth,
+	const function<void(uint64_t, size_t, uint8_t*)>& getBits,
+	const function<void(float)>& downloadCallback)
+{
 	float scale = amplitude / 2;
-	float phase_to_next_edge = period;
-	bool value = false;
-	int nbit = 0;
-	for(size_t i=0; i<depth; i++)
+	double uiPerSample = (double)sampleperiod / period;
+	float* samples = cap->m_samples.GetCpuPointer();
+
+	ParallelBlocks(depth, [&](size_t blk, size_t istart, size_t iend)
 	{
-		//Increment phase accumulator
-		float last_phase = phase_to_next_edge;
-		phase_to_next_edge -= sampleperiod;
+		if(istart >= iend)
+			return;
 
-		bool last = value;
-		if(phase_to_next_edge < 0)
+		uint64_t firstbit = istart ? (uint64_t)((istart - 1) * uiPerSample) : 0;
+		uint64_t lastbit = (uint64_t)((iend - 1) * uiPerSample);
+		vector<uint8_t> bits(lastbit - firstbit + 1);
+		getBits(firstbit, bits.size(), bits.data());
+
+		uint64_t lastui = istart ? firstbit : 0;
+		for(size_t i=istart; i<iend; i++)
 		{
-			value = pattern[nbit ++];
-			if(nbit >= patternlen)
-				nbit = 0;
+			double ui = i * uiPerSample;
+			uint64_t nui = (uint64_t)ui;
 
-			phase_to_next_edge += period;
-		}
+			bool last = bits[lastui - firstbit];
+			bool value = bits[nui - firstbit];
+			lastui = nui;
 
-		//Not an edge, just repeat the value
-		if(last == value)
-			ret->m_samples[i] = value ? scale : -scale;
+			//Not an edge, just repeat the value
+			if(last == value)
+				samples[i] = value ? scale : -scale;
 
-		//Edge - interpolate
-		else
-		{
-			float last_voltage = last ? scale : -scale;
-			float cur_voltage = value ? scale : -scale;
+			//Edge - interpolate by how far past the edge this sample is
+			else
+			{
+				float last_voltage = last ? scale : -scale;
+				float cur_voltage = value ? scale : -scale;
 
-			float frac = 1 - (last_phase / sampleperiod);
-			float delta = cur_voltage - last_voltage;
+				float frac = (ui - nui) / uiPerSample;
+				float delta = cur_voltage - last_voltage;
 
-			ret->m_samples[i] = last_voltage + delta*frac;
-		}
+				samples[i] = last_voltage + delta*frac;
+			}
 
-		if (i % 1024 == 0)
-		{
-			downloadCallback((float)i / (float)depth);
+			if(downloadCallback && (blk == 0) && ((i % 1024) == 0) )
+				downloadCallback((float)(i - istart) / (float)(iend - istart));
 		}
-	}
-
-	DegradeSerialData(ret, sampleperiod, depth, lpf, noise_stdev, cmdBuf, queue);
-
-	return ret;
+	});
 }
 
 /**
@@ -389,9 +440,6 @@ void TestWaveformSource::DegradeSerialData(
 	//assume input came from CPU
 	cap->MarkModifiedFromCpu();
 
-	//RNGs
-	normal_distribution<> noise(0, noise_stdev);
-
 	//Prepare for second pass: reallocate FFT buffer if sample depth changed
 	const size_t npoints = next_pow2(depth);
 	size_t nouts = npoints/2 + 1;
@@ -491,18 +539,23 @@ void TestWaveformSource::DegradeSerialData(
 
 		//Rescale the FFT output and copy to the output, then add noise
 		float fftscale = 1.0f / npoints;
-		for(size_t i=0; i<finalLen; i++)
-			cap->m_samples[i] = m_reverseOutBuf[i + istart] * fftscale + noise(m_rng);
+		float* dst = cap->m_samples.GetCpuPointer();
+		const float* src = m_reverseOutBuf.GetCpuPointer() + istart;
+		ParallelBlocks(finalLen, [&](size_t /*blk*/, size_t bstart, size_t bend)
+		{
+			for(size_t i=bstart; i<bend; i++)
+				dst[i] = src[i] * fftscale;
+		});
+		AddNoise(dst, finalLen, noise_stdev);
 
 		//Resize the waveform to truncate garbage at the end
 		cap->Resize(finalLen);
 	}
 
 	else
-	{
-		for(size_t i=0; i<depth; i++)
-			cap->m_samples[i] += noise(m_rng);
-	}
+		AddNoise(cap->m_samples.GetCpuPointer(), depth, noise_stdev);
+
+	cap->MarkModifiedFromCpu();
 }
 
 /**
@@ -534,3 +587,329 @@ void TestWaveformSource::InterpolateSparameters(float bin_hz, size_t nouts)
 	m_resampledSparamSines.MarkModifiedFromCpu();
 	m_resampledSparamCosines.MarkModifiedFromCpu();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Threading helpers
+
+/**
+	@brief Splits a waveform into one block per thread and runs body(block, istart, iend) on each in parallel
+
+	Small waveforms aren't worth the threading overhead and run as a single block on the calling thread. Block
+	boundaries are multiples of 64 samples.
+ */
+void TestWaveformSource::ParallelBlocks(size_t len, const function<void(size_t, size_t, size_t)>& body)
+{
+	size_t numblocks = 1;
+	if(len >= 1024*1024)
+		numblocks = omp_get_max_threads();
+	if(numblocks <= 1)
+	{
+		body(0, 0, len);
+		return;
+	}
+
+	size_t lastblock = numblocks - 1;
+	size_t blocksize = len / numblocks;
+	blocksize = blocksize - (blocksize % 64);
+
+	#pragma omp parallel for
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t istart = i*blocksize;
+		size_t iend = istart + blocksize;
+		if(i == lastblock)
+			iend = len;
+
+		body(i, istart, iend);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Noise generation
+
+/**
+	@brief Hashes a 32-bit counter under a key (murmur3 finalizer)
+
+	This is the whole random number generator: noise for each sample is a pure function of its index and the key,
+	so any block of a waveform can be generated independently of the others.
+ */
+static inline uint32_t NoiseHash(uint32_t key, uint32_t ctr)
+{
+	uint32_t h = ctr*0x9e3779b9 + key;
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+/**
+	@brief Adds AWGN to a buffer of samples
+
+	Samples are taken in pairs and each pair gets both outputs of one Box-Muller transform, with the uniform inputs
+	coming from a counter-based hash of the pair index. The keys are drawn from our RNG once per call, so output is
+	reproducible for a given RNG state no matter how many threads are used. The counter is 32 bits, so the noise
+	repeats every 8G samples.
+
+	@param samples		Samples to add noise to
+	@param len			Number of samples
+	@param noise_stdev	Standard deviation of the noise, in volts
+ */
+void TestWaveformSource::AddNoise(float* samples, size_t len, float noise_stdev)
+{
+	uint32_t key1 = m_rng();
+	uint32_t key2 = m_rng();
+	if(noise_stdev <= 0)
+		return;
+
+	ParallelBlocks(len, [&](size_t /*blk*/, size_t istart, size_t iend)
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			AddNoiseAVX2(samples, istart, iend, noise_stdev, key1, key2);
+		else
+		#endif
+			AddNoiseGeneric(samples, istart, iend, noise_stdev, key1, key2);
+	});
+}
+
+/**
+	@brief Adds AWGN to samples[istart, iend)
+ */
+void TestWaveformSource::AddNoiseGeneric(
+	float* samples,
+	size_t istart,
+	size_t iend,
+	float noise_stdev,
+	uint32_t key1,
+	uint32_t key2)
+{
+	const float scale = 1.0f / 16777216;
+	for(size_t pair = istart/2; pair*2 < iend; pair++)
+	{
+		//Uniform values in (0, 1] and [0, 1)
+		float u1 = ((NoiseHash(key1, pair) >> 8) + 1) * scale;
+		float u2 = (NoiseHash(key2, pair) >> 8) * scale;
+
+		float mag = noise_stdev * sqrtf(-2 * logf(u1));
+		float theta = 2 * M_PI * u2;
+
+		size_t i = pair*2;
+		if(i >= istart)
+			samples[i] += mag * cosf(theta);
+		if(i+1 < iend)
+			samples[i+1] += mag * sinf(theta);
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief Adds AWGN to samples[istart, iend), eight Box-Muller transforms at a time
+
+	Generates the same sequence as AddNoiseGeneric() to within the accuracy of the vectorized log and sincos.
+ */
+__attribute__((target("avx2")))
+void TestWaveformSource::AddNoiseAVX2(
+	float* samples,
+	size_t istart,
+	size_t iend,
+	float noise_stdev,
+	uint32_t key1,
+	uint32_t key2)
+{
+	//Vector loop has to start on an even sample so it lines up with the pairs
+	size_t i = istart;
+	if(i & 1)
+	{
+		AddNoiseGeneric(samples, i, i+1, noise_stdev, key1, key2);
+		i++;
+	}
+
+	__m256i vkey1		= _mm256_set1_epi32(key1);
+	__m256i vkey2		= _mm256_set1_epi32(key2);
+	__m256i vgolden		= _mm256_set1_epi32(0x9e3779b9);
+	__m256i vmul1		= _mm256_set1_epi32(0x85ebca6b);
+	__m256i vmul2		= _mm256_set1_epi32(0xc2b2ae35);
+	__m256i vone		= _mm256_set1_epi32(1);
+	__m256i vlanes		= _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	__m256 vscale		= _mm256_set1_ps(1.0f / 16777216);
+	__m256 vmtwo		= _mm256_set1_ps(-2.0f);
+	__m256 vtpi			= _mm256_set1_ps(M_PI * 2);
+	__m256 vsigma		= _mm256_set1_ps(noise_stdev);
+
+	for(; i + 16 <= iend; i += 16)
+	{
+		__m256i ctr = _mm256_add_epi32(_mm256_set1_epi32(i/2), vlanes);
+		ctr = _mm256_mullo_epi32(ctr, vgolden);
+
+		//Hash the pair indexes under both keys
+		__m256i h1 = _mm256_add_epi32(ctr, vkey1);
+		__m256i h2 = _mm256_add_epi32(ctr, vkey2);
+		h1 = _mm256_xor_si256(h1, _mm256_srli_epi32(h1, 16));
+		h2 = _mm256_xor_si256(h2, _mm256_srli_epi32(h2, 16));
+		h1 = _mm256_mullo_epi32(h1, vmul1);
+		h2 = _mm256_mullo_epi32(h2, vmul1);
+		h1 = _mm256_xor_si256(h1, _mm256_srli_epi32(h1, 13));
+		h2 = _mm256_xor_si256(h2, _mm256_srli_epi32(h2, 13));
+		h1 = _mm256_mullo_epi32(h1, vmul2);
+		h2 = _mm256_mullo_epi32(h2, vmul2);
+		h1 = _mm256_xor_si256(h1, _mm256_srli_epi32(h1, 16));
+		h2 = _mm256_xor_si256(h2, _mm256_srli_epi32(h2, 16));
+
+		//Convert to uniform values in (0, 1] and [0, 1)
+		h1 = _mm256_add_epi32(_mm256_srli_epi32(h1, 8), vone);
+		h2 = _mm256_srli_epi32(h2, 8);
+		__m256 u1 = _mm256_mul_ps(_mm256_cvtepi32_ps(h1), vscale);
+		__m256 u2 = _mm256_mul_ps(_mm256_cvtepi32_ps(h2), vscale);
+
+		//Apply Box-Muller transformation
+		__m256 mag		= _mm256_log_ps(u1);
+		mag				= _mm256_mul_ps(mag, vmtwo);
+		mag				= _mm256_sqrt_ps(mag);
+		mag				= _mm256_mul_ps(mag, vsigma);
+		__m256 theta	= _mm256_mul_ps(u2, vtpi);
+		__m256 vsin;
+		__m256 vcos;
+		_mm256_sincos_ps(theta, &vsin, &vcos);
+		vcos			= _mm256_mul_ps(mag, vcos);
+		vsin			= _mm256_mul_ps(mag, vsin);
+
+		//Interleave so each pair gets (cos, sin)
+		__m256 lo		= _mm256_unpacklo_ps(vcos, vsin);
+		__m256 hi		= _mm256_unpackhi_ps(vcos, vsin);
+		__m256 norm1	= _mm256_permute2f128_ps(lo, hi, 0x20);
+		__m256 norm2	= _mm256_permute2f128_ps(lo, hi, 0x31);
+
+		//Add the noise
+		_mm256_storeu_ps(samples + i, _mm256_add_ps(_mm256_loadu_ps(samples + i), norm1));
+		_mm256_storeu_ps(samples + i + 8, _mm256_add_ps(_mm256_loadu_ps(samples + i + 8), norm2));
+	}
+
+	//Process the last few samples
+	if(i < iend)
+		AddNoiseGeneric(samples, i, iend, noise_stdev, key1, key2);
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRBS generation
+
+/**
+	@brief Gets the feedback taps of a PRBS polynomial
+
+	Taps are numbered from 1 = most recent bit, so the LFSR computes b[n] = b[n - order] ^ b[n - tap].
+ */
+static unsigned GetPRBSTap(TestWaveformSource::PRBSPolynomial poly)
+{
+	switch(poly)
+	{
+		case TestWaveformSource::PRBS_7:
+			return 6;
+
+		case TestWaveformSource::PRBS_15:
+			return 14;
+
+		case TestWaveformSource::PRBS_23:
+			return 18;
+
+		case TestWaveformSource::PRBS_31:
+		default:
+			return 28;
+	}
+}
+
+/**
+	@brief Advances a PRBS LFSR by an arbitrary number of bits in O(log nbits) time
+
+	The LFSR is a linear map over GF(2), so we raise its transition matrix to the nbits'th power by repeated
+	squaring. Matrices are stored as one column bitmask per state bit.
+
+	The state uses the same layout as PRBSGeneratorFilter::RunPRBS(): bit 0 is the most recently generated bit.
+
+	@param state	Starting LFSR state
+	@param poly		PRBS polynomial
+	@param nbits	Number of bits to advance by
+
+	@return The state after nbits more bits have been generated
+ */
+uint32_t TestWaveformSource::JumpPRBS(uint32_t state, PRBSPolynomial poly, uint64_t nbits)
+{
+	unsigned order = poly;
+	unsigned tap = GetPRBSTap(poly);
+	uint32_t mask = (1U << order) - 1;
+
+	auto apply = [&](const uint32_t* m, uint32_t v)
+	{
+		uint32_t ret = 0;
+		for(unsigned j=0; j<order; j++)
+		{
+			if(v & (1U << j))
+				ret ^= m[j];
+		}
+		return ret;
+	};
+
+	//Single step transition matrix
+	uint32_t base[32];
+	for(unsigned j=0; j<order; j++)
+	{
+		uint32_t s = 1U << j;
+		uint32_t next = ( (s >> (order-1)) ^ (s >> (tap-1)) ) & 1;
+		base[j] = ((s << 1) | next) & mask;
+	}
+
+	state &= mask;
+	uint32_t tmp[32];
+	while(nbits)
+	{
+		if(nbits & 1)
+			state = apply(base, state);
+
+		//Square the matrix
+		for(unsigned j=0; j<order; j++)
+			tmp[j] = apply(base, base[j]);
+		memcpy(base, tmp, order * sizeof(uint32_t));
+
+		nbits >>= 1;
+	}
+	return state;
+}
+
+/**
+	@brief Generates a span of a PRBS, one bit per byte
+
+	Jumps the LFSR to the first requested bit, then generates up to (tap) bits per step: every bit in a step depends
+	only on bits at least (tap) positions back, which are all already in the state word.
+
+	@param poly			PRBS polynomial
+	@param state		LFSR state at the start of the sequence
+	@param firstbit		Index of the first bit to generate
+	@param nbits		Number of bits to generate
+	@param bits			Output buffer
+ */
+void TestWaveformSource::GeneratePRBSBits(
+	PRBSPolynomial poly,
+	uint32_t state,
+	uint64_t firstbit,
+	size_t nbits,
+	uint8_t* bits)
+{
+	unsigned order = poly;
+	unsigned tap = GetPRBSTap(poly);
+
+	//History word, bit 0 is the most recent bit
+	uint64_t h = JumpPRBS(state, poly, firstbit);
+	for(size_t i=0; i<nbits; )
+	{
+		size_t k = min((size_t)tap, nbits - i);
+		uint64_t w = ( (h >> (order - k)) ^ (h >> (tap - k)) ) & ((1ULL << k) - 1);
+		h = (h << k) | w;
+
+		//Oldest bit of the step is the MSB
+		for(size_t t=0; t<k; t++)
+			bits[i+t] = (w >> (k - 1 - t)) & 1;
+		i += k;
+	}
+}
@@ -76,6 +76,27 @@ public:
 		std::function<void(float)> downloadCallback,
 		float noise_stdev = 0.01);
 
+	///@brief PRBS polynomials supported by GeneratePRBS(), numbered by the order of the polynomial
+	enum PRBSPolynomial
+	{
+		PRBS_7 = 7,
+		PRBS_15 = 15,
+		PRBS_23 = 23,
+		PRBS_31 = 31
+	};
+
+	WaveformBase* GeneratePRBS(
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		PRBSPolynomial poly,
+		float amplitude,
+		float period,
+		int64_t sampleperiod,
+		size_t depth,
+		std::function<void(float)> downloadCallback,
+		bool lpf = true,
+		float noise_stdev = 0.01);
+
 	WaveformBase* GeneratePRBS31(
 		vk::raii::CommandBuffer& cmdBuf,
 		std::shared_ptr<QueueHandle> queue,
@@ -113,7 +134,27 @@ public:
 		vk::raii::CommandBuffer& cmdBuf,
 		std::shared_ptr<QueueHandle> queue);
 
+	void AddNoise(float* samples, size_t len, float noise_stdev);
+
+	static uint32_t JumpPRBS(uint32_t state, PRBSPolynomial poly, uint64_t nbits);
+	static void GeneratePRBSBits(PRBSPolynomial poly, uint32_t state, uint64_t firstbit, size_t nbits, uint8_t* bits);
+
 protected:
+	static void ParallelBlocks(size_t len, const std::function<void(size_t, size_t, size_t)>& body);
+
+	void RenderSerialData(
+		UniformAnalogWaveform* cap,
+		float amplitude,
+		float period,
+		int64_t sampleperiod,
+		size_t depth,
+		const std::function<void(uint64_t, size_t, uint8_t*)>& getBits,
+		const std::function<void(float)>& downloadCallback);
+
+	static void AddNoiseGeneric(float* samples, size_t istart, size_t iend, float noise_stdev, uint32_t key1, uint32_t key2);
+#ifdef __x86_64__
+	static void AddNoiseAVX2(float* samples, size_t istart, size_t iend, float noise_stdev, uint32_t key1, uint32_t key2);
+#endif
 
 	///@brief Random number generator
 	std::minstd_rand& m_rng;
@@ -362,7 +362,7 @@ bool ThunderScopeOscilloscope::AcquireData()
 			abuf->MarkModifiedFromCpu();
 
 			//Create our waveform
-			UniformAnalogWaveform* cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+			UniformAnalogWaveform* cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname(), memdepth);
 			cap->m_timescale = fs_per_sample;
 			cap->m_triggerPhase = trigphase;
 			cap->m_startTimestamp = time(NULL);
@@ -50,6 +50,10 @@ VICPSocketTransport::VICPSocketTransport(const string& args)
 	: m_nextSequence(1)
 	, m_lastSequence(1)
 	, m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_rxBuffer(m_socket)
+	, m_blockFrameRemaining(0)
+	, m_blockFrameEOI(false)
+	, m_blockInMessage(false)
 {
 	char hostname[128];
 	unsigned int port = 0;
@@ -223,16 +227,125 @@ void VICPSocketTransport::SendRawData(size_t len, const unsigned char* buf)
 	m_socket.SendLooped(buf, len);
 }
 
-size_t VICPSocketTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> /*progress*/)
+size_t VICPSocketTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
 {
-	if(!m_socket.RecvLooped(buf, len))
+	if(!m_rxBuffer.Read(buf, len, progress))
 		return 0;
 	return len;
 }
 
 void VICPSocketTransport::FlushRXBuffer(void)
 {
-	m_socket.FlushRxBuffer();
+	m_rxBuffer.Flush();
+	m_blockFrameRemaining = 0;
+	m_blockFrameEOI = false;
+	m_blockInMessage = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary block reads
+
+/**
+	@brief Reads the header of the next VICP frame for ReadBlockData()
+
+	Empty frames with EOI set ahead of any data are skipped, same as ReadReply() does.
+
+	@return True on success, false on a socket error or bad header
+ */
+bool VICPSocketTransport::ReadFrameHeader()
+{
+	while(true)
+	{
+		unsigned char header[8];
+		if(!m_rxBuffer.Read(header, sizeof(header)))
+			return false;
+
+		if(header[1] != 1)
+		{
+			LogError("Bad VICP protocol version\n");
+			return false;
+		}
+		if(header[3] != 0)
+		{
+			LogError("Bad VICP reserved field\n");
+			return false;
+		}
+
+		m_blockFrameRemaining = (header[4] << 24) | (header[5] << 16) | (header[6] << 8) | header[7];
+		m_blockFrameEOI = (header[0] & OP_EOI) != 0;
+
+		if(m_blockFrameRemaining != 0)
+		{
+			m_blockInMessage = true;
+			return true;
+		}
+		if(!m_blockFrameEOI || m_blockInMessage)
+			return true;
+	}
+}
+
+/**
+	@brief Reads block payload data, stripping VICP framing
+
+	The payload goes straight from the receive buffer (or the socket, for large frames) into the caller's memory.
+ */
+size_t VICPSocketTransport::ReadBlockData(size_t len, unsigned char* buf, std::function<void(float)> progress)
+{
+	size_t pos = 0;
+	while(pos < len)
+	{
+		//Need a new frame
+		if(m_blockFrameRemaining == 0)
+		{
+			if(m_blockFrameEOI)
+			{
+				LogError("VICP message ended %zu bytes before the end of the block\n", len - pos);
+				break;
+			}
+			if(!ReadFrameHeader())
+				break;
+			continue;
+		}
+
+		//Read as much of this frame as we need
+		size_t n = min(len - pos, m_blockFrameRemaining);
+		function<void(float)> frameProgress = nullptr;
+		if(progress)
+			frameProgress = [&](float f) { progress((pos + f*n) / len); };
+		if(!m_rxBuffer.Read(buf + pos, n, frameProgress))
+			break;
+
+		pos += n;
+		m_blockFrameRemaining -= n;
+	}
+
+	return pos;
+}
+
+/**
+	@brief Discards the remainder of the current VICP message (typically the trailing newline)
+ */
+void VICPSocketTransport::EndBlock()
+{
+	unsigned char trash[256];
+	while(m_blockInMessage && !(m_blockFrameEOI && (m_blockFrameRemaining == 0)))
+	{
+		if(m_blockFrameRemaining == 0)
+		{
+			if(!ReadFrameHeader())
+				break;
+			continue;
+		}
+
+		size_t n = min(sizeof(trash), m_blockFrameRemaining);
+		if(!m_rxBuffer.Read(trash, n))
+			break;
+		m_blockFrameRemaining -= n;
+	}
+
+	m_blockFrameRemaining = 0;
+	m_blockFrameEOI = false;
+	m_blockInMessage = false;
 }
 
 bool VICPSocketTransport::IsCommandBatchingSupported()
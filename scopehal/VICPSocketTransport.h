@@ -71,6 +71,9 @@ public:
 
 	virtual void FlushRXBuffer() override;
 
+	virtual size_t ReadBlockData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+	virtual void EndBlock() override;
+
 	///@brief VICP header opcode values
 	enum HEADER_OPS
 	{
@@ -100,6 +103,7 @@ public:
 
 protected:
 	uint8_t GetNextSequenceNumber();
+	bool ReadFrameHeader();
 
 	///@brief Next sequence number
 	uint8_t m_nextSequence;
@@ -110,6 +114,18 @@ protected:
 	///@brief Socket for communicating with the scope
 	Socket m_socket;
 
+	///@brief Receive buffer for m_socket, so VICP headers don't each cost a syscall
+	SocketRxBuffer m_rxBuffer;
+
+	///@brief Payload bytes left in the VICP frame currently being read by ReadBlockData()
+	size_t m_blockFrameRemaining;
+
+	///@brief True if the VICP frame currently being read by ReadBlockData() is the last one in its message
+	bool m_blockFrameEOI;
+
+	///@brief True if ReadBlockData() has seen a non-empty frame of the current message
+	bool m_blockInMessage;
+
 	///@brief Hostname our socket is connected to
 	std::string m_hostname;
 
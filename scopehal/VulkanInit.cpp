@@ -246,6 +246,14 @@ bool g_vulkanDeviceIsAnyMesa = false;
  */
 bool g_vulkanDeviceIsMoltenVK = false;
 
+/**
+	@brief Indicates that the Vulkan device is a software implementation running on the host CPU (llvmpipe etc)
+	@ingroup vksupport
+
+	Compute shaders on such a device are slower than native code, so filters with a CPU implementation should prefer it.
+ */
+bool g_vulkanDeviceIsSoftware = false;
+
 void VulkanCleanup();
 
 /**
@@ -625,6 +633,7 @@ bool VulkanInit(bool skipGLFW)
 				auto properties = device.getProperties();
 				g_vkComputeDeviceDriverVer = properties.driverVersion;
 				memcpy(g_vkComputeDeviceUuid, properties.pipelineCacheUUID, 16);
+				g_vulkanDeviceIsSoftware = (properties.deviceType == vk::PhysicalDeviceType::eCpu);
 
 				//Detect driver (used by some workarounds for bugs etc)
 				if(vulkan11Available)
@@ -1067,6 +1076,7 @@ void VulkanCleanup()
 
 	glslang_finalize_process();
 
+	AcceleratorTransfer::ClearCache();
 	g_vkTransferQueue = nullptr;
 	g_vkTransferCommandBuffer = nullptr;
 	g_vkTransferCommandPool = nullptr;
@@ -37,9 +37,24 @@
 #include "scopehal.h"
 #include "Waveform.h"
 #include "Filter.h"
+#include <atomic>
 
 using namespace std;
 
+///@brief Base of the next unused block of waveform revision numbers
+static atomic<uint64_t> g_nextWaveformRevision(1);
+
+/**
+	@brief Reserves a block of 2^32 revision numbers for a newly created waveform
+
+	Revision numbers are thus unique across all waveforms, not just within one object, unless a single waveform is
+	modified more than four billion times.
+ */
+uint64_t WaveformBase::AllocateRevisionRange()
+{
+	return g_nextWaveformRevision.fetch_add(1ULL << 32);
+}
+
 template<class T>
 size_t BinarySearchForGequal(T* buf, size_t len, T value)
 {
@@ -68,7 +68,9 @@ public:
 		, m_startFemtoseconds(0)
 		, m_triggerPhase(0)
 		, m_flags(0)
-		, m_revision(0)
+		, m_revision(AllocateRevisionRange())
+		, m_appendBaseRevision(0)
+		, m_appendedRevision(0)
 		, m_cachedColorRevision(0)
 	{
 	}
@@ -83,6 +85,8 @@ public:
 		, m_triggerPhase(rhs.m_triggerPhase)
 		, m_flags(rhs.m_flags)
 		, m_revision(rhs.m_revision)
+		, m_appendBaseRevision(0)
+		, m_appendedRevision(0)
 	{}
 
 	//empty virtual destructor in case any derived classes need one
@@ -135,9 +139,46 @@ public:
 		This is a monotonically increasing counter that indicates waveform data has changed. Filters may choose to
 		cache pre-processed versions of input data (for example, resampled versions of raw input) as long as the
 		pointer and revision number have not changed.
+
+		Each newly constructed waveform starts at the base of its own, previously unused block of revision numbers
+		(see AllocateRevisionRange()), so a new waveform allocated at the address of a deleted one can never be
+		mistaken for it by a (pointer, revision) comparison.
 	 */
 	uint64_t m_revision;
 
+	static uint64_t AllocateRevisionRange();
+
+	/**
+		@brief Bumps the revision number after samples were appended in place, without changing existing ones
+
+		Sparse waveforms may shorten the duration of the previous last sample so it doesn't overlap the first new
+		one (as AppendSamples() does), but must not otherwise modify samples that were already present.
+
+		Producers which change the waveform in any other way should increment m_revision directly instead.
+	 */
+	void MarkSamplesAppended()
+	{
+		//Start a new run of appends unless the previous change was also an append
+		if(m_appendedRevision != m_revision)
+			m_appendBaseRevision = m_revision;
+
+		m_revision ++;
+		m_appendedRevision = m_revision;
+	}
+
+	/**
+		@brief Checks if every change to the waveform since it was at the given revision was an append
+
+		@param revision	A revision this waveform previously had
+
+		@return True if the content as of that revision is still present and unchanged, other than the duration of
+				its last sample (see MarkSamplesAppended())
+	 */
+	bool IsAppendedSince(uint64_t revision) const
+	{
+		return (m_appendedRevision == m_revision) && (m_appendBaseRevision <= revision) && (revision <= m_revision);
+	}
+
 	///@brief Flags which may apply to m_flags
 	enum WaveformFlags_t
 	{
@@ -160,6 +201,14 @@ public:
 	///@brief Returns the number of samples in this waveform
 	virtual size_t size() const  =0;
 
+	///@brief Returns the number of samples this waveform can hold without reallocating its buffers
+	virtual size_t capacity() const
+	{ return 0; }
+
+	///@brief Returns the total CPU and GPU memory allocated for this waveform's sample data, in bytes
+	virtual size_t GetMemoryUsage() const
+	{ return 0; }
+
 	///@brief Returns true if this waveform contains no samples, false otherwise
 	virtual bool empty()
 	{ return size() == 0; }
@@ -212,6 +261,22 @@ public:
 	 */
 	virtual void PrepareForGpuAccess() =0;
 
+	/**
+		@brief Starts making the CPU-side copy of the data coherent, without waiting for the copy to complete
+
+		PrepareForCpuAccess() must still be called before the data is used, and waits for anything started here.
+	 */
+	virtual void PrepareForCpuAccessAsync()
+	{}
+
+	/**
+		@brief Starts making the GPU-side copy of the data coherent, without waiting for the copy to complete
+
+		PrepareForGpuAccess() must still be called before the data is used, and waits for anything started here.
+	 */
+	virtual void PrepareForGpuAccessAsync()
+	{}
+
 	/**
 		@brief Indicates that this waveform's sample data has been modified on the CPU and the GPU-side copy is no longer coherent
 	 */
@@ -240,8 +305,53 @@ public:
 	///@brief Returns true if we have at least one buffer resident on the GPU
 	virtual bool HasGpuBuffer() =0;
 
+	/**
+		@brief Discards all samples outside the range [start, start+count), keeping timestamps of the remaining
+		samples unchanged.
+
+		Used to trim the overlap off each segment's output during segmented filter graph execution.
+
+		@return True on success, false if this waveform type cannot be cropped
+	 */
+	virtual bool Crop(size_t /*start*/, size_t /*count*/)
+	{ return false; }
+
+	/**
+		@brief Appends a range of samples from another waveform of the same type to the end of this one
+
+		Timestamps of the appended samples are converted to this waveform's timebase.
+
+		@param src		Waveform to copy from
+		@param start	Index of the first sample to copy
+		@param count	Number of samples to copy
+
+		@return True on success, false if the waveforms are not compatible
+	 */
+	virtual bool AppendSamples(WaveformBase* /*src*/, size_t /*start*/, size_t /*count*/)
+	{ return false; }
+
+	/**
+		@brief Moves sample data to pageable, CPU-only memory so that very large waveforms do not have to stay resident
+		in RAM or in pinned memory.
+	 */
+	virtual void UsePagedMemory()
+	{}
+
+	/**
+		@brief Drops the resident pages of sample data in pageable memory (see UsePagedMemory()), leaving the content
+		in its backing file to be paged back in on next access.
+	 */
+	virtual void PageOut()
+	{}
+
 protected:
 
+	///@brief Revision the waveform had before the current run of MarkSamplesAppended() calls began
+	uint64_t m_appendBaseRevision;
+
+	///@brief Revision produced by the most recent call to MarkSamplesAppended(), or zero if never called
+	uint64_t m_appendedRevision;
+
 	///@brief Cache of packed RGBA32 data with colors for each protocol decode event. Empty for non-protocol waveforms.
 	AcceleratorBuffer<uint32_t> m_protocolColors;
 
@@ -421,6 +531,12 @@ public:
 	virtual size_t size() const override
 	{ return m_samples.size(); }
 
+	virtual size_t capacity() const override
+	{ return m_samples.capacity(); }
+
+	virtual size_t GetMemoryUsage() const override
+	{ return m_samples.GetCpuMemoryBytes() + m_samples.GetGpuMemoryBytes(); }
+
 	virtual void clear() override
 	{ m_samples.clear(); }
 
@@ -430,6 +546,12 @@ public:
 	virtual void PrepareForGpuAccess() override
 	{ m_samples.PrepareForGpuAccess(); }
 
+	virtual void PrepareForCpuAccessAsync() override
+	{ m_samples.PrepareForCpuAccessAsync(); }
+
+	virtual void PrepareForGpuAccessAsync() override
+	{ m_samples.PrepareForGpuAccessAsync(); }
+
 	virtual void MarkSamplesModifiedFromCpu() override
 	{ m_samples.MarkModifiedFromCpu(); }
 
@@ -442,6 +564,44 @@ public:
 	virtual void MarkModifiedFromGpu() override
 	{ MarkSamplesModifiedFromGpu(); }
 
+	virtual bool Crop(size_t start, size_t count) override
+	{
+		m_samples.PrepareForCpuAccess();
+		for(size_t i=0; i<count; i++)
+			m_samples[i] = m_samples[start + i];
+		m_samples.resize(count);
+		m_samples.MarkModifiedFromCpu();
+
+		m_triggerPhase += start * m_timescale;
+		return true;
+	}
+
+	virtual bool AppendSamples(WaveformBase* src, size_t start, size_t count) override
+	{
+		auto rhs = dynamic_cast<UniformWaveform<S>*>(src);
+		if(!rhs || (rhs->m_timescale != m_timescale) )
+			return false;
+
+		rhs->m_samples.PrepareForCpuAccess();
+		m_samples.PrepareForCpuAccess();
+
+		size_t base = m_samples.size();
+		m_samples.resize(base + count);
+		for(size_t i=0; i<count; i++)
+			m_samples[base + i] = rhs->m_samples[start + i];
+		m_samples.MarkModifiedFromCpu();
+		return true;
+	}
+
+	virtual void UsePagedMemory() override
+	{
+		m_samples.SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);
+		m_samples.SetCpuAccessHint(AcceleratorBuffer<S>::HINT_UNLIKELY, true);
+	}
+
+	virtual void PageOut() override
+	{ m_samples.PageOut(); }
+
 	/**
 		@brief Passes a hint to the memory allocator about where our sample data is expected to be used
 
@@ -543,6 +703,17 @@ public:
 	virtual size_t size() const override
 	{ return m_samples.size(); }
 
+	virtual size_t capacity() const override
+	{ return m_samples.capacity(); }
+
+	virtual size_t GetMemoryUsage() const override
+	{
+		return
+			m_offsets.GetCpuMemoryBytes() + m_offsets.GetGpuMemoryBytes() +
+			m_durations.GetCpuMemoryBytes() + m_durations.GetGpuMemoryBytes() +
+			m_samples.GetCpuMemoryBytes() + m_samples.GetGpuMemoryBytes();
+	}
+
 	virtual void clear() override
 	{
 		m_offsets.clear();
@@ -564,12 +735,88 @@ public:
 		m_samples.PrepareForGpuAccess();
 	}
 
+	virtual void PrepareForCpuAccessAsync() override
+	{
+		m_offsets.PrepareForCpuAccessAsync();
+		m_durations.PrepareForCpuAccessAsync();
+		m_samples.PrepareForCpuAccessAsync();
+	}
+
+	virtual void PrepareForGpuAccessAsync() override
+	{
+		m_offsets.PrepareForGpuAccessAsync();
+		m_durations.PrepareForGpuAccessAsync();
+		m_samples.PrepareForGpuAccessAsync();
+	}
+
 	virtual void MarkSamplesModifiedFromCpu() override
 	{ m_samples.MarkModifiedFromCpu(); }
 
 	virtual void MarkSamplesModifiedFromGpu() override
 	{ m_samples.MarkModifiedFromGpu(); }
 
+	virtual bool Crop(size_t start, size_t count) override
+	{
+		PrepareForCpuAccess();
+		for(size_t i=0; i<count; i++)
+		{
+			m_offsets[i] = m_offsets[start + i];
+			m_durations[i] = m_durations[start + i];
+			m_samples[i] = m_samples[start + i];
+		}
+		Resize(count);
+		MarkModifiedFromCpu();
+		return true;
+	}
+
+	virtual bool AppendSamples(WaveformBase* src, size_t start, size_t count) override
+	{
+		auto rhs = dynamic_cast<SparseWaveform<S>*>(src);
+		if(!rhs || (rhs->m_timescale != m_timescale) )
+			return false;
+
+		rhs->PrepareForCpuAccess();
+		PrepareForCpuAccess();
+
+		//Convert timestamps to our trigger phase
+		int64_t delta = (rhs->m_triggerPhase - m_triggerPhase) / m_timescale;
+
+		size_t base = m_samples.size();
+		Resize(base + count);
+		for(size_t i=0; i<count; i++)
+		{
+			m_offsets[base + i] = rhs->m_offsets[start + i] + delta;
+			m_durations[base + i] = rhs->m_durations[start + i];
+			m_samples[base + i] = rhs->m_samples[start + i];
+		}
+
+		//Don't let our previous last sample overlap the first appended one
+		if( (base > 0) && (count > 0) )
+		{
+			int64_t maxlen = m_offsets[base] - m_offsets[base-1];
+			if(m_durations[base-1] > maxlen)
+				m_durations[base-1] = maxlen;
+		}
+
+		MarkModifiedFromCpu();
+		return true;
+	}
+
+	virtual void UsePagedMemory() override
+	{
+		SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);
+		m_offsets.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_UNLIKELY, true);
+		m_durations.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_UNLIKELY, true);
+		m_samples.SetCpuAccessHint(AcceleratorBuffer<S>::HINT_UNLIKELY, true);
+	}
+
+	virtual void PageOut() override
+	{
+		m_offsets.PageOut();
+		m_durations.PageOut();
+		m_samples.PageOut();
+	}
+
 	/**
 		@brief Passes a hint to the memory allocator about where our sample data is expected to be used
 
@@ -0,0 +1,486 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPool
+	@ingroup datamodel
+ */
+
+#include "scopehal.h"
+#include <typeindex>
+
+using namespace std;
+
+///@brief The global waveform pool shared by all drivers and filters
+WaveformPool g_waveformPool;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Per-thread caches
+
+/**
+	@brief Owns a thread's private cache, and returns its contents to the pool when the thread exits
+ */
+class WaveformPool::ThreadCacheHolder
+{
+public:
+	ThreadCacheHolder()
+		: m_pool(nullptr)
+		, m_cache(nullptr)
+	{}
+
+	~ThreadCacheHolder()
+	{
+		if(m_pool)
+			m_pool->UnregisterThreadCache(m_cache);
+	}
+
+	///@brief The pool the cache belongs to
+	WaveformPool* m_pool;
+
+	///@brief The cache
+	ThreadCache* m_cache;
+};
+
+/**
+	@brief Gets the calling thread's private cache, creating it if necessary
+
+	Each thread only has a cache for the first pool it uses (normally g_waveformPool). Other pools only use their
+	shared tier from that thread.
+
+	@return The cache, or nullptr if this thread's cache belongs to another pool
+ */
+WaveformPool::ThreadCache* WaveformPool::GetThreadCache()
+{
+	static thread_local ThreadCacheHolder holder;
+
+	if(holder.m_pool == nullptr)
+	{
+		auto cache = new ThreadCache;
+		for(auto& s : cache->m_slots)
+			s.store(nullptr, memory_order_relaxed);
+
+		lock_guard<mutex> lock(m_threadCacheMutex);
+		m_threadCaches.push_back(cache);
+		holder.m_pool = this;
+		holder.m_cache = cache;
+	}
+
+	if(holder.m_pool != this)
+		return nullptr;
+	return holder.m_cache;
+}
+
+/**
+	@brief Moves the contents of an exiting thread's cache to the shared tier and frees the cache
+ */
+void WaveformPool::UnregisterThreadCache(ThreadCache* cache)
+{
+	{
+		lock_guard<mutex> lock(m_threadCacheMutex);
+		m_threadCaches.erase(remove(m_threadCaches.begin(), m_threadCaches.end(), cache), m_threadCaches.end());
+	}
+
+	for(auto& s : cache->m_slots)
+	{
+		auto w = s.exchange(nullptr);
+		if(!w)
+			continue;
+
+		//Move to the shared tier. We're already counted as pooled, so just move the pointer
+		size_t bucket = GetBucket(typeid(*w), GetCapacityClass(w->capacity()));
+		bool stored = false;
+		for(auto& slot : m_buckets[bucket])
+		{
+			if(Store(slot, w))
+			{
+				stored = true;
+				break;
+			}
+		}
+
+		if(!stored)
+		{
+			m_bytes -= w->GetMemoryUsage();
+			m_count --;
+			m_discarded ++;
+			delete w;
+		}
+	}
+
+	delete cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a waveform pool
+
+	@param maxBytes	Maximum memory which may be held by waveforms in the pool
+ */
+WaveformPool::WaveformPool(size_t maxBytes)
+	: m_maxBytes(maxBytes)
+	, m_bytes(0)
+	, m_count(0)
+	, m_hits(0)
+	, m_misses(0)
+	, m_added(0)
+	, m_discarded(0)
+{
+	for(auto& b : m_buckets)
+	{
+		for(auto& s : b)
+			s.store(nullptr, memory_order_relaxed);
+	}
+}
+
+WaveformPool::~WaveformPool()
+{
+	clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation
+
+/**
+	@brief Attempts to get a waveform from the pool
+
+	Callers normally use Allocate() instead.
+
+	@param type		Exact type of waveform required
+	@param capacity	Number of samples the waveform is expected to hold, or zero for any
+
+	@return The waveform, if a suitable one is available. Returns nullptr if not.
+ */
+WaveformBase* WaveformPool::Get(const type_info& type, size_t capacity)
+{
+	WaveformBase* ret = nullptr;
+
+	//Check our own cache first
+	auto cache = GetThreadCache();
+	if(cache)
+	{
+		for(auto& s : cache->m_slots)
+		{
+			ret = Claim(s, type, capacity);
+			if(ret)
+				break;
+		}
+	}
+
+	//Then the shared tier: the smallest class that's big enough, then the next one up.
+	//If the caller doesn't care about size, look in every class.
+	if(!ret)
+	{
+		size_t first = GetRequestClass(capacity);
+		size_t last = capacity ? min(first + 1, NUM_CLASSES - 1) : (NUM_CLASSES - 1);
+		for(size_t c = first; (c <= last) && !ret; c++)
+		{
+			for(auto& s : m_buckets[GetBucket(type, c)])
+			{
+				ret = Claim(s, type, capacity);
+				if(ret)
+					break;
+			}
+		}
+	}
+
+	if(!ret)
+	{
+		m_misses ++;
+		return nullptr;
+	}
+
+	m_hits ++;
+	m_bytes -= ret->GetMemoryUsage();
+	m_count --;
+
+	//Make sure nobody mistakes the recycled waveform for what it used to contain
+	ret->m_revision ++;
+	ret->m_flags = 0;
+	return ret;
+}
+
+/**
+	@brief Returns a waveform to the pool
+
+	Waveforms which aren't recyclable (see IsRecyclable()), or which don't fit in the pool, are deleted.
+
+	@param w	The waveform to add
+ */
+void WaveformPool::Add(WaveformBase* w)
+{
+	if(!w)
+		return;
+
+	size_t bytes = w->GetMemoryUsage();
+	if(!IsRecyclable(w) || (m_bytes.load() + bytes > m_maxBytes.load()) )
+	{
+		m_discarded ++;
+		delete w;
+		return;
+	}
+
+	w->Rename("WaveformPool.freelist");
+	m_bytes += bytes;
+	m_count ++;
+	m_added ++;
+
+	//Prefer our own cache, then the shared tier
+	auto cache = GetThreadCache();
+	if(cache)
+	{
+		for(auto& s : cache->m_slots)
+		{
+			if(Store(s, w))
+				return;
+		}
+	}
+	for(auto& s : m_buckets[GetBucket(typeid(*w), GetCapacityClass(w->capacity()))])
+	{
+		if(Store(s, w))
+			return;
+	}
+
+	//No room
+	m_bytes -= bytes;
+	m_count --;
+	m_added --;
+	m_discarded ++;
+	delete w;
+}
+
+/**
+	@brief Checks if a waveform can safely be recycled
+
+	Only the plain uniform and sparse analog and digital waveform types are recycled. Protocol, eye pattern and other
+	derived waveforms may carry state beyond their sample buffers which a new owner would not expect.
+ */
+bool WaveformPool::IsRecyclable(WaveformBase* w)
+{
+	auto& type = typeid(*w);
+	return
+		(type == typeid(UniformAnalogWaveform)) ||
+		(type == typeid(UniformDigitalWaveform)) ||
+		(type == typeid(SparseAnalogWaveform)) ||
+		(type == typeid(SparseDigitalWaveform));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Slot handling
+
+/**
+	@brief Gets the capacity class a pooled waveform is filed under (capacity rounded down to a power of two)
+ */
+size_t WaveformPool::GetCapacityClass(size_t capacity)
+{
+	size_t ret = 0;
+	while( (capacity >>= 1) && (ret < NUM_CLASSES - 1) )
+		ret ++;
+	return ret;
+}
+
+/**
+	@brief Gets the smallest capacity class guaranteed to hold a request (capacity rounded up to a power of two)
+ */
+size_t WaveformPool::GetRequestClass(size_t capacity)
+{
+	size_t ret = GetCapacityClass(capacity);
+	if( (ret < NUM_CLASSES - 1) && (capacity > (1ULL << ret)) )
+		ret ++;
+	return ret;
+}
+
+/**
+	@brief Gets the shared tier bucket for a given waveform type and capacity class
+ */
+size_t WaveformPool::GetBucket(const type_info& type, size_t capacityClass)
+{
+	return (type_index(type).hash_code() * 31 + capacityClass) % NUM_BUCKETS;
+}
+
+/**
+	@brief Checks if a waveform can be handed out for a request
+ */
+bool WaveformPool::IsMatch(WaveformBase* w, const type_info& type, size_t capacity)
+{
+	if(typeid(*w) != type)
+		return false;
+	if(capacity == 0)
+		return true;
+
+	//Must be big enough, but not excessively so
+	size_t wcap = w->capacity();
+	return (wcap >= capacity) && (GetCapacityClass(wcap) <= GetRequestClass(capacity) + 1);
+}
+
+/**
+	@brief Takes the waveform in a slot if it matches a request
+
+	The waveform has to be removed from the slot before it can be safely examined, since another thread could claim
+	and reuse it at any time. If it doesn't match, it's put back.
+
+	@return The waveform, or nullptr if the slot was empty or didn't match
+ */
+WaveformBase* WaveformPool::Claim(atomic<WaveformBase*>& slot, const type_info& type, size_t capacity)
+{
+	if(slot.load(memory_order_relaxed) == nullptr)
+		return nullptr;
+
+	auto w = slot.exchange(nullptr, memory_order_acquire);
+	if(!w)
+		return nullptr;
+	if(IsMatch(w, type, capacity))
+		return w;
+
+	//Not what we wanted. Put it back, or drop it if another thread has filled the slot in the meantime.
+	if(!Store(slot, w))
+	{
+		m_bytes -= w->GetMemoryUsage();
+		m_count --;
+		m_discarded ++;
+		delete w;
+	}
+	return nullptr;
+}
+
+/**
+	@brief Stores a waveform in a slot if it's empty
+
+	@return True if the waveform was stored
+ */
+bool WaveformPool::Store(atomic<WaveformBase*>& slot, WaveformBase* w)
+{
+	WaveformBase* expected = nullptr;
+	return slot.compare_exchange_strong(expected, w, memory_order_release, memory_order_relaxed);
+}
+
+/**
+	@brief Deletes the waveform in a slot, if any
+
+	@return True if a waveform was deleted
+ */
+bool WaveformPool::Discard(atomic<WaveformBase*>& slot)
+{
+	auto w = slot.exchange(nullptr, memory_order_acquire);
+	if(!w)
+		return false;
+
+	m_bytes -= w->GetMemoryUsage();
+	m_count --;
+	m_discarded ++;
+	delete w;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Trimming
+
+/**
+	@brief Free all waveforms in the pool to reclaim memory
+
+	@return True if memory was freed, false if pool was empty to begin with
+ */
+bool WaveformPool::clear()
+{
+	return Trim(0);
+}
+
+/**
+	@brief Frees pooled waveforms until the pool holds no more than the given amount of memory
+
+	The shared tier is trimmed first, then the private caches of each thread.
+
+	@param targetBytes	Amount of memory to leave in the pool
+
+	@return True if memory was freed
+ */
+bool WaveformPool::Trim(size_t targetBytes)
+{
+	bool freed = false;
+	auto done = [&]{ return (targetBytes != 0) && (m_bytes.load() <= targetBytes); };
+
+	for(auto& b : m_buckets)
+	{
+		for(auto& s : b)
+		{
+			if(done())
+				return freed;
+			if(Discard(s))
+				freed = true;
+		}
+	}
+
+	lock_guard<mutex> lock(m_threadCacheMutex);
+	for(auto cache : m_threadCaches)
+	{
+		for(auto& s : cache->m_slots)
+		{
+			if(done())
+				return freed;
+			if(Discard(s))
+				freed = true;
+		}
+	}
+
+	return freed;
+}
+
+/**
+	@brief Memory pressure handler for the global pool
+
+	Soft pressure halves the memory held by the pool, hard pressure empties it.
+ */
+bool WaveformPool::OnMemoryPressure(MemoryPressureLevel level, MemoryPressureType /*type*/, size_t /*requestedSize*/)
+{
+	if(level == MemoryPressureLevel::Hard)
+		return g_waveformPool.clear();
+	else
+		return g_waveformPool.Trim(g_waveformPool.m_bytes.load() / 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+/**
+	@brief Gets hit/miss statistics for the pool
+ */
+WaveformPoolStats WaveformPool::GetStats()
+{
+	WaveformPoolStats ret;
+	ret.m_hits = m_hits.load();
+	ret.m_misses = m_misses.load();
+	ret.m_added = m_added.load();
+	ret.m_discarded = m_discarded.load();
+	ret.m_count = m_count.load();
+	ret.m_bytes = m_bytes.load();
+	return ret;
+}
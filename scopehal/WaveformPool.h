@@ -36,100 +36,152 @@
 #ifndef WaveformPool_h
 #define WaveformPool_h
 
+#include <atomic>
+#include <typeinfo>
+
+/**
+	@brief Allocation statistics for a WaveformPool
+	@ingroup datamodel
+ */
+struct WaveformPoolStats
+{
+	///@brief Number of allocations satisfied by a pooled waveform
+	uint64_t m_hits;
+
+	///@brief Number of allocations which had to create a new waveform
+	uint64_t m_misses;
+
+	///@brief Number of waveforms added to the pool
+	uint64_t m_added;
+
+	///@brief Number of waveforms deleted because the pool was full, or when trimming it
+	uint64_t m_discarded;
+
+	///@brief Number of waveforms currently in the pool
+	size_t m_count;
+
+	///@brief Memory currently held by waveforms in the pool, in bytes
+	size_t m_bytes;
+};
+
 /**
 	@brief Thread safe memory pool for reusing Waveform objects
 	@ingroup datamodel
 
 	Allocating and freeing GPU memory can be an expensive operation so it's usually preferable to recycle existing
 	Waveform objects if possible.
+
+	Waveforms are matched by concrete type and capacity class (capacity rounded down to a power of two), so a request
+	is only ever satisfied by a waveform of exactly the requested type which can hold the requested number of samples
+	without reallocating, and not much more.
+
+	Each thread has a small private cache which is checked first. Behind it is a shared tier of hashed buckets, each
+	a handful of atomic slots. Neither tier takes any locks on the allocation or release path; waveforms are claimed
+	by atomically exchanging a slot with null, and released by compare-and-swap into an empty slot.
+
+	A single global pool, g_waveformPool, is shared by all instrument drivers and filters. It trims itself in
+	response to OnMemoryPressure().
  */
 class WaveformPool
 {
 public:
+	WaveformPool(size_t maxBytes = 1024LL * 1024LL * 1024LL);
+	~WaveformPool();
 
 	/**
-		@brief Creates a waveform pool
+		@brief Gets a waveform of type T from the pool, or creates a new one if none is available
 
-		@param maxSize	Maximum number of waveforms to store in the pool
+		@param capacity	Number of samples the waveform is expected to hold. If zero, any pooled waveform of type T
+						may be returned.
+		@param name		Internal name for the waveform, used in debug log messages etc
 	 */
-	WaveformPool(size_t maxSize = 16)
-	: m_maxSize(maxSize)
-	{}
-
-	~WaveformPool()
+	template<class T>
+	T* Allocate(size_t capacity = 0, const std::string& name = "")
 	{
-		for(auto w : m_waveforms)
-			delete w;
-		m_waveforms.clear();
+		auto ret = static_cast<T*>(Get(typeid(T), capacity));
+		if(ret)
+			ret->Rename(name);
+		else
+			ret = new T(name);
+		return ret;
 	}
 
-	/**
-		@brief Adds a new waveform to the pool if there's sufficient free slots in the pool.
-
-		If the pool is already full the waveform is destroyed.
+	WaveformBase* Get(const std::type_info& type, size_t capacity);
+	void Add(WaveformBase* w);
 
-		@param w	The waveform to add
-	 */
-	void Add(WaveformBase* w)
-	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-		w->Rename("WaveformPool.freelist");
+	bool clear();
+	bool Trim(size_t targetBytes);
 
-		if(m_waveforms.size() < m_maxSize)
-			m_waveforms.push_back(w);
-		else
-			delete w;
-	}
+	WaveformPoolStats GetStats();
 
 	/**
-		@brief Attempts to get a waveform from the pool.
-
-		@return The waveform, if one is available. Returns nullptr if the pool is empty.
+		@brief Sets the maximum amount of memory which may be held by waveforms in the pool
 	 */
-	WaveformBase* Get()
-	{
-		std::lock_guard<std::mutex> lock(m_mutex);
+	void SetMaxBytes(size_t maxBytes)
+	{ m_maxBytes = maxBytes; }
 
-		if(m_waveforms.empty())
-			return nullptr;
+	static bool IsRecyclable(WaveformBase* w);
+	static bool OnMemoryPressure(MemoryPressureLevel level, MemoryPressureType type, size_t requestedSize);
 
-		auto ret = *m_waveforms.begin();
-		ret->m_revision ++;
-		m_waveforms.pop_front();
+	///@brief Number of slots in each thread's private cache
+	static const size_t THREAD_CACHE_SIZE = 4;
 
-		ret->Rename("WaveformPool.allocated");
-		return ret;
-	}
+protected:
 
-	/**
-		@brief Free all waveforms in the pool to reclaim memory
+	///@brief Number of buckets in the shared tier
+	static const size_t NUM_BUCKETS = 64;
 
-		@return True if memory was freed, false if pool was empty to begin with
-	 */
-	bool clear()
+	///@brief Number of slots in each bucket of the shared tier
+	static const size_t BUCKET_SIZE = 4;
+
+	///@brief Number of capacity classes (powers of two)
+	static const size_t NUM_CLASSES = 48;
+
+	///@brief A thread's private cache. Only the owning thread adds waveforms, but any thread may remove them.
+	struct ThreadCache
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
+		std::atomic<WaveformBase*> m_slots[THREAD_CACHE_SIZE];
+	};
 
-		if(m_waveforms.empty())
-			return false;
+	class ThreadCacheHolder;
+	friend class ThreadCacheHolder;
 
-		for(auto w : m_waveforms)
-			delete w;
-		m_waveforms.clear();
+	ThreadCache* GetThreadCache();
+	void UnregisterThreadCache(ThreadCache* cache);
 
-		return true;
-	}
+	static size_t GetCapacityClass(size_t capacity);
+	static size_t GetRequestClass(size_t capacity);
+	size_t GetBucket(const std::type_info& type, size_t capacityClass);
 
-protected:
+	bool IsMatch(WaveformBase* w, const std::type_info& type, size_t capacity);
+	WaveformBase* Claim(std::atomic<WaveformBase*>& slot, const std::type_info& type, size_t capacity);
+	bool Store(std::atomic<WaveformBase*>& slot, WaveformBase* w);
+	bool Discard(std::atomic<WaveformBase*>& slot);
 
-	///@brief Maximum number of waveforms to store in the pool
-	size_t m_maxSize;
+	///@brief Maximum memory which may be held by waveforms in the pool, in bytes
+	std::atomic<size_t> m_maxBytes;
 
-	///@brief Mutex for synchronizing access to m_waveforms across threads
-	std::mutex m_mutex;
+	///@brief Memory currently held by waveforms in the pool, in bytes
+	std::atomic<size_t> m_bytes;
 
-	///@brief The list of free waveforms
-	std::list<WaveformBase*> m_waveforms;
+	///@brief Number of waveforms currently in the pool
+	std::atomic<size_t> m_count;
+
+	///@brief Shared tier of the pool
+	std::atomic<WaveformBase*> m_buckets[NUM_BUCKETS][BUCKET_SIZE];
+
+	///@brief Private caches of every thread which has used the pool
+	std::vector<ThreadCache*> m_threadCaches;
+
+	///@brief Mutex for m_threadCaches (only taken when a thread first uses the pool, exits, or when trimming)
+	std::mutex m_threadCacheMutex;
+
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_added;
+	std::atomic<uint64_t> m_discarded;
 };
 
+extern WaveformPool g_waveformPool;
+
 #endif
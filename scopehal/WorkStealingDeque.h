@@ -0,0 +1,145 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WorkStealingDeque
+ */
+#ifndef WorkStealingDeque_h
+#define WorkStealingDeque_h
+
+#include <atomic>
+
+/**
+	@brief Fixed capacity lock-free work-stealing deque of indexes (Chase-Lev)
+
+	The owning thread pushes and pops at the bottom, other threads steal from the top. Capacity is fixed at reset time,
+	so the caller must ensure no more than that many items are ever pushed between resets.
+
+	Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+ */
+class WorkStealingDeque
+{
+public:
+	WorkStealingDeque()
+	: m_top(0)
+	, m_bottom(0)
+	, m_capacity(0)
+	{}
+
+	/**
+		@brief Empties the deque and makes sure it can hold at least capacity items
+
+		Must not be called while any other thread is accessing the deque.
+	 */
+	void Reset(size_t capacity)
+	{
+		if(capacity > m_capacity)
+		{
+			m_items = std::make_unique<std::atomic<size_t>[]>(capacity);
+			m_capacity = capacity;
+		}
+		m_top.store(0, std::memory_order_relaxed);
+		m_bottom.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+		@brief Pushes an item onto the bottom of the deque (owner thread only)
+	 */
+	void Push(size_t item)
+	{
+		int64_t b = m_bottom.load(std::memory_order_relaxed);
+		m_items[b % m_capacity].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	/**
+		@brief Pops the most recently pushed item from the bottom of the deque (owner thread only)
+
+		@return True if an item was popped, false if the deque was empty
+	 */
+	bool Pop(size_t& item)
+	{
+		int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = m_top.load(std::memory_order_relaxed);
+
+		//Empty
+		if(t > b)
+		{
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = m_items[b % m_capacity].load(std::memory_order_relaxed);
+		if(t != b)
+			return true;
+
+		//Last item, race against thieves for it
+		bool ok = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		m_bottom.store(b + 1, std::memory_order_relaxed);
+		return ok;
+	}
+
+	/**
+		@brief Steals the oldest item from the top of the deque (any thread)
+
+		@return True if an item was stolen, false if the deque was empty or we lost a race for the item
+	 */
+	bool Steal(size_t& item)
+	{
+		int64_t t = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = m_bottom.load(std::memory_order_acquire);
+		if(t >= b)
+			return false;
+
+		item = m_items[t % m_capacity].load(std::memory_order_relaxed);
+		return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+protected:
+
+	///@brief Index of the oldest item (thieves take from here)
+	std::atomic<int64_t> m_top;
+
+	///@brief Index one past the newest item (owner pushes and pops here)
+	std::atomic<int64_t> m_bottom;
+
+	///@brief Item storage
+	std::unique_ptr<std::atomic<size_t>[]> m_items;
+
+	///@brief Number of slots in m_items
+	size_t m_capacity;
+};
+
+#endif
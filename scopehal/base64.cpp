@@ -5,8 +5,13 @@ This is part of the libb64 project, and has been placed in the public domain.
 For details, see http://sourceforge.net/projects/libb64
 */
 
+#include "scopehal.h"
 #include "base64.h"
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
 int base64_decode_value(signed char value_in)
 {
 	static const signed char decoding[] = {62,-1,-1,-1,63,52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-2,-1,-1,-1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51};
@@ -91,3 +96,176 @@ int base64_decode_block(const char* code_in, const int length_in, char* plaintex
 	/* control should not reach here */
 	return plainchar - plaintext_out;
 }
+
+/*
+Fast path for decoding large blocks in one call (not part of libb64).
+
+Complete groups of four valid characters are decoded with a lookup table, or 32 characters at a time with AVX2 if
+available. Anything else (whitespace, padding, or a group split by either) is stepped through with
+base64_decode_block() until we're back on a group boundary, so the output is identical to decoding the whole block
+with libb64.
+*/
+
+/**
+	@brief Lookup table from ASCII to 6-bit value, or -1 if not a base64 digit
+ */
+struct base64_decode_table
+{
+	base64_decode_table()
+	{
+		for(int i=0; i<256; i++)
+			m_values[i] = (int8_t)base64_decode_value((signed char)i);
+
+		//base64_decode_value() returns -2 for '=', we treat it the same as any other non-digit
+		for(int i=0; i<256; i++)
+		{
+			if(m_values[i] < 0)
+				m_values[i] = -1;
+		}
+	}
+
+	int8_t m_values[256];
+};
+
+static const base64_decode_table g_base64DecodeTable;
+
+/**
+	@brief Decodes complete groups of four base64 digits, stopping at the first group containing anything else
+
+	@return Number of input characters consumed (always a multiple of 4)
+ */
+static size_t base64_decode_groups_generic(const char* code_in, size_t length_in, unsigned char* plaintext_out)
+{
+	auto in = reinterpret_cast<const unsigned char*>(code_in);
+	auto table = g_base64DecodeTable.m_values;
+
+	size_t i = 0;
+	for(; i+4 <= length_in; i += 4)
+	{
+		int a = table[in[i]];
+		int b = table[in[i+1]];
+		int c = table[in[i+2]];
+		int d = table[in[i+3]];
+		if( (a | b | c | d) < 0)
+			break;
+
+		uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+		*plaintext_out++ = v >> 16;
+		*plaintext_out++ = v >> 8;
+		*plaintext_out++ = v;
+	}
+	return i;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 version of base64_decode_groups_generic()
+
+	Translates and validates 32 characters per iteration using nibble lookup tables, then packs each group of four
+	6-bit values into three bytes. Finishes any remaining groups with the generic version.
+
+	Writes up to 8 bytes past the end of the decoded data, so the output buffer must be at least length_in bytes.
+ */
+__attribute__((target("avx2")))
+static size_t base64_decode_groups_avx2(const char* code_in, size_t length_in, unsigned char* plaintext_out)
+{
+	//Valid characters are those whose low nibble class (lut_lo) and high nibble class (lut_hi) don't overlap
+	const __m256i lut_lo = _mm256_setr_epi8(
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lut_hi = _mm256_setr_epi8(
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+
+	//Offset to add to each character to get its value, indexed by high nibble ('/' gets its own entry)
+	const __m256i lut_roll = _mm256_setr_epi8(
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	const __m256i slash = _mm256_set1_epi8('/');
+
+	//Packing: merge pairs of 6-bit values into 12 bits, then pairs of those into 24, then drop the zero bytes
+	const __m256i merge6 = _mm256_set1_epi32(0x01400140);
+	const __m256i merge12 = _mm256_set1_epi32(0x00011000);
+	const __m256i shuf = _mm256_setr_epi8(
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+	size_t i = 0;
+	for(; i+32 <= length_in; i += 32)
+	{
+		__m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(code_in + i));
+
+		//Validate
+		__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), nibble);
+		__m256i lo_nibbles = _mm256_and_si256(str, nibble);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		if(!_mm256_testz_si256(lo, hi))
+			break;
+
+		//Translate to 6-bit values
+		__m256i eq_slash = _mm256_cmpeq_epi8(str, slash);
+		__m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_slash, hi_nibbles));
+		str = _mm256_add_epi8(str, roll);
+
+		//Pack
+		__m256i merged = _mm256_maddubs_epi16(str, merge6);
+		__m256i out = _mm256_madd_epi16(merged, merge12);
+		out = _mm256_shuffle_epi8(out, shuf);
+		out = _mm256_permutevar8x32_epi32(out, perm);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(plaintext_out), out);
+
+		plaintext_out += 24;
+	}
+
+	return i + base64_decode_groups_generic(code_in + i, length_in - i, plaintext_out);
+}
+#endif
+
+/**
+	@brief Decodes an entire base64 block in one call
+
+	Characters which are not base64 digits are skipped, as with base64_decode_block().
+
+	@param code_in			Base64 text
+	@param length_in		Length of the text
+	@param plaintext_out	Output buffer, which must be at least length_in bytes
+
+	@return Number of bytes decoded
+ */
+size_t base64_decode_fast(const char* code_in, size_t length_in, unsigned char* plaintext_out)
+{
+	base64_decodestate state;
+	base64_init_decodestate(&state);
+
+	size_t pos = 0;
+	size_t nout = 0;
+	while(pos < length_in)
+	{
+		//Bulk decode everything we can while on a group boundary
+		if(state.step == step_a)
+		{
+			size_t n;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				n = base64_decode_groups_avx2(code_in + pos, length_in - pos, plaintext_out + nout);
+			else
+			#endif
+				n = base64_decode_groups_generic(code_in + pos, length_in - pos, plaintext_out + nout);
+
+			pos += n;
+			nout += (n / 4) * 3;
+			if(pos >= length_in)
+				break;
+		}
+
+		//Step over the character that stopped us
+		nout += base64_decode_block(code_in + pos, 1, reinterpret_cast<char*>(plaintext_out) + nout, &state);
+		pos ++;
+	}
+
+	return nout;
+}
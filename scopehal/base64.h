@@ -8,6 +8,8 @@ For details, see http://sourceforge.net/projects/libb64
 #ifndef BASE64_CDECODE_H
 #define BASE64_CDECODE_H
 
+#include <cstddef>
+
 typedef enum
 {
 	step_a, step_b, step_c, step_d
@@ -25,4 +27,6 @@ int base64_decode_value(signed char value_in);
 
 int base64_decode_block(const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in);
 
+size_t base64_decode_fast(const char* code_in, size_t length_in, unsigned char* plaintext_out);
+
 #endif /* BASE64_CDECODE_H */
@@ -203,6 +203,9 @@ void DetectCPUFeatures()
 
 void ScopehalStaticCleanup()
 {
+	//Pooled waveforms may hold GPU memory, so they have to go before the Vulkan device does
+	g_waveformPool.clear();
+
 	VulkanCleanup();
 }
 
@@ -214,6 +217,8 @@ void DriverStaticInit()
 	InitializeSearchPaths();
 	DetectCPUFeatures();
 
+	g_memoryPressureHandlers.emplace(WaveformPool::OnMemoryPressure);
+
 	AddBERTDriverClass(AntikernelLabsTriggerCrossbar);
 	AddBERTDriverClass(MultiLaneBERT);
 
@@ -895,6 +900,37 @@ string str_replace(const string& search, const string& replace, const string& su
 	return ret;
 }
 
+/**
+	@brief Escapes a string for inclusion in a JSON document
+ */
+string JSONEscape(const string& s)
+{
+	string ret;
+	for(auto c : s)
+	{
+		switch(c)
+		{
+			case '\"':	ret += "\\\"";	break;
+			case '\\':	ret += "\\\\";	break;
+			case '\n':	ret += "\\n";	break;
+			case '\r':	ret += "\\r";	break;
+			case '\t':	ret += "\\t";	break;
+
+			default:
+				if( (unsigned char)c < 0x20)
+				{
+					char tmp[8];
+					snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+					ret += tmp;
+				}
+				else
+					ret += c;
+				break;
+		}
+	}
+	return ret;
+}
+
 uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize)
 {
 	uint32_t ret = numGlobal / blockSize;
@@ -995,6 +1031,15 @@ const char* ScopehalGetVersion()
 	return SCOPEHAL_VERSION;
 }
 
+/**
+	@brief Gets the CPU/GPU transfer counters for the calling thread
+ */
+AcceleratorTransferCounters& GetAcceleratorTransferCounters()
+{
+	static thread_local AcceleratorTransferCounters counters = {0, 0, 0};
+	return counters;
+}
+
 /**
 	@brief Called when we run low on memory
 
@@ -102,6 +102,7 @@ extern size_t g_maxComputeGroupCount[3];
 #include "ComputePipeline.h"
 
 #include "SCPITransport.h"
+#include "SocketRxBuffer.h"
 #include "SCPISocketTransport.h"
 #include "SCPITwinLanTransport.h"
 #include "SCPILinuxGPIBTransport.h"
@@ -121,6 +122,7 @@ extern size_t g_maxComputeGroupCount[3];
 #endif
 
 #include "FlowGraphNode.h"
+#include "PackedDigitalBusWaveform.h"
 #include "Instrument.h"
 #include "StreamDescriptor.h"
 
@@ -151,6 +153,7 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SCPILoad.h"
 #include "SCPIMiscInstrument.h"
 #include "SCPIMultimeter.h"
+#include "AcquisitionPipeline.h"
 #include "SCPIOscilloscope.h"
 #include "SCPIPowerSupply.h"
 #include "SCPIRFSignalGenerator.h"
@@ -172,6 +175,7 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SParameterSourceFilter.h"
 #include "SParameterFilter.h"
 
+#include "WorkStealingDeque.h"
 #include "FilterGraphExecutor.h"
 
 #include "QueueManager.h"
@@ -212,6 +216,7 @@ uint64_t prev_pow2(uint64_t v);
 std::vector<std::string> explode(const std::string& str, char separator);
 std::string str_replace(const std::string& search, const std::string& replace, const std::string& subject);
 std::string strtolower(const std::string& s);
+std::string JSONEscape(const std::string& s);
 
 #define FS_PER_PICOSECOND 1e3
 #define FS_PER_NANOSECOND 1e6
@@ -246,6 +251,7 @@ extern std::unique_ptr<QueueManager> g_vkQueueManager;
 extern bool g_vulkanDeviceIsIntelMesa;
 extern bool g_vulkanDeviceIsAnyMesa;
 extern bool g_vulkanDeviceIsMoltenVK;
+extern bool g_vulkanDeviceIsSoftware;
 extern uint32_t g_vkPinnedMemoryHeap;
 extern uint32_t g_vkLocalMemoryHeap;
 extern bool g_vulkanDeviceHasUnifiedMemory;
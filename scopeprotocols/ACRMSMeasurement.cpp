@@ -114,13 +114,10 @@ void ACRMSMeasurement::Refresh()
 
 	//Now we can do the cycle-by-cycle value
 	temp = 0;
-	vector<int64_t> edges;
 
 	//Auto-threshold analog signals at average of the full scale range
-	if(uadin)
-		FindZeroCrossings(uadin, average, edges);
-	else if(sadin)
-		FindZeroCrossings(sadin, average, edges);
+	auto pedges = FindZeroCrossings(sadin, uadin, average);
+	auto& edges = *pedges;
 
 	//We need at least one full cycle of the waveform to have a meaningful AC RMS Measurement
 	if(edges.size() < 2)
@@ -155,13 +155,10 @@ void AreaMeasurement::Refresh()
 	else if (measurement_type == CYCLE_AREA)
 	{
 		float average = GetAvgVoltage(sadin, uadin);
-		vector<int64_t> edges;
 
 		//Auto-threshold analog signals at average of the full scale range
-		if(uadin)
-			FindZeroCrossings(uadin, average, edges);
-		else if(sadin)
-			FindZeroCrossings(sadin, average, edges);
+		auto pedges = FindZeroCrossings(sadin, uadin, average);
+		auto& edges = *pedges;
 
 		//We need at least one full cycle of the waveform
 		if(edges.size() < 2)
@@ -97,17 +97,135 @@ void AutocorrelationFilter::Refresh()
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0, true);
 	cap->PrepareForCpuAccess();
 	din->PrepareForCpuAccess();
+	cap->Resize(range);
 
+	//Use whichever method is cheaper for this length and lag range
 	size_t end = len - range;
+	size_t npoints = next_pow2(len);
+	if(IsFFTFaster(end, range, npoints))
+		RefreshFFT(din->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len, end, range, npoints);
+	else
+	{
+		RefreshDirect(din->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), end, range);
+
+		//Free FFT memory if we aren't using it
+		m_forwardPlan = nullptr;
+		m_reversePlan = nullptr;
+		m_fftInput.clear();
+		m_fftInput.shrink_to_fit();
+		m_fftOutput.clear();
+		m_fftOutput.shrink_to_fit();
+		m_correlation.clear();
+		m_correlation.shrink_to_fit();
+	}
+
+	cap->MarkSamplesModifiedFromCpu();
+	SetData(cap, 0);
+}
+
+/**
+	@brief Decides whether the FFT method is expected to be faster than the direct method
+
+	The direct method does one multiply-accumulate per input sample per lag. The FFT method does a batch of two
+	forward transforms and one inverse transform of npoints points, regardless of the lag range.
+
+	@param end		Number of samples correlated at each lag
+	@param range	Number of lags
+	@param npoints	FFT length
+ */
+bool AutocorrelationFilter::IsFFTFaster(size_t end, size_t range, size_t npoints)
+{
+	if(!CPUFFTPlan::IsSizeSupported(npoints))
+		return false;
+
+	//Cost of the whole FFT method per N log2(N), in units of one direct multiply-accumulate.
+	//Measured as about 1.6 on x86-64 with AVX2, rounded up to allow for plan setup.
+	const double fftCostPerPoint = 2;
+
+	double directCost = static_cast<double>(end) * range;
+	double fftCost = fftCostPerPoint * npoints * log2(npoints);
+	return fftCost < directCost;
+}
+
+/**
+	@brief Computes the autocorrelation by direct summation
+
+	@param samples	Input samples
+	@param out		Output samples, one per lag
+	@param end		Number of samples correlated at each lag
+	@param range	Number of lags
+ */
+void AutocorrelationFilter::RefreshDirect(const float* samples, float* out, size_t end, size_t range)
+{
+	#pragma omp parallel for
 	for(size_t delta=1; delta <= range; delta ++)
 	{
 		double total = 0;
 		for(size_t i=0; i<end; i++)
-			total += din->m_samples[i] * din->m_samples[i+delta];
+			total += samples[i] * samples[i+delta];
 
-		cap->m_samples.push_back(total / end);
+		out[delta-1] = total / end;
 	}
+}
 
-	cap->MarkSamplesModifiedFromCpu();
-	SetData(cap, 0);
+/**
+	@brief Computes the autocorrelation using the Wiener-Khinchin theorem
+
+	The first end samples of the input (a) and the full input (x) are zero padded to npoints and transformed. The
+	inverse FFT of conj(A)*X is the circular cross-correlation of a and x. Since a is zero beyond end and npoints is
+	at least the input length, none of the lags we output wrap around, so they are identical to the direct sum.
+
+	@param samples	Input samples
+	@param out		Output samples, one per lag
+	@param len		Number of input samples
+	@param end		Number of samples correlated at each lag
+	@param range	Number of lags
+	@param npoints	FFT length, a power of two no smaller than len
+ */
+void AutocorrelationFilter::RefreshFFT(
+	const float* samples, float* out, size_t len, size_t end, size_t range, size_t npoints)
+{
+	size_t nouts = npoints/2 + 1;
+
+	if(!m_forwardPlan || (m_forwardPlan->size() != npoints))
+	{
+		m_forwardPlan = make_unique<CPUFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD, 2);
+		m_reversePlan = make_unique<CPUFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+
+		m_fftInput.resize(2*npoints);
+		m_fftOutput.resize(4*nouts);
+		m_correlation.resize(npoints);
+	}
+
+	//Copy and zero pad both transform inputs
+	float* pa = m_fftInput.data();
+	float* px = pa + npoints;
+	memcpy(pa, samples, end*sizeof(float));
+	memset(pa + end, 0, (npoints - end)*sizeof(float));
+	memcpy(px, samples, len*sizeof(float));
+	memset(px + len, 0, (npoints - len)*sizeof(float));
+
+	m_forwardPlan->Forward(m_fftInput.data(), m_fftOutput.data());
+
+	//Cross power spectrum conj(A)*X, overwriting A
+	float* fa = m_fftOutput.data();
+	const float* fx = fa + 2*nouts;
+	#pragma omp parallel for
+	for(size_t i=0; i<nouts; i++)
+	{
+		float ar = fa[i*2];
+		float ai = fa[i*2 + 1];
+		float xr = fx[i*2];
+		float xi = fx[i*2 + 1];
+
+		fa[i*2]		= ar*xr + ai*xi;
+		fa[i*2 + 1]	= ar*xi - ai*xr;
+	}
+
+	m_reversePlan->Reverse(m_fftOutput.data(), m_correlation.data());
+
+	//Inverse FFT is unnormalized, so fold its scale into the averaging
+	float scale = 1.0 / (static_cast<double>(npoints) * end);
+	for(size_t delta=1; delta <= range; delta ++)
+		out[delta-1] = m_correlation[delta] * scale;
 }
@@ -35,6 +35,8 @@
 #ifndef AutocorrelationFilter_h
 #define AutocorrelationFilter_h
 
+#include "CPUFFTPlan.h"
+
 class AutocorrelationFilter : public Filter
 {
 public:
@@ -49,7 +51,27 @@ public:
 	PROTOCOL_DECODER_INITPROC(AutocorrelationFilter)
 
 protected:
+	static bool IsFFTFaster(size_t end, size_t range, size_t npoints);
+
+	void RefreshDirect(const float* samples, float* out, size_t end, size_t range);
+	void RefreshFFT(const float* samples, float* out, size_t len, size_t end, size_t range, size_t npoints);
+
 	std::string m_maxDeltaName;
+
+	///@brief Forward FFT of the truncated and full input, done as a two-transform batch
+	std::unique_ptr<CPUFFTPlan> m_forwardPlan;
+
+	///@brief Inverse FFT of the cross power spectrum
+	std::unique_ptr<CPUFFTPlan> m_reversePlan;
+
+	///@brief Zero padded time domain inputs to m_forwardPlan
+	std::vector<float, AlignedAllocator<float, 64> > m_fftInput;
+
+	///@brief Frequency domain outputs of m_forwardPlan
+	std::vector<float, AlignedAllocator<float, 64> > m_fftOutput;
+
+	///@brief Circular correlation output of m_reversePlan
+	std::vector<float, AlignedAllocator<float, 64> > m_correlation;
 };
 
 #endif
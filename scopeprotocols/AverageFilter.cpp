@@ -90,15 +90,9 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 		size_t len = data->size();
 
 		if(udata)
-		{
-			for(auto sample : udata->m_samples)
-				total += sample;
-		}
+			total = SumSamples(udata->m_samples.GetCpuPointer(), len);
 		else if(sdata)
-		{
-			for(auto sample : sdata->m_samples)
-				total += sample;
-		}
+			total = SumSamples(sdata->m_samples.GetCpuPointer(), len);
 		m_pastCount += len;
 		m_pastSum += total;
 
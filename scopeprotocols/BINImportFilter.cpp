@@ -70,11 +70,17 @@ void BINImportFilter::OnFileNameChanged()
 	int64_t fs = 0;
 	GetTimestampOfFile(fname, timestamp, fs);
 
-	string f = ReadFile(fname);
-	uint32_t fpos = 0;
+	//Map the file rather than reading it, so large analog waveforms can be converted a segment at a time
+	if(!MapFile(fname))
+		return;
+	size_t fpos = 0;
 
 	FileHeader fh;
-	f.copy((char*)&fh, sizeof(FileHeader), fpos);
+	if(!ReadMapped(&fh, sizeof(FileHeader), fpos))
+	{
+		LogError("File is too short for a BIN header\n");
+		return;
+	}
 	fpos += sizeof(FileHeader);
 
 	//Get vendor from file signature
@@ -107,7 +113,11 @@ void BINImportFilter::OnFileNameChanged()
 
 		//Parse waveform header
 		WaveHeader wh;
-		f.copy((char*)&wh, sizeof(WaveHeader), fpos);
+		if(!ReadMapped(&wh, sizeof(WaveHeader), fpos))
+		{
+			LogError("Waveform header is past the end of the file\n");
+			return;
+		}
 		fpos += sizeof(WaveHeader);
 
 		//TODO: make this metadata readable somewhere via properties etc
@@ -149,7 +159,11 @@ void BINImportFilter::OnFileNameChanged()
 
 		//Grab the initial data header and figure out what it is
 		DataHeader dh;
-		f.copy((char*)&dh, sizeof(DataHeader), fpos);
+		if(!ReadMapped(&dh, sizeof(DataHeader), fpos))
+		{
+			LogError("Data header is past the end of the file\n");
+			return;
+		}
 
 		//Digital logic waveform
 		if(wh.type == 6)
@@ -168,6 +182,7 @@ void BINImportFilter::OnFileNameChanged()
 				SetData(wfm, m_streams.size()-1);
 				wfms.push_back(wfm);
 
+				ReserveImportedSamples(wfm, (size_t)wh.samples * wh.buffers);
 				wfm->PrepareForCpuAccess();
 			}
 
@@ -177,7 +192,12 @@ void BINImportFilter::OnFileNameChanged()
 				LogIndenter li_b;
 
 				//Parse waveform data header
-				f.copy((char*)&dh, sizeof(DataHeader), fpos);
+				if(!ReadMapped(&dh, sizeof(DataHeader), fpos) ||
+					((size_t)wh.samples * dh.depth > m_mappedSize - fpos - sizeof(DataHeader)) )
+				{
+					LogError("Buffer is past the end of the file\n");
+					return;
+				}
 				fpos += sizeof(DataHeader);
 
 				LogDebug("Data Type:      %i\n", dh.type);
@@ -193,13 +213,13 @@ void BINImportFilter::OnFileNameChanged()
 					{
 						//Do not violate strict aliasing, compiler will optimize out the memcpy
 						float val;
-						memcpy(&val, f.c_str() + fpos, sizeof(float));
+						memcpy(&val, m_mappedFile + fpos, sizeof(float));
 						s = static_cast<uint8_t>(val);
 					}
 					//Logic samples (digital unsigned 8-bit character data)
 					else if (dh.type == 6)
 					{
-						s = *(uint8_t*)(f.c_str() + fpos);
+						s = m_mappedFile[fpos];
 					}
 					else
 					{
@@ -226,14 +246,41 @@ void BINImportFilter::OnFileNameChanged()
 		//Analog waveform
 		else
 		{
-			//Create the stream and a waveform for it
+			//Create the stream
 			AddStream(Unit(Unit::UNIT_VOLTS), name, Stream::STREAM_TYPE_ANALOG);
 
+			//A single buffer of float samples can be read straight out of the file, when needed
+			if( (wh.buffers == 1) && (dh.depth >= (short)sizeof(float)) &&
+				((size_t)wh.samples * dh.depth <= m_mappedSize - fpos - sizeof(DataHeader)) )
+			{
+				LogDebug("Data Type:      %i\n", dh.type);
+				LogDebug("Sample depth:   %i bits\n", dh.depth*8);
+				LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
+
+				MappedStream stream;
+				stream.m_stream = m_streams.size()-1;
+				stream.m_fileOffset = fpos + sizeof(DataHeader);
+				stream.m_count = wh.samples;
+				stream.m_stride = dh.depth;
+				stream.m_type = MAPPED_FLOAT32;
+				stream.m_scale = 1;
+				stream.m_offset = 0;
+				stream.m_timescale = wh.interval * FS_PER_SECOND;
+				stream.m_triggerPhase = 0;
+				stream.m_startTimestamp = timestamp;
+				stream.m_startFemtoseconds = fs;
+				AddMappedStream(stream);
+
+				fpos += sizeof(DataHeader) + (size_t)wh.samples * dh.depth;
+				continue;
+			}
+
 			auto wfm = new UniformAnalogWaveform;
 			wfm->m_timescale = wh.interval * FS_PER_SECOND;
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
+			ReserveImportedSamples(wfm, (size_t)wh.samples * wh.buffers);
 			wfm->PrepareForCpuAccess();
 			SetData(wfm, m_streams.size()-1);
 
@@ -243,7 +290,12 @@ void BINImportFilter::OnFileNameChanged()
 				LogIndenter li_b;
 
 				//Parse waveform data header
-				f.copy((char*)&dh, sizeof(DataHeader), fpos);
+				if(!ReadMapped(&dh, sizeof(DataHeader), fpos) ||
+					((size_t)wh.samples * dh.depth > m_mappedSize - fpos - sizeof(DataHeader)) )
+				{
+					LogError("Buffer is past the end of the file\n");
+					return;
+				}
 				fpos += sizeof(DataHeader);
 
 				LogDebug("Data Type:      %i\n", dh.type);
@@ -254,9 +306,9 @@ void BINImportFilter::OnFileNameChanged()
 				for(size_t k=0; k<wh.samples; k++)
 				{
 					//Do not violate strict aliasing, compiler will optimize out the memcpy
-					float* sample_f;
-					memcpy(&sample_f, f.c_str() + fpos, sizeof(float));
-					wfm->m_samples.push_back(*sample_f);
+					float sample_f;
+					memcpy(&sample_f, m_mappedFile + fpos, sizeof(float));
+					wfm->m_samples.push_back(sample_f);
 					fpos += dh.depth;
 				}
 			}
@@ -267,5 +319,9 @@ void BINImportFilter::OnFileNameChanged()
 		AutoscaleVertical(i);
 	}
 
+	//Everything was loaded up front, so the mapping isn't needed any more
+	if(m_mappedStreams.empty())
+		UnmapFile();
+
 	m_outputsChangedSignal.emit();
 }
@@ -94,19 +94,22 @@ void BurstWidthMeasurement::Refresh()
 	auto sadin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto uddin = dynamic_cast<UniformDigitalWaveform*>(din);
 	auto sddin = dynamic_cast<SparseDigitalWaveform*>(din);
-	vector<int64_t> edges;
+	EdgeList pedges;
 
 	//Auto-threshold analog signals at 50% of full scale range
 	if(uadin)
-		FindZeroCrossings(uadin, GetAvgVoltage(uadin), edges);
+		pedges = FindZeroCrossings(uadin, GetAvgVoltage(uadin));
 	else if(sadin)
-		FindZeroCrossings(sadin, GetAvgVoltage(sadin), edges);
+		pedges = FindZeroCrossings(sadin, GetAvgVoltage(sadin));
 
 	//Just find edges in digital signals
 	else if(uddin)
-		FindZeroCrossings(uddin, edges);
+		pedges = FindZeroCrossings(uddin);
 	else
-		FindZeroCrossings(sddin, edges);
+		pedges = FindZeroCrossings(sddin);
+
+	//We append an end marker below, so work on a private copy of the shared edge list
+	auto edges = *pedges;
 
 	//We need at least one full cycle of the waveform to have a meaningful burst width
 	if(edges.size() < 2)
@@ -154,6 +154,7 @@ void BusHeatmapFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Q
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 	cap->m_triggerPhase = din->m_triggerPhase;
 	cap->m_timescale = xscale;
+	cap->m_revision ++;
 	cap->PrepareForCpuAccess();
 	SetData(cap, 0);
 
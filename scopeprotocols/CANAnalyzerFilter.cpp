@@ -38,6 +38,8 @@ using namespace std;
 
 CANAnalyzerFilter::CANAnalyzerFilter(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_state(STATE_IDLE)
+	, m_pack(nullptr)
 {
 	CreateInput("din");
 }
@@ -84,28 +86,38 @@ void CANAnalyzerFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared
 	auto din = dynamic_cast<CANWaveform*>(GetInputWaveform(0));
 	auto len = din->size();
 
-	//copy input to output
-	auto cap = new CANWaveform;
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
-	cap->m_offsets.CopyFrom(din->m_offsets);
-	cap->m_durations.CopyFrom(din->m_durations);
-	cap->m_samples.CopyFrom(din->m_samples);
-	SetData(cap, 0);
-
-	ClearPackets();
-
-	enum
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<CANWaveform*>(GetData(0));
+	if(cap && GetAppendedInputStart(0, start))
 	{
-		STATE_IDLE,
-		STATE_DATA,
-		STATE_GARBAGE
-	} state = STATE_IDLE;
+		//copy new input samples to output
+		cap->AppendSamples(din, start, len - start);
+		cap->MarkSamplesAppended();
+	}
+	else
+	{
+		start = 0;
+
+		//copy input to output
+		cap = new CANWaveform;
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+		cap->m_offsets.CopyFrom(din->m_offsets);
+		cap->m_durations.CopyFrom(din->m_durations);
+		cap->m_samples.CopyFrom(din->m_samples);
+		SetData(cap, 0);
+
+		ClearPackets();
+		m_state = STATE_IDLE;
+		m_pack = nullptr;
+	}
 
-	Packet* pack = nullptr;
-	for(size_t i=0; i<len; i++)
+	auto& state = m_state;
+	auto& pack = m_pack;
+	for(size_t i=start; i<len; i++)
 	{
 		auto s = din->m_samples[i];
 
@@ -51,6 +51,17 @@ public:
 	PROTOCOL_DECODER_INITPROC(CANAnalyzerFilter)
 
 protected:
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_DATA,
+		STATE_GARBAGE
+	} m_state;
+
+	///@brief The packet currently being decoded, if any (kept so appended input can be decoded incrementally)
+	Packet* m_pack;
 };
 
 #endif
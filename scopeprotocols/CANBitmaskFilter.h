@@ -53,6 +53,28 @@ protected:
 	std::string m_busAddress;
 	std::string m_bitmask;
 	std::string m_pattern;
+
+	//Decoder state, kept so appended input can be decoded incrementally
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_DLC,
+		STATE_DATA
+	} m_state;
+
+	///@brief Start time of the frame being decoded
+	int64_t m_framestart;
+
+	///@brief Payload bytes of the frame being decoded so far
+	int64_t m_payload;
+
+	///@brief Number of payload bytes still expected
+	size_t m_bytesleft;
+
+	///@brief Duration of the last real output sample before it was extended to the end of the capture
+	int64_t m_tailDuration;
 };
 
 #endif
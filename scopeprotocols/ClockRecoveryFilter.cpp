@@ -97,6 +97,30 @@ string ClockRecoveryFilter::GetProtocolName()
 	return "Clock Recovery (PLL)";
 }
 
+bool ClockRecoveryFilter::IsStreamingCapable()
+{
+	return true;
+}
+
+/**
+	@brief Gets the overlap needed for the PLL to lock before the start of a segment
+
+	The PLL state isn't carried from one segment to the next, so each segment relocks on its own leading overlap.
+	Edges near a segment boundary can therefore differ from a single pass over the whole record by up to about one UI
+	of phase. Segmented results are not bit-exact; scopebench accepts this through BenchmarkCase::m_segmentTolerance.
+ */
+int64_t ClockRecoveryFilter::GetStreamingOverlap()
+{
+	//Zero, negative, or sub-1 baud rates would overflow the result, and can't be decoded anyway
+	float baud = m_parameters[m_baudname].GetFloatVal();
+	if(!(baud >= 1))
+		return 0;
+
+	//The PLL needs a couple of thousand UIs to lock, on both sides of the segment so the last edges are
+	//locked too
+	return 2000 * round(FS_PER_SECOND / baud);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -123,20 +147,21 @@ void ClockRecoveryFilter::Refresh()
 		gate->PrepareForCpuAccess();
 
 	//Timestamps of the edges
-	vector<int64_t> edges;
+	EdgeList pedges;
 	if(uadin)
-		FindZeroCrossings(uadin, m_parameters[m_threshname].GetFloatVal(), edges);
+		pedges = FindZeroCrossings(uadin, m_parameters[m_threshname].GetFloatVal());
 	else if(sadin)
-		FindZeroCrossings(sadin, m_parameters[m_threshname].GetFloatVal(), edges);
+		pedges = FindZeroCrossings(sadin, m_parameters[m_threshname].GetFloatVal());
 	else if(uddin)
-		FindZeroCrossings(uddin, edges);
+		pedges = FindZeroCrossings(uddin);
 	else if(sddin)
-		FindZeroCrossings(sddin, edges);
-	if(edges.empty())
+		pedges = FindZeroCrossings(sddin);
+	if(!pedges || pedges->empty())
 	{
 		SetData(NULL, 0);
 		return;
 	}
+	auto& edges = *pedges;
 
 	//Get nominal period used for the first cycle of the NCO
 	int64_t initialPeriod = round(FS_PER_SECOND / m_parameters[m_baudname].GetFloatVal());
@@ -89,6 +89,12 @@ string ComplexSpectrogramFilter::GetProtocolName()
 	return "Complex Spectrogram";
 }
 
+FlowGraphNode::DataLocation ComplexSpectrogramFilter::GetInputLocation()
+{
+	//Complex spectrograms always run on the GPU, so unlike the base class we never want our input moved to the CPU
+	return LOC_DONTCARE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -183,6 +189,7 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	cap->m_startFemtoseconds = din_i->m_startFemtoseconds;
 	cap->m_triggerPhase = din_i->m_triggerPhase;
 	cap->m_timescale = fs_per_sample * fftlen;
+	cap->m_revision ++;
 	cap->PrepareForGpuAccess();
 	SetData(cap, 0);
 
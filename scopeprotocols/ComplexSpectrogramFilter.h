@@ -48,6 +48,7 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -79,6 +79,14 @@ void ConstantFilter::OnUnitChanged()
 	m_parameters[m_value] = FilterParameter(FilterParameter::TYPE_FLOAT, unit);
 }
 
+/**
+	@brief Our output depends only on our parameters, so there's no need to refresh unless they change
+ */
+bool ConstantFilter::IsRefreshRequired()
+{
+	return HasChangedSinceLastRefresh();
+}
+
 void ConstantFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
 {
 	SetYAxisUnits(static_cast<Unit::UnitType>(m_parameters[m_unit].GetIntVal()), 0);
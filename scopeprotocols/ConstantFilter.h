@@ -41,6 +41,7 @@ public:
 	ConstantFilter(const std::string& color);
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual bool IsRefreshRequired() override;
 
 	static std::string GetProtocolName();
 
@@ -155,6 +155,7 @@ void ConstellationFilter::Refresh(
 	if(!cap)
 		cap = ReallocateWaveform();
 	cap->PrepareForCpuAccess();
+	cap->m_revision ++;
 
 	//Recompute scales
 	float xscale = m_width / GetVoltageRange(0);
@@ -123,7 +123,12 @@ string DeEmbedFilter::GetProtocolName()
 
 Filter::DataLocation DeEmbedFilter::GetInputLocation()
 {
-	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	//If the FFTs are going to run on the CPU, pull the input over before Refresh() is called.
+	//Otherwise we explicitly manage our input memory and don't care where it is.
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	if(din && CPUFFTPlan::IsPreferred(next_pow2(din->size()), 1, false))
+		return LOC_CPU;
+
 	return LOC_DONTCARE;
 }
 
@@ -163,7 +168,7 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	//Format the input data as raw samples for the FFT
 	size_t nouts = npoints/2 + 1;
 
-	//Invalidate old vkFFT plans if size has changed
+	//Invalidate old FFT plans if size has changed
 	if(m_vkForwardPlan)
 	{
 		if(m_vkForwardPlan->size() != npoints)
@@ -174,6 +179,16 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 		if(m_vkReversePlan->size() != npoints)
 			m_vkReversePlan = nullptr;
 	}
+	if(m_cpuForwardPlan)
+	{
+		if(m_cpuForwardPlan->size() != npoints)
+			m_cpuForwardPlan = nullptr;
+	}
+	if(m_cpuReversePlan)
+	{
+		if(m_cpuReversePlan->size() != npoints)
+			m_cpuReversePlan = nullptr;
+	}
 
 	//Set up the FFT and allocate buffers if we change point count
 	bool sizechange = false;
@@ -187,12 +202,6 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 		sizechange = true;
 	}
 
-	//Set up new FFT plans
-	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
-	if(!m_vkReversePlan)
-		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
-
 	//Calculate size of each bin
 	double fs = din->m_timescale;
 	double sample_ghz = 1e6 / fs;
@@ -272,6 +281,19 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	cap->Resize(outlen);
 	m_cachedOutLen = outlen;
 
+	//Small transforms of CPU-resident data, or no usable GPU? Do it all on the CPU
+	if(CPUFFTPlan::IsPreferred(npoints, 1, din->m_samples.IsCpuBufferStale()))
+	{
+		DoRefreshCPU(din, cap, npoints, nouts, istart, outlen, scale);
+		return;
+	}
+
+	//Set up new FFT plans
+	if(!m_vkForwardPlan)
+		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(!m_vkReversePlan)
+		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
@@ -321,6 +343,62 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	cap->MarkModifiedFromGpu();
 }
 
+/**
+	@brief Runs the forward FFT, S-parameter correction, inverse FFT, and normalization on the CPU
+
+	Equivalent to the shader path in DoRefresh().
+ */
+void DeEmbedFilter::DoRefreshCPU(
+	UniformAnalogWaveform* din,
+	UniformAnalogWaveform* cap,
+	size_t npoints,
+	size_t nouts,
+	size_t istart,
+	size_t outlen,
+	float scale)
+{
+	if(!m_cpuForwardPlan)
+		m_cpuForwardPlan = make_unique<CPUFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(!m_cpuReversePlan)
+		m_cpuReversePlan = make_unique<CPUFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
+
+	//Copy and zero-pad the input as needed
+	size_t npoints_raw = din->size();
+	din->PrepareForCpuAccess();
+	m_forwardInBuf.PrepareForCpuAccess();
+	memcpy(m_forwardInBuf.GetCpuPointer(), din->m_samples.GetCpuPointer(), npoints_raw * sizeof(float));
+	for(size_t i=npoints_raw; i<npoints; i++)
+		m_forwardInBuf[i] = 0;
+	m_forwardInBuf.MarkModifiedFromCpu();
+
+	m_cpuForwardPlan->Forward(m_forwardInBuf, m_forwardOutBuf);
+
+	//Apply the interpolated S-parameters
+	m_resampledSparamSines.PrepareForCpuAccess();
+	m_resampledSparamCosines.PrepareForCpuAccess();
+	float* data = m_forwardOutBuf.GetCpuPointer();
+	const float* sines = m_resampledSparamSines.GetCpuPointer();
+	const float* cosines = m_resampledSparamCosines.GetCpuPointer();
+	for(size_t i=0; i<nouts; i++)
+	{
+		float real_orig = data[i*2];
+		float imag_orig = data[i*2 + 1];
+		data[i*2] = real_orig*cosines[i] - imag_orig*sines[i];
+		data[i*2 + 1] = real_orig*sines[i] + imag_orig*cosines[i];
+	}
+	m_forwardOutBuf.MarkModifiedFromCpu();
+
+	m_cpuReversePlan->Reverse(m_forwardOutBuf, m_reverseOutBuf);
+
+	//Copy and normalize output
+	cap->PrepareForCpuAccess();
+	float* pout = cap->m_samples.GetCpuPointer();
+	const float* pin = m_reverseOutBuf.GetCpuPointer() + istart;
+	for(size_t i=0; i<outlen; i++)
+		pout[i] = pin[i] * scale;
+	cap->MarkModifiedFromCpu();
+}
+
 /**
 	@brief Returns the max mid-band group delay of the channel
  */
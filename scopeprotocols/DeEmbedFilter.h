@@ -75,6 +75,14 @@ public:
 protected:
 	virtual int64_t GetGroupDelay();
 	void DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
+	void DoRefreshCPU(
+		UniformAnalogWaveform* din,
+		UniformAnalogWaveform* cap,
+		size_t npoints,
+		size_t nouts,
+		size_t istart,
+		size_t outlen,
+		float scale);
 	virtual void InterpolateSparameters(float bin_hz, bool invert, size_t nouts);
 
 	std::string m_maxGainName;
@@ -111,6 +119,8 @@ protected:
 	ComputePipeline m_normalizeComputePipeline;
 	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
 	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	std::unique_ptr<CPUFFTPlan> m_cpuForwardPlan;
+	std::unique_ptr<CPUFFTPlan> m_cpuReversePlan;
 };
 
 #endif
@@ -116,20 +116,14 @@ void DramClockFilter::Refresh()
 
 	//Find edges in the DQS signal (double rate so we want both polarity)
 	//TODO: support differential DQS for DDR2/3
-	vector<int64_t> edges;
 	float thresh = m_parameters[m_dqsthreshname].GetFloatVal();
-	if(sdqs)
-		FindZeroCrossings(sdqs, thresh, edges);
-	else
-		FindZeroCrossings(udqs, thresh, edges);
+	auto pedges = FindZeroCrossings(sdqs, udqs, thresh);
+	auto& edges = *pedges;
 
 	//Find edges in the CLK signal
 	//TODO: support analog clock too?
-	vector<int64_t> clkedges;
-	if(sclk)
-		FindZeroCrossings(sclk, clkedges);
-	else
-		FindZeroCrossings(uclk, clkedges);
+	auto pclkedges = FindZeroCrossings(sclk, uclk);
+	auto& clkedges = *pclkedges;
 
 	//Create output waveforms
 	auto rdclk = new SparseDigitalWaveform;
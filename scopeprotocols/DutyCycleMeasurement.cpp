@@ -86,11 +86,8 @@ void DutyCycleMeasurement::Refresh()
 	float midpoint = GetAvgVoltage(sdin, udin);
 
 	//Timestamps of the edges
-	vector<int64_t> edges;
-	if(sdin)
-		FindZeroCrossings(sdin, midpoint, edges);
-	else
-		FindZeroCrossings(udin, midpoint, edges);
+	auto pedges = FindZeroCrossings(sdin, udin, midpoint);
+	auto& edges = *pedges;
 	if(edges.size() < 2)
 	{
 		SetData(NULL, 0);
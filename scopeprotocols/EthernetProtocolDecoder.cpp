@@ -49,6 +49,22 @@ EthernetProtocolDecoder::EthernetProtocolDecoder(const string& color)
 	m_parameters[m_outfile].m_fileIsOutput = true;
 
 	m_fpOut = NULL;
+
+	//Intern header columns and colors up front so the per-packet path doesn't need to look them up
+	m_destMacColumn = m_packetStore.GetColumnID("Dest MAC");
+	m_srcMacColumn = m_packetStore.GetColumnID("Src MAC");
+	m_vlanColumn = m_packetStore.GetColumnID("VLAN");
+	m_ethertypeColumn = m_packetStore.GetColumnID("Ethertype");
+
+	m_blackColor = m_packetStore.GetColorID("#000000");
+	m_llcColor = m_packetStore.GetColorID("#33a02c");
+	m_stpColor = m_packetStore.GetColorID("#fdbf6f");
+	m_ipv4Color = m_packetStore.GetColorID("#a6cee3");
+	m_arpColor = m_packetStore.GetColorID("#ffff99");
+	m_vlanColor = m_packetStore.GetColorID("#b2df8a");
+	m_ipv6Color = m_packetStore.GetColorID("#1f78b4");
+	m_lldpColor = m_packetStore.GetColorID("#5e4fa2");
+	m_otherEthertypeColor = m_packetStore.GetColorID("#fb9a99");
 }
 
 EthernetProtocolDecoder::~EthernetProtocolDecoder()
@@ -129,7 +145,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 		}
 	}
 
-	Packet* pack = new Packet;
+	size_t pack = m_packetStore.AddPacket(0);
 
 	EthernetFrameSegment segment;
 	segment.m_type = EthernetFrameSegment::TYPE_INVALID;
@@ -164,7 +180,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_data.push_back(0x55);
 
 					//Start a new packet
-					pack->m_offset = starts[i];
+					m_packetStore.SetOffset(pack, starts[i]);
 				}
 				break;
 
@@ -253,16 +269,11 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale );
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Dest MAC"] = tmp;
+					//Save the address, it's formatted for display only when the packet is viewed
+					int64_t mac = 0;
+					for(int j=0; j<6; j++)
+						mac = (mac << 8) | segment.m_data[j];
+					m_packetStore.SetHeader(m_destMacColumn, PacketStore::VALUE_MAC, mac);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_SRC_MAC;
@@ -289,16 +300,11 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Src MAC"] = tmp;
+					//Save the address, it's formatted for display only when the packet is viewed
+					int64_t mac = 0;
+					for(int j=0; j<6; j++)
+						mac = (mac << 8) | segment.m_data[j];
+					m_packetStore.SetHeader(m_srcMacColumn, PacketStore::VALUE_MAC, mac);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
@@ -338,64 +344,60 @@ void EthernetProtocolDecoder::BytesToFrames(
 					if(ethertype < 1500)
 					{
 						//Default to unknown LLC
-						pack->m_headers["Ethertype"] = "LLC";
-						pack->m_displayBackgroundColor = "#33a02c";
-						pack->m_displayForegroundColor = "#000000";
+						m_packetStore.SetHeader(m_ethertypeColumn, "LLC");
+						m_packetStore.SetBackgroundColor(pack, m_llcColor);
+						m_packetStore.SetForegroundColor(pack, m_blackColor);
 
 						//Look up the LLC LSAP address to see what it is
 						if( (i+1) < bytes.size() )
 						{
 							if(bytes[i+1] == 0x42)
 							{
-								pack->m_headers["Ethertype"] = "STP";
-								pack->m_displayBackgroundColor = "#fdbf6f";
-								pack->m_displayForegroundColor = "#000000";
+								m_packetStore.SetHeader(m_ethertypeColumn, "STP");
+								m_packetStore.SetBackgroundColor(pack, m_stpColor);
+								m_packetStore.SetForegroundColor(pack, m_blackColor);
 							}
 						}
 					}
 					else
 					{
-						char tmp[64];
 						switch(ethertype)
 						{
 							case 0x0800:
-								pack->m_headers["Ethertype"] = "IPv4";
-								pack->m_displayBackgroundColor = "#a6cee3";
-								pack->m_displayForegroundColor = "#000000";
+								m_packetStore.SetHeader(m_ethertypeColumn, "IPv4");
+								m_packetStore.SetBackgroundColor(pack, m_ipv4Color);
+								m_packetStore.SetForegroundColor(pack, m_blackColor);
 								break;
 
 							case 0x0806:
-								pack->m_headers["Ethertype"] = "ARP";
-								pack->m_displayBackgroundColor = "#ffff99";
-								pack->m_displayForegroundColor = "#000000";
+								m_packetStore.SetHeader(m_ethertypeColumn, "ARP");
+								m_packetStore.SetBackgroundColor(pack, m_arpColor);
+								m_packetStore.SetForegroundColor(pack, m_blackColor);
 								break;
 
 							//TODO: decoder inner ethertype too?
 							case 0x8100:
-								pack->m_headers["Ethertype"] = "802.1q";
-								pack->m_displayBackgroundColor = "#b2df8a";
-								pack->m_displayForegroundColor = "#000000";
+								m_packetStore.SetHeader(m_ethertypeColumn, "802.1q");
+								m_packetStore.SetBackgroundColor(pack, m_vlanColor);
+								m_packetStore.SetForegroundColor(pack, m_blackColor);
 								break;
 
 							case 0x86DD:
-								pack->m_headers["Ethertype"] = "IPv6";
-								pack->m_displayBackgroundColor = "#1f78b4";
-								pack->m_displayForegroundColor = "#ffffff";
+								m_packetStore.SetHeader(m_ethertypeColumn, "IPv6");
+								m_packetStore.SetBackgroundColor(pack, m_ipv6Color);
+								m_packetStore.SetForegroundColor(pack, m_packetStore.m_defaultForeground);
 								break;
 
 							case 0x88cc:
-								pack->m_headers["Ethertype"] = "LLDP";
-								pack->m_displayBackgroundColor = "#5e4fa2";
-								pack->m_displayForegroundColor = "#ffffff";
+								m_packetStore.SetHeader(m_ethertypeColumn, "LLDP");
+								m_packetStore.SetBackgroundColor(pack, m_lldpColor);
+								m_packetStore.SetForegroundColor(pack, m_packetStore.m_defaultForeground);
 								break;
 
 							default:
-								snprintf(tmp, sizeof(tmp), "%02x%02x",
-								segment.m_data[0],
-								segment.m_data[1]);
-								pack->m_headers["Ethertype"] = tmp;
-								pack->m_displayBackgroundColor = "#fb9a99";
-								pack->m_displayForegroundColor = "#000000";
+								m_packetStore.SetHeader(m_ethertypeColumn, PacketStore::VALUE_HEX, ethertype, 4);
+								m_packetStore.SetBackgroundColor(pack, m_otherEthertypeColor);
+								m_packetStore.SetForegroundColor(pack, m_blackColor);
 								break;
 						}
 					}
@@ -435,10 +437,8 @@ void EthernetProtocolDecoder::BytesToFrames(
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
 					segment.m_data.clear();
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%d", tag & 0xfff);
-					pack->m_headers["VLAN"] = tmp;
+					//Save the VLAN ID
+					m_packetStore.SetHeader(m_vlanColumn, PacketStore::VALUE_DECIMAL, tag & 0xfff);
 				}
 
 				break;
@@ -455,15 +455,14 @@ void EthernetProtocolDecoder::BytesToFrames(
 				segment.m_data.push_back(bytes[i]);
 				cap->m_samples.push_back(segment);
 
-				pack->m_data.push_back(bytes[i]);
+				m_packetStore.AppendData(bytes[i]);
 
 				//If almost at end of packet, next 4 bytes are FCS
 				if(suppressedPreambleAndFCS)
 				{
 					if(i == bytes.size()-1)
 					{
-						pack->m_len = ends[i] - pack->m_offset;
-						m_packets.push_back(pack);
+						m_packetStore.SetLength(pack, ends[i] - m_packetStore.GetOffset(pack));
 						return;
 					}
 				}
@@ -496,16 +495,15 @@ void EthernetProtocolDecoder::BytesToFrames(
 					if(crc_actual != crc_expected)
 					{
 						segment.m_type = EthernetFrameSegment::TYPE_FCS_BAD;
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-						pack->m_displayForegroundColor = "#ffffff";
+						m_packetStore.SetBackgroundColor(pack, PROTO_COLOR_ERROR);
+						m_packetStore.SetForegroundColor(pack, m_packetStore.m_defaultForeground);
 						LogTrace("Frame CRC is %08x, expected %08x\n", crc_actual, crc_expected);
 					}
 
 					cap->m_durations.push_back( (ends[i] - start)/ cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					pack->m_len = ends[i] - pack->m_offset;
-					m_packets.push_back(pack);
+					m_packetStore.SetLength(pack, ends[i] - m_packetStore.GetOffset(pack));
 					return;
 				}
 
@@ -517,7 +515,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 	}
 
 	//If we get here it wasn't a valid frame
-	delete pack;
+	m_packetStore.DiscardLastPacket();
 }
 
 std::string EthernetWaveform::GetColor(size_t i)
@@ -108,6 +108,23 @@ protected:
 	std::string m_outfile;
 	std::string m_cachedOutputFname;
 	FILE* m_fpOut;
+
+	//Packet store column IDs
+	uint16_t m_destMacColumn;
+	uint16_t m_srcMacColumn;
+	uint16_t m_vlanColumn;
+	uint16_t m_ethertypeColumn;
+
+	//Packet store color IDs
+	uint16_t m_blackColor;
+	uint16_t m_llcColor;
+	uint16_t m_stpColor;
+	uint16_t m_ipv4Color;
+	uint16_t m_arpColor;
+	uint16_t m_vlanColor;
+	uint16_t m_ipv6Color;
+	uint16_t m_lldpColor;
+	uint16_t m_otherEthertypeColor;
 };
 
 #endif
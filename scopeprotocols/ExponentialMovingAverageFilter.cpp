@@ -131,11 +131,7 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 		//Actual filter code path
 		else
 		{
-			auto pin = sdin->m_samples.GetCpuPointer();
-			auto pout = scap->m_samples.GetCpuPointer();
-
-			for(size_t i=0; i<len; i++)
-				pout[i] = pout[i]*decay + pin[i]*(1-decay);
+			ExponentialBlendSamples(scap->m_samples.GetCpuPointer(), sdin->m_samples.GetCpuPointer(), len, decay);
 		}
 
 		//Either way we want to reuse the timestamps
@@ -158,11 +154,7 @@ void ExponentialMovingAverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/
 		//Actual filter code path
 		else
 		{
-			auto pin = udin->m_samples.GetCpuPointer();
-			auto pout = ucap->m_samples.GetCpuPointer();
-
-			for(size_t i=0; i<len; i++)
-				pout[i] = pout[i]*decay + pin[i]*(1-decay);
+			ExponentialBlendSamples(ucap->m_samples.GetCpuPointer(), udin->m_samples.GetCpuPointer(), len, decay);
 		}
 	}
 
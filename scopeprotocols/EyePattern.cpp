@@ -199,29 +199,31 @@ void EyePattern::Refresh(
 	if(cap == NULL)
 		cap = ReallocateWaveform();
 	cap->m_saturationLevel = m_parameters[m_saturationName].GetFloatVal();
+	cap->m_revision ++;
 	int64_t* data = cap->GetAccumData();
 
 	//Find all toggles in the clock
-	vector<int64_t> clock_edges;
+	EdgeList pclock;
 	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clock);
 	auto uclk = dynamic_cast<UniformDigitalWaveform*>(clock);
 	switch(m_parameters[m_polarityName].GetIntVal())
 	{
 		case CLOCK_RISING:
-			FindRisingEdges(sclk, uclk, clock_edges);
+			pclock = FindRisingEdges(sclk, uclk);
 			break;
 
 		case CLOCK_FALLING:
-			FindFallingEdges(sclk, uclk, clock_edges);
+			pclock = FindFallingEdges(sclk, uclk);
 			break;
 
 		case CLOCK_BOTH:
-			FindZeroCrossings(sclk, uclk, clock_edges);
+		default:
+			pclock = FindZeroCrossings(sclk, uclk);
 			break;
 	}
 
 	//If no clock edges, don't change anything
-	if(clock_edges.empty())
+	if(pclock->empty())
 		return;
 
 	//Calculate the nominal UI width
@@ -230,11 +232,15 @@ void EyePattern::Refresh(
 
 	//Shift the clock by half a UI if it's edge aligned
 	//All of the eye creation logic assumes a center aligned clock.
+	//The edge list is shared with other filters so we have to shift a private copy.
 	if(clock_align == ALIGN_EDGE)
 	{
-		for(size_t i=0; i<clock_edges.size(); i++)
-			clock_edges[i] += cap->m_uiWidth / 2;
+		auto shifted = make_shared<vector<int64_t> >(*pclock);
+		for(auto& t : *shifted)
+			t += cap->m_uiWidth / 2;
+		pclock = shifted;
 	}
+	auto& clock_edges = *pclock;
 
 	//Recompute scales
 	float eye_width_fs = 2 * cap->m_uiWidth;
@@ -286,7 +292,7 @@ void EyePattern::Refresh(
 __attribute__((target("avx2")))
 void EyePattern::DensePackedInnerLoopAVX2(
 	UniformAnalogWaveform* waveform,
-	vector<int64_t>& clock_edges,
+	const vector<int64_t>& clock_edges,
 	int64_t* data,
 	size_t wend,
 	size_t cend,
@@ -468,7 +474,7 @@ void EyePattern::DensePackedInnerLoopAVX2(
 
 void EyePattern::DensePackedInnerLoop(
 	UniformAnalogWaveform* waveform,
-	vector<int64_t>& clock_edges,
+	const vector<int64_t>& clock_edges,
 	int64_t* data,
 	size_t wend,
 	size_t cend,
@@ -542,7 +548,7 @@ void EyePattern::DensePackedInnerLoop(
 
 void EyePattern::SparsePackedInnerLoop(
 	SparseAnalogWaveform* waveform,
-	vector<int64_t>& clock_edges,
+	const vector<int64_t>& clock_edges,
 	int64_t* data,
 	size_t wend,
 	size_t cend,
@@ -641,25 +647,27 @@ void EyePattern::RecalculateUIWidth()
 		return;
 
 	//Find all toggles in the clock
-	vector<int64_t> clock_edges;
+	EdgeList pclock;
 	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clock);
 	auto uclk = dynamic_cast<UniformDigitalWaveform*>(clock);
 	switch(m_parameters[m_polarityName].GetIntVal())
 	{
 		case CLOCK_RISING:
-			FindRisingEdges(sclk, uclk, clock_edges);
+			pclock = FindRisingEdges(sclk, uclk);
 			break;
 
 		case CLOCK_FALLING:
-			FindFallingEdges(sclk, uclk, clock_edges);
+			pclock = FindFallingEdges(sclk, uclk);
 			break;
 
 		case CLOCK_BOTH:
-			FindZeroCrossings(sclk, uclk, clock_edges);
+		default:
+			pclock = FindZeroCrossings(sclk, uclk);
 			break;
 	}
 
 	//If no clock edges, don't change anything
+	auto& clock_edges = *pclock;
 	if(clock_edges.empty())
 		return;
 
@@ -123,7 +123,7 @@ protected:
 
 	void SparsePackedInnerLoop(
 		SparseAnalogWaveform* waveform,
-		std::vector<int64_t>& clock_edges,
+		const std::vector<int64_t>& clock_edges,
 		int64_t* data,
 		size_t wend,
 		size_t cend,
@@ -136,7 +136,7 @@ protected:
 
 	void DensePackedInnerLoop(
 		UniformAnalogWaveform* waveform,
-		std::vector<int64_t>& clock_edges,
+		const std::vector<int64_t>& clock_edges,
 		int64_t* data,
 		size_t wend,
 		size_t cend,
@@ -150,7 +150,7 @@ protected:
 #ifdef __x86_64__
 	void DensePackedInnerLoopAVX2(
 		UniformAnalogWaveform* waveform,
-		std::vector<int64_t>& clock_edges,
+		const std::vector<int64_t>& clock_edges,
 		int64_t* data,
 		size_t wend,
 		size_t cend,
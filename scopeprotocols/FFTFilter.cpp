@@ -55,6 +55,7 @@ FFTFilter::FFTFilter(const string& color)
 	m_cachedNumPoints = 0;
 	m_cachedNumPointsFFT = 0;
 	m_cachedNumOuts = 0;
+	m_cachedCpuWindowType = WINDOW_RECTANGULAR;
 
 	//Default config
 	m_range = 70;
@@ -121,13 +122,76 @@ string FFTFilter::GetProtocolName()
 
 Filter::DataLocation FFTFilter::GetInputLocation()
 {
-	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	//If this FFT is going to run on the CPU, pull the input over before Refresh() is called.
+	//Otherwise we explicitly manage our input memory and don't care where it is.
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	if(din && CPUFFTPlan::IsPreferred(RoundPointCount(din->size()), 1, false))
+		return LOC_CPU;
+
 	return LOC_DONTCARE;
 }
 
+/**
+	@brief Calculates window function coefficients on the CPU
+
+	This uses the same math as the window shaders, so the CPU and GPU paths give the same results.
+
+	@param window				The window function to use
+	@param numActualSamples		Number of coefficients to calculate
+	@param coeffs				Output coefficients
+ */
+void FFTFilter::CalculateWindow(WindowFunction window, size_t numActualSamples, float* coeffs)
+{
+	double scale = 2 * M_PI / numActualSamples;
+
+	switch(window)
+	{
+		case WINDOW_BLACKMAN_HARRIS:
+			{
+				const double alpha0 = 0.35875;
+				const double alpha1 = 0.48829;
+				const double alpha2 = 0.14128;
+				const double alpha3 = 0.01168;
+				for(size_t i=0; i<numActualSamples; i++)
+				{
+					double num = i * scale;
+					coeffs[i] = alpha0 - alpha1*cos(num) + alpha2*cos(2*num) - alpha3*cos(6*num);
+				}
+			}
+			break;
+
+		case WINDOW_HANN:
+		case WINDOW_HAMMING:
+			{
+				double alpha0 = (window == WINDOW_HANN) ? 0.5 : (25.0 / 46);
+				double alpha1 = 1 - alpha0;
+				for(size_t i=0; i<numActualSamples; i++)
+					coeffs[i] = alpha0 - alpha1*cos(i * scale);
+			}
+			break;
+
+		case WINDOW_RECTANGULAR:
+		default:
+			for(size_t i=0; i<numActualSamples; i++)
+				coeffs[i] = 1;
+			break;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Returns the number of FFT points to use for a given input length, according to the rounding mode
+ */
+size_t FFTFilter::RoundPointCount(size_t npoints_raw)
+{
+	if(m_parameters[m_roundingName].GetIntVal() == ROUND_TRUNCATE)
+		return prev_pow2(npoints_raw);
+	else
+		return next_pow2(npoints_raw);
+}
+
 void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nouts)
 {
 	m_cachedNumPoints = npoints_raw;
@@ -141,13 +205,17 @@ void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nou
 	m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdoutbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
+	//Plans are created on first use, since we might only ever need one of them
 	if(m_vkPlan)
 	{
 		if(m_vkPlan->size() != npoints)
 			m_vkPlan = nullptr;
 	}
-	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	if(m_cpuPlan)
+	{
+		if(m_cpuPlan->size() != npoints)
+			m_cpuPlan = nullptr;
+	}
 
 	m_rdinbuf.resize(npoints);
 	m_rdoutbuf.resize(2*nouts);
@@ -164,11 +232,7 @@ void FFTFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
 
 	const size_t npoints_raw = din->size();
-	size_t npoints;
-	if(m_parameters[m_roundingName].GetIntVal() == ROUND_TRUNCATE)
-		npoints = prev_pow2(npoints_raw);
-	else
-		npoints = next_pow2(npoints_raw);
+	size_t npoints = RoundPointCount(npoints_raw);
 	LogTrace("FFTFilter: processing %zu raw points\n", npoints_raw);
 	LogTrace("Rounded to %zu\n", npoints);
 
@@ -230,6 +294,17 @@ void FFTFilter::DoRefresh(
 			break;
 	}
 
+	//Small transforms of CPU-resident data, or no usable GPU? Do it all on the CPU
+	if(CPUFFTPlan::IsPreferred(npoints, 1, data.IsCpuBufferStale()))
+	{
+		DoRefreshCPU(data, cap, window, numActualSamples, npoints, nouts, scale, log_output);
+		FindPeaks(cap);
+		return;
+	}
+
+	if(!m_vkPlan || (m_vkPlan->size() != npoints) )
+		m_vkPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+
 	//Configure the window
 	WindowFunctionArgs args;
 	args.numActualSamples = numActualSamples;
@@ -309,3 +384,70 @@ void FFTFilter::DoRefresh(
 	//Peak search (for now this runs on the CPU)
 	FindPeaks(cap);
 }
+
+/**
+	@brief Runs the window, FFT, and magnitude calculation on the CPU
+
+	Equivalent to the shader path in DoRefresh().
+ */
+void FFTFilter::DoRefreshCPU(
+	AcceleratorBuffer<float>& data,
+	UniformAnalogWaveform* cap,
+	WindowFunction window,
+	size_t numActualSamples,
+	size_t npoints,
+	size_t nouts,
+	float scale,
+	bool log_output)
+{
+	if(!m_cpuPlan || (m_cpuPlan->size() != npoints) )
+		m_cpuPlan = make_unique<CPUFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+
+	//Update cached window coefficients if the window changed
+	if( (m_cpuWindow.size() != numActualSamples) || (m_cachedCpuWindowType != window) )
+	{
+		m_cpuWindow.resize(numActualSamples);
+		CalculateWindow(window, numActualSamples, m_cpuWindow.data());
+		m_cachedCpuWindowType = window;
+	}
+
+	//Apply the window and zero pad
+	data.PrepareForCpuAccess();
+	m_cpuFFTInput.resize(npoints);
+	m_cpuFFTOutput.resize(2*nouts);
+	float* pin = data.GetCpuPointer();
+	float* pwin = m_cpuFFTInput.data();
+	const float* coeffs = m_cpuWindow.data();
+	for(size_t i=0; i<numActualSamples; i++)
+		pwin[i] = pin[i] * coeffs[i];
+	for(size_t i=numActualSamples; i<npoints; i++)
+		pwin[i] = 0;
+
+	m_cpuPlan->Forward(pwin, m_cpuFFTOutput.data());
+
+	//Convert complex to real
+	cap->PrepareForCpuAccess();
+	float* pout = cap->m_samples.GetCpuPointer();
+	const float* pfft = m_cpuFFTOutput.data();
+	if(log_output)
+	{
+		const float impedance = 50;
+		float cscale = scale * scale / impedance;
+		for(size_t i=0; i<nouts; i++)
+		{
+			float real = pfft[i*2];
+			float imag = pfft[i*2 + 1];
+			pout[i] = 10 * log10f((real*real + imag*imag) * cscale) + 30;
+		}
+	}
+	else
+	{
+		for(size_t i=0; i<nouts; i++)
+		{
+			float real = pfft[i*2];
+			float imag = pfft[i*2 + 1];
+			pout[i] = sqrtf(real*real + imag*imag) * scale;
+		}
+	}
+	cap->MarkModifiedFromCpu();
+}
@@ -36,6 +36,7 @@
 #define FFTFilter_h
 
 #include "VulkanFFTPlan.h"
+#include "CPUFFTPlan.h"
 
 class QueueHandle;
 
@@ -82,6 +83,8 @@ public:
 	void SetWindowFunction(WindowFunction f)
 	{ m_parameters[m_windowName].SetIntVal(f); }
 
+	static void CalculateWindow(WindowFunction window, size_t numActualSamples, float* coeffs);
+
 	//Accessors for internal values only used by unit tests
 	//TODO: refactor this into a friend class or something?
 	size_t test_GetNumPoints()
@@ -93,6 +96,7 @@ public:
 protected:
 
 	void ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nouts);
+	size_t RoundPointCount(size_t npoints_raw);
 
 	void DoRefresh(
 		WaveformBase* din,
@@ -105,6 +109,16 @@ protected:
 		std::shared_ptr<QueueHandle> queue
 		);
 
+	void DoRefreshCPU(
+		AcceleratorBuffer<float>& data,
+		UniformAnalogWaveform* cap,
+		WindowFunction window,
+		size_t numActualSamples,
+		size_t npoints,
+		size_t nouts,
+		float scale,
+		bool log_output);
+
 	size_t m_cachedNumPoints;
 	size_t m_cachedNumPointsFFT;
 	size_t m_cachedNumOuts;
@@ -119,6 +133,12 @@ protected:
 
 	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
 
+	std::unique_ptr<CPUFFTPlan> m_cpuPlan;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuWindow;
+	WindowFunction m_cachedCpuWindowType;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuFFTInput;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuFFTOutput;
+
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
 	ComputePipeline m_cosineSumComputePipeline;
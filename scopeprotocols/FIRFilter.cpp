@@ -138,6 +138,24 @@ Filter::DataLocation FIRFilter::GetInputLocation()
 	return LOC_DONTCARE;
 }
 
+bool FIRFilter::IsStreamingCapable()
+{
+	return true;
+}
+
+int64_t FIRFilter::GetStreamingOverlap()
+{
+	auto din = GetInputWaveform(0);
+	if(!din)
+		return 0;
+
+	//Coefficients aren't known until the first refresh, so assume the longest possible filter until then
+	size_t filterlen = m_coefficients.size();
+	if(filterlen == 0)
+		filterlen = 4096;
+	return (filterlen + 1) * din->m_timescale;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -272,6 +272,7 @@ void HistogramFilter::Refresh()
 	m_midpoint = m_range/2;
 
 	cap->m_flags |= didClipRange ? WaveformBase::WAVEFORM_CLIPPING : 0;
+	cap->m_revision ++;
 
 	cap->MarkModifiedFromCpu();
 }
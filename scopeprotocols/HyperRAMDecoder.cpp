@@ -163,6 +163,11 @@ void HyperRAMDecoder::Refresh()
 	size_t cslen = csn->size();
 	size_t rwdslen = rwds->size();
 
+	//Cursors for skipping between edges on uniform inputs
+	TransitionCursor csEdges(csn);
+	TransitionCursor clkEdges(clk);
+	TransitionCursor rwdsEdges(rwds);
+
 	while(true)
 	{
 		//Get the current samples
@@ -288,8 +293,8 @@ void HyperRAMDecoder::Refresh()
 				{
 					// The symbol should continue until the next RWDS edge in this transaction, if available.
 					// The final symbol may not have an RWDS edge after it, so use clk_time in that case.
-					auto next_rwds = GetNextEventTimestampScaled(srwds, urwds, irwds, rwdslen, timestamp);
-					auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, ics, cslen, timestamp);
+					auto next_rwds = GetNextEventTimestampScaled(srwds, urwds, rwdsEdges, irwds, rwdslen, timestamp);
+					auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, csEdges, ics, cslen, timestamp);
 					auto duration = next_rwds - timestamp;
 					if (next_rwds == timestamp || next_rwds > next_cs)
 						duration = clk_time;
@@ -310,8 +315,8 @@ void HyperRAMDecoder::Refresh()
 				}
 				else if (event_type == EVENT_CLK)
 				{
-					auto next_clk = GetNextEventTimestampScaled(sclk, uclk, iclk, clklen, timestamp);
-					auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, ics, cslen, timestamp);
+					auto next_clk = GetNextEventTimestampScaled(sclk, uclk, clkEdges, iclk, clklen, timestamp);
+					auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, csEdges, ics, cslen, timestamp);
 					auto sym_end = timestamp + (next_clk - timestamp) / 2;
 					if (next_clk == timestamp || next_clk > next_cs)
 						sym_end = timestamp + clk_time/2;
@@ -326,9 +331,9 @@ void HyperRAMDecoder::Refresh()
 		}
 
 		//Get timestamps of next event on each channel
-		auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, ics, cslen, timestamp);
-		auto next_clk = GetNextEventTimestampScaled(sclk, uclk, iclk, clklen, timestamp);
-		auto next_rwds = GetNextEventTimestampScaled(srwds, urwds, irwds, rwdslen, timestamp);
+		auto next_cs = GetNextEventTimestampScaled(scsn, ucsn, csEdges, ics, cslen, timestamp);
+		auto next_clk = GetNextEventTimestampScaled(sclk, uclk, clkEdges, iclk, clklen, timestamp);
+		auto next_rwds = GetNextEventTimestampScaled(srwds, urwds, rwdsEdges, irwds, rwdslen, timestamp);
 
 		// Find soonest event
 		auto next_timestamp = next_cs;
@@ -100,6 +100,10 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 	size_t 				iscl = 0;
 	int64_t 			timestamp	= 0;
 
+	//Cursors for skipping between edges on uniform inputs
+	Filter::TransitionCursor sdaEdges(sda);
+	Filter::TransitionCursor sclEdges(scl);
+
 	while(true)
 	{
 		bool cur_sda = sda->m_samples[isda];
@@ -267,8 +271,8 @@ void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap)
 		last_scl = cur_scl;
 
 		//Move on
-		int64_t next_sda = Filter::GetNextEventTimestampScaled(sda, isda, sdalen, timestamp);
-		int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, iscl, scllen, timestamp);
+		int64_t next_sda = Filter::GetNextEventTimestampScaled(sda, sdaEdges, isda, sdalen, timestamp);
+		int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, sclEdges, iscl, scllen, timestamp);
 		int64_t next_timestamp = min(next_sda, next_scl);
 		if(next_timestamp == timestamp)
 			break;
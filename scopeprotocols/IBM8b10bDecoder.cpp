@@ -85,6 +85,32 @@ string IBM8b10bDecoder::GetProtocolName()
 	return "8b/10b (IBM)";
 }
 
+bool IBM8b10bDecoder::IsStreamingCapable()
+{
+	return true;
+}
+
+/**
+	@brief Gets the overlap needed to find comma alignment before the start of a segment
+
+	Symbol alignment and running disparity aren't carried from one segment to the next, so each segment realigns on
+	its own leading overlap. If the recovered clock differs near a segment boundary (see
+	ClockRecoveryFilter::GetStreamingOverlap()), symbols there can start up to about one UI away from those of a single
+	pass over the whole record. scopebench accepts this through BenchmarkCase::m_segmentTolerance.
+ */
+int64_t IBM8b10bDecoder::GetStreamingOverlap()
+{
+	//Estimate the UI from the recovered clock
+	auto clkin = dynamic_cast<SparseDigitalWaveform*>(GetInputWaveform(1));
+	if(!clkin || (clkin->size() < 2) )
+		return 0;
+	clkin->m_offsets.PrepareForCpuAccess();
+	int64_t ui = (GetOffsetScaled(clkin, clkin->size()-1) - GetOffsetScaled(clkin, 0)) / (int64_t)(clkin->size() - 1);
+
+	//Need enough context to find a comma and align to it, plus one symbol
+	return (m_parameters[m_commaSearchWindow].GetIntVal() + 10) * ui;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -92,6 +92,9 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
+	virtual bool IsStreamingCapable() override;
+	virtual int64_t GetStreamingOverlap() override;
+
 	enum DisplayFormat
 	{
 		FORMAT_DOTTED,
@@ -46,6 +46,10 @@ J1939AnalogDecoder::J1939AnalogDecoder(const string& color)
 	, m_offset("Offset")
 	, m_format("Format")
 	, m_scalemode("Scale mode")
+	, m_state(STATE_IDLE)
+	, m_framestart(0)
+	, m_payload(0)
+	, m_tailDuration(0)
 {
 	AddStream(Unit(Unit::UNIT_COUNTS), "data", Stream::STREAM_TYPE_ANALOG);
 
@@ -133,21 +137,6 @@ void J1939AnalogDecoder::Refresh()
 	}
 	auto len = din->size();
 
-	//Make output waveform
-	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0);
-	cap->PrepareForCpuAccess();
-
-	enum
-	{
-		STATE_IDLE,
-		STATE_DATA,
-	} state = STATE_IDLE;
-
-	//Initial sample at time zero
-	cap->m_offsets.push_back(0);
-	cap->m_durations.push_back(0);
-	cap->m_samples.push_back(m_parameters[m_initValue].GetFloatVal());
-
 	auto format = static_cast<format_t>(m_parameters[m_format].GetIntVal());
 	auto scalemode = static_cast<scalemode_t>(m_parameters[m_scalemode].GetIntVal());
 	auto bitpos = m_parameters[m_bitpos].GetIntVal();
@@ -157,10 +146,41 @@ void J1939AnalogDecoder::Refresh()
 	if(scalemode == SCALE_DIV)
 		scale = 1.0 / scale;
 
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<SparseAnalogWaveform*>(GetData(0));
+	if(cap && (cap->size() >= 3) && GetAppendedInputStart(0, start))
+	{
+		cap->PrepareForCpuAccess();
+
+		//Remove the padding and undo the extension of the last sample
+		cap->Resize(cap->size() - 2);
+		cap->m_durations[cap->size() - 1] = m_tailDuration;
+		cap->m_revision ++;
+	}
+	else
+	{
+		start = 0;
+
+		//Make output waveform
+		cap = SetupEmptySparseAnalogOutputWaveform(din, 0);
+		cap->PrepareForCpuAccess();
+
+		//Initial sample at time zero
+		cap->m_offsets.push_back(0);
+		cap->m_durations.push_back(0);
+		cap->m_samples.push_back(m_parameters[m_initValue].GetFloatVal());
+
+		m_state = STATE_IDLE;
+		m_framestart = 0;
+		m_payload = 0;
+	}
+
 	//TODO: support >8 byte packets
-	int64_t framestart = 0;
-	uint64_t payload = 0;
-	for(size_t i=0; i<len; i++)
+	auto& state = m_state;
+	auto& framestart = m_framestart;
+	auto& payload = m_payload;
+	for(size_t i=start; i<len; i++)
 	{
 		auto& s = din->m_samples[i];
 
@@ -242,6 +262,7 @@ void J1939AnalogDecoder::Refresh()
 
 	//Extend the last sample to the end of the capture
 	size_t nlast = cap->m_offsets.size() - 1;
+	m_tailDuration = cap->m_durations[nlast];
 	cap->m_durations[nlast] = (din->m_offsets[len-1] * din->m_timescale) - cap->m_offsets[nlast];
 
 	//Add three padding samples (do we still have this rendering bug??)
@@ -73,6 +73,24 @@ protected:
 		SCALE_DIV
 	};
 	std::string m_scalemode;
+
+	//Decoder state, kept so appended input can be decoded incrementally
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_DATA
+	} m_state;
+
+	///@brief Start time of the frame being decoded
+	int64_t m_framestart;
+
+	///@brief Payload bytes of the frame being decoded so far
+	uint64_t m_payload;
+
+	///@brief Duration of the last real output sample before it was extended to the end of the capture
+	int64_t m_tailDuration;
 };
 
 #endif
@@ -42,6 +42,10 @@ J1939BitmaskDecoder::J1939BitmaskDecoder(const string& color)
 	, m_pgn("PGN")
 	, m_bitmask("Pattern Bitmask")
 	, m_pattern("Pattern Target")
+	, m_state(STATE_IDLE)
+	, m_framestart(0)
+	, m_payload(0)
+	, m_tailDuration(0)
 {
 	AddDigitalStream("data");
 
@@ -101,29 +105,45 @@ void J1939BitmaskDecoder::Refresh()
 	}
 	auto len = din->size();
 
-	//Make output waveform
-	auto cap = SetupEmptySparseDigitalOutputWaveform(din, 0);
-	cap->PrepareForCpuAccess();
+	int64_t mask = m_parameters[m_bitmask].GetIntVal();
+	int64_t pattern = m_parameters[m_pattern].GetIntVal();
+	auto targetaddr = m_parameters[m_pgn].GetIntVal() ;
 
-	enum
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<SparseDigitalWaveform*>(GetData(0));
+	if(cap && (cap->size() >= 3) && GetAppendedInputStart(0, start))
 	{
-		STATE_IDLE,
-		STATE_DATA,
-	} state = STATE_IDLE;
+		cap->PrepareForCpuAccess();
 
-	//Initial sample at time zero
-	cap->m_offsets.push_back(0);
-	cap->m_durations.push_back(0);
-	cap->m_samples.push_back(static_cast<bool>(m_parameters[m_initValue].GetIntVal()));
+		//Remove the padding and undo the extension of the last sample
+		cap->Resize(cap->size() - 2);
+		cap->m_durations[cap->size() - 1] = m_tailDuration;
+		cap->m_revision ++;
+	}
+	else
+	{
+		start = 0;
 
-	int64_t mask = m_parameters[m_bitmask].GetIntVal();
-	int64_t pattern = m_parameters[m_pattern].GetIntVal();
-	auto targetaddr = m_parameters[m_pgn].GetIntVal() ;
+		//Make output waveform
+		cap = SetupEmptySparseDigitalOutputWaveform(din, 0);
+		cap->PrepareForCpuAccess();
+
+		//Initial sample at time zero
+		cap->m_offsets.push_back(0);
+		cap->m_durations.push_back(0);
+		cap->m_samples.push_back(static_cast<bool>(m_parameters[m_initValue].GetIntVal()));
+
+		m_state = STATE_IDLE;
+		m_framestart = 0;
+		m_payload = 0;
+	}
 
 	//TODO: support >8 byte packetds
-	int64_t framestart = 0;
-	int64_t payload = 0;
-	for(size_t i=0; i<len; i++)
+	auto& state = m_state;
+	auto& framestart = m_framestart;
+	auto& payload = m_payload;
+	for(size_t i=start; i<len; i++)
 	{
 		auto& s = din->m_samples[i];
 
@@ -186,6 +206,7 @@ void J1939BitmaskDecoder::Refresh()
 
 	//Extend the last sample to the end of the capture
 	size_t nlast = cap->m_offsets.size() - 1;
+	m_tailDuration = cap->m_durations[nlast];
 	cap->m_durations[nlast] = (din->m_offsets[len-1] * din->m_timescale) - cap->m_offsets[nlast];
 
 	//Add three padding samples (do we still have this rendering bug??)
@@ -38,6 +38,9 @@ using namespace std;
 
 J1939PDUDecoder::J1939PDUDecoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_state(STATE_IDLE)
+	, m_bytesleft(0)
+	, m_pack(nullptr)
 {
 	CreateInput("can");
 }
@@ -85,42 +88,52 @@ string J1939PDUDecoder::GetProtocolName()
 
 void J1939PDUDecoder::Refresh()
 {
-	ClearPackets();
-
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
 
 	auto din = dynamic_cast<CANWaveform*>(GetInputWaveform(0));
-	auto len = din->size();
 	if(!din)
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
+	auto len = din->size();
 
-	//Create the capture
-	auto cap = new J1939PDUWaveform;
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = 0;
-	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
-
-	enum
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<J1939PDUWaveform*>(GetData(0));
+	bool appending = cap && GetAppendedInputStart(0, start);
+	if(appending)
+		cap->PrepareForCpuAccess();
+	else
 	{
-		STATE_IDLE,
-		STATE_DLC,
-		STATE_DATA
-	} state = STATE_IDLE;
+		start = 0;
+		ClearPackets();
+
+		//Create the capture
+		cap = new J1939PDUWaveform;
+		cap->m_timescale = 1;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = 0;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+
+		m_state = STATE_IDLE;
+		m_bytesleft = 0;
+		m_pack = nullptr;
+	}
 
 	//Process the CAN packet stream
-	size_t bytesleft = 0;
-	Packet* pack = nullptr;
-	for(size_t i=0; i<len; i++)
+	auto& state = m_state;
+	auto& bytesleft = m_bytesleft;
+	auto& pack = m_pack;
+	for(size_t i=start; i<len; i++)
 	{
 		auto& s = din->m_samples[i];
 
@@ -251,6 +264,8 @@ void J1939PDUDecoder::Refresh()
 	}
 
 	//Done updating
+	if(appending)
+		cap->MarkSamplesAppended();
 	cap->MarkModifiedFromCpu();
 }
 
@@ -90,6 +90,22 @@ public:
 	PROTOCOL_DECODER_INITPROC(J1939PDUDecoder)
 
 protected:
+
+	//Decoder state, kept so appended input can be decoded incrementally
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_DLC,
+		STATE_DATA
+	} m_state;
+
+	///@brief Number of payload bytes still expected
+	size_t m_bytesleft;
+
+	///@brief The packet currently being decoded, if any
+	Packet* m_pack;
 };
 
 #endif
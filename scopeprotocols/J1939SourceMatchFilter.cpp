@@ -38,6 +38,10 @@ using namespace std;
 J1939SourceMatchFilter::J1939SourceMatchFilter(const string& color)
 	: PacketDecoder(color, CAT_BUS)
 	, m_sourceAddr("Source address")
+	, m_state(STATE_IDLE)
+	, m_nstart(0)
+	, m_srcPacketsDone(0)
+	, m_lastPacketCopy(nullptr)
 {
 	CreateInput("j1939");
 
@@ -88,59 +92,81 @@ string J1939SourceMatchFilter::GetProtocolName()
 
 void J1939SourceMatchFilter::Refresh()
 {
-	ClearPackets();
-
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
 
 	auto din = dynamic_cast<J1939PDUWaveform*>(GetInputWaveform(0));
-	auto len = din->size();
 	if(!din)
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
-
-	//Create the capture
-	auto cap = new J1939PDUWaveform;
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = 0;
-	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
-
-	enum
-	{
-		STATE_IDLE,
-		STATE_PGN,
-		STATE_SOURCE,
-		STATE_DATA,
-		STATE_GARBAGE
-	} state = STATE_IDLE;
+	auto len = din->size();
+	auto& srcPackets = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel)->GetPackets();
 
 	//Find the target
 	auto target = m_parameters[m_sourceAddr].GetIntVal();
 	auto starget = to_string(target);
 
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<J1939PDUWaveform*>(GetData(0));
+	bool appending =
+		cap && GetAppendedInputStart(0, start) && (srcPackets.size() >= m_srcPacketsDone);
+	if(appending)
+	{
+		cap->PrepareForCpuAccess();
+
+		//The last packet we looked at may have still been in progress, update our copy of it
+		if(m_lastPacketCopy)
+			*m_lastPacketCopy = *srcPackets[m_srcPacketsDone - 1];
+	}
+	else
+	{
+		start = 0;
+		ClearPackets();
+
+		//Create the capture
+		cap = new J1939PDUWaveform;
+		cap->m_timescale = 1;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = 0;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+
+		m_state = STATE_IDLE;
+		m_nstart = 0;
+		m_srcPacketsDone = 0;
+		m_lastPacketCopy = nullptr;
+	}
+
 	//Filter the packet stream separately from the timeline stream
-	auto& srcPackets = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel)->GetPackets();
-	for(auto p : srcPackets)
+	for(; m_srcPacketsDone < srcPackets.size(); m_srcPacketsDone ++)
 	{
+		auto p = srcPackets[m_srcPacketsDone];
+		m_lastPacketCopy = nullptr;
 		if(p->m_headers["Source"] == starget)
 		{
 			auto np = new Packet;
 			*np = *p;
 			m_packets.push_back(np);
+			m_lastPacketCopy = np;
 		}
 	}
 
 	//Process the J1939 packet stream
-	size_t nstart = 0;
-	for(size_t i=0; i<len; i++)
+	//(if an incomplete frame from the last refresh turns out to be garbage, samples we already output are removed)
+	size_t base = cap->size();
+	size_t keep = base;
+	auto& state = m_state;
+	auto& nstart = m_nstart;
+	for(size_t i=start; i<len; i++)
 	{
 		auto& s = din->m_samples[i];
 
@@ -166,6 +192,7 @@ void J1939SourceMatchFilter::Refresh()
 					cap->m_offsets.resize(nstart);
 					cap->m_durations.resize(nstart);
 					cap->m_samples.resize(nstart);
+					keep = min(keep, nstart);
 					state = STATE_GARBAGE;
 				}
 				break;
@@ -195,6 +222,7 @@ void J1939SourceMatchFilter::Refresh()
 					cap->m_offsets.resize(nstart);
 					cap->m_durations.resize(nstart);
 					cap->m_samples.resize(nstart);
+					keep = min(keep, nstart);
 					state = STATE_GARBAGE;
 				}
 				break;
@@ -230,5 +258,12 @@ void J1939SourceMatchFilter::Refresh()
 	}
 
 	//Done updating
+	if(appending)
+	{
+		if(keep == base)
+			cap->MarkSamplesAppended();
+		else
+			cap->m_revision ++;
+	}
 	cap->MarkModifiedFromCpu();
 }
@@ -53,6 +53,27 @@ public:
 
 protected:
 	std::string m_sourceAddr;
+
+	//Decoder state, kept so appended input can be decoded incrementally
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_PGN,
+		STATE_SOURCE,
+		STATE_DATA,
+		STATE_GARBAGE
+	} m_state;
+
+	///@brief Index of the first output sample of the frame being decoded
+	size_t m_nstart;
+
+	///@brief Number of packets from the upstream decoder we've already filtered
+	size_t m_srcPacketsDone;
+
+	///@brief Our copy of the last upstream packet we filtered, if it matched (it may still have been in progress)
+	Packet* m_lastPacketCopy;
 };
 
 #endif
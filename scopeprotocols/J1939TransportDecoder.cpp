@@ -37,8 +37,17 @@ using namespace std;
 
 J1939TransportDecoder::J1939TransportDecoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_state(STATE_IDLE)
+	, m_nstart(0)
+	, m_currentPGN(0)
+	, m_currentSrc(0)
+	, m_currentDst(0)
+	, m_currentPacketStart(0)
 {
 	CreateInput("j1939");
+
+	for(int i=0; i<256; i++)
+		m_workingPacketsBySourceAddress[i] = nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,39 +95,54 @@ string J1939TransportDecoder::GetProtocolName()
 
 void J1939TransportDecoder::Refresh()
 {
-	ClearPackets();
-
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
 
 	auto din = dynamic_cast<J1939PDUWaveform*>(GetInputWaveform(0));
-	auto len = din->size();
 	if(!din)
 	{
+		ClearPackets();
 		SetData(nullptr, 0);
 		return;
 	}
+	auto len = din->size();
 
-	//Create the capture
-	auto cap = new J1939PDUWaveform;
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = 0;
-	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
-
-	enum
+	//If the input has only grown since last time, pick up where we left off
+	size_t start = 0;
+	auto cap = dynamic_cast<J1939PDUWaveform*>(GetData(0));
+	bool appending = cap && GetAppendedInputStart(0, start);
+	if(appending)
+		cap->PrepareForCpuAccess();
+	else
 	{
-		STATE_IDLE,
-		STATE_PGN,
-		STATE_SOURCE,
-		STATE_DATA,
-		STATE_GARBAGE
-	} state = STATE_IDLE;
+		start = 0;
+		ClearPackets();
+
+		//Create the capture
+		cap = new J1939PDUWaveform;
+		cap->m_timescale = 1;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = 0;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+
+		//In-progress transport layer packets
+		for(int i=0; i<256; i++)
+			m_workingPacketsBySourceAddress[i] = nullptr;
+
+		m_state = STATE_IDLE;
+		m_nstart = 0;
+		m_currentPGN = 0;
+		m_currentSrc = 0;
+		m_currentDst = 0;
+		m_currentPacketBytes.clear();
+		m_currentPacketStart = 0;
+	}
 
 	/*
 	//Filter the packet stream separately from the timeline stream
@@ -134,21 +158,21 @@ void J1939TransportDecoder::Refresh()
 	}
 	*/
 
-	//In-progress transport layer packets
-	[[maybe_unused]] Packet* workingPacketsBySourceAddress[256];
-	for(int i=0; i<256; i++)
-		workingPacketsBySourceAddress[i] = {nullptr};
-
 	//TODO: generate packet output for non-transport-coded packets
 
 	//Process the J1939 packet stream
-	size_t nstart = 0;
-	uint32_t currentPGN = 0;
-	uint8_t currentSrc = 0;
-	uint8_t currentDst = 0;
-	vector<uint8_t> currentPacketBytes;
-	int64_t currentPacketStart = 0;
-	for(size_t i=0; i<len; i++)
+	//(if an incomplete frame from the last refresh turns out to be garbage, samples we already output are removed)
+	size_t base = cap->size();
+	size_t keep = base;
+	auto& state = m_state;
+	auto& workingPacketsBySourceAddress = m_workingPacketsBySourceAddress;
+	auto& nstart = m_nstart;
+	auto& currentPGN = m_currentPGN;
+	auto& currentSrc = m_currentSrc;
+	auto& currentDst = m_currentDst;
+	auto& currentPacketBytes = m_currentPacketBytes;
+	auto& currentPacketStart = m_currentPacketStart;
+	for(size_t i=start; i<len; i++)
 	{
 		auto& s = din->m_samples[i];
 		int64_t tstart = din->m_offsets[i] * din->m_timescale + din->m_triggerPhase;
@@ -178,6 +202,7 @@ void J1939TransportDecoder::Refresh()
 					cap->m_offsets.resize(nstart);
 					cap->m_durations.resize(nstart);
 					cap->m_samples.resize(nstart);
+					keep = min(keep, nstart);
 					state = STATE_GARBAGE;
 				}
 				break;
@@ -211,6 +236,7 @@ void J1939TransportDecoder::Refresh()
 					cap->m_offsets.resize(nstart);
 					cap->m_durations.resize(nstart);
 					cap->m_samples.resize(nstart);
+					keep = min(keep, nstart);
 					state = STATE_GARBAGE;
 				}
 				break;
@@ -303,5 +329,12 @@ void J1939TransportDecoder::Refresh()
 	}
 
 	//Done updating
+	if(appending)
+	{
+		if(keep == base)
+			cap->MarkSamplesAppended();
+		else
+			cap->m_revision ++;
+	}
 	cap->MarkModifiedFromCpu();
 }
@@ -52,6 +52,39 @@ public:
 	PROTOCOL_DECODER_INITPROC(J1939TransportDecoder)
 
 protected:
+
+	//Decoder state, kept so appended input can be decoded incrementally
+
+	///@brief Decoder states
+	enum
+	{
+		STATE_IDLE,
+		STATE_PGN,
+		STATE_SOURCE,
+		STATE_DATA,
+		STATE_GARBAGE
+	} m_state;
+
+	///@brief In-progress transport layer packets
+	Packet* m_workingPacketsBySourceAddress[256];
+
+	///@brief Index of the first output sample of the frame being decoded
+	size_t m_nstart;
+
+	///@brief PGN of the frame being decoded
+	uint32_t m_currentPGN;
+
+	///@brief Source address of the frame being decoded
+	uint8_t m_currentSrc;
+
+	///@brief Destination address of the frame being decoded
+	uint8_t m_currentDst;
+
+	///@brief Payload bytes of the frame being decoded so far
+	std::vector<uint8_t> m_currentPacketBytes;
+
+	///@brief Start time of the frame being decoded
+	int64_t m_currentPacketStart;
 };
 
 #endif
@@ -81,6 +81,14 @@ string JitterFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief New random jitter is generated every time we're evaluated, even if the input hasn't changed
+ */
+bool JitterFilter::IsRefreshRequired()
+{
+	return true;
+}
+
 void JitterFilter::Refresh()
 {
 	//Make sure we've got valid inputs
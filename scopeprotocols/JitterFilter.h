@@ -41,6 +41,7 @@ public:
 	JitterFilter(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual bool IsRefreshRequired() override;
 
 	static std::string GetProtocolName();
 
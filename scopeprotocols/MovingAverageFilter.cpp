@@ -68,6 +68,30 @@ string MovingAverageFilter::GetProtocolName()
 	return "Moving average";
 }
 
+bool MovingAverageFilter::IsStreamingCapable()
+{
+	return true;
+}
+
+int64_t MovingAverageFilter::GetStreamingOverlap()
+{
+	auto din = GetInputWaveform(0);
+	if(!din || din->empty())
+		return 0;
+
+	//Sparse inputs are assumed to be sampled at roughly their average rate
+	int64_t interval = din->m_timescale;
+	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
+	if(sdin)
+	{
+		sdin->m_offsets.PrepareForCpuAccess();
+		interval = max((int64_t)1, (GetOffsetScaled(sdin, sdin->size()-1) - GetOffsetScaled(sdin, 0)) / (int64_t)sdin->size());
+	}
+
+	int64_t depth = max((int64_t)1, m_parameters[m_depthname].GetIntVal());
+	return (depth + 1) * interval;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -83,7 +107,7 @@ void MovingAverageFilter::Refresh()
 	auto din = GetInputWaveform(0);
 	din->PrepareForCpuAccess();
 	size_t len = din->size();
-	size_t depth = m_parameters[m_depthname].GetIntVal();
+	size_t depth = max((int64_t)1, m_parameters[m_depthname].GetIntVal());
 	if(len < depth)
 	{
 		SetData(NULL, 0);
@@ -101,22 +125,12 @@ void MovingAverageFilter::Refresh()
 
 	if(sdin)
 	{
-		//Do the average
+		//Timestamps are copied from the middle of each window
 		auto cap = SetupSparseOutputWaveform(sdin, 0, off, off);
 		cap->PrepareForCpuAccess();
 
-		//#pragma omp parallel for
-		for(size_t i=0; i<nsamples; i++)
-		{
-			float v = 0;
-			for(size_t j=0; j<depth; j++)
-				v += sdin->m_samples[i+j];
-			v /= depth;
-
-			cap->m_offsets[i] = sdin->m_offsets[i+off];
-			cap->m_durations[i] = sdin->m_durations[i+off];
-			cap->m_samples[i] = v;
-		}
+		//Do the average
+		MovingAverageSamples(sdin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), nsamples, depth);
 		SetData(cap, 0);
 
 		cap->MarkModifiedFromCpu();
@@ -127,16 +141,7 @@ void MovingAverageFilter::Refresh()
 		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
 		cap->PrepareForCpuAccess();
 		cap->Resize(nsamples);
-		//#pragma omp parallel for
-		for(size_t i=0; i<nsamples; i++)
-		{
-			float v = 0;
-			for(size_t j=0; j<depth; j++)
-				v += udin->m_samples[i+j];
-			v /= depth;
-
-			cap->m_samples[i] = v;
-		}
+		MovingAverageSamples(udin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), nsamples, depth);
 		SetData(cap, 0);
 
 		cap->MarkModifiedFromCpu();
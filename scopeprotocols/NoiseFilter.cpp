@@ -76,6 +76,14 @@ string NoiseFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief New noise is generated every time we're evaluated, even if the input hasn't changed
+ */
+bool NoiseFilter::IsRefreshRequired()
+{
+	return true;
+}
+
 void NoiseFilter::Refresh()
 {
 	//Make sure we've got valid inputs
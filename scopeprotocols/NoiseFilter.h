@@ -43,6 +43,7 @@ public:
 	NoiseFilter(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual bool IsRefreshRequired() override;
 
 	static std::string GetProtocolName();
 
@@ -173,6 +173,7 @@ void PRBSGeneratorFilter::Refresh()
 	dat->m_triggerPhase = 0;
 	dat->m_startTimestamp = floor(t);
 	dat->m_startFemtoseconds = fs;
+	dat->m_revision ++;
 	dat->Resize(depth);
 
 	auto clk = dynamic_cast<UniformDigitalWaveform*>(GetData(1));
@@ -186,6 +187,7 @@ void PRBSGeneratorFilter::Refresh()
 	clk->m_triggerPhase = samplePeriod / 2;
 	clk->m_startTimestamp = floor(t);
 	clk->m_startFemtoseconds = fs;
+	clk->m_revision ++;
 	clk->Resize(depth);
 
 	bool lastclk = false;
@@ -83,6 +83,13 @@ void ParallelBus::Refresh()
 	//Figure out how wide our input is
 	int width = m_parameters[m_widthname].GetIntVal();
 
+	//Packed lanes can be copied straight into a packed bus
+	if(RefreshPacked(width))
+	{
+		ReleaseUnusedInputs(width);
+		return;
+	}
+
 	//Make sure we have an input for each channel in use
 	vector<SparseDigitalWaveform*> inputs;
 	for(int i=0; i<width; i++)
@@ -126,7 +133,57 @@ void ParallelBus::Refresh()
 	cap->m_startTimestamp = inputs[0]->m_startTimestamp;
 	cap->m_startFemtoseconds = inputs[0]->m_startFemtoseconds;
 
-	//Set all unused channels to NULL
+	ReleaseUnusedInputs(width);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Builds a packed bus if every input in use is a packed digital waveform, copying each lane a word at a time
+
+	@return True if the output was created, false if any input isn't packed
+ */
+bool ParallelBus::RefreshPacked(int width)
+{
+	vector<PackedDigitalWaveform*> inputs;
+	for(int i=0; i<width; i++)
+	{
+		auto din = GetPackedDigitalInputWaveform(i);
+		if(din == nullptr)
+			return false;
+		inputs.push_back(din);
+	}
+	if(inputs.empty())
+		return false;
+
+	//Figure out length of the output
+	//TODO: handle variable sample rates etc
+	size_t len = inputs[0]->size();
+	for(int j=1; j<width; j++)
+		len = min(len, inputs[j]->size());
+
+	auto cap = new PackedDigitalBusWaveform(width);
+	cap->PrepareForCpuAccess();
+	for(int j=0; j<width; j++)
+		cap->PackLane(j, *inputs[j]);
+	cap->Resize(len);
+
+	//PackLane() copies the time scale of each lane, use the first one's to match the unpacked path
+	cap->m_timescale = inputs[0]->m_timescale;
+	cap->m_startTimestamp = inputs[0]->m_startTimestamp;
+	cap->m_startFemtoseconds = inputs[0]->m_startFemtoseconds;
+	cap->m_triggerPhase = inputs[0]->m_triggerPhase;
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+	return true;
+}
+
+/**
+	@brief Disconnects every input past the current bus width
+ */
+void ParallelBus::ReleaseUnusedInputs(int width)
+{
 	for(size_t i=width; i < 16; i++)
 	{
 		auto chan = m_inputs[i].m_channel;
@@ -138,6 +195,4 @@ void ParallelBus::Refresh()
 			m_inputs[i].m_channel = nullptr;
 		}
 	}
-
-	cap->MarkModifiedFromCpu();
 }
@@ -49,6 +49,9 @@ public:
 	PROTOCOL_DECODER_INITPROC(ParallelBus)
 
 protected:
+	bool RefreshPacked(int width);
+	void ReleaseUnusedInputs(int width);
+
 	std::string m_widthname;
 };
 
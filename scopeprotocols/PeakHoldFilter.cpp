@@ -118,6 +118,7 @@ void PeakHoldFilter::Refresh()
 		cap->m_timescale = din->m_timescale;
 		cap->m_startTimestamp = din->m_startTimestamp;
 		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_revision ++;
 
 		//Copy timestamps from the input
 		cap->CopyTimestamps(sdin);
@@ -160,6 +161,7 @@ void PeakHoldFilter::Refresh()
 		cap->m_timescale = din->m_timescale;
 		cap->m_startTimestamp = din->m_startTimestamp;
 		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_revision ++;
 
 		//First waveform just copies the input
 		if(first)
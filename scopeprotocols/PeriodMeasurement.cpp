@@ -79,25 +79,30 @@ void PeriodMeasurement::Refresh()
 		return;
 	}
 
-	auto din = GetInputWaveform(0);
+	//Packed digital inputs are searched a word at a time, without unpacking them
+	auto pddin = GetPackedDigitalInputWaveform(0);
+	WaveformBase* din = pddin ? pddin : GetInputWaveform(0);
 	din->PrepareForCpuAccess();
 	auto uadin = dynamic_cast<UniformAnalogWaveform*>(din);
 	auto sadin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto uddin = dynamic_cast<UniformDigitalWaveform*>(din);
 	auto sddin = dynamic_cast<SparseDigitalWaveform*>(din);
-	vector<int64_t> edges;
+	EdgeList pedges;
 
 	//Auto-threshold analog signals at 50% of full scale range
 	if(uadin)
-		FindZeroCrossings(uadin, GetAvgVoltage(uadin), edges);
+		pedges = FindZeroCrossings(uadin, GetAvgVoltage(uadin));
 	else if(sadin)
-		FindZeroCrossings(sadin, GetAvgVoltage(sadin), edges);
+		pedges = FindZeroCrossings(sadin, GetAvgVoltage(sadin));
 
 	//Just find edges in digital signals
+	else if(pddin)
+		pedges = FindZeroCrossings(pddin);
 	else if(uddin)
-		FindZeroCrossings(uddin, edges);
+		pedges = FindZeroCrossings(uddin);
 	else
-		FindZeroCrossings(sddin, edges);
+		pedges = FindZeroCrossings(sddin);
+	auto& edges = *pedges;
 
 	//We need at least one full cycle of the waveform to have a meaningful frequency
 	if(edges.size() < 2)
@@ -100,11 +100,8 @@ void PhaseMeasurement::Refresh()
 	float vmax = GetTopVoltage(sdin, udin);
 	float vmin = GetBaseVoltage(sdin, udin);
 	float vavg = (vmax + vmin) / 2;
-	vector<int64_t> edges;
-	if(sdin)
-		FindRisingEdges(sdin, vavg, edges);
-	else
-		FindRisingEdges(udin, vavg, edges);
+	auto pedges = FindRisingEdges(sdin, udin, vavg);
+	auto& edges = *pedges;
 	size_t edgelen = edges.size();
 
 	//Auto: use median of interval between pairs of rising edges
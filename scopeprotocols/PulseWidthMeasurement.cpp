@@ -91,7 +91,7 @@ void PulseWidthMeasurement::Refresh()
 	auto sadin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto uddin = dynamic_cast<UniformDigitalWaveform*>(din);
 	auto sddin = dynamic_cast<SparseDigitalWaveform*>(din);
-	vector<int64_t> edges;
+	EdgeList pedges;
 	float average_voltage = 0;
 	float max_value;
 	size_t temp = 0;
@@ -103,15 +103,16 @@ void PulseWidthMeasurement::Refresh()
 
 	//Auto-threshold analog signals at 50% of full scale range
 	if(uadin)
-		FindZeroCrossings(uadin, average_voltage, edges);
+		pedges = FindZeroCrossings(uadin, average_voltage);
 	else if(sadin)
-		FindZeroCrossings(sadin, average_voltage, edges);
+		pedges = FindZeroCrossings(sadin, average_voltage);
 
 	//Just find edges in digital signals
 	else if(uddin)
-		FindZeroCrossings(uddin, edges);
+		pedges = FindZeroCrossings(uddin);
 	else
-		FindZeroCrossings(sddin, edges);
+		pedges = FindZeroCrossings(sddin);
+	auto& edges = *pedges;
 
 	//We need at least one full cycle of the waveform to have a meaningful frequency
 	if(edges.size() < 2)
@@ -155,6 +155,10 @@ void QSPIDecoder::Refresh()
 	size_t iclk			= 0;
 	size_t idata[4]		= {0};
 
+	//Cursors for skipping between edges on uniform inputs
+	TransitionCursor csEdges(csn);
+	TransitionCursor clkEdges(clk);
+
 	int64_t timestamp	= 0;
 
 	while(true)
@@ -265,8 +269,8 @@ void QSPIDecoder::Refresh()
 		}
 
 		//Get timestamps of next event on each channel
-		int64_t next_cs = GetNextEventTimestampScaled(scsn, ucsn, ics, cslen, timestamp);
-		int64_t next_clk = GetNextEventTimestampScaled(sclk, uclk, iclk, clklen, timestamp);
+		int64_t next_cs = GetNextEventTimestampScaled(scsn, ucsn, csEdges, ics, cslen, timestamp);
+		int64_t next_clk = GetNextEventTimestampScaled(sclk, uclk, clkEdges, iclk, clklen, timestamp);
 
 		//If we can't move forward, stop (don't bother looking for glitches on data)
 		int64_t next_timestamp = min(next_clk, next_cs);
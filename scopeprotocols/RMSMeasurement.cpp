@@ -112,15 +112,12 @@ void RMSMeasurement::Refresh()
 
 	//Now we can do the cycle-by-cycle value
 	temp = 0;
-	vector<int64_t> edges;
 
 	//Auto-threshold analog signals at average value
 	//TODO: make threshold configurable?
 	float threshold = GetAvgVoltage(sadin, uadin);
-	if(uadin)
-		FindZeroCrossings(uadin, threshold, edges);
-	else if(sadin)
-		FindZeroCrossings(sadin, threshold, edges);
+	auto pedges = FindZeroCrossings(sadin, uadin, threshold);
+	auto& edges = *pedges;
 
 	//We need at least one full cycle of the waveform to have a meaningful AC RMS Measurement
 	if(edges.size() < 2)
@@ -140,6 +140,10 @@ void SPIDecoder::Refresh()
 	size_t cslen = csn->size();
 	size_t datalen = data->size();
 
+	//Cursors for skipping between edges on uniform inputs
+	TransitionCursor csEdges(csn);
+	TransitionCursor clkEdges(clk);
+
 	//Get SPI clock polarity
 	auto cpol = m_parameters[m_cpol].GetIntVal();
 
@@ -257,8 +261,8 @@ void SPIDecoder::Refresh()
 		}
 
 		//Get timestamps of next event on each channel
-		int64_t next_cs = GetNextEventTimestampScaled(scsn, ucsn, ics, cslen, timestamp);
-		int64_t next_clk = GetNextEventTimestampScaled(sclk, uclk, iclk, clklen, timestamp);
+		int64_t next_cs = GetNextEventTimestampScaled(scsn, ucsn, csEdges, ics, cslen, timestamp);
+		int64_t next_clk = GetNextEventTimestampScaled(sclk, uclk, clkEdges, iclk, clklen, timestamp);
 
 		//If we can't move forward, stop (don't bother looking for glitches on data)
 		int64_t next_timestamp = min(next_clk, next_cs);
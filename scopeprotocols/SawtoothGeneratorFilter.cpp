@@ -130,6 +130,7 @@ void SawtoothGeneratorFilter::Refresh()
 	cap->m_triggerPhase = 0;
 	cap->m_startTimestamp = floor(t);
 	cap->m_startFemtoseconds = fs;
+	cap->m_revision ++;
 	cap->Resize(depth);
 	cap->PrepareForCpuAccess();
 
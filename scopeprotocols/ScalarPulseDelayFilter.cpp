@@ -73,6 +73,14 @@ string ScalarPulseDelayFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Our output depends on wall clock time, so we have to be evaluated even if the input hasn't changed
+ */
+bool ScalarPulseDelayFilter::IsRefreshRequired()
+{
+	return true;
+}
+
 void ScalarPulseDelayFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
 {
 	//If the input pulse goes high high, start the timer
@@ -74,6 +74,7 @@ SpectrogramFilter::SpectrogramFilter(const string& color)
 	m_offset = -5e8;
 	m_cachedFFTLength = 0;
 	m_cachedFFTNumBlocks = 0;
+	m_cachedCpuWindowType = -1;
 
 	m_parameters[m_windowName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
 	m_parameters[m_windowName].AddEnumValue("Blackman-Harris", FFTFilter::FFTFilter::WINDOW_BLACKMAN_HARRIS);
@@ -156,14 +157,17 @@ void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	m_cachedFFTLength = fftlen;
 	m_cachedFFTNumBlocks = nblocks;
 
-	size_t nouts = fftlen/2 + 1;
+	//Plans are created on first use, since we might only ever need one of them
 	if(m_vkPlan)
 	{
 		if(m_vkPlan->size() != fftlen)
 			m_vkPlan = nullptr;
 	}
-	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+	if(m_cpuPlan)
+	{
+		if( (m_cpuPlan->size() != fftlen) || (m_cpuPlan->GetBatchCount() != nblocks) )
+			m_cpuPlan = nullptr;
+	}
 
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -173,6 +177,16 @@ void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 
 FlowGraphNode::DataLocation SpectrogramFilter::GetInputLocation()
 {
+	//If the FFTs are going to run on the CPU, pull the input over before Refresh() is called
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	if(din)
+	{
+		size_t fftlen = m_parameters[m_fftLengthName].GetIntVal();
+		size_t nblocks = din->size() / fftlen;
+		if(CPUFFTPlan::IsPreferred(fftlen, nblocks, false))
+			return LOC_CPU;
+	}
+
 	return LOC_DONTCARE;
 }
 
@@ -238,7 +252,7 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 	cap->m_triggerPhase = din->m_triggerPhase;
 	cap->m_timescale = fs_per_sample * fftlen;
-	cap->PrepareForGpuAccess();
+	cap->m_revision ++;
 	SetData(cap, 0);
 
 	//We also need to adjust the scale by the coherent power gain of the window function
@@ -263,6 +277,22 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 			break;
 	}
 
+	//Cache a bunch of configuration
+	float minscale = m_parameters[m_rangeMinName].GetFloatVal();
+	float fullscale = m_parameters[m_rangeMaxName].GetFloatVal();
+	float range = fullscale - minscale;
+
+	//Small transforms of CPU-resident data, or no usable GPU? Do it all on the CPU
+	if(CPUFFTPlan::IsPreferred(fftlen, nblocks, din->m_samples.IsCpuBufferStale()))
+	{
+		RefreshCPU(din, cap, fftlen, nblocks, scale, minscale, range);
+		return;
+	}
+
+	cap->PrepareForGpuAccess();
+	if(!m_vkPlan)
+		m_vkPlan = make_unique<VulkanFFTPlan>(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+
 	//Configure the window
 	WindowFunctionArgs args;
 	args.numActualSamples = fftlen;
@@ -307,11 +337,6 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	m_rdinbuf.resize(nblocks * fftlen);
 	m_rdoutbuf.resize(nblocks * (nouts * 2) );
 
-	//Cache a bunch of configuration
-	float minscale = m_parameters[m_rangeMinName].GetFloatVal();
-	float fullscale = m_parameters[m_rangeMaxName].GetFloatVal();
-	float range = fullscale - minscale;
-
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
@@ -363,3 +388,72 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 
 	cap->MarkModifiedFromGpu();
 }
+
+/**
+	@brief Runs the window, FFTs, and postprocessing on the CPU
+
+	Equivalent to the shader path in Refresh().
+ */
+void SpectrogramFilter::RefreshCPU(
+	UniformAnalogWaveform* din,
+	SpectrogramWaveform* cap,
+	size_t fftlen,
+	size_t nblocks,
+	float scale,
+	float minscale,
+	float range)
+{
+	size_t nouts = fftlen/2 + 1;
+	if(!m_cpuPlan)
+		m_cpuPlan = make_unique<CPUFFTPlan>(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+
+	//Update cached window coefficients if the window changed
+	auto window = m_parameters[m_windowName].GetIntVal();
+	if( (m_cpuWindow.size() != fftlen) || (m_cachedCpuWindowType != window) )
+	{
+		m_cpuWindow.resize(fftlen);
+		FFTFilter::CalculateWindow(static_cast<FFTFilter::WindowFunction>(window), fftlen, m_cpuWindow.data());
+		m_cachedCpuWindowType = window;
+	}
+
+	//Apply the window to each block
+	din->PrepareForCpuAccess();
+	m_cpuFFTInput.resize(nblocks * fftlen);
+	m_cpuFFTOutput.resize(nblocks * nouts * 2);
+	float* pin = din->m_samples.GetCpuPointer();
+	float* pwin = m_cpuFFTInput.data();
+	const float* coeffs = m_cpuWindow.data();
+	for(size_t block=0; block<nblocks; block++)
+	{
+		size_t base = block*fftlen;
+		for(size_t i=0; i<fftlen; i++)
+			pwin[base + i] = pin[base + i] * coeffs[i];
+	}
+
+	//Do all of the FFTs in one batch
+	m_cpuPlan->Forward(pwin, m_cpuFFTOutput.data());
+
+	//Convert to normalized dBm, transposing so each block becomes one column of the output
+	const float impedance = 50;
+	float impscale = scale*scale / impedance;
+	float irange = 1.0 / range;
+	cap->PrepareForCpuAccess();
+	float* pout = cap->GetOutData().GetCpuPointer();
+	const float* pfft = m_cpuFFTOutput.data();
+	for(size_t block=0; block<nblocks; block++)
+	{
+		const float* row = pfft + block*nouts*2;
+		for(size_t i=0; i<nouts; i++)
+		{
+			float real = row[i*2];
+			float imag = row[i*2 + 1];
+			float dbm = 10 * log10f((real*real + imag*imag) * impscale) + 30;
+
+			if(dbm < minscale)
+				pout[i*nblocks + block] = 0;
+			else
+				pout[i*nblocks + block] = (dbm - minscale) * irange;
+		}
+	}
+	cap->MarkModifiedFromCpu();
+}
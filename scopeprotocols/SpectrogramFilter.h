@@ -36,6 +36,7 @@
 #define SpectrogramFilter_h
 
 #include "VulkanFFTPlan.h"
+#include "CPUFFTPlan.h"
 
 #include "../scopehal/DensityFunctionWaveform.h"
 
@@ -100,6 +101,15 @@ public:
 protected:
 	virtual void ReallocateBuffers(size_t fftlen, size_t nblocks);
 
+	void RefreshCPU(
+		UniformAnalogWaveform* din,
+		SpectrogramWaveform* cap,
+		size_t fftlen,
+		size_t nblocks,
+		float scale,
+		float minscale,
+		float range);
+
 	AcceleratorBuffer<float> m_rdinbuf;
 	AcceleratorBuffer<float> m_rdoutbuf;
 
@@ -116,6 +126,12 @@ protected:
 
 	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
 
+	std::unique_ptr<CPUFFTPlan> m_cpuPlan;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuWindow;
+	int64_t m_cachedCpuWindowType;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuFFTInput;
+	std::vector<float, AlignedAllocator<float, 64> > m_cpuFFTOutput;
+
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
 	ComputePipeline m_cosineSumComputePipeline;
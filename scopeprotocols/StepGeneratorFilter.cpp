@@ -104,6 +104,7 @@ void StepGeneratorFilter::Refresh()
 	cap->m_triggerPhase = 0;
 	cap->m_startTimestamp = floor(t);
 	cap->m_startFemtoseconds = fs;
+	cap->m_revision ++;
 	cap->Resize(depth);
 
 	for(size_t i=0; i<depth; i++)
@@ -111,11 +111,11 @@ void TIEMeasurement::Refresh()
 	cap->PrepareForCpuAccess();
 
 	//Timestamps of the edges
-	vector<int64_t> edges;
+	EdgeList edges;
 	if(uaclk || saclk)
-		FindZeroCrossings(saclk, uaclk, m_parameters[m_threshname].GetFloatVal(), edges);
+		edges = FindZeroCrossings(saclk, uaclk, m_parameters[m_threshname].GetFloatVal());
 	else
-		FindZeroCrossings(sdclk, udclk, edges);
+		edges = FindZeroCrossings(sdclk, udclk);
 
 	//Ignore edges before things have stabilized
 	int64_t skip_time = m_parameters[m_skipname].GetIntVal();
@@ -123,7 +123,7 @@ void TIEMeasurement::Refresh()
 	//For each input clock edge, find the closest recovered clock edge
 	size_t iedge = 0;
 	size_t tlast = 0;
-	for(auto atime : edges)
+	for(auto atime : *edges)
 	{
 		if(iedge >= len)
 			break;
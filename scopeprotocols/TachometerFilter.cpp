@@ -91,8 +91,8 @@ void TachometerFilter::Refresh()
 	float midpoint = GetAvgVoltage(sdin, udin);
 
 	//Timestamps of the edges
-	vector<int64_t> edges;
-	FindZeroCrossings(sdin, udin, midpoint, edges);
+	auto pedges = FindZeroCrossings(sdin, udin, midpoint);
+	auto& edges = *pedges;
 	if(edges.size() < 2)
 	{
 		SetData(NULL, 0);
@@ -72,6 +72,23 @@ string ThresholdFilter::GetProtocolName()
 	return "Threshold";
 }
 
+bool ThresholdFilter::IsStreamingCapable()
+{
+	return true;
+}
+
+int64_t ThresholdFilter::GetStreamingOverlap()
+{
+	//Without hysteresis, every sample is independent
+	auto din = GetInputWaveform(0);
+	if(!din || (m_parameters[m_hysname].GetFloatVal() == 0) )
+		return 0;
+
+	//With hysteresis, output only matches once the signal has left the hysteresis band. Assume that happens
+	//within a few hundred samples.
+	return 256 * din->m_timescale;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
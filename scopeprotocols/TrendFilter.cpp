@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/RollingSparseWaveform.h"
 #include "TrendFilter.h"
 
 using namespace std;
@@ -38,6 +39,7 @@ using namespace std;
 TrendFilter::TrendFilter(const string& color)
 	: PausableFilter(color, CAT_MATH)
 	, m_tlast(0)
+	, m_tbase(0)
 	, m_depthname("Buffer length")
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
@@ -86,6 +88,14 @@ void TrendFilter::ClearSweeps()
 	SetData(nullptr, 0);
 }
 
+/**
+	@brief Every evaluation appends a new point to the trend, even if the input value hasn't changed
+ */
+bool TrendFilter::IsRefreshRequired()
+{
+	return true;
+}
+
 void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<QueueHandle> /*queue*/)
 {
 	if(!ShouldRefresh())
@@ -99,27 +109,30 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 
 	//See if we have output already
 	double now = GetTime();
-	auto wfm = dynamic_cast<SparseAnalogWaveform*>(GetData(0));
-	if(wfm)
+	auto wfm = dynamic_cast<RollingSparseAnalogWaveform*>(GetData(0));
+	if(!wfm)
 	{
-		//Remove old samples
-		size_t nmax = m_parameters[m_depthname].GetIntVal();
-		while(wfm->m_samples.size() > nmax)
+		wfm = new RollingSparseAnalogWaveform;
+		wfm->m_timescale = 1;
+		wfm->PrepareForCpuAccess();
+
+		//Keep any history we were handed from elsewhere (e.g. a waveform loaded from a saved session)
+		auto old = dynamic_cast<SparseAnalogWaveform*>(GetData(0));
+		if(old && old->size() && (old->m_timescale == 1) && wfm->AppendSamples(old, 0, old->size()))
 		{
-			wfm->m_samples.pop_front();
-			wfm->m_durations.pop_front();
-			wfm->m_offsets.pop_front();
+			if(m_tlast <= 0)
+				m_tlast = now;
+			m_tbase = m_tlast - wfm->m_offsets[wfm->size() - 1] / FS_PER_SECOND;
+		}
+		else
+		{
+			m_tlast = now;
+			m_tbase = now;
 		}
-	}
-	else
-	{
-		wfm = new SparseAnalogWaveform;
-		SetData(wfm, 0);
 
-		wfm->m_triggerPhase = 0;
-		wfm->m_timescale = 1;
-		m_tlast = now;
+		SetData(wfm, 0);
 	}
+	wfm->SetDepth(m_parameters[m_depthname].GetIntVal());
 	wfm->PrepareForCpuAccess();
 	wfm->m_revision ++;
 
@@ -128,23 +141,24 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 	wfm->m_startFemtoseconds = (now - wfm->m_startTimestamp) * FS_PER_SECOND;
 
 	//Update duration of previous sample
-	size_t len = wfm->m_samples.size();
-	double dt = (now - m_tlast) * FS_PER_SECOND;
+	size_t len = wfm->size();
+	int64_t dt = (now - m_tlast) * FS_PER_SECOND;
 	if(len > 0)
 		wfm->m_durations[len-1] = dt;
 
-	//Add the new sample
-	wfm->m_samples.push_back(GetInput(0).GetScalarValue());
-	wfm->m_durations.push_back(dt);
-	if(wfm->m_offsets.empty())
-		wfm->m_offsets.push_back(0);
-	else
-		wfm->m_offsets.push_back(dt + wfm->m_offsets[len-1]);
-
-	//Update offsets of old samples
-	len = wfm->m_samples.size();
-	for(size_t i=0; i<len; i++)
-		wfm->m_offsets[i] -= dt;
+	//Offsets count up from m_tbase and are never rewritten, except for an occasional rebase so they can't overflow
+	int64_t offset = (now - m_tbase) * FS_PER_SECOND;
+	if(offset > 4000LL * 1000LL * 1000LL * 1000LL * 1000LL * 1000LL)
+	{
+		int64_t delta = (len > 0) ? wfm->m_offsets[0] : offset;
+		wfm->RebaseOffsets(delta);
+		m_tbase += delta / FS_PER_SECOND;
+		offset -= delta;
+	}
+
+	//Add the new sample, then shift the whole waveform so it's at time zero
+	wfm->Append(offset, dt, GetInput(0).GetScalarValue());
+	wfm->SetBaseOffset(offset);
 
 	wfm->MarkModifiedFromCpu();
 
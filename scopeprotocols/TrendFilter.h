@@ -43,6 +43,7 @@ public:
 	TrendFilter(const std::string& color);
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual bool IsRefreshRequired() override;
 
 	virtual void ClearSweeps() override;
 
@@ -55,6 +56,7 @@ public:
 
 protected:
 	double m_tlast;
+	double m_tbase;
 
 	std::string m_depthname;
 };
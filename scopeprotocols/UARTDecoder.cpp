@@ -82,6 +82,22 @@ string UARTDecoder::GetProtocolName()
 	return "UART";
 }
 
+bool UARTDecoder::IsStreamingCapable()
+{
+	return true;
+}
+
+int64_t UARTDecoder::GetStreamingOverlap()
+{
+	//Zero, negative, or sub-1 baud rates would overflow the result, and can't be decoded anyway
+	float baud = m_parameters[m_baudname].GetFloatVal();
+	if(!(baud >= 1))
+		return 0;
+
+	//Enough for two complete frames with parity and stop bits
+	return 24 * FS_PER_SECOND / baud;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -63,6 +63,9 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
+	virtual bool IsStreamingCapable() override;
+	virtual int64_t GetStreamingOverlap() override;
+
 	PROTOCOL_DECODER_INITPROC(UARTDecoder)
 
 protected:
@@ -97,12 +97,10 @@ void UartClockRecoveryFilter::Refresh()
 	cap->m_timescale = 1;
 	cap->PrepareForCpuAccess();
 
-	//Timestamps of the edges
-	vector<int64_t> edges;
-
 	//Find times of the zero crossings
 	const float threshold = m_parameters[m_threshname].GetFloatVal();
-	FindZeroCrossingsBase(din, threshold, edges);
+	auto pedges = FindZeroCrossings(din, threshold);
+	auto& edges = *pedges;
 
 	//Actual DLL logic
 	size_t nedge = 0;
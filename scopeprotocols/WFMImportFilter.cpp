@@ -630,60 +630,31 @@ void WFMImportFilter::OnFileNameChanged()
 	else
 		LogWarning("Unrecognized Y axis unit \"%s\"\n", yunits);
 
-	//Create output waveform and stream
+	//Create output stream
 	//TODO: handle multi channel etc
 	ClearStreams();
 	AddStream(yunit, "data", Stream::STREAM_TYPE_ANALOG);
-	auto wfm = new UniformAnalogWaveform;
-	wfm->m_timescale = FS_PER_SECOND * (spacing+1) * xscale;
-	wfm->Resize(numRealSamples);
-	wfm->m_startTimestamp = gmtSec;
-	wfm->m_startFemtoseconds = fracSec * FS_PER_SECOND;
-	wfm->m_triggerPhase = triggerPhase * wfm->m_timescale;
-	wfm->PrepareForCpuAccess();
-	SetData(wfm, 0);
-
-	if(bytesperpoint == 2)
-	{
-		//Read sample data
-		int16_t* rawdata = new int16_t[numRealSamples];
-		fseek(fp, curveoffset, SEEK_SET);
-		if(numRealSamples != fread(rawdata, sizeof(int16_t), numRealSamples, fp))
-		{
-			LogError("Fail to read waveform data\n");
-			delete[] rawdata;
-			return;
-		}
-
-		//Convert (TODO vectorize)
-		for(size_t i=0; i<numRealSamples; i++)
-			wfm->m_samples[i] = (rawdata[i] * yscale) + yoff;
+	fclose(fp);
 
-		delete[] rawdata;
-	}
-	else //if(bytesperpoint == 1)
+	//Samples are converted straight out of the file when needed, a segment at a time if the filter graph is run
+	//segmented (see ImportFilter::ReadSegment())
+	if(!MapFile(fname) || (curveoffset > m_mappedSize) || (numBytes > m_mappedSize - curveoffset) )
 	{
-		//Read sample data
-		int8_t* rawdata = new int8_t[numRealSamples];
-		fseek(fp, curveoffset, SEEK_SET);
-		if(numRealSamples != fread(rawdata, sizeof(int8_t), numRealSamples, fp))
-		{
-			LogError("Fail to read waveform data\n");
-			delete[] rawdata;
-			return;
-		}
-
-		//Convert (TODO vectorize)
-		for(size_t i=0; i<numRealSamples; i++)
-			wfm->m_samples[i] = (rawdata[i] * yscale) + yoff;
-
-		delete[] rawdata;
+		LogError("Fail to read waveform data\n");
+		return;
 	}
 
-	//Done, set scale
-	wfm->MarkModifiedFromCpu();
-	AutoscaleVertical(0);
-
-	//Clean up
-	fclose(fp);
+	MappedStream stream;
+	stream.m_stream = 0;
+	stream.m_fileOffset = curveoffset;
+	stream.m_count = numRealSamples;
+	stream.m_stride = bytesperpoint;
+	stream.m_type = (bytesperpoint == 2) ? MAPPED_INT16 : MAPPED_INT8;
+	stream.m_scale = yscale;
+	stream.m_offset = yoff;
+	stream.m_timescale = FS_PER_SECOND * (spacing+1) * xscale;
+	stream.m_triggerPhase = triggerPhase * stream.m_timescale;
+	stream.m_startTimestamp = gmtSec;
+	stream.m_startFemtoseconds = fracSec * FS_PER_SECOND;
+	AddMappedStream(stream);
 }
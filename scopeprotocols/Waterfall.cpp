@@ -147,6 +147,7 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 
 	//Recalculate timescale and update timestamps
 	cap->m_timescale = spanIn / capwidth;
+	cap->m_revision ++;
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 
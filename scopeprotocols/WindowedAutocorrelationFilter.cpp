@@ -28,7 +28,6 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
-#include <complex>
 #include "WindowedAutocorrelationFilter.h"
 
 using namespace std;
@@ -95,15 +94,15 @@ void WindowedAutocorrelationFilter::Refresh()
 	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 0);
 
 	//Convert window and period to samples
-	int window_ps = m_parameters[m_windowName].GetIntVal();
-	size_t window_samples = window_ps / din_i->m_timescale;
-	int period_ps = m_parameters[m_periodName].GetIntVal();
-	size_t period_samples = period_ps / din_i->m_timescale;
+	int64_t window_fs = m_parameters[m_windowName].GetIntVal();
+	size_t window_samples = max((int64_t)1, window_fs / din_i->m_timescale);
+	int64_t period_fs = m_parameters[m_periodName].GetIntVal();
+	size_t period_samples = period_fs / din_i->m_timescale;
 	window_samples = min(window_samples, period_samples);
 
 	//We need meaningful data, bail if it's too short
 	auto len = min(din_i->m_samples.size(), din_q->m_samples.size());
-	if(len < period_samples)
+	if( (len <= 2*period_samples) || (window_samples == 0) )
 	{
 		SetData(NULL, 0);
 		return;
@@ -115,24 +114,31 @@ void WindowedAutocorrelationFilter::Refresh()
 	cap->PrepareForCpuAccess();
 	cap->Resize(end);
 
-	for(size_t i=0; i < end; i ++)
+	//Product of each sample with the one a period later
+	size_t nprod = end + window_samples - 1;
+	m_productReal.resize(nprod);
+	m_productImag.resize(nprod);
+	auto pi = din_i->m_samples.GetCpuPointer();
+	auto pq = din_q->m_samples.GetCpuPointer();
+	#pragma omp parallel for
+	for(size_t i=0; i<nprod; i++)
 	{
-		complex<float> total = 0;
-		for(size_t j=0; j<window_samples; j++)
-		{
-			size_t first = i + j;
-			size_t second = first + period_samples;
-
-			complex<float> a(din_i->m_samples[first], din_q->m_samples[first]);
-			complex<float> b(din_i->m_samples[second], din_q->m_samples[second]);
-
-			total += a*b;
-		}
+		size_t second = i + period_samples;
+		m_productReal[i] = pi[i]*pi[second] - pq[i]*pq[second];
+		m_productImag[i] = pi[i]*pq[second] + pq[i]*pi[second];
+	}
 
-		float v = abs(total) / window_samples;
+	//Average the products over the window, at a cost independent of the window size
+	m_averageReal.resize(end);
+	m_averageImag.resize(end);
+	MovingAverageSamples(m_productReal.data(), m_averageReal.data(), end, window_samples);
+	MovingAverageSamples(m_productImag.data(), m_averageImag.data(), end, window_samples);
 
-		cap->m_samples[i] = v;
-	}
+	//Output is the magnitude of the average
+	auto pout = cap->m_samples.GetCpuPointer();
+	#pragma omp parallel for
+	for(size_t i=0; i < end; i ++)
+		pout[i] = hypot(m_averageReal[i], m_averageImag[i]);
 
 	cap->MarkModifiedFromCpu();
 }
@@ -51,6 +51,18 @@ public:
 protected:
 	std::string m_windowName;
 	std::string m_periodName;
+
+	///@brief Real part of the product of each sample with the one a period later
+	std::vector<float, AlignedAllocator<float, 64> > m_productReal;
+
+	///@brief Imaginary part of the product of each sample with the one a period later
+	std::vector<float, AlignedAllocator<float, 64> > m_productImag;
+
+	///@brief Windowed average of m_productReal
+	std::vector<float, AlignedAllocator<float, 64> > m_averageReal;
+
+	///@brief Windowed average of m_productImag
+	std::vector<float, AlignedAllocator<float, 64> > m_averageImag;
 };
 
 #endif
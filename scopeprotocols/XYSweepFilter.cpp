@@ -83,6 +83,14 @@ void XYSweepFilter::ClearSweeps()
 	SetData(nullptr, 0);
 }
 
+/**
+	@brief Every evaluation may append a new point to the sweep, even if the inputs haven't changed
+ */
+bool XYSweepFilter::IsRefreshRequired()
+{
+	return true;
+}
+
 void XYSweepFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<QueueHandle> /*queue*/)
 {
 	//Make sure we've got valid inputs